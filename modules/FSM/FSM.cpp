@@ -15,6 +15,8 @@
 */ 
 
 #include "FSM.h"
+#include "FSMTickSubsystem.h"
+#include "Engine/World.h"
 #include "Net/UnrealNetwork.h"
 #include "VSPCheck.h"
 #include "Utility/Network/Network.h"
@@ -23,6 +25,7 @@
 namespace FFSMLocal
 {
 	static constexpr int8 INVALID_STATE_ID = -42;
+	static constexpr double NEVER = TNumericLimits<double>::Max();
 }
 
 
@@ -31,6 +34,8 @@ UFSM::UFSM()
 	PrimaryComponentTick.bCanEverTick = true;
 	PrimaryComponentTick.bStartWithTickEnabled = false;
 	CurrentStateID = FFSMLocal::INVALID_STATE_ID;
+	OwnerReplicatedState.StateID = FFSMLocal::INVALID_STATE_ID;
+	SharedReplicatedState.StateID = FFSMLocal::INVALID_STATE_ID;
 	NetMode = EMachineNetMode::None;
 	SetIsReplicatedByDefault(false);
 }
@@ -38,17 +43,25 @@ UFSM::UFSM()
 void UFSM::AddStateInner(int8 StateID, FState* State)
 {
 	VSPCheck(!HasBegunPlay());
-	VSPCheck(!States.Find(StateID));
+	VSPCheck(!FindState(StateID));
 	VSPCheck(StateID != FFSMLocal::INVALID_STATE_ID);
-	FStateInfo StateInfo;
-	StateInfo.State = State;
-	States.Add(StateID, StateInfo);
+	if (States.Num() == 0)
+		FirstStateID = StateID;
+	else if (StateID < FirstStateID)
+	{
+		States.InsertDefaulted(0, FirstStateID - StateID);
+		FirstStateID = StateID;
+	}
+	const int32 StateIndex = StateID - FirstStateID;
+	if (StateIndex >= States.Num())
+		States.SetNum(StateIndex + 1);
+	States[StateIndex].State = State;
 }
 
 void UFSM::AddTransitionInner(int8 FromStateID, int8 ToStateID, FTransition* Transition)
 {
 	VSPCheck(!HasBegunPlay());
-	FStateInfo* StateInfo = States.Find(FromStateID);
+	FStateInfo* StateInfo = FindState(FromStateID);
 	VSPCheckReturn(StateInfo);
 	StateInfo->Transitions.Add(TTuple<int8, FTransition*>(ToStateID, Transition));
 }
@@ -60,7 +73,7 @@ void UFSM::Setup(EMachineNetMode MachineNetMode, int8 StateID, bool ManualTick)
 	SetIsReplicated(NetMode != EMachineNetMode::None);
 
 	VSPCheck(!HasBegunPlay());
-	VSPCheck(States.Find(StateID) != nullptr);
+	VSPCheck(FindState(StateID) != nullptr);
 	VSPCheckF(CurrentStateID == FFSMLocal::INVALID_STATE_ID, TEXT("duplicate UFSM::SetStartingState call"));
 	CurrentStateID = StateID;
 
@@ -72,50 +85,54 @@ void UFSM::ForceTransitionInner(int8 ToStateID, bool bReEnter)
 {
 	VSPCheck(NetMode != EMachineNetMode::Synchronized || FNetworkUtility::HasAuthority(this));
 
-	FStateInfo* PrevStateInfo = States.Find(CurrentStateID);
+	FStateInfo* PrevStateInfo = FindState(CurrentStateID);
 	VSPCheckReturn(PrevStateInfo);
-	FStateInfo* NewStateInfo = States.Find(ToStateID);
+	FStateInfo* NewStateInfo = FindState(ToStateID);
 	VSPCheckReturn(NewStateInfo);
 
 
-	if (PrevStateInfo->State->NetMode == NewStateInfo->State->NetMode)
+	// replicated state machines replicate the state once the transition is done
+	if (!bReplicatedState)
 	{
-		switch (PrevStateInfo->State->NetMode)
+		if (PrevStateInfo->State->NetMode == NewStateInfo->State->NetMode)
 		{
-		case EStateNetMode::None:
-			break;
-		case EStateNetMode::OwnClient:
-			ClientSwitchState(ToStateID);
-			break;
-		case EStateNetMode::AllClients:
-			NetMulticastSwitchState(ToStateID);
-			break;
+			switch (PrevStateInfo->State->NetMode)
+			{
+			case EStateNetMode::None:
+				break;
+			case EStateNetMode::OwnClient:
+				ClientSwitchState(ToStateID);
+				break;
+			case EStateNetMode::AllClients:
+				NetMulticastSwitchState(ToStateID);
+				break;
+			}
 		}
-	}
-	else
-	{
-		switch (PrevStateInfo->State->NetMode)
+		else
 		{
-		case EStateNetMode::None:
-			break;
-		case EStateNetMode::OwnClient:
-			ClientEndState(CurrentStateID);
-			break;
-		case EStateNetMode::AllClients:
-			NetMulticastEndState(CurrentStateID);
-			break;
-		}
+			switch (PrevStateInfo->State->NetMode)
+			{
+			case EStateNetMode::None:
+				break;
+			case EStateNetMode::OwnClient:
+				ClientEndState(CurrentStateID);
+				break;
+			case EStateNetMode::AllClients:
+				NetMulticastEndState(CurrentStateID);
+				break;
+			}
 
-		switch (NewStateInfo->State->NetMode)
-		{
-		case EStateNetMode::None:
-			break;
-		case EStateNetMode::OwnClient:
-			ClientBeginState(ToStateID);
-			break;
-		case EStateNetMode::AllClients:
-			NetMulticastBeginState(ToStateID);
-			break;
+			switch (NewStateInfo->State->NetMode)
+			{
+			case EStateNetMode::None:
+				break;
+			case EStateNetMode::OwnClient:
+				ClientBeginState(ToStateID);
+				break;
+			case EStateNetMode::AllClients:
+				NetMulticastBeginState(ToStateID);
+				break;
+			}
 		}
 	}
 
@@ -124,8 +141,12 @@ void UFSM::ForceTransitionInner(int8 ToStateID, bool bReEnter)
 	{
 		PrevStateInfo->State->End();
 		CurrentStateID = ToStateID;
+		OnStateEntered();
+		if (bReplicatedState)
+			UpdateReplicatedState();
 		NewStateInfo->State->Begin(false);
 	}
+	ScheduleWakeUp();
 }
 
 void UFSM::SetupReplication(EMachineNetMode MachineNetMode)
@@ -138,7 +159,7 @@ void UFSM::SetupReplication(EMachineNetMode MachineNetMode)
 void UFSM::SetStartingStateInner(int8 StateID)
 {
 	VSPCheck(!HasBegunPlay());
-	VSPCheck(States.Find(StateID) != nullptr);
+	VSPCheck(FindState(StateID) != nullptr);
 	VSPCheckF(CurrentStateID == FFSMLocal::INVALID_STATE_ID, TEXT("duplicate UFSM::SetStartingState call"));
 	CurrentStateID = StateID;
 }
@@ -148,6 +169,37 @@ void UFSM::ManualTick(float DeltaTime)
 	TickState(DeltaTime);
 }
 
+void UFSM::EnableBatchedTick(bool bThreadSafe)
+{
+	VSPCheck(!HasBegunPlay());
+	bBatchedTick = true;
+	bThreadSafeTick = bThreadSafe;
+}
+
+void UFSM::Signal(FName SignalName)
+{
+	if (!HasBegunPlay() || (NetMode == EMachineNetMode::Synchronized && !FNetworkUtility::HasAuthority(this)))
+		return;
+	FStateInfo* StateInfo = FindState(CurrentStateID);
+	VSPCheckReturn(StateInfo);
+
+	for (TTuple<int8, FTransition*> const& Transition : StateInfo->Transitions)
+	{
+		FTransition const* It = Transition.Get<1>();
+		if (It->Trigger == FTransition::ETrigger::Signal && It->TriggerSignal == SignalName && It->Tick())
+		{
+			ForceTransitionInner(Transition.Get<0>(), false);
+			return;
+		}
+	}
+}
+
+void UFSM::EnableReplicatedState()
+{
+	VSPCheck(!HasBegunPlay());
+	bReplicatedState = true;
+}
+
 void UFSM::SuspendTransitions()
 {
 	VSPCheck(!bTransitionsSuspended);
@@ -180,6 +232,10 @@ void UFSM::ResumeTransitions()
 			VSPNoEntry();
 		}
 	}
+
+	// latest replicated state received meanwhile
+	if (bReplicatedState)
+		ApplyReplicatedState();
 }
 
 void UFSM::BeginPlay()
@@ -187,7 +243,7 @@ void UFSM::BeginPlay()
 	Super::BeginPlay();
 	VSPCheck(States.Num() > 0);
 	VSPCheckF(CurrentStateID != FFSMLocal::INVALID_STATE_ID, TEXT("did you forget to call UFSM::SetStartingState?"));
-	FStateInfo* StateInfo = States.Find(CurrentStateID);
+	FStateInfo* StateInfo = FindState(CurrentStateID);
 	VSPCheckReturn(StateInfo);
 
 	if (FNetworkUtility::HasAuthority(this) || NetMode == EMachineNetMode::None)
@@ -195,9 +251,11 @@ void UFSM::BeginPlay()
 		StateInfo->State->Begin(false);
 		bValidClientState = true;
 	}
+	// replicated state machines begin the replicated state below, the initial CurrentStateID may be older
 	else if (
-		NetMode == EMachineNetMode::Autonomous || StateInfo->State->NetMode == EStateNetMode::AllClients
-		|| (StateInfo->State->NetMode == EStateNetMode::OwnClient && FNetworkUtility::IsClientOwnership(this)))
+		!bReplicatedState
+		&& (NetMode == EMachineNetMode::Autonomous || StateInfo->State->NetMode == EStateNetMode::AllClients
+			|| (StateInfo->State->NetMode == EStateNetMode::OwnClient && FNetworkUtility::IsClientOwnership(this))))
 	{
 		StateInfo->State->Begin(true);
 		bValidClientState = true;
@@ -205,20 +263,58 @@ void UFSM::BeginPlay()
 
 	bool bSynchronized = NetMode == EMachineNetMode::Synchronized;
 	bool bHasReplicatedStates = false;
-	for (TPair<int8, FStateInfo> const& It : States)
+	for (FStateInfo const& It : States)
 	{
-		if (It.Value.State->NetMode != EStateNetMode::None)
+		if (It.State && It.State->NetMode != EStateNetMode::None)
 			bHasReplicatedStates = true;
 	}
 	if (!bSynchronized && bHasReplicatedStates)
 		VSPNoEntryF(TEXT("non-synchronized fsm has replicated states"));
 	if (bSynchronized && !bHasReplicatedStates)
 		VSPNoEntryF(TEXT("syncrhonized fsm has no replicated states"));
+	VSPCheckF(!bReplicatedState || bSynchronized, TEXT("replicated state fsm is not synchronized"));
+	if (bReplicatedState)
+	{
+		if (FNetworkUtility::HasAuthority(this))
+			UpdateReplicatedState();
+		else
+			ApplyReplicatedState();
+	}
+
+	for (FStateInfo& It : States)
+	{
+		It.bHasPolledTransitions = It.Transitions.ContainsByPredicate(
+			[](TTuple<int8, FTransition*> const& Transition) { return Transition.Get<1>()->IsPolled(); });
+	}
+	bAutoTick = IsComponentTickEnabled();
+
+	// machines set up for manual tick keep it
+	if (bBatchedTick && IsComponentTickEnabled())
+	{
+		if (UFSMTickSubsystem* TickSubsystem = GetTickSubsystem())
+		{
+			SetComponentTickEnabled(false);
+			TickSubsystem->Register(this);
+		}
+	}
+
+	OnStateEntered();
+	ScheduleWakeUp();
 }
 
 void UFSM::EndPlay(EEndPlayReason::Type const EndPlayReason)
 {
-	FStateInfo* StateInfo = States.Find(CurrentStateID);
+	if (BatchedTickIndex != INDEX_NONE)
+	{
+		if (UFSMTickSubsystem* TickSubsystem = GetTickSubsystem())
+			TickSubsystem->Unregister(this);
+	}
+	// pending wake-ups are void
+	bSleeping = false;
+	bSleepDisabledTick = false;
+	++WakeTicket;
+
+	FStateInfo* StateInfo = FindState(CurrentStateID);
 	VSPCheckReturn(StateInfo);
 	if (NetMode != EMachineNetMode::Synchronized || FNetworkUtility::HasAuthority(this)
 		|| (bValidClientState
@@ -235,24 +331,58 @@ void UFSM::EndPlay(EEndPlayReason::Type const EndPlayReason)
 void UFSM::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	TickState(DeltaTime);
+	// already ticked by UFSMTickSubsystem, or nothing due while asleep with the tick kept on
+	if (BatchedTickIndex == INDEX_NONE && !bSleeping)
+		TickState(DeltaTime);
+}
+
+UFSM::FStateInfo* UFSM::FindState(int8 StateID)
+{
+	const int32 StateIndex = StateID - FirstStateID;
+	return States.IsValidIndex(StateIndex) && States[StateIndex].State ? &States[StateIndex] : nullptr;
 }
 
 void UFSM::TickState(float DeltaTime)
 {
-	FStateInfo* StateInfo = States.Find(CurrentStateID);
-	VSPCheckReturn(StateInfo);
+	int8 ToStateID;
+	const bool bTransitionPassed = EvaluateState(DeltaTime, ToStateID);
+	CompleteTick(bTransitionPassed, ToStateID);
+}
+
+bool UFSM::EvaluateState(float DeltaTime, int8& OutToStateID)
+{
+	FStateInfo* StateInfo = FindState(CurrentStateID);
+	VSPCheckReturn(StateInfo, false);
 
 	if (NetMode != EMachineNetMode::Synchronized || FNetworkUtility::HasAuthority(this))
 	{
 		StateInfo->State->Tick(DeltaTime);
+		const double Now = GetTime();
 		for (TTuple<int8, FTransition*> const& Transition : StateInfo->Transitions)
 		{
-			if (Transition.Get<1>()->Tick())
+			FTransition* It = Transition.Get<1>();
+			switch (It->Trigger)
 			{
-				ForceTransitionInner(Transition.Get<0>(), false);
+			case FTransition::ETrigger::Polled:
+				break;
+			case FTransition::ETrigger::Delay:
+				if (Now - StateEnterTime < It->TriggerSeconds)
+					continue;
+				break;
+			case FTransition::ETrigger::Signal:
+				continue;
+			case FTransition::ETrigger::PollInterval:
+				if (Now < It->NextPollTime)
+					continue;
+				It->NextPollTime = Now + It->TriggerSeconds;
 				break;
 			}
+
+			if (It->Tick())
+			{
+				OutToStateID = Transition.Get<0>();
+				return true;
+			}
 		}
 	}
 	else
@@ -260,40 +390,162 @@ void UFSM::TickState(float DeltaTime)
 		if (bValidClientState)
 			StateInfo->State->Tick(DeltaTime);
 	}
+	return false;
+}
 
+void UFSM::CompleteTick(bool bTransitionPassed, int8 ToStateID)
+{
+	if (bTransitionPassed)
+		ForceTransitionInner(ToStateID, false);
+	else
+		ScheduleWakeUp();
 }
 
-void UFSM::BeginState(int8 StateID)
+void UFSM::OnStateEntered()
 {
-	FStateInfo* StateInfo = States.Find(StateID);
+	FStateInfo* StateInfo = FindState(CurrentStateID);
 	VSPCheckReturn(StateInfo);
-	StateInfo->State->Begin(false);
+	StateEnterTime = GetTime();
+	for (TTuple<int8, FTransition*> const& Transition : StateInfo->Transitions)
+	{
+		FTransition* It = Transition.Get<1>();
+		if (It->Trigger == FTransition::ETrigger::PollInterval)
+			It->NextPollTime = StateEnterTime + It->TriggerSeconds;
+	}
+}
+
+void UFSM::ScheduleWakeUp()
+{
+	if (!bAutoTick || !HasBegunPlay())
+		return;
+	if (NeedsTick())
+		WakeUp();
+	else
+		Sleep(GetNextTriggerTime());
+}
+
+bool UFSM::NeedsTick()
+{
+	if (!bAutoTick || !HasBegunPlay())
+		return false;
+	FStateInfo* StateInfo = FindState(CurrentStateID);
+	VSPCheckReturn(StateInfo, false);
+
+	const bool bEvaluatesTransitions = NetMode != EMachineNetMode::Synchronized || FNetworkUtility::HasAuthority(this);
+	return (StateInfo->State->NeedsTick() && (bEvaluatesTransitions || bValidClientState))
+		|| (bEvaluatesTransitions && StateInfo->bHasPolledTransitions)
+		|| GetNextTriggerTime() <= GetTime();
+}
+
+double UFSM::GetNextTriggerTime()
+{
+	double WakeTime = FFSMLocal::NEVER;
+	if (NetMode == EMachineNetMode::Synchronized && !FNetworkUtility::HasAuthority(this))
+		return WakeTime;
+	FStateInfo* StateInfo = FindState(CurrentStateID);
+	VSPCheckReturn(StateInfo, WakeTime);
+
+	for (TTuple<int8, FTransition*> const& Transition : StateInfo->Transitions)
+	{
+		FTransition const* It = Transition.Get<1>();
+		if (It->Trigger == FTransition::ETrigger::Delay)
+			WakeTime = FMath::Min(WakeTime, StateEnterTime + It->TriggerSeconds);
+		else if (It->Trigger == FTransition::ETrigger::PollInterval)
+			WakeTime = FMath::Min(WakeTime, It->NextPollTime);
+	}
+	return WakeTime;
+}
+
+void UFSM::Sleep(double WakeTime)
+{
+	UFSMTickSubsystem* TickSubsystem = GetTickSubsystem();
+	// nothing to wake it up, keeps ticking
+	if (!TickSubsystem)
+		return;
+
+	if (!bSleeping)
+	{
+		if (BatchedTickIndex != INDEX_NONE)
+			TickSubsystem->Unregister(this);
+		// a component tick with prerequisites orders more than the machine, it stays on
+		else if (IsComponentTickEnabled() && PrimaryComponentTick.GetPrerequisites().Num() == 0)
+		{
+			SetComponentTickEnabled(false);
+			bSleepDisabledTick = true;
+		}
+		bSleeping = true;
+	}
+	++WakeTicket;
+	if (WakeTime != FFSMLocal::NEVER)
+		TickSubsystem->ScheduleWakeUp(this, WakeTime, WakeTicket);
+}
+
+void UFSM::WakeUp()
+{
+	if (!bSleeping || !NeedsTick())
+		return;
+	bSleeping = false;
+	++WakeTicket;
+
+	if (bSleepDisabledTick)
+	{
+		bSleepDisabledTick = false;
+		SetComponentTickEnabled(true);
+	}
+
+	// batched machines rejoin their batch
+	UFSMTickSubsystem* TickSubsystem = bBatchedTick ? GetTickSubsystem() : nullptr;
+	if (TickSubsystem && BatchedTickIndex == INDEX_NONE && !IsComponentTickEnabled())
+		TickSubsystem->Register(this);
+}
+
+double UFSM::GetTime() const
+{
+	UWorld const* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+UFSMTickSubsystem* UFSM::GetTickSubsystem() const
+{
+	return UWorld::GetSubsystem<UFSMTickSubsystem>(GetWorld());
+}
+
+void UFSM::BeginState(int8 StateID, bool bReplicated)
+{
+	FStateInfo* StateInfo = FindState(StateID);
+	VSPCheckReturn(StateInfo);
+	StateInfo->State->Begin(bReplicated);
 	CurrentStateID = StateID;
 	bValidClientState = true;
+	OnStateEntered();
+	ScheduleWakeUp();
 }
 
 void UFSM::EndState(int8 StateID)
 {
-	FStateInfo* StateInfo = States.Find(StateID);
+	FStateInfo* StateInfo = FindState(StateID);
 	VSPCheckReturn(StateInfo);
 	VSPCheck(bValidClientState);
 	StateInfo->State->End();
 	bValidClientState = false;
+	ScheduleWakeUp();
 }
 
-void UFSM::SwitchState(int8 StateID)
+void UFSM::SwitchState(int8 StateID, bool bReplicated)
 {
-	FStateInfo* StateInfo = States.Find(CurrentStateID);
+	FStateInfo* StateInfo = FindState(CurrentStateID);
 	VSPCheckReturn(StateInfo);
 	if (bValidClientState)
 		StateInfo->State->End();
 	CurrentStateID = StateID;
+	OnStateEntered();
 
-	StateInfo = States.Find(StateID);
+	StateInfo = FindState(StateID);
 	VSPCheckReturn(StateInfo);
-	StateInfo->State->Begin(false);
+	StateInfo->State->Begin(bReplicated);
 
 	bValidClientState = true;
+	ScheduleWakeUp();
 }
 
 void UFSM::CacheTransitionWhileSuspended(int8 ToStateID, ETransitionType TransitionType)
@@ -371,8 +623,60 @@ void UFSM::NetMulticastSwitchState_Implementation(int8 StateID)
 }
 
 
+void UFSM::UpdateReplicatedState()
+{
+	FStateInfo* StateInfo = FindState(CurrentStateID);
+	VSPCheckReturn(StateInfo);
+	const EStateNetMode StateNetMode = StateInfo->State->NetMode;
+	const int8 OwnerStateID = StateNetMode != EStateNetMode::None ? CurrentStateID : FFSMLocal::INVALID_STATE_ID;
+	const int8 SharedStateID = StateNetMode == EStateNetMode::AllClients ? CurrentStateID : FFSMLocal::INVALID_STATE_ID;
+
+	// re-entering a visible state changes the sequence only, so clients re-enter it too
+	if (OwnerStateID != FFSMLocal::INVALID_STATE_ID || OwnerReplicatedState.StateID != FFSMLocal::INVALID_STATE_ID)
+	{
+		OwnerReplicatedState.StateID = OwnerStateID;
+		++OwnerReplicatedState.Sequence;
+	}
+	if (SharedStateID != FFSMLocal::INVALID_STATE_ID || SharedReplicatedState.StateID != FFSMLocal::INVALID_STATE_ID)
+	{
+		SharedReplicatedState.StateID = SharedStateID;
+		++SharedReplicatedState.Sequence;
+	}
+}
+
+void UFSM::ApplyReplicatedState()
+{
+	FFSMReplicatedState const& ReplicatedState = GetClientReplicatedState();
+	if (!HasBegunPlay() || FNetworkUtility::HasAuthority(this) || ReplicatedState.Sequence == AppliedSequence)
+		return;
+	// applied on resume
+	if (bTransitionsSuspended)
+		return;
+
+	AppliedSequence = ReplicatedState.Sequence;
+	const bool bVisibleState = ReplicatedState.StateID != FFSMLocal::INVALID_STATE_ID;
+	if (bValidClientState && bVisibleState)
+		SwitchState(ReplicatedState.StateID, true);
+	else if (bValidClientState)
+		EndState(CurrentStateID);
+	else if (bVisibleState)
+		BeginState(ReplicatedState.StateID, true);
+}
+
+FFSMReplicatedState const& UFSM::GetClientReplicatedState() const
+{
+	return FNetworkUtility::IsClientOwnership(this) ? OwnerReplicatedState : SharedReplicatedState;
+}
+
+void UFSM::OnRep_ReplicatedState()
+{
+	ApplyReplicatedState();
+}
+
 void UFSM::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	DOREPLIFETIME_CONDITION(UFSM, CurrentStateID, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(UFSM, OwnerReplicatedState, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UFSM, SharedReplicatedState, COND_SkipOwner);
 }
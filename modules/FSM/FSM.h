@@ -23,6 +23,24 @@
 #include "FSM.generated.h"
 
 
+//--------------------------------------------------------
+//--------------------------------------------------------
+
+// state of a synchronized UFSM as seen by a client, the sequence changes with every transition the client has to see
+// (32 bits: a client only compares it for equality, a smaller counter could wrap back to the applied value between two updates)
+USTRUCT()
+struct FFSMReplicatedState
+{
+	UPROPERTY()
+	int8 StateID = 0;
+
+	UPROPERTY()
+	uint32 Sequence = 0;
+
+	GENERATED_BODY()
+};
+
+
 //--------------------------------------------------------
 //--------------------------------------------------------
 
@@ -96,6 +114,17 @@ public:
 
 	void ManualTick(float DeltaTime);
 
+	// opt-in: tick with all the other batched machines of the world in UFSMTickSubsystem instead of an own component tick,
+	// thread-safe machines have their state and transitions ticked in parallel (transitions themselves are applied on the game thread)
+	void EnableBatchedTick(bool bThreadSafe = false);
+
+	// checks the transitions of the current state waiting for this signal, see FTransition::SetSignal
+	void Signal(FName SignalName);
+
+	// opt-in for synchronized machines: the state replicates as a property instead of a reliable RPC per transition,
+	// clients only see the latest state (intermediate transitions are coalesced) and End/Begin it on change
+	void EnableReplicatedState();
+
 	void SuspendTransitions();
 	void ResumeTransitions();
 
@@ -117,21 +146,44 @@ private:
 
 	struct FStateInfo
 	{
-		FState* State;
+		FState* State = nullptr;
 		TArray<TTuple<int8, FTransition*>, TInlineAllocator<8> > Transitions;
+		bool bHasPolledTransitions = false; // set on BeginPlay
 	};
 
+	FStateInfo* FindState(int8 StateID);
+
 	EMachineNetMode NetMode;
-	TMap<int8, FStateInfo> States;
+	// indexed by StateID - FirstStateID, State is null for the ids without a state
+	TArray<FStateInfo> States;
+	int8 FirstStateID = 0;
 
 	UPROPERTY(Replicated)
 	int8 CurrentStateID;
 	bool bValidClientState;
 
 	void TickState(float DeltaTime);
-	void BeginState(int8 StateID);
+	// ticks the current state, true with the state its first passing transition leads to if any, doesn't switch to it
+	bool EvaluateState(float DeltaTime, int8& OutToStateID);
+	// switches to the state EvaluateState passed, or puts the machine to sleep if nothing is due before a trigger
+	void CompleteTick(bool bTransitionPassed, int8 ToStateID);
+
+	// triggers of the current state start over
+	void OnStateEntered();
+	// ticks every frame while the current state or one of its transitions needs it, sleeps until the next trigger otherwise
+	void ScheduleWakeUp();
+	// the current state or one of its transitions has work this frame
+	bool NeedsTick();
+	// earliest delay or poll interval trigger of the current state, signals wake the machine up on their own
+	double GetNextTriggerTime();
+	void Sleep(double WakeTime);
+	void WakeUp();
+	double GetTime() const;
+	class UFSMTickSubsystem* GetTickSubsystem() const;
+	// bReplicated is passed on to FState::Begin, true when applying a replicated state
+	void BeginState(int8 StateID, bool bReplicated = false);
 	void EndState(int8 StateID);
-	void SwitchState(int8 StateID);
+	void SwitchState(int8 StateID, bool bReplicated = false);
 
 	UFUNCTION(Client, Reliable)
 	void ClientBeginState(int8 StateID);
@@ -151,6 +203,24 @@ private:
 	UFUNCTION(NetMulticast, Reliable)
 	void NetMulticastSwitchState(int8 StateID);
 
+	// server side, after a transition
+	void UpdateReplicatedState();
+	// client side, ends and begins states up to the replicated one
+	void ApplyReplicatedState();
+	FFSMReplicatedState const& GetClientReplicatedState() const;
+
+	UFUNCTION()
+	void OnRep_ReplicatedState();
+
+	// OwnClient and AllClients states for the owning client, AllClients states only for the other ones
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedState)
+	FFSMReplicatedState OwnerReplicatedState;
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedState)
+	FFSMReplicatedState SharedReplicatedState;
+
+	bool bReplicatedState = false;
+	uint32 AppliedSequence = 0; // client side, sequence of the replicated state begun last
+
 	enum class ETransitionType : uint8
 	{
 		Undefined,
@@ -174,7 +244,19 @@ private:
 	FString DebugStateMachineName;
 	TMap<int8, FString> DebugStateNames;
 
+	bool bBatchedTick = false;
+	bool bThreadSafeTick = false;
+	int32 BatchedTickIndex = INDEX_NONE;
+
+	bool bAutoTick = false; // ticked by its component or UFSMTickSubsystem, manually ticked machines never sleep
+	bool bSleeping = false; // no state work, an unbatched component tick without prerequisites is turned off too
+	bool bSleepDisabledTick = false; // the component tick was turned off by Sleep, WakeUp turns it back on
+	uint32 WakeTicket = 0; // wake-ups scheduled with an older ticket are void
+	double StateEnterTime = 0.0;
+
 	friend class UAutomationUtils;
+	friend class FFSMTestAccess;
+	friend class UFSMTickSubsystem;
 
 	GENERATED_BODY()
 };
@@ -219,6 +301,8 @@ protected:
 	virtual void Begin(bool bReplicated) = 0;
 	virtual void End() = 0;
 	virtual void Tick(float DeltaTime) = 0;
+	// false lets the machine sleep in this state until one of its transitions is due
+	virtual bool NeedsTick() const;
 
 	friend UFSM;
 };
@@ -227,11 +311,37 @@ protected:
 //--------------------------------------------------------
 //--------------------------------------------------------
 
+// A transition is polled on every tick unless it opts in for a trigger (before BeginPlay).
+// Triggered transitions without a predicate pass as soon as they are triggered.
 class UFSM::FTransition
 {
+public:
+	// checked once its state has been current for Seconds, then polled
+	void SetDelay(float Seconds);
+	// checked only when UFSM::Signal(SignalName) is called
+	void SetSignal(FName SignalName);
+	// polled every Seconds instead of every tick
+	void SetPollInterval(float Seconds);
+
 protected:
 	virtual bool Tick() const = 0;
 
+	bool IsPolled() const;
+
+private:
+	enum class ETrigger : uint8
+	{
+		Polled,
+		Delay,
+		Signal,
+		PollInterval
+	};
+
+	ETrigger Trigger = ETrigger::Polled;
+	float TriggerSeconds = 0.f;
+	FName TriggerSignal;
+	double NextPollTime = 0.0;
+
 	friend UFSM;
 };
 
@@ -267,6 +377,7 @@ protected:
 	virtual void Begin(bool bReplicated) override;
 	virtual void End() override;
 	virtual void Tick(float DeltaTime) override;
+	virtual bool NeedsTick() const override;
 
 private:
 	FMethod BeginMethod;
@@ -305,6 +416,42 @@ inline UFSM::FState::FState() : NetMode(UFSM::EStateNetMode::None)
 }
 
 
+inline bool UFSM::FState::NeedsTick() const
+{
+	return true;
+}
+
+
+//--------------------------------------------------------
+//--------------------------------------------------------
+
+inline void UFSM::FTransition::SetDelay(float Seconds)
+{
+	Trigger = ETrigger::Delay;
+	TriggerSeconds = Seconds;
+}
+
+
+inline void UFSM::FTransition::SetSignal(FName SignalName)
+{
+	Trigger = ETrigger::Signal;
+	TriggerSignal = SignalName;
+}
+
+
+inline void UFSM::FTransition::SetPollInterval(float Seconds)
+{
+	Trigger = ETrigger::PollInterval;
+	TriggerSeconds = Seconds;
+}
+
+
+inline bool UFSM::FTransition::IsPolled() const
+{
+	return Trigger == ETrigger::Polled;
+}
+
+
 //--------------------------------------------------------
 //--------------------------------------------------------
 
@@ -379,6 +526,13 @@ void UFSM::TState<FOwnerClass>::Tick(float DeltaTime)
 }
 
 
+template<class FOwnerClass>
+bool UFSM::TState<FOwnerClass>::NeedsTick() const
+{
+	return TickMethod != nullptr;
+}
+
+
 //--------------------------------------------------------
 //--------------------------------------------------------
 
@@ -400,5 +554,5 @@ inline void UFSM::TTransition<FOwnerClass>::Init(FOwnerClass* Owner, FTickMethod
 template<class FOwnerClass>
 bool UFSM::TTransition<FOwnerClass>::Tick() const
 {
-	return TickMethod ? (Object->*TickMethod)() : false;
+	return TickMethod ? (Object->*TickMethod)() : !IsPolled();
 }
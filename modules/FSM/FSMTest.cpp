@@ -0,0 +1,522 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "FSM.h"
+#include "FSMTickSubsystem.h"
+#include "VSPTests.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+
+// stands for the net driver: delivers what a server machine sends to the client machines
+class FFSMTestAccess
+{
+public:
+	// the replicated state properties, as a property update does
+	static void ReceiveReplicatedState(UFSM const* Server, UFSM* Client)
+	{
+		Client->OwnerReplicatedState = Server->OwnerReplicatedState;
+		Client->SharedReplicatedState = Server->SharedReplicatedState;
+		Client->OnRep_ReplicatedState();
+	}
+
+	static uint32 GetSequence(UFSM const* Server) { return Server->SharedReplicatedState.Sequence; }
+
+	static void ReceiveBeginState(UFSM* Client, int8 StateID) { Client->NetMulticastBeginState_Implementation(StateID); }
+	static void ReceiveEndState(UFSM* Client, int8 StateID) { Client->NetMulticastEndState_Implementation(StateID); }
+	static void ReceiveSwitchState(UFSM* Client, int8 StateID) { Client->NetMulticastSwitchState_Implementation(StateID); }
+};
+
+namespace FFSMTestLocal
+{
+	enum class EState : int8
+	{
+		Idle,
+		Counting,
+		Done
+	};
+
+	enum class ETickMode : uint8
+	{
+		Component,
+		Batched,
+		ThreadSafe,
+		Num
+	};
+
+	static TCHAR const* const TICK_MODE_NAMES[] = { TEXT("component"), TEXT("batched"), TEXT("thread-safe") };
+	static const FName RESTART_SIGNAL = TEXT("Restart");
+	static constexpr float DELTA_TIME = 1.f / 30.f;
+	static constexpr float IDLE_SECONDS = 0.2f;
+	static constexpr int32 COUNTING_TICKS = 5;
+	static constexpr int32 MACHINES_PER_ACTOR = 100;
+
+
+	// game world without a viewport nor a net driver, ticked by hand
+	class FTestWorld
+	{
+	public:
+		FTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("FSMTestWorld"));
+			GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+		}
+
+		~FTestWorld()
+		{
+			// machines end their state on EndPlay, before the world is gone
+			for (AActor* Actor : Actors)
+				Actor->Destroy();
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UWorld* Get() const { return World; }
+
+		AActor* SpawnActor()
+		{
+			return Actors.Add_GetRef(World->SpawnActor<AActor>());
+		}
+
+		void Tick(int32 Frames)
+		{
+			for (int32 Frame = 0; Frame < Frames; ++Frame)
+				World->Tick(LEVELTICK_All, DELTA_TIME);
+		}
+
+	private:
+		UWorld* World;
+		TArray<AActor*> Actors;
+	};
+
+
+	// Idle until a delay, Counting ticks until a polled transition passes, Done until the restart signal.
+	// Begin and End calls are traced, the trace must not depend on how the machine is ticked.
+	class FTestMachine
+	{
+	public:
+		FTestMachine(AActor* Owner, ETickMode TickMode, float InIdleSeconds = IDLE_SECONDS, int32 InCountingTicks = COUNTING_TICKS)
+			: IdleSeconds(InIdleSeconds)
+			, CountingTicks(InCountingTicks)
+		{
+			IdleState.Init(this, &FTestMachine::BeginIdle, &FTestMachine::EndIdle, nullptr, UFSM::EStateNetMode::None);
+			CountingState.Init(
+				this,
+				&FTestMachine::BeginCounting,
+				&FTestMachine::EndCounting,
+				&FTestMachine::TickCounting,
+				UFSM::EStateNetMode::None);
+			DoneState.Init(this, &FTestMachine::BeginDone, &FTestMachine::EndDone, nullptr, UFSM::EStateNetMode::None);
+			StartTransition.Init(this, nullptr);
+			StartTransition.SetDelay(IdleSeconds);
+			DoneTransition.Init(this, &FTestMachine::IsCountingDone);
+			RestartTransition.Init(this, nullptr);
+			RestartTransition.SetSignal(RESTART_SIGNAL);
+
+			Machine = NewObject<UFSM>(Owner);
+			Machine->AddState(EState::Idle, &IdleState);
+			Machine->AddState(EState::Counting, &CountingState);
+			Machine->AddState(EState::Done, &DoneState);
+			Machine->AddTransition(EState::Idle, EState::Counting, &StartTransition);
+			Machine->AddTransition(EState::Counting, EState::Done, &DoneTransition);
+			Machine->AddTransition(EState::Done, EState::Idle, &RestartTransition);
+			Machine->InitConstructor(UFSM::EMachineNetMode::None, EState::Idle);
+			if (TickMode != ETickMode::Component)
+				Machine->EnableBatchedTick(TickMode == ETickMode::ThreadSafe);
+			// begins play, the owner already has
+			Machine->RegisterComponent();
+		}
+
+		~FTestMachine()
+		{
+			if (IsValid(Machine))
+				Machine->DestroyComponent();
+		}
+
+		UFSM* GetMachine() const { return Machine; }
+		FString const& GetTrace() const { return Trace; }
+		int32 GetTotalTicks() const { return TotalTicks; }
+		bool HasStartedEarly() const { return bStartedEarly; }
+
+	private:
+		void BeginIdle()
+		{
+			Trace += TEXT("+I");
+			IdleEnterTime = Machine->GetWorld()->GetTimeSeconds();
+		}
+
+		void EndIdle() { Trace += TEXT("-I"); }
+
+		void BeginCounting()
+		{
+			Trace += TEXT("+C");
+			Ticks = 0;
+			bStartedEarly |= Machine->GetWorld()->GetTimeSeconds() - IdleEnterTime < IdleSeconds - KINDA_SMALL_NUMBER;
+		}
+
+		void EndCounting() { Trace += TEXT("-C"); }
+
+		// on a worker thread for thread-safe machines, touches this machine only
+		void TickCounting(float DeltaTime)
+		{
+			++Ticks;
+			++TotalTicks;
+		}
+
+		bool IsCountingDone() const { return Ticks >= CountingTicks; }
+
+		void BeginDone() { Trace += TEXT("+D"); }
+
+		void EndDone() { Trace += TEXT("-D"); }
+
+		UFSM* Machine;
+		UFSM::TState<FTestMachine> IdleState;
+		UFSM::TState<FTestMachine> CountingState;
+		UFSM::TState<FTestMachine> DoneState;
+		UFSM::TTransition<FTestMachine> StartTransition;
+		UFSM::TTransition<FTestMachine> DoneTransition;
+		UFSM::TTransition<FTestMachine> RestartTransition;
+
+		const float IdleSeconds;
+		const int32 CountingTicks;
+		FString Trace;
+		double IdleEnterTime = 0.0;
+		int32 Ticks = 0;
+		int32 TotalTicks = 0;
+		bool bStartedEarly = false;
+	};
+
+
+	enum class ENetState : int8
+	{
+		A,
+		B,
+		C,
+		Hidden,
+		Num
+	};
+
+	class FNetMachine;
+
+	// appends its name to the trace of its machine on Begin and End
+	struct FTracedState
+	{
+		FNetMachine* Machine = nullptr;
+		TCHAR Name = 0;
+
+		void Begin(bool bReplicated);
+		void End();
+	};
+
+	// synchronized machine with three states seen by all clients and a server-only one, transitions are forced
+	class FNetMachine
+	{
+	public:
+		FNetMachine(AActor* Owner, bool bReplicatedState)
+		{
+			static TCHAR const NAMES[] = { 'A', 'B', 'C', 'H' };
+			Machine = NewObject<UFSM>(Owner);
+			for (int32 Index = 0; Index < static_cast<int32>(ENetState::Num); ++Index)
+			{
+				TracedStates[Index].Machine = this;
+				TracedStates[Index].Name = NAMES[Index];
+				const bool bHidden = Index == static_cast<int32>(ENetState::Hidden);
+				States[Index].InitNet(
+					&TracedStates[Index],
+					&FTracedState::Begin,
+					&FTracedState::End,
+					nullptr,
+					bHidden ? UFSM::EStateNetMode::None : UFSM::EStateNetMode::AllClients);
+				Machine->AddState(static_cast<ENetState>(Index), &States[Index]);
+			}
+			Machine->InitConstructor(UFSM::EMachineNetMode::Synchronized, ENetState::A, true);
+			if (bReplicatedState)
+				Machine->EnableReplicatedState();
+		}
+
+		~FNetMachine()
+		{
+			if (IsValid(Machine))
+				Machine->DestroyComponent();
+		}
+
+		// begins play, the owner already has
+		void Register() { Machine->RegisterComponent(); }
+
+		UFSM* GetMachine() const { return Machine; }
+		FString const& GetTrace() const { return Trace; }
+		// name of the state begun last, 0 once it ended
+		TCHAR GetCurrentState() const { return CurrentState; }
+		// as seen by the clients
+		TCHAR GetVisibleState() const { return CurrentState == 'H' ? 0 : CurrentState; }
+		bool HasBegunReplicatedOnly() const { return bBegunReplicatedOnly; }
+
+	private:
+		UFSM* Machine;
+		FTracedState TracedStates[static_cast<int32>(ENetState::Num)];
+		UFSM::TState<FTracedState> States[static_cast<int32>(ENetState::Num)];
+
+		FString Trace;
+		TCHAR CurrentState = 0;
+		bool bBegunReplicatedOnly = true;
+
+		friend FTracedState;
+	};
+
+	void FTracedState::Begin(bool bReplicated)
+	{
+		Machine->Trace.AppendChar('+');
+		Machine->Trace.AppendChar(Name);
+		Machine->CurrentState = Name;
+		Machine->bBegunReplicatedOnly &= bReplicated;
+	}
+
+	void FTracedState::End()
+	{
+		Machine->Trace.AppendChar('-');
+		Machine->Trace.AppendChar(Name);
+		Machine->CurrentState = 0;
+	}
+
+
+	void AddMachines(
+		FTestWorld& World,
+		ETickMode TickMode,
+		int32 Num,
+		TArray<TUniquePtr<FTestMachine> >& OutMachines,
+		float IdleSeconds = IDLE_SECONDS,
+		int32 CountingTicks = COUNTING_TICKS)
+	{
+		AActor* Owner = nullptr;
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			if (Index % MACHINES_PER_ACTOR == 0)
+				Owner = World.SpawnActor();
+			OutMachines.Add(MakeUnique<FTestMachine>(Owner, TickMode, IdleSeconds, CountingTicks));
+		}
+	}
+
+	double TimeFrames(FTestWorld& World, int32 Frames)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		World.Tick(Frames);
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0 / Frames;
+	}
+}
+
+
+VSP_TEST(FSM, BatchedTick, TestsFlags)
+{
+	using namespace FFSMTestLocal;
+
+	// more than the thread-safe machines ticked on the game thread, they go parallel
+	static constexpr int32 MachinesNum = 100;
+	// the idle delay, woken up by the timing wheel, then the counting ticks
+	static constexpr int32 FramesToDone = 30;
+
+	FTestWorld World;
+	TArray<TUniquePtr<FTestMachine> > Machines[static_cast<int32>(ETickMode::Num)];
+	for (int32 Mode = 0; Mode < static_cast<int32>(ETickMode::Num); ++Mode)
+		AddMachines(World, static_cast<ETickMode>(Mode), MachinesNum, Machines[Mode]);
+
+	World.Tick(FramesToDone);
+	for (TArray<TUniquePtr<FTestMachine> > const& ModeMachines : Machines)
+	{
+		for (TUniquePtr<FTestMachine> const& It : ModeMachines)
+			It->GetMachine()->Signal(RESTART_SIGNAL);
+	}
+	World.Tick(FramesToDone);
+
+	// same states begun and ended in the same order, each counting state ticked as often, never out of the delay early
+	for (int32 Mode = 0; Mode < static_cast<int32>(ETickMode::Num); ++Mode)
+	{
+		int32 Mismatches = 0;
+		for (TUniquePtr<FTestMachine> const& It : Machines[Mode])
+		{
+			if (It->GetTrace() != TEXT("+I-I+C-C+D-D+I-I+C-C+D") || It->GetTotalTicks() != 2 * COUNTING_TICKS
+				|| It->HasStartedEarly())
+				++Mismatches;
+		}
+		if (Mismatches > 0)
+			AddError(FString::Printf(TEXT("%d %s machines out of %d differ"), Mismatches, TICK_MODE_NAMES[Mode], MachinesNum));
+	}
+
+	// the batches only hold the machines with work, the ones done sleep
+	UFSMTickSubsystem* TickSubsystem = World.Get()->GetSubsystem<UFSMTickSubsystem>();
+	VSP_EXPECT_TRUE(TickSubsystem != nullptr);
+	if (TickSubsystem)
+		VSP_EXPECT_TRUE(!TickSubsystem->IsTickable());
+
+	return true;
+}
+
+VSP_TEST(FSM, TickBenchmark, BenchmarkFlags)
+{
+	using namespace FFSMTestLocal;
+
+	static constexpr int32 MachinesNum = 10000;
+	static constexpr int32 Frames = 100;
+
+	double EmptyFrameTime;
+	{
+		FTestWorld World;
+		EmptyFrameTime = TimeFrames(World, Frames);
+	}
+
+	for (int32 Mode = 0; Mode < static_cast<int32>(ETickMode::Num); ++Mode)
+	{
+		// counting all along, ticked every frame
+		double BusyFrameTime;
+		{
+			FTestWorld World;
+			TArray<TUniquePtr<FTestMachine> > Machines;
+			AddMachines(World, static_cast<ETickMode>(Mode), MachinesNum, Machines, 0.f, MAX_int32);
+			World.Tick(1);
+			BusyFrameTime = TimeFrames(World, Frames);
+		}
+
+		// idle for longer than the benchmark, asleep
+		double IdleFrameTime;
+		{
+			FTestWorld World;
+			TArray<TUniquePtr<FTestMachine> > Machines;
+			AddMachines(World, static_cast<ETickMode>(Mode), MachinesNum, Machines, 1000.f);
+			World.Tick(1);
+			IdleFrameTime = TimeFrames(World, Frames);
+		}
+
+		AddInfo(FString::Printf(
+			TEXT("%d %s machines: %.3f ms per frame ticking, %.3f ms asleep (empty world %.3f ms)"),
+			MachinesNum,
+			TICK_MODE_NAMES[Mode],
+			BusyFrameTime,
+			IdleFrameTime,
+			EmptyFrameTime));
+	}
+
+	return true;
+}
+
+VSP_TEST(FSM, ReplicatedState, TestsFlags)
+{
+	using namespace FFSMTestLocal;
+
+	FTestWorld World;
+	// the world has no net driver, the clients are simulated proxies of the same world
+	AActor* ClientOwner = World.SpawnActor();
+	ClientOwner->SetRole(ROLE_SimulatedProxy);
+	FNetMachine Server(World.SpawnActor(), true);
+	FNetMachine RpcClient(ClientOwner, false);
+	FNetMachine ReplicatedClient(ClientOwner, true);
+
+	int32 Transitions = 0;
+	int32 Rpcs = 0;
+	int32 PropertyUpdates = 0;
+	uint32 SentSequence = 0;
+	auto Transition = [&](ENetState ToState, bool bReEnter = false)
+	{
+		Server.GetMachine()->ForceTransition(ToState, bReEnter);
+		++Transitions;
+	};
+	// the RPC the server machine sends for the transition, all the visible states are seen by all clients
+	auto SendRpc = [&](void (*Receive)(UFSM*, int8), ENetState State)
+	{
+		Receive(RpcClient.GetMachine(), static_cast<int8>(State));
+		++Rpcs;
+	};
+	// end of a server frame, the changed properties are sent
+	auto SendProperties = [&]()
+	{
+		const uint32 Sequence = FFSMTestAccess::GetSequence(Server.GetMachine());
+		if (Sequence == SentSequence)
+			return;
+		SentSequence = Sequence;
+		FFSMTestAccess::ReceiveReplicatedState(Server.GetMachine(), ReplicatedClient.GetMachine());
+		++PropertyUpdates;
+	};
+	auto ExpectClientsInSync = [&]()
+	{
+		VSP_EXPECT_EQ(RpcClient.GetCurrentState(), Server.GetVisibleState());
+		VSP_EXPECT_EQ(ReplicatedClient.GetCurrentState(), Server.GetVisibleState());
+	};
+
+	// the initial replication comes before BeginPlay
+	Server.Register();
+	SendProperties();
+	RpcClient.Register();
+	ReplicatedClient.Register();
+	ExpectClientsInSync();
+
+	Transition(ENetState::B);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::B);
+	SendProperties();
+	ExpectClientsInSync();
+
+	// transitions of a frame are coalesced
+	Transition(ENetState::C);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::C);
+	Transition(ENetState::A);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::A);
+	SendProperties();
+	ExpectClientsInSync();
+
+	// to the server-only state and back
+	Transition(ENetState::Hidden);
+	SendRpc(&FFSMTestAccess::ReceiveEndState, ENetState::A);
+	SendProperties();
+	ExpectClientsInSync();
+	Transition(ENetState::B);
+	SendRpc(&FFSMTestAccess::ReceiveBeginState, ENetState::B);
+	SendProperties();
+	ExpectClientsInSync();
+
+	Transition(ENetState::B, true);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::B);
+	SendProperties();
+	ExpectClientsInSync();
+
+	// received while suspended, applied on resume
+	RpcClient.GetMachine()->SuspendTransitions();
+	ReplicatedClient.GetMachine()->SuspendTransitions();
+	Transition(ENetState::C);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::C);
+	SendProperties();
+	Transition(ENetState::A);
+	SendRpc(&FFSMTestAccess::ReceiveSwitchState, ENetState::A);
+	SendProperties();
+	VSP_EXPECT_EQ(RpcClient.GetCurrentState(), TCHAR('B'));
+	VSP_EXPECT_EQ(ReplicatedClient.GetCurrentState(), TCHAR('B'));
+	RpcClient.GetMachine()->ResumeTransitions();
+	ReplicatedClient.GetMachine()->ResumeTransitions();
+	ExpectClientsInSync();
+
+	VSP_EXPECT_EQ(Server.GetTrace(), FString(TEXT("+A-A+B-B+C-C+A-A+H-H+B-B+B-B+C-C+A")));
+	VSP_EXPECT_EQ(RpcClient.GetTrace(), FString(TEXT("+A-A+B-B+C-C+A-A+B-B+B-B+C-C+A")));
+	// only the latest state of each update is begun, as a replicated one
+	VSP_EXPECT_EQ(ReplicatedClient.GetTrace(), FString(TEXT("+A-A+B-B+A-A+B-B+B-B+A")));
+	VSP_EXPECT_TRUE(ReplicatedClient.HasBegunReplicatedOnly());
+
+	AddInfo(FString::Printf(
+		TEXT("%d transitions: %d reliable RPCs, %d replicated state updates"), Transitions, Rpcs, PropertyUpdates));
+
+	return true;
+}
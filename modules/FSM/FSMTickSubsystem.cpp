@@ -0,0 +1,192 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "FSMTickSubsystem.h"
+#include "FSM.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/Actor.h"
+#include "VSPCheck.h"
+
+
+namespace FFSMTickSubsystemLocal
+{
+	// fewer thread-safe machines are ticked on the game thread, not worth the task overhead
+	static constexpr int32 MIN_PARALLEL_MACHINES = 64;
+
+	static constexpr int32 WHEEL_SLOTS = 256;
+	static constexpr double WHEEL_SLOT_SECONDS = 0.05;
+
+	float GetMachineDeltaTime(UFSM const* Machine, float DeltaTime)
+	{
+		// same as a component tick, scaled by the owner time dilation
+		AActor const* Owner = Machine->GetOwner();
+		return Owner ? DeltaTime * Owner->CustomTimeDilation : DeltaTime;
+	}
+}
+
+
+void UFSMTickSubsystem::Register(UFSM* Machine)
+{
+	VSPCheckReturn(Machine && Machine->BatchedTickIndex == INDEX_NONE);
+	Machine->BatchedTickIndex = GetBatch(Machine).Add(Machine);
+}
+
+void UFSMTickSubsystem::Unregister(UFSM* Machine)
+{
+	VSPCheckReturn(Machine && Machine->BatchedTickIndex != INDEX_NONE);
+	TArray<UFSM*>& Batch = GetBatch(Machine);
+	const int32 Index = Machine->BatchedTickIndex;
+	VSPCheckReturn(Batch.IsValidIndex(Index) && Batch[Index] == Machine);
+
+	Batch.RemoveAtSwap(Index, 1, false);
+	if (Batch.IsValidIndex(Index))
+		Batch[Index]->BatchedTickIndex = Index;
+	Machine->BatchedTickIndex = INDEX_NONE;
+}
+
+void UFSMTickSubsystem::ScheduleWakeUp(UFSM* Machine, double WakeTime, uint32 Ticket)
+{
+	VSPCheckReturn(Machine);
+	// never early, at the earliest on the next tick
+	const int64 EntryTick = FMath::Max(
+		static_cast<int64>(FMath::CeilToDouble(WakeTime / FFSMTickSubsystemLocal::WHEEL_SLOT_SECONDS)),
+		WheelTick + 1);
+	WheelSlots[EntryTick % FFSMTickSubsystemLocal::WHEEL_SLOTS].Add({ Machine, EntryTick, Ticket });
+	++WheelEntryCount;
+}
+
+void UFSMTickSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	WheelSlots.SetNum(FFSMTickSubsystemLocal::WHEEL_SLOTS);
+	WheelTick = 0;
+}
+
+void UFSMTickSubsystem::Deinitialize()
+{
+	for (UFSM* Machine : Machines)
+		Machine->BatchedTickIndex = INDEX_NONE;
+	for (UFSM* Machine : ThreadSafeMachines)
+		Machine->BatchedTickIndex = INDEX_NONE;
+	Machines.Empty();
+	ThreadSafeMachines.Empty();
+	WheelSlots.Empty();
+	WheelEntryCount = 0;
+	Super::Deinitialize();
+}
+
+void UFSMTickSubsystem::Tick(float DeltaTime)
+{
+	AdvanceWheel(GetWorld()->GetTimeSeconds());
+	TickThreadSafeMachines(DeltaTime);
+	TickMachines(DeltaTime);
+}
+
+ETickableTickType UFSMTickSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UFSMTickSubsystem::IsTickable() const
+{
+	return Machines.Num() > 0 || ThreadSafeMachines.Num() > 0 || WheelEntryCount > 0;
+}
+
+TStatId UFSMTickSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFSMTickSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UFSMTickSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TArray<UFSM*>& UFSMTickSubsystem::GetBatch(UFSM const* Machine)
+{
+	return Machine->bThreadSafeTick ? ThreadSafeMachines : Machines;
+}
+
+void UFSMTickSubsystem::AdvanceWheel(double Now)
+{
+	const int64 NowTick = static_cast<int64>(FMath::FloorToDouble(Now / FFSMTickSubsystemLocal::WHEEL_SLOT_SECONDS));
+	if (NowTick <= WheelTick)
+		return;
+
+	// a lap at most, every slot is visited once then
+	const int64 LastTick = FMath::Min(NowTick, WheelTick + FFSMTickSubsystemLocal::WHEEL_SLOTS);
+	DueMachines.Reset();
+	for (int64 SlotTick = WheelTick + 1; SlotTick <= LastTick; ++SlotTick)
+	{
+		TArray<FWheelEntry>& Slot = WheelSlots[SlotTick % FFSMTickSubsystemLocal::WHEEL_SLOTS];
+		for (int32 Index = Slot.Num() - 1; Index >= 0; --Index)
+		{
+			FWheelEntry const& Entry = Slot[Index];
+			UFSM* Machine = Entry.Machine.Get();
+			const bool bStale = !Machine || Machine->WakeTicket != Entry.Ticket;
+			if (!bStale && Entry.WheelTick > NowTick)
+				continue;
+
+			if (!bStale)
+				DueMachines.Add(Machine);
+			Slot.RemoveAtSwap(Index, 1, false);
+			--WheelEntryCount;
+		}
+	}
+	WheelTick = NowTick;
+
+	// waking up registers batched machines, they are ticked this frame
+	for (UFSM* Machine : DueMachines)
+		Machine->WakeUp();
+}
+
+void UFSMTickSubsystem::TickMachines(float DeltaTime)
+{
+	TickingMachines = Machines;
+	for (UFSM* Machine : TickingMachines)
+	{
+		if (Machine->BatchedTickIndex != INDEX_NONE)
+			Machine->TickState(FFSMTickSubsystemLocal::GetMachineDeltaTime(Machine, DeltaTime));
+	}
+}
+
+void UFSMTickSubsystem::TickThreadSafeMachines(float DeltaTime)
+{
+	TickingMachines = ThreadSafeMachines;
+	PendingTransitions.Reset();
+	PendingTransitions.SetNum(TickingMachines.Num());
+	ParallelFor(
+		TickingMachines.Num(),
+		[this, DeltaTime](int32 Index)
+		{
+			UFSM* Machine = TickingMachines[Index];
+			FPendingTransition& Transition = PendingTransitions[Index];
+			Transition.FromStateID = Machine->CurrentStateID;
+			Transition.bPending =
+				Machine->EvaluateState(FFSMTickSubsystemLocal::GetMachineDeltaTime(Machine, DeltaTime), Transition.ToStateID);
+		},
+		TickingMachines.Num() < FFSMTickSubsystemLocal::MIN_PARALLEL_MACHINES);
+
+	// transitions begin and end states and send RPCs, sleeping does (un)register, game thread only
+	for (int32 Index = 0; Index < TickingMachines.Num(); ++Index)
+	{
+		UFSM* Machine = TickingMachines[Index];
+		FPendingTransition const& Transition = PendingTransitions[Index];
+		// skips the machines that ended play, fell asleep or switched state (on a signal) since the evaluation
+		if (Machine->BatchedTickIndex != INDEX_NONE && Machine->CurrentStateID == Transition.FromStateID)
+			Machine->CompleteTick(Transition.bPending, Transition.ToStateID);
+	}
+}
@@ -0,0 +1,89 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "FSMTickSubsystem.generated.h"
+
+class UFSM;
+
+
+//--------------------------------------------------------
+//--------------------------------------------------------
+
+// Ticks the machines that opted in with UFSM::EnableBatchedTick, all in one tick instead of a component tick each.
+// Thread-safe machines evaluate their state in parallel, the transitions they pass are then applied on the game thread.
+// Also wakes up the sleeping machines (any tick mode) when their next transition trigger is due, see UFSM::FTransition.
+UCLASS()
+class PROJECTVSP_API UFSMTickSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+public:
+	void Register(UFSM* Machine);
+	void Unregister(UFSM* Machine);
+	// wakes the machine up at WakeTime (world time) unless its wake ticket changed meanwhile
+	void ScheduleWakeUp(UFSM* Machine, double WakeTime, uint32 Ticket);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+private:
+	struct FPendingTransition
+	{
+		int8 FromStateID = 0;
+		int8 ToStateID = 0;
+		bool bPending = false;
+	};
+
+	struct FWheelEntry
+	{
+		TWeakObjectPtr<UFSM> Machine;
+		int64 WheelTick = 0;
+		uint32 Ticket = 0;
+	};
+
+	TArray<UFSM*>& GetBatch(UFSM const* Machine);
+	void AdvanceWheel(double Now);
+	void TickMachines(float DeltaTime);
+	void TickThreadSafeMachines(float DeltaTime);
+
+	// dense, UFSM::BatchedTickIndex is the index in its array, a removed machine is replaced by the last one
+	UPROPERTY(Transient)
+	TArray<UFSM*> Machines;
+	UPROPERTY(Transient)
+	TArray<UFSM*> ThreadSafeMachines;
+
+	// machines ticked this frame, the ones ending play meanwhile are unregistered and skipped
+	TArray<UFSM*> TickingMachines;
+	TArray<FPendingTransition> PendingTransitions;
+
+	// timing wheel, a slot per wheel tick modulo the slot count, entries due a lap later stay in their slot
+	TArray<TArray<FWheelEntry> > WheelSlots;
+	int64 WheelTick = 0; // last processed wheel tick
+	int32 WheelEntryCount = 0;
+	TArray<UFSM*> DueMachines;
+
+	GENERATED_BODY()
+};
@@ -15,6 +15,8 @@
 */ 
 
 #include "FXContainerTypes.h"
+#include "FXDynamicUpdateSubsystem.h"
+#include "FXSpawnBatchSubsystem.h"
 #include "FXSpawnLibrary.h"
 
 #include "Particles/ParticleSystemComponent.h"
@@ -49,6 +51,8 @@ void FFXComponentContainer::ReleaseToPool()
 		UFXSystemComponent*& FXComponent = *It;
 		if (IsValid(FXComponent))
 		{
+			UFXSpawnBatchSubsystem::CancelActivation(FXComponent);
+			UFXDynamicUpdateSubsystem::UnregisterFromWorld(FXComponent);
 			FXComponent->ReleaseToPool();
 		}
 	}
@@ -63,6 +67,7 @@ void FFXComponentContainer::Deactivate()
 		UFXSystemComponent*& FXComponent = *It;
 		if (IsValid(FXComponent))
 		{
+			UFXSpawnBatchSubsystem::CancelActivation(FXComponent);
 			FXComponent->Deactivate();
 		}
 	}
@@ -77,6 +82,7 @@ void FFXComponentContainer::Destroy()
 		UFXSystemComponent*& FXComponent = *It;
 		if (IsValid(FXComponent))
 		{
+			UFXSpawnBatchSubsystem::CancelActivation(FXComponent);
 			FXComponent->DestroyComponent();
 		}
 	}
@@ -257,6 +263,7 @@ void FFXBeamContainer::ReleaseToPool()
 	{
 		if (BeamContext.FXComponent)
 		{
+			UFXDynamicUpdateSubsystem::UnregisterFromWorld(BeamContext.FXComponent);
 			BeamContext.FXComponent->ReleaseToPool();
 		}
 	}
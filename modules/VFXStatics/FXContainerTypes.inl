@@ -14,6 +14,8 @@
 * limitations under the License.
 */ 
 #pragma once
+#include "FXDynamicUpdateSubsystem.h"
+#include "FXSpawnBatchSubsystem.h"
 #include "Particles/ParticleSystemComponent.h"
 
 template<typename TComparisonType>
@@ -49,6 +51,8 @@ void FFXComponentContainer::RemoveFXComponents(TRemoveType const& InFXData)
 		{
 			if (InFXData == FXComponent->GetFXSystemAsset())
 			{
+				UFXSpawnBatchSubsystem::CancelActivation(FXComponent);
+				UFXDynamicUpdateSubsystem::UnregisterFromWorld(FXComponent);
 				FXComponent->ReleaseToPool();
 				It.RemoveCurrent();
 			}
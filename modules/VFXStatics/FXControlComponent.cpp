@@ -14,6 +14,8 @@
 * limitations under the License.
 */ 
 #include "FXControlComponent.h"
+#include "Algo/BinarySearch.h"
+#include "FXConfigTypes.h"
 #include "FXSpawnLibrary.h"
 #include "Particles/ParticleSystemComponent.h"
 
@@ -38,6 +40,7 @@ uint32 GetTypeHash(const UFXControlComponent::FFXLocationInfo& FXLocation)
 UFXControlComponent::FFXInfo::FFXInfo(uint8 EffectPriority, UFXSystemComponent* InFXComponent)
 	: EffectPriority(EffectPriority)
 	, FXComponent(InFXComponent)
+	, FXAsset(InFXComponent ? InFXComponent->GetFXSystemAsset() : nullptr)
 {
 }
 
@@ -46,39 +49,84 @@ bool UFXControlComponent::FFXInfo::IsValid() const
 	return FXComponent.IsValid() && FXComponent.Get()->IsActive() && FXCounter > 0;
 }
 
-void UFXControlComponent::EvaluateFXStack()
+void UFXControlComponent::EvaluateFXStack(FFXStack& FXStack)
 {
-	for (auto It = FXLocationToInfos.CreateIterator(); It; ++It)
+	if (FXStack.FXInfos.Num() == 0)
 	{
-		EvaluateFXStack(It.Value());
+		FXStack.VisiblePriority = INDEX_NONE;
+		return;
 	}
-}
-
-void UFXControlComponent::EvaluateFXStack(FFXStack& FXStack)
-{
-	check(FXStack.Num() != 0);
 
-	Algo::Sort(
-		FXStack,
-		[](const FFXInfo& Left, const FFXInfo& Right)
-		{
-			return Left.EffectPriority > Right.EffectPriority;
-		});
+	const uint8 MaxPriority = FXStack.FXInfos[0].EffectPriority;
+	if (FXStack.VisiblePriority == MaxPriority)
+	{
+		return;
+	}
+	FXStack.VisiblePriority = MaxPriority;
 
-	const uint8 MaxPriority = FXStack[0].EffectPriority;
-	for (FFXInfo FXInfo : FXStack)
+	for (FFXInfo const& FXInfo : FXStack.FXInfos)
 	{
 		if (!FXInfo.IsValid())
 		{
 			continue;
 		}
-		if (FXInfo.EffectPriority >= MaxPriority)
+		FXInfo.FXComponent->SetVisibility(FXInfo.EffectPriority >= MaxPriority, false);
+	}
+}
+
+void UFXControlComponent::RemoveFromStack(FFXStack& FXStack, int32 Index)
+{
+	const FObjectKey FXAsset = FXStack.FXInfos[Index].FXAsset;
+	if (TArray<FFXStack*, TInlineAllocator<2>>* FXStacks = FXAssetToStacks.Find(FXAsset))
+	{
+		FXStacks->RemoveSingleSwap(&FXStack, false);
+		if (FXStacks->Num() == 0)
 		{
-			FXInfo.FXComponent->SetVisibility(true, false);
+			FXAssetToStacks.Remove(FXAsset);
 		}
-		else
+	}
+	FXStack.FXInfos.RemoveAt(Index, 1, false);
+}
+
+void UFXControlComponent::DeactivateEffectInStacks(
+	UFXSystemAsset const* FXToDeactivate,
+	bool bReleaseToPool,
+	TArray<FFXStack*, TInlineAllocator<4>>* OutChangedStacks)
+{
+	const FObjectKey FXAsset(FXToDeactivate);
+	TArray<FFXStack*, TInlineAllocator<2>> const* FoundFXStacks = FXAssetToStacks.Find(FXAsset);
+	if (!FoundFXStacks)
+	{
+		return;
+	}
+
+	// Removing effects updates the index, and a stack is listed once per effect with this FX in it
+	TArray<FFXStack*, TInlineAllocator<4>> FXStacks;
+	for (FFXStack* FXStack : *FoundFXStacks)
+	{
+		FXStacks.AddUnique(FXStack);
+	}
+
+	for (FFXStack* FXStack : FXStacks)
+	{
+		for (int32 Index = FXStack->FXInfos.Num() - 1; Index >= 0; --Index)
 		{
-			FXInfo.FXComponent->SetVisibility(false, false);
+			FFXInfo& FXInfo = FXStack->FXInfos[Index];
+			if (FXInfo.FXAsset != FXAsset || !FXInfo.FXComponent.IsValid())
+			{
+				continue;
+			}
+
+			FXInfo.FXCounter--;
+			if (FXInfo.FXCounter == 0)
+			{
+				bReleaseToPool ? FXInfo.FXComponent->ReleaseToPool() : FXInfo.FXComponent->Deactivate();
+				RemoveFromStack(*FXStack, Index);
+				if (OutChangedStacks)
+				{
+					OutChangedStacks->AddUnique(FXStack);
+				}
+			}
 		}
 	}
 }
@@ -94,18 +142,19 @@ UFXSystemComponent* UFXControlComponent::TryIncreaseEffectsNum(
 	const FName& SocketName)
 {
 	FFXLocationInfo LocationInfo { SocketName, AttachToComponent };
-	FFXStack* FoundFXInfosPtr = FXLocationToInfos.Find(MoveTemp(LocationInfo));
-	if (FoundFXInfosPtr)
+	TUniquePtr<FFXStack>* FoundFXStackPtr = FXLocationToInfos.Find(MoveTemp(LocationInfo));
+	if (FoundFXStackPtr)
 	{
-		FFXStack& FXInfos = *FoundFXInfosPtr;
-		for (auto It = FXInfos.CreateIterator(); It; ++It)
+		FFXStack& FXStack = **FoundFXStackPtr;
+		for (int32 Index = 0; Index < FXStack.FXInfos.Num(); ++Index)
 		{
-			if (It->FXComponent.IsValid() && It->FXComponent->GetFXSystemAsset() == FX)
+			FFXInfo& FXInfo = FXStack.FXInfos[Index];
+			if (FXInfo.FXComponent.IsValid() && FXInfo.FXComponent->GetFXSystemAsset() == FX)
 			{
-				if (It->IsValid())
+				if (FXInfo.IsValid())
 				{
-					It->FXCounter++;
-					return It->FXComponent.Get();
+					FXInfo.FXCounter++;
+					return FXInfo.FXComponent.Get();
 				}
 
 				// Since tick interval may be greater than one frame, the situation is possible, were FX gone to be FreeInPool (means bIsActive == false),
@@ -113,7 +162,8 @@ UFXSystemComponent* UFXControlComponent::TryIncreaseEffectsNum(
 				// Then UFXControlComponent::AddEffectInSocket called and, due to pooling we have the same exact FX in our array as "newly" spawned one
 				// And we will not pass check for not containing FX to add, since we didn't tick yet, thus didn't have an opportunity to remove invalid FX
 				// To prevent this situations we want to remove invalid FX at this point
-				It.RemoveCurrent();
+				RemoveFromStack(FXStack, Index);
+				EvaluateFXStack(FXStack);
 				return nullptr;
 			}
 		}
@@ -129,92 +179,65 @@ void UFXControlComponent::AddEffectInSocket(
 	uint8 EffectPriority)
 {
 	FFXLocationInfo LocationInfo { SocketName, AttachToComponent };
-	FFXStack& FXInfos = FXLocationToInfos.FindOrAdd(MoveTemp(LocationInfo));
+	TUniquePtr<FFXStack>& FXStackPtr = FXLocationToInfos.FindOrAdd(MoveTemp(LocationInfo));
+	if (!FXStackPtr)
+	{
+		FXStackPtr = MakeUnique<FFXStack>();
+	}
+	FFXStack& FXStack = *FXStackPtr;
 
-	check(!FXInfos.Contains(FXComponent));
+	check(!FXStack.FXInfos.Contains(FXComponent));
 
-	FXInfos.Emplace(EffectPriority, FXComponent);
+	// After the effects with the same priority, so they keep the order they were added in
+	const int32 Index =
+		Algo::UpperBoundBy(FXStack.FXInfos, EffectPriority, &FFXInfo::EffectPriority, TGreater<>());
+	FXStack.FXInfos.EmplaceAt(Index, EffectPriority, FXComponent);
+	FXAssetToStacks.FindOrAdd(FXStack.FXInfos[Index].FXAsset).Add(&FXStack);
 
-	EvaluateFXStack(FXInfos);
-}
-
-void UFXControlComponent::DeactivateEffect(UFXSystemAsset const* FXToDeactivate, bool bReleaseToPool)
-{
-	for (auto LocationIt = FXLocationToInfos.CreateIterator(); LocationIt; ++LocationIt)
+	// The top priority didn't change, the others keep their visibility
+	if (FXStack.VisiblePriority == FXStack.FXInfos[0].EffectPriority)
 	{
-		for (auto FXIt = LocationIt.Value().CreateIterator(); FXIt; ++FXIt)
-		{
-			if (FXIt->FXComponent.IsValid() && FXIt->FXComponent.Get()->GetFXSystemAsset() == FXToDeactivate)
-			{
-				FXIt->FXCounter--;
-				if (FXIt->FXCounter == 0)
-				{
-					bReleaseToPool ? FXIt->FXComponent->ReleaseToPool() : FXIt->FXComponent->Deactivate();
-					FXIt.RemoveCurrent();
-				}
-			}
-		}
-		if (LocationIt.Value().Num() == 0)
+		FFXInfo const& FXInfo = FXStack.FXInfos[Index];
+		if (FXInfo.IsValid())
 		{
-			LocationIt.RemoveCurrent();
+			FXInfo.FXComponent->SetVisibility(EffectPriority >= FXStack.VisiblePriority, false);
 		}
 	}
+	else
+	{
+		EvaluateFXStack(FXStack);
+	}
+}
+
+void UFXControlComponent::DeactivateEffect(UFXSystemAsset const* FXToDeactivate, bool bReleaseToPool)
+{
+	DeactivateEffectInStacks(FXToDeactivate, bReleaseToPool);
 }
 
 void UFXControlComponent::DeactivateEffect(FFXEffectDataAttached const* FXToDeactivate, bool bReleaseToPool)
 {
 	check(FXToDeactivate);
-	bool bEffectRemoved = false;
-	for (auto LocationIt = FXLocationToInfos.CreateIterator(); LocationIt; ++LocationIt)
+	TArray<FFXStack*, TInlineAllocator<4>> ChangedStacks;
+	DeactivateEffectInStacks(FXToDeactivate->FXData.FXAlly, bReleaseToPool, &ChangedStacks);
+	if (FXToDeactivate->FXData.FXEnemy != FXToDeactivate->FXData.FXAlly)
 	{
-		for (auto FXIt = LocationIt.Value().CreateIterator(); FXIt; ++FXIt)
-		{
-			if (FXIt->FXComponent.IsValid() && *FXToDeactivate == FXIt->FXComponent.Get()->GetFXSystemAsset())
-			{
-				FXIt->FXCounter--;
-				if (FXIt->FXCounter == 0)
-				{
-					bReleaseToPool ? FXIt->FXComponent->ReleaseToPool() : FXIt->FXComponent->Deactivate();
-					FXIt.RemoveCurrent();
-					bEffectRemoved = true;
-				}
-			}
-		}
-		if (LocationIt.Value().Num() == 0)
-		{
-			LocationIt.RemoveCurrent();
-		}
+		DeactivateEffectInStacks(FXToDeactivate->FXData.FXEnemy, bReleaseToPool, &ChangedStacks);
 	}
 
-	if (bEffectRemoved)
+	for (FFXStack* FXStack : ChangedStacks)
 	{
-		EvaluateFXStack();
+		EvaluateFXStack(*FXStack);
 	}
 }
 
 void UFXControlComponent::DeactivateAllEffects(TArray<UFXSystemAsset*> const& FXToDeactivate, bool bReleaseToPool)
 {
-	if (FXToDeactivate.Num() == 0)
+	for (int32 Index = 0; Index < FXToDeactivate.Num(); ++Index)
 	{
-		return;
-	}
-	for (auto LocationIt = FXLocationToInfos.CreateIterator(); LocationIt; ++LocationIt)
-	{
-		for (auto FXIt = LocationIt.Value().CreateIterator(); FXIt; ++FXIt)
-		{
-			if (FXIt->FXComponent.IsValid() && FXToDeactivate.Contains(FXIt->FXComponent.Get()->GetFXSystemAsset()))
-			{
-				FXIt->FXCounter--;
-				if (FXIt->FXCounter == 0)
-				{
-					bReleaseToPool ? FXIt->FXComponent->ReleaseToPool() : FXIt->FXComponent->Deactivate();
-					FXIt.RemoveCurrent();
-				}
-			}
-		}
-		if (LocationIt.Value().Num() == 0)
+		// Every effect is deactivated once, even if its FX is listed several times
+		if (FXToDeactivate.Find(FXToDeactivate[Index]) == Index)
 		{
-			LocationIt.RemoveCurrent();
+			DeactivateEffectInStacks(FXToDeactivate[Index], bReleaseToPool);
 		}
 	}
 }
@@ -223,19 +246,21 @@ void UFXControlComponent::DeactivateAllEffects(bool bReleaseToPool)
 {
 	for (auto LocationIt = FXLocationToInfos.CreateIterator(); LocationIt; ++LocationIt)
 	{
-		for (auto FXIt = LocationIt.Value().CreateIterator(); FXIt; ++FXIt)
+		FFXStack& FXStack = *LocationIt.Value();
+		for (int32 Index = FXStack.FXInfos.Num() - 1; Index >= 0; --Index)
 		{
-			if (FXIt->FXComponent.IsValid())
+			FFXInfo& FXInfo = FXStack.FXInfos[Index];
+			if (FXInfo.FXComponent.IsValid())
 			{
-				FXIt->FXCounter--;
-				if (FXIt->FXCounter == 0)
+				FXInfo.FXCounter--;
+				if (FXInfo.FXCounter == 0)
 				{
-					bReleaseToPool ? FXIt->FXComponent->ReleaseToPool() : FXIt->FXComponent->Deactivate();
-					FXIt.RemoveCurrent();
+					bReleaseToPool ? FXInfo.FXComponent->ReleaseToPool() : FXInfo.FXComponent->Deactivate();
+					RemoveFromStack(FXStack, Index);
 				}
 			}
 		}
-		if (LocationIt.Value().Num() == 0)
+		if (FXStack.FXInfos.Num() == 0)
 		{
 			LocationIt.RemoveCurrent();
 		}
@@ -252,31 +277,24 @@ void UFXControlComponent::Tick(float DeltaTime)
 
 	for (auto LocationIt = FXLocationToInfos.CreateIterator(); LocationIt; ++LocationIt)
 	{
-		uint8 MaxRemovedEffectPriority = FFXSpawnLibrary::MinEffectPriority;
-		uint8 MaxActiveEffectPriority = FFXSpawnLibrary::MinEffectPriority;
-		for (auto FXIt = LocationIt.Value().CreateIterator(); FXIt; ++FXIt)
+		FFXStack& FXStack = *LocationIt.Value();
+		for (int32 Index = FXStack.FXInfos.Num() - 1; Index >= 0; --Index)
 		{
-			if (!FXIt->IsValid())
+			if (!FXStack.FXInfos[Index].IsValid())
 			{
-				MaxRemovedEffectPriority = FMath::Max(FXIt->EffectPriority, MaxRemovedEffectPriority);
-
 				// At this point the FX system has already completed, meaning it was either reclaimed by the pool or deactivated
 				// We do not need to care about it and can safely remove
-				FXIt.RemoveCurrent();
-			}
-			else
-			{
-				MaxActiveEffectPriority = FMath::Max(FXIt->EffectPriority, MaxActiveEffectPriority);
+				RemoveFromStack(FXStack, Index);
 			}
 		}
-		if (LocationIt.Value().Num() == 0)
+		if (FXStack.FXInfos.Num() == 0)
 		{
 			LocationIt.RemoveCurrent();
 		}
-		// We only evaluate FX stack if we removed the effect with the max priority
-		else if (MaxRemovedEffectPriority > MaxActiveEffectPriority)
+		// Only changes visibility if we removed the effects with the max priority
+		else
 		{
-			EvaluateFXStack(LocationIt.Value());
+			EvaluateFXStack(FXStack);
 		}
 	}
 
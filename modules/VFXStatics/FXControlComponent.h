@@ -17,6 +17,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
 #include "FXControlComponent.generated.h"
 
 struct FFXEffectDataAttached;
@@ -65,6 +66,8 @@ private:
 		uint32 FXCounter = 1;
 		uint8 EffectPriority = 0;
 		TWeakObjectPtr<UFXSystemComponent> FXComponent = nullptr;
+		// FX of the component when added, key in FXAssetToStacks
+		FObjectKey FXAsset {};
 
 		FFXInfo() = default;
 		FFXInfo(uint8 EffectPriority, UFXSystemComponent* InFXComponent);
@@ -73,13 +76,28 @@ private:
 	};
 	friend bool operator==(const FFXInfo& First, const UFXSystemComponent* Second);
 
-	using FFXStack = TArray<FFXInfo>;
-	// TODO: consider adding iterator for this type to reduce the amount of copy-paste
-	using FFXLocationToInfos = TMap<FFXLocationInfo, FFXStack>;
+	struct FFXStack
+	{
+		// Sorted by descending priority, FXs with the same priority in the order they were added
+		TArray<FFXInfo> FXInfos {};
+		// Top priority the visibility was last evaluated for, INDEX_NONE if not evaluated yet
+		int32 VisiblePriority = INDEX_NONE;
+	};
+	// Stacks are heap allocated to keep FXAssetToStacks pointers valid when the map grows
+	using FFXLocationToInfos = TMap<FFXLocationInfo, TUniquePtr<FFXStack>>;
+	// A stack pointer per FFXInfo with this FX, so the same stack is listed once per such FX in it
+	using FFXAssetToStacks = TMap<FObjectKey, TArray<FFXStack*, TInlineAllocator<2>>>;
 
 	FFXLocationToInfos FXLocationToInfos {};
+	FFXAssetToStacks FXAssetToStacks {};
 	float TimeSinceLastTick = 0.0f;
 
-	void EvaluateFXStack();
+	// Updates visibility only when the top priority of the stack changed since the last evaluation
 	void EvaluateFXStack(FFXStack& FXStack);
+	void RemoveFromStack(FFXStack& FXStack, int32 Index);
+	// Empty stacks are left for the tick to remove, their location key may be stale already
+	void DeactivateEffectInStacks(
+		UFXSystemAsset const* FXToDeactivate,
+		bool bReleaseToPool,
+		TArray<FFXStack*, TInlineAllocator<4>>* OutChangedStacks = nullptr);
 };
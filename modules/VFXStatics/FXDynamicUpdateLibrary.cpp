@@ -18,9 +18,11 @@
 #include "FXDynamicUpdateLibrary.h"
 #include "FXConfigTypes.h"
 #include "FXContainerTypes.h"
+#include "FXDynamicUpdateSubsystem.h"
 
 #include "Curves/CurveFloat.h"
 #include "Curves/CurveVector.h"
+#include "Engine/World.h"
 #include "Particles/ParticleSystemComponent.h"
 
 namespace FFXDynamicUpdateLibraryLocal
@@ -135,6 +137,24 @@ void FFXDynamicUpdateLibrary::UpdateFXWithNormalizedValue(
 	}
 }
 
+void FFXDynamicUpdateLibrary::UpdateFXWithNormalizedValueBudgeted(
+	UFXSystemComponent* FXComponent,
+	const FFXDynamicUpdateData& DynamicUpdateData,
+	float NormalizedValue)
+{
+	check(FXComponent);
+
+	if (UFXDynamicUpdateSubsystem* DynamicUpdateSubsystem =
+			UWorld::GetSubsystem<UFXDynamicUpdateSubsystem>(FXComponent->GetWorld()))
+	{
+		DynamicUpdateSubsystem->UpdateWithNormalizedValue(FXComponent, DynamicUpdateData, NormalizedValue);
+	}
+	else
+	{
+		UpdateFXWithNormalizedValue(FXComponent, DynamicUpdateData, NormalizedValue);
+	}
+}
+
 bool FFXDynamicUpdateData::IsEmpty() const
 {
 	return DynamicUpdateEmitters.Num() == 0 && DynamicUpdateFloats.Num() == 0 && DynamicUpdateVectors.Num() == 0;
@@ -91,4 +91,9 @@ namespace FFXDynamicUpdateLibrary
 		UFXSystemComponent* FXComponent,
 		const FFXDynamicUpdateData& DynamicUpdateData,
 		float NormalizedValue);
+	// Same values, pushed by UFXDynamicUpdateSubsystem: only the changed ones, under its per-frame budget
+	void UpdateFXWithNormalizedValueBudgeted(
+		UFXSystemComponent* FXComponent,
+		const FFXDynamicUpdateData& DynamicUpdateData,
+		float NormalizedValue);
 }
@@ -0,0 +1,378 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "FXDynamicUpdateSubsystem.h"
+#include "FXContainerTypes.h"
+#include "FXDynamicUpdateLibrary.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Particles/ParticleSystemComponent.h"
+
+namespace FFXDynamicUpdateSubsystemLocal
+{
+	// Beam end points move by world locations, sub-millimeter changes are not visible
+	static constexpr float LocationTolerance = 0.1f;
+
+	bool IsChanged(float Value, float PushedValue, float Tolerance)
+	{
+		return !FMath::IsNearlyEqual(Value, PushedValue, Tolerance);
+	}
+
+	bool IsChanged(const FVector& Value, const FVector& PushedValue, float Tolerance)
+	{
+		return !Value.Equals(PushedValue, Tolerance);
+	}
+
+	template<typename TBinding>
+	bool NeedsPush(const TBinding& Binding)
+	{
+		return !Binding.bPushed || IsChanged(Binding.Value, Binding.PushedValue, Binding.Tolerance);
+	}
+
+	template<typename TDynamicUpdateParam>
+	int32 GetNumNames(const TArray<TDynamicUpdateParam>& DynamicUpdateParams)
+	{
+		int32 NumNames = 0;
+		for (const TDynamicUpdateParam& DynamicUpdateParam : DynamicUpdateParams)
+		{
+			NumNames += DynamicUpdateParam.DynamicUpdateParametersName.Num();
+		}
+		return NumNames;
+	}
+}
+
+bool UFXDynamicUpdateSubsystem::FDynamicUpdate::IsBoundTo(FFXDynamicUpdateData const& InDynamicUpdateData) const
+{
+	if (DynamicUpdateData != &InDynamicUpdateData)
+	{
+		return false;
+	}
+
+	int32 NumEmitters = 0;
+	for (const FFXDynamicUpdateParam_Emitter& DynamicUpdateParam : InDynamicUpdateData.DynamicUpdateEmitters)
+	{
+		NumEmitters += DynamicUpdateParam.DynamicUpdateEmittersName.Num();
+	}
+	return Floats.Num() == FFXDynamicUpdateSubsystemLocal::GetNumNames(InDynamicUpdateData.DynamicUpdateFloats)
+		&& Vectors.Num() == BeamEndPoints.Num() + FFXDynamicUpdateSubsystemLocal::GetNumNames(InDynamicUpdateData.DynamicUpdateVectors)
+		&& Emitters.Num() == NumEmitters;
+}
+
+void UFXDynamicUpdateSubsystem::FDynamicUpdate::BindDynamicUpdateData(FFXDynamicUpdateData const& InDynamicUpdateData)
+{
+	DynamicUpdateData = &InDynamicUpdateData;
+	// Beam bindings are kept, they come first
+	Floats.Reset();
+	Vectors.SetNum(BeamEndPoints.Num());
+	Emitters.Reset();
+
+	for (const FFXDynamicUpdateParam_Float& DynamicUpdateParam : InDynamicUpdateData.DynamicUpdateFloats)
+	{
+		for (const FName& ParameterName : DynamicUpdateParam.DynamicUpdateParametersName)
+		{
+			Floats.AddDefaulted_GetRef().ParameterName = ParameterName;
+		}
+	}
+	for (const FFXDynamicUpdateParam_Vector& DynamicUpdateParam : InDynamicUpdateData.DynamicUpdateVectors)
+	{
+		for (const FName& ParameterName : DynamicUpdateParam.DynamicUpdateParametersName)
+		{
+			Vectors.AddDefaulted_GetRef().ParameterName = ParameterName;
+		}
+	}
+	for (const FFXDynamicUpdateParam_Emitter& DynamicUpdateParam : InDynamicUpdateData.DynamicUpdateEmitters)
+	{
+		for (const FName& EmitterName : DynamicUpdateParam.DynamicUpdateEmittersName)
+		{
+			Emitters.AddDefaulted_GetRef().EmitterName = EmitterName;
+		}
+	}
+}
+
+int32 UFXDynamicUpdateSubsystem::FDynamicUpdate::GetNumChanged() const
+{
+	int32 NumChanged = 0;
+	for (const TParameterBinding<float>& Binding : Floats)
+	{
+		NumChanged += FFXDynamicUpdateSubsystemLocal::NeedsPush(Binding);
+	}
+	for (const TParameterBinding<FVector>& Binding : Vectors)
+	{
+		NumChanged += FFXDynamicUpdateSubsystemLocal::NeedsPush(Binding);
+	}
+	for (const FEmitterBinding& Binding : Emitters)
+	{
+		NumChanged += !Binding.bPushed || Binding.bEnabled != Binding.bPushedEnabled;
+	}
+	return NumChanged;
+}
+
+void UFXDynamicUpdateSubsystem::FDynamicUpdate::Push(UFXSystemComponent* FXComponent)
+{
+	for (TParameterBinding<float>& Binding : Floats)
+	{
+		if (FFXDynamicUpdateSubsystemLocal::NeedsPush(Binding))
+		{
+			FXComponent->SetFloatParameter(Binding.ParameterName, Binding.Value);
+			Binding.PushedValue = Binding.Value;
+			Binding.bPushed = true;
+		}
+	}
+	for (TParameterBinding<FVector>& Binding : Vectors)
+	{
+		if (FFXDynamicUpdateSubsystemLocal::NeedsPush(Binding))
+		{
+			FXComponent->SetVectorParameter(Binding.ParameterName, Binding.Value);
+			Binding.PushedValue = Binding.Value;
+			Binding.bPushed = true;
+		}
+	}
+	for (FEmitterBinding& Binding : Emitters)
+	{
+		if (!Binding.bPushed || Binding.bEnabled != Binding.bPushedEnabled)
+		{
+			FXComponent->SetEmitterEnable(Binding.EmitterName, Binding.bEnabled);
+			Binding.bPushedEnabled = Binding.bEnabled;
+			Binding.bPushed = true;
+		}
+	}
+}
+
+void UFXDynamicUpdateSubsystem::UpdateWithNormalizedValue(
+	UFXSystemComponent* FXComponent,
+	const FFXDynamicUpdateData& DynamicUpdateData,
+	float NormalizedValue)
+{
+	check(FXComponent);
+
+	if (DynamicUpdateData.IsEmpty())
+	{
+		return;
+	}
+
+	// Nothing is drawn yet, set right away so the activation starts from these values
+	if (!FXComponent->IsActive())
+	{
+		DynamicUpdates.Remove(FXComponent);
+		FFXDynamicUpdateLibrary::UpdateFXWithNormalizedValue(FXComponent, DynamicUpdateData, NormalizedValue);
+		return;
+	}
+
+	FDynamicUpdate& DynamicUpdate = DynamicUpdates.FindOrAdd(FXComponent);
+	if (!DynamicUpdate.IsBoundTo(DynamicUpdateData))
+	{
+		DynamicUpdate.BindDynamicUpdateData(DynamicUpdateData);
+	}
+
+	// Same values as FFXDynamicUpdateLibrary::UpdateFXWithNormalizedValue, in the order of the bindings
+	int32 BindingIndex = 0;
+	for (const FFXDynamicUpdateParam_Float& DynamicUpdateParam : DynamicUpdateData.DynamicUpdateFloats)
+	{
+		const float Value = IsValid(DynamicUpdateParam.DynamicUpdateCurve)
+			? DynamicUpdateParam.DynamicUpdateCurve->GetFloatValue(NormalizedValue)
+			: NormalizedValue;
+		for (int32 Index = 0; Index < DynamicUpdateParam.DynamicUpdateParametersName.Num(); ++Index)
+		{
+			DynamicUpdate.Floats[BindingIndex++].Value = Value;
+		}
+	}
+
+	BindingIndex = DynamicUpdate.BeamEndPoints.Num();
+	for (const FFXDynamicUpdateParam_Vector& DynamicUpdateParam : DynamicUpdateData.DynamicUpdateVectors)
+	{
+		const FVector Value = IsValid(DynamicUpdateParam.DynamicUpdateCurve)
+			? DynamicUpdateParam.DynamicUpdateCurve->GetVectorValue(NormalizedValue)
+			: FVector { NormalizedValue };
+		for (int32 Index = 0; Index < DynamicUpdateParam.DynamicUpdateParametersName.Num(); ++Index)
+		{
+			DynamicUpdate.Vectors[BindingIndex++].Value = Value;
+		}
+	}
+
+	BindingIndex = 0;
+	for (const FFXDynamicUpdateParam_Emitter& DynamicUpdateParam : DynamicUpdateData.DynamicUpdateEmitters)
+	{
+		const bool bEnabled = NormalizedValue >= DynamicUpdateParam.ValueThreshold
+			? DynamicUpdateParam.bEnableEmitter
+			: !DynamicUpdateParam.bEnableEmitter;
+		for (int32 Index = 0; Index < DynamicUpdateParam.DynamicUpdateEmittersName.Num(); ++Index)
+		{
+			DynamicUpdate.Emitters[BindingIndex++].bEnabled = bEnabled;
+		}
+	}
+}
+
+void UFXDynamicUpdateSubsystem::RegisterBeam(const FFXBeamContext& BeamContext)
+{
+	check(BeamContext.FXComponent);
+
+	FDynamicUpdate& DynamicUpdate = DynamicUpdates.FindOrAdd(BeamContext.FXComponent);
+	const bool bRegistered = DynamicUpdate.BeamEndPoints.Num() > 0;
+
+	int32 EndPointIndex = 0;
+	for (const FFXBeamEndPoint* EndPoint : { &BeamContext.SourcePoint, &BeamContext.TargetPoint })
+	{
+		// Beam bindings come first, the dynamic data ones follow
+		if (!bRegistered)
+		{
+			DynamicUpdate.BeamEndPoints.AddDefaulted_GetRef().VectorIndex = EndPointIndex;
+			DynamicUpdate.Vectors.InsertDefaulted(EndPointIndex);
+			DynamicUpdate.Vectors[EndPointIndex].Tolerance = FFXDynamicUpdateSubsystemLocal::LocationTolerance;
+		}
+
+		FBeamEndPointBinding& EndPointBinding = DynamicUpdate.BeamEndPoints[EndPointIndex++];
+		EndPointBinding.PointComponent = EndPoint->PointComponent;
+		EndPointBinding.PointSocketName = EndPoint->PointSocketName;
+		EndPointBinding.PointLocation = EndPoint->PointLocation;
+
+		// Another parameter name has nothing pushed yet
+		TParameterBinding<FVector>& Binding = DynamicUpdate.Vectors[EndPointBinding.VectorIndex];
+		if (Binding.ParameterName != EndPoint->PointBeamParameterName)
+		{
+			Binding.ParameterName = EndPoint->PointBeamParameterName;
+			Binding.bPushed = false;
+		}
+		Binding.Value = EndPoint->GetUpdatedLocation();
+	}
+}
+
+void UFXDynamicUpdateSubsystem::Unregister(UFXSystemComponent* FXComponent)
+{
+	DynamicUpdates.Remove(FXComponent);
+}
+
+void UFXDynamicUpdateSubsystem::UnregisterFromWorld(UFXSystemComponent* FXComponent)
+{
+	if (!IsValid(FXComponent))
+	{
+		return;
+	}
+
+	UFXDynamicUpdateSubsystem* DynamicUpdateSubsystem = UWorld::GetSubsystem<UFXDynamicUpdateSubsystem>(FXComponent->GetWorld());
+	if (DynamicUpdateSubsystem && DynamicUpdateSubsystem->DynamicUpdates.Num() > 0)
+	{
+		DynamicUpdateSubsystem->DynamicUpdates.Remove(FXComponent);
+	}
+}
+
+void UFXDynamicUpdateSubsystem::SetMaxUpdatesPerFrame(int32 InMaxUpdatesPerFrame)
+{
+	check(InMaxUpdatesPerFrame > 0);
+	MaxUpdatesPerFrame = InMaxUpdatesPerFrame;
+}
+
+void UFXDynamicUpdateSubsystem::Deinitialize()
+{
+	DynamicUpdates.Empty();
+	UpdateCandidates.Empty();
+	Super::Deinitialize();
+}
+
+void UFXDynamicUpdateSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFXDynamicUpdateSubsystem::Tick);
+
+	FVector ViewLocation = FVector::ZeroVector;
+	const bool bHasViewLocation = GetViewLocation(ViewLocation);
+
+	UpdateCandidates.Reset();
+	for (auto It = DynamicUpdates.CreateIterator(); It; ++It)
+	{
+		// Pooled components are inactive once back in the pool, their next owner registers them again
+		UFXSystemComponent* FXComponent = It.Key().Get();
+		if (!FXComponent || !FXComponent->IsActive())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		FDynamicUpdate& DynamicUpdate = It.Value();
+		for (const FBeamEndPointBinding& EndPointBinding : DynamicUpdate.BeamEndPoints)
+		{
+			USceneComponent* PointComponent = EndPointBinding.PointComponent.Get();
+			DynamicUpdate.Vectors[EndPointBinding.VectorIndex].Value = PointComponent
+				? PointComponent->GetSocketLocation(EndPointBinding.PointSocketName)
+				: EndPointBinding.PointLocation;
+		}
+
+		const int32 NumChanged = DynamicUpdate.GetNumChanged();
+		if (NumChanged == 0)
+		{
+			DynamicUpdate.FramesWaiting = 0;
+			continue;
+		}
+
+		// Nearest first, the waiting ones move up every frame they are skipped
+		const float DistanceSquared =
+			bHasViewLocation ? FVector::DistSquared(ViewLocation, FXComponent->GetComponentLocation()) : 0.0f;
+		const float Priority = DistanceSquared / FMath::Square(1.0f + DynamicUpdate.FramesWaiting);
+		UpdateCandidates.Add({ FXComponent, &DynamicUpdate, NumChanged, Priority });
+	}
+
+	UpdateCandidates.Sort(
+		[](const FUpdateCandidate& Left, const FUpdateCandidate& Right)
+		{
+			return Left.Priority < Right.Priority;
+		});
+
+	int32 NumUpdates = 0;
+	for (const FUpdateCandidate& Candidate : UpdateCandidates)
+	{
+		// The nearest FX is updated even if it alone is over the budget
+		if (NumUpdates > 0 && NumUpdates + Candidate.NumChanged > MaxUpdatesPerFrame)
+		{
+			Candidate.DynamicUpdate->FramesWaiting++;
+			continue;
+		}
+		Candidate.DynamicUpdate->Push(Candidate.FXComponent);
+		Candidate.DynamicUpdate->FramesWaiting = 0;
+		NumUpdates += Candidate.NumChanged;
+	}
+}
+
+ETickableTickType UFXDynamicUpdateSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UFXDynamicUpdateSubsystem::IsTickable() const
+{
+	return DynamicUpdates.Num() > 0;
+}
+
+TStatId UFXDynamicUpdateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFXDynamicUpdateSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UFXDynamicUpdateSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+bool UFXDynamicUpdateSubsystem::GetViewLocation(FVector& OutViewLocation) const
+{
+	APlayerController const* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		OutViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+		return true;
+	}
+	return false;
+}
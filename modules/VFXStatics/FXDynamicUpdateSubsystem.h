@@ -0,0 +1,122 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FXDynamicUpdateSubsystem.generated.h"
+
+class UFXSystemComponent;
+struct FFXBeamContext;
+struct FFXDynamicUpdateData;
+
+// Registry of the FX updated every frame (dynamic values, tracked beams).
+// Parameter names are resolved to bindings once per component, only the values that changed are pushed,
+// at most MaxUpdatesPerFrame of them per frame, the FX nearest to the view first.
+// Components are followed while active: inactive, pooled and destroyed ones are dropped on their own,
+// FX containers unregister theirs when releasing them to the pool.
+UCLASS()
+class UFXDynamicUpdateSubsystem
+	: public UWorldSubsystem
+	, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// DynamicUpdateData has to outlive the registration, its bindings are resolved again if another one is passed
+	// or its parameters were added or removed
+	void UpdateWithNormalizedValue(
+		UFXSystemComponent* FXComponent,
+		const FFXDynamicUpdateData& DynamicUpdateData,
+		float NormalizedValue);
+	// The beam end points are followed every frame until the component is unregistered or deactivated,
+	// registering the same beam again only moves its end points
+	void RegisterBeam(const FFXBeamContext& BeamContext);
+	void Unregister(UFXSystemComponent* FXComponent);
+	// Unregisters the component from the subsystem of its world, called when it goes back to the pool
+	static void UnregisterFromWorld(UFXSystemComponent* FXComponent);
+
+	void SetMaxUpdatesPerFrame(int32 InMaxUpdatesPerFrame);
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+private:
+	template<typename TValueType>
+	struct TParameterBinding
+	{
+		FName ParameterName = NAME_None;
+		TValueType Value {};
+		TValueType PushedValue {};
+		// Smallest change pushed, beam end points use a coarser one
+		float Tolerance = KINDA_SMALL_NUMBER;
+		bool bPushed = false;
+	};
+
+	struct FEmitterBinding
+	{
+		FName EmitterName = NAME_None;
+		bool bEnabled = false;
+		bool bPushedEnabled = false;
+		bool bPushed = false;
+	};
+
+	struct FBeamEndPointBinding
+	{
+		TWeakObjectPtr<USceneComponent> PointComponent = nullptr;
+		FName PointSocketName = NAME_None;
+		FVector PointLocation = FVector::ZeroVector;
+		int32 VectorIndex = INDEX_NONE;
+	};
+
+	struct FDynamicUpdate
+	{
+		FFXDynamicUpdateData const* DynamicUpdateData = nullptr;
+		TArray<TParameterBinding<float>> Floats {};
+		TArray<TParameterBinding<FVector>> Vectors {};
+		TArray<FEmitterBinding> Emitters {};
+		TArray<FBeamEndPointBinding, TInlineAllocator<2>> BeamEndPoints {};
+		// Frames the changed values have been waiting for the budget, raises the priority
+		int32 FramesWaiting = 0;
+
+		// False if the data at the same address was edited since, its parameter counts differ then
+		bool IsBoundTo(FFXDynamicUpdateData const& InDynamicUpdateData) const;
+		void BindDynamicUpdateData(FFXDynamicUpdateData const& InDynamicUpdateData);
+		int32 GetNumChanged() const;
+		void Push(UFXSystemComponent* FXComponent);
+	};
+
+	struct FUpdateCandidate
+	{
+		UFXSystemComponent* FXComponent = nullptr;
+		FDynamicUpdate* DynamicUpdate = nullptr;
+		int32 NumChanged = 0;
+		float Priority = 0.0f;
+	};
+
+	TMap<TWeakObjectPtr<UFXSystemComponent>, FDynamicUpdate> DynamicUpdates {};
+	TArray<FUpdateCandidate> UpdateCandidates {};
+	int32 MaxUpdatesPerFrame = 256;
+
+	bool GetViewLocation(FVector& OutViewLocation) const;
+};
@@ -0,0 +1,117 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "FXSpawnBatchSubsystem.h"
+#include "Particles/ParticleSystemComponent.h"
+
+bool UFXSpawnBatchSubsystem::FPendingActivations::IsDone() const
+{
+	return NextIndex >= FXComponents.Num();
+}
+
+void UFXSpawnBatchSubsystem::ActivateBudgeted(
+	TArray<UFXSystemComponent*> const& FXComponents,
+	int32 MaxActivationsPerFrame)
+{
+	check(MaxActivationsPerFrame > 0);
+
+	FPendingActivations Pending;
+	Pending.FXComponents.Reserve(FXComponents.Num());
+	for (UFXSystemComponent* FXComponent : FXComponents)
+	{
+		Pending.FXComponents.Emplace(FXComponent);
+		PendingComponents.Add(FXComponent);
+	}
+	Pending.MaxActivationsPerFrame = MaxActivationsPerFrame;
+
+	ActivateNext(Pending);
+	if (!Pending.IsDone())
+	{
+		PendingActivations.Add(MoveTemp(Pending));
+	}
+}
+
+void UFXSpawnBatchSubsystem::CancelActivation(UFXSystemComponent* FXComponent)
+{
+	if (!IsValid(FXComponent))
+	{
+		return;
+	}
+
+	UFXSpawnBatchSubsystem* SpawnBatchSubsystem = UWorld::GetSubsystem<UFXSpawnBatchSubsystem>(FXComponent->GetWorld());
+	if (SpawnBatchSubsystem && SpawnBatchSubsystem->PendingComponents.Num() > 0)
+	{
+		SpawnBatchSubsystem->PendingComponents.Remove(FXComponent);
+	}
+}
+
+void UFXSpawnBatchSubsystem::Deinitialize()
+{
+	PendingActivations.Empty();
+	PendingComponents.Empty();
+	Super::Deinitialize();
+}
+
+void UFXSpawnBatchSubsystem::Tick(float DeltaTime)
+{
+	for (int32 Index = PendingActivations.Num() - 1; Index >= 0; --Index)
+	{
+		ActivateNext(PendingActivations[Index]);
+		if (PendingActivations[Index].IsDone())
+		{
+			PendingActivations.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	// Drops the keys of the components destroyed before their turn
+	if (PendingActivations.Num() == 0)
+	{
+		PendingComponents.Reset();
+	}
+}
+
+ETickableTickType UFXSpawnBatchSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UFXSpawnBatchSubsystem::IsTickable() const
+{
+	return PendingActivations.Num() > 0;
+}
+
+TStatId UFXSpawnBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFXSpawnBatchSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UFXSpawnBatchSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UFXSpawnBatchSubsystem::ActivateNext(FPendingActivations& Pending)
+{
+	const int32 EndIndex = FMath::Min(Pending.NextIndex + Pending.MaxActivationsPerFrame, Pending.FXComponents.Num());
+	for (; Pending.NextIndex < EndIndex; ++Pending.NextIndex)
+	{
+		// Destroyed, or cancelled when released to the pool or deactivated meanwhile
+		UFXSystemComponent* FXComponent = Pending.FXComponents[Pending.NextIndex].Get();
+		if (FXComponent && PendingComponents.Remove(FXComponent) > 0)
+		{
+			FXComponent->Activate();
+		}
+	}
+}
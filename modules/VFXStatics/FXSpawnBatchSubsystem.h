@@ -0,0 +1,66 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "FXSpawnBatchSubsystem.generated.h"
+
+class UFXSystemComponent;
+
+// Activates the FX spawned by FFXSpawnLibrary::SpawnFXBatch under a per-frame budget,
+// so a batch of hundreds of FX doesn't activate all of them in the frame it was spawned
+UCLASS()
+class UFXSpawnBatchSubsystem
+	: public UWorldSubsystem
+	, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Activates MaxActivationsPerFrame of the components right away, and as many each next frame
+	void ActivateBudgeted(TArray<UFXSystemComponent*> const& FXComponents, int32 MaxActivationsPerFrame);
+	// Keeps a batch still being activated from activating the component, pooled components may be reused meanwhile.
+	// FFXComponentContainer calls it when releasing, deactivating or destroying its components
+	static void CancelActivation(UFXSystemComponent* FXComponent);
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+private:
+	struct FPendingActivations
+	{
+		TArray<TWeakObjectPtr<UFXSystemComponent>> FXComponents {};
+		int32 NextIndex = 0;
+		int32 MaxActivationsPerFrame = 0;
+
+		bool IsDone() const;
+	};
+
+	void ActivateNext(FPendingActivations& Pending);
+
+	TArray<FPendingActivations> PendingActivations {};
+	// Components of the pending batches still to activate, a cancelled one is removed
+	TSet<TObjectKey<UFXSystemComponent>> PendingComponents {};
+};
@@ -17,6 +17,7 @@
 #include "FXConfigTypes.h"
 #include "FXContainerTypes.h"
 #include "FXControlComponent.h"
+#include "FXSpawnBatchSubsystem.h"
 #include "Kismet/GameplayStatics.h"
 #include "NiagaraComponent.h"
 #include "NiagaraFunctionLibrary.h"
@@ -284,23 +285,21 @@ namespace FFXSpawnLibraryLocal
 		}
 	}
 
-	UFXSystemComponent* CreateFXComponentAtLocation(
-		UFXSystemAsset* FXSystem,
-		UWorld* World,
+	UFXSystemComponent* SpawnFXAtLocationAsComponent(
+		const FFXSpawnContext& Context,
 		EPSCPoolMethod PoolMethod,
 		const FVector& SpawnLocation,
 		const FRotator& Rotation,
 		const FVector& Scale,
-		const FTransform& FXOffset,
-		const FFXEffectData* EffectData,
 		bool bAutoActivate,
 		bool bAutoDestroy)
 	{
-		if (UParticleSystem* ParticleSystem = Cast<UParticleSystem>(FXSystem))
+		const FTransform& FXOffset = *Context.SpawnTransform;
+		if (Context.ParticleSystem)
 		{
 			UParticleSystemComponent* ParticleSystemComponent = UGameplayStatics::SpawnEmitterAtLocation(
-				World,
-				ParticleSystem,
+				Context.World,
+				Context.ParticleSystem,
 				SpawnLocation + FXOffset.GetLocation(),
 				FXOffset.Rotator() + Rotation,
 				FXOffset.GetScale3D() * Scale,
@@ -308,18 +307,18 @@ namespace FFXSpawnLibraryLocal
 				PoolMethod,
 				bAutoActivate);
 
-			if (ParticleSystemComponent && EffectData)
+			if (ParticleSystemComponent && Context.EffectData)
 			{
-				ParticleSystemComponent->CustomTimeDilation = EffectData->FXPlayRate;
+				ParticleSystemComponent->CustomTimeDilation = Context.EffectData->FXPlayRate;
 			}
 			return ParticleSystemComponent;
 		}
 
-		if (UNiagaraSystem* NiagaraSystem = Cast<UNiagaraSystem>(FXSystem))
+		if (Context.NiagaraSystem)
 		{
 			return UNiagaraFunctionLibrary::SpawnSystemAtLocation(
-				World,
-				NiagaraSystem,
+				Context.World,
+				Context.NiagaraSystem,
 				SpawnLocation + FXOffset.GetLocation(),
 				FXOffset.Rotator() + Rotation,
 				FXOffset.GetScale3D() * Scale,
@@ -331,6 +330,30 @@ namespace FFXSpawnLibraryLocal
 		return nullptr;
 	}
 
+	UFXSystemComponent* CreateFXComponentAtLocation(
+		UFXSystemAsset* FXSystem,
+		UWorld* World,
+		EPSCPoolMethod PoolMethod,
+		const FVector& SpawnLocation,
+		const FRotator& Rotation,
+		const FVector& Scale,
+		const FTransform& FXOffset,
+		const FFXEffectData* EffectData,
+		bool bAutoActivate,
+		bool bAutoDestroy)
+	{
+		FFXSpawnContext SpawnContext { FXSystem, World, nullptr, &FXOffset };
+		SpawnContext.EffectData = EffectData;
+		return SpawnFXAtLocationAsComponent(
+			SpawnContext,
+			PoolMethod,
+			SpawnLocation,
+			Rotation,
+			Scale,
+			bAutoActivate,
+			bAutoDestroy);
+	}
+
 	UFXSystemComponent* SpawnFXAtLocationInternal(
 		const FFXEffectData& Config,
 		UWorld* World,
@@ -736,6 +759,122 @@ UFXSystemComponent* FFXSpawnLibrary::SpawnFXAtLocation(
 		bAutoDestroy);
 }
 
+FFXComponentContainer FFXSpawnLibrary::SpawnFXBatch(
+	TArrayView<const FFXSpawnRequest> Requests,
+	UWorld* World,
+	EPSCPoolMethod PoolMethod,
+	int32 MaxActivationsPerFrame,
+	bool bAutoDestroy)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FFXSpawnLibrary::SpawnFXBatch);
+	check(World);
+
+	// Requests with the same config share the spawn context
+	TMap<const FFXEffectData*, int32> ConfigToContextIndex;
+	TArray<FFXSpawnLibraryLocal::FFXSpawnContext> SpawnContexts;
+	TArray<int32> ContextIndices;
+	ContextIndices.SetNumUninitialized(Requests.Num());
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const FFXEffectData* Config = Requests[RequestIndex].Config;
+		check(Config);
+		const int32* FoundContextIndex = ConfigToContextIndex.Find(Config);
+		if (!FoundContextIndex)
+		{
+			//Here you can use your relathionship methods
+			const bool bAlly = false;
+			UFXSystemAsset* FXSystem = bAlly ? Config->FXAlly : Config->FXEnemy;
+
+			FFXSpawnLibraryLocal::FFXSpawnContext SpawnContext { FXSystem, World, nullptr, &Config->FXOffset };
+			SpawnContext.EffectData = Config;
+			FoundContextIndex = &ConfigToContextIndex.Add(Config, SpawnContexts.Add(SpawnContext));
+		}
+		ContextIndices[RequestIndex] = *FoundContextIndex;
+	}
+
+	// The same FX systems are spawned one after another, taking their components from the same pool
+	TArray<int32> SpawnOrder;
+	SpawnOrder.Reserve(Requests.Num());
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		SpawnOrder.Add(RequestIndex);
+	}
+	SpawnOrder.StableSort(
+		[&SpawnContexts, &ContextIndices](int32 Left, int32 Right)
+		{
+			return SpawnContexts[ContextIndices[Left]].FXSystem < SpawnContexts[ContextIndices[Right]].FXSystem;
+		});
+
+	TArray<UFXSystemComponent*> SpawnedComponents;
+	SpawnedComponents.SetNumZeroed(Requests.Num());
+	for (const int32 RequestIndex : SpawnOrder)
+	{
+		const FFXSpawnRequest& Request = Requests[RequestIndex];
+		FFXSpawnLibraryLocal::FFXSpawnContext SpawnContext = SpawnContexts[ContextIndices[RequestIndex]];
+		if (Request.AttachToComponent)
+		{
+			// Attached spawns need the owning actor
+			SpawnContext.AttachToActor = Request.AttachToComponent->GetOwner();
+			if (!SpawnContext.AttachToActor)
+			{
+				continue;
+			}
+			SpawnedComponents[RequestIndex] = FFXSpawnLibraryLocal::CreateFXComponentAttached(
+				SpawnContext,
+				Request.Config->FXParametersData,
+				nullptr,
+				Request.AttachToComponent,
+				NAME_None,
+				Request.Location,
+				Request.Rotation,
+				Request.Scale,
+				EAttachLocation::KeepRelativeOffset,
+				PoolMethod,
+				false,
+				bAutoDestroy);
+		}
+		else
+		{
+			UFXSystemComponent* FXComponent = FFXSpawnLibraryLocal::SpawnFXAtLocationAsComponent(
+				SpawnContext,
+				PoolMethod,
+				Request.Location,
+				Request.Rotation,
+				Request.Scale,
+				false,
+				bAutoDestroy);
+			if (FXComponent)
+			{
+				FFXSpawnLibrary::UpdateFXParameters(FXComponent, Request.Config->FXParametersData);
+			}
+			SpawnedComponents[RequestIndex] = FXComponent;
+		}
+	}
+
+	FFXComponentContainer Result(SpawnedComponents.Num());
+	for (UFXSystemComponent* FXComponent : SpawnedComponents)
+	{
+		if (FXComponent)
+		{
+			Result.Add(FXComponent);
+		}
+	}
+
+	if (UFXSpawnBatchSubsystem* SpawnBatchSubsystem = UWorld::GetSubsystem<UFXSpawnBatchSubsystem>(World))
+	{
+		SpawnBatchSubsystem->ActivateBudgeted(Result.GetComponents(), MaxActivationsPerFrame);
+	}
+	else
+	{
+		for (UFXSystemComponent* FXComponent : Result.GetComponents())
+		{
+			FXComponent->Activate();
+		}
+	}
+
+	return Result;
+}
+
 FFXBeamContainer FFXSpawnLibrary::SpawnFXBeam(
 	const FFXBeamData& Config,
 	UWorld* World,
@@ -33,6 +33,18 @@ class UFXSystemAsset;
 
 namespace FFXSpawnLibrary
 {
+	static constexpr int32 DefaultMaxActivationsPerFrame = 32;
+
+	// A spawn of SpawnFXBatch, at a world location, or relative to AttachToComponent if set
+	struct FFXSpawnRequest
+	{
+		const FFXEffectData* Config = nullptr;
+		USceneComponent* AttachToComponent = nullptr;
+		FVector Location = FVector::ZeroVector;
+		FRotator Rotation = FRotator::ZeroRotator;
+		FVector Scale = FVector::OneVector;
+	};
+
 	FFXComponentContainer SpawnFXAttachedToActor(
 		const FFXEffectDataAttached& Config,
 		UWorld* World,
@@ -135,6 +147,18 @@ namespace FFXSpawnLibrary
 		bool bAutoDestroy = true);
 
 
+	// Spawns all the requests deactivated, grouped by FX system, with one FX system lookup per config,
+	// then activates MaxActivationsPerFrame of them per frame, see UFXSpawnBatchSubsystem.
+	// The container holds the spawned components in the order of their requests, the requests that spawned nothing
+	// (no FX system for the config, or an AttachToComponent without an owner) are left out, so indices may not match
+	FFXComponentContainer SpawnFXBatch(
+		TArrayView<const FFXSpawnRequest> Requests,
+		UWorld* World,
+		EPSCPoolMethod PoolMethod,
+		int32 MaxActivationsPerFrame = DefaultMaxActivationsPerFrame,
+		bool bAutoDestroy = true);
+
+
 	FFXBeamContainer SpawnFXBeam(
 		const FFXBeamData& Config,
 		UWorld* World,
@@ -0,0 +1,100 @@
+"""
+Local stand-in for the params nginx server.
+
+Serves a directory the same way as nginx with `autoindex_format json`: folder URLs return a JSON listing with
+name/type/mtime, file URLs return content with ETag and Last-Modified and honour If-None-Match/If-Modified-Since.
+
+Usage: python params_server_standin.py <uparams dir> [--port 5080] [--prefix /uparams/]
+"""
+
+import argparse
+import email.utils
+import json
+import os
+import sys
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import unquote
+
+
+def make_handler(root, prefix):
+    class Handler(BaseHTTPRequestHandler):
+        bytes_sent = 0
+
+        def do_GET(self):
+            path = unquote(self.path.split("?", 1)[0])
+            if not path.startswith(prefix):
+                return self.send_error(404)
+
+            local_path = os.path.normpath(os.path.join(root, path[len(prefix):]))
+            if not local_path.startswith(root) or not os.path.exists(local_path):
+                return self.send_error(404)
+
+            if os.path.isdir(local_path):
+                return self.send_listing(local_path)
+            return self.send_file(local_path)
+
+        def send_listing(self, local_path):
+            entries = []
+            for name in sorted(os.listdir(local_path)):
+                stat = os.stat(os.path.join(local_path, name))
+                is_dir = os.path.isdir(os.path.join(local_path, name))
+                entry = {
+                    "name": name,
+                    "type": "directory" if is_dir else "file",
+                    "mtime": email.utils.formatdate(stat.st_mtime, usegmt=True),
+                }
+                if not is_dir:
+                    entry["size"] = stat.st_size
+                entries.append(entry)
+            self.send_body(200, json.dumps(entries).encode("utf-8"), "application/json")
+
+        def send_file(self, local_path):
+            stat = os.stat(local_path)
+            etag = '"%x-%x"' % (int(stat.st_mtime), stat.st_size)
+            last_modified = email.utils.formatdate(stat.st_mtime, usegmt=True)
+
+            if self.headers.get("If-None-Match") == etag or (
+                self.headers.get("If-None-Match") is None
+                and self.headers.get("If-Modified-Since") == last_modified
+            ):
+                self.send_response(304)
+                self.send_header("ETag", etag)
+                self.send_header("Last-Modified", last_modified)
+                self.end_headers()
+                return
+
+            with open(local_path, "rb") as file:
+                body = file.read()
+            self.send_body(200, body, "application/octet-stream", {"ETag": etag, "Last-Modified": last_modified})
+
+        def send_body(self, code, body, content_type, headers=None):
+            self.send_response(code)
+            self.send_header("Content-Type", content_type)
+            self.send_header("Content-Length", str(len(body)))
+            for key, value in (headers or {}).items():
+                self.send_header(key, value)
+            self.end_headers()
+            self.wfile.write(body)
+            Handler.bytes_sent += len(body)
+
+        def log_message(self, format, *args):
+            sys.stderr.write("%s [sent %d bytes total]\n" % (format % args, Handler.bytes_sent))
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("root")
+    parser.add_argument("--port", type=int, default=5080)
+    parser.add_argument("--prefix", default="/uparams/")
+    args = parser.parse_args()
+
+    root = os.path.abspath(args.root)
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), make_handler(root, args.prefix))
+    print("Serving %s at http://127.0.0.1:%d%s" % (root, args.port, args.prefix))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
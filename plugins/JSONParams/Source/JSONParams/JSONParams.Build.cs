@@ -24,6 +24,7 @@ public class JSONParams : ModuleRules
 				"DeveloperSettings",
 				"UMG",
 				"HTTP",
+				"VSPTests",
 			});
 	}
 }
@@ -64,7 +64,7 @@ FParamsRegistry& FParamsRegistry::Get()
 
 void FParamsRegistry::Init()
 {
-	FailedParamsNumber.Reset();
+	ResetFailedParams();
 
 	if (ParamsInitialization.AtomicSet(true))
 	{
@@ -121,6 +121,10 @@ void FParamsRegistry::Init()
 	{
 		FScopeLock AddParamLock(&AddParamMutex);
 		ParamsTree.Empty();
+		ServerParamFiles.Empty();
+#if WITH_EDITOR
+		ParamFilesIndex.Empty();
+#endif
 	}
 
 	for (IPlatformFile* PlatformFile : PlatformFiles)
@@ -128,12 +132,12 @@ void FParamsRegistry::Init()
 		ReloadParams(PlatformFile, ParamFilesRootPaths);
 	}
 
-	GetParamsFromServer();
+	GetParamsFromServer(true);
 }
 
 void FParamsRegistry::RequestParamsFromServer()
 {
-	FailedParamsNumber.Reset();
+	ResetFailedParams();
 
 	if (IsEngineExitRequested())
 	{
@@ -150,7 +154,8 @@ void FParamsRegistry::RequestParamsFromServer()
 		return;
 	}
 
-	GetParamsFromServer();
+	// Params are already in the registry, so only files changed on server are needed.
+	GetParamsFromServer(false);
 }
 
 void FParamsRegistry::CallWhenInitialized(TFunction<void()> Callback)
@@ -168,20 +173,26 @@ void FParamsRegistry::CallWhenInitialized(TFunction<void()> Callback)
 
 FParamRegistryDataPtr FParamsRegistry::GetParam(const UScriptStruct* Type, const FName& ID)
 {
-	if (Get().ParamsInitialization)
+	uint32 Version = 0;
+	return ResolveParam(Type, ID, Version);
+}
+
+FParamRegistryDataPtr FParamsRegistry::ResolveParam(const UScriptStruct* Type, const FName& ID, uint32& OutVersion)
+{
+	// While re-initialization is in progress readers keep getting params from the previous snapshot.
+	const FParamsSnapshotPtr CurrentSnapshot = Get().GetSnapshot();
+	if (!CurrentSnapshot)
 	{
 		UE_LOG(LogParams, Error, TEXT("FParamsRegistry::GetParam: called before initialization has finished"));
+		OutVersion = 0;
 		return nullptr;
 	}
 
-	if (TMap<FName, FParamRegistryDataPtr>* Params = Get().ParamsTree.Find(Type))
-	{
-		FParamRegistryDataPtr* DataRef = Params->Find(ID);
+	OutVersion = CurrentSnapshot->GetVersion();
 
-		if (DataRef)
-		{
-			return *DataRef;
-		}
+	if (const FParamRegistryDataPtr* Param = CurrentSnapshot->Find(Type, ID))
+	{
+		return *Param;
 	}
 	return nullptr;
 }
@@ -192,6 +203,53 @@ FParamRegistryDataPtr FParamsRegistry::GetParam(const FParamRegistryInfo& Param)
 }
 
 
+void FParamsRegistry::PublishSnapshot()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FParamsRegistry::PublishSnapshot);
+
+	FParamsSnapshotPtr NewSnapshot;
+	{
+		FScopeLock AddParamLock(&AddParamMutex);
+		NewSnapshot = MakeShared<const FParamsSnapshot, ESPMode::ThreadSafe>(ParamsTree, SnapshotVersion.Load() + 1);
+	}
+
+	// Old snapshot is released outside of the lock, readers which still hold it keep using it.
+	FParamsSnapshotPtr OldSnapshot;
+	{
+		FWriteScopeLock SnapshotLock(SnapshotMutex);
+		OldSnapshot = MoveTemp(Snapshot);
+		Snapshot = NewSnapshot;
+		SnapshotVersion.Store(NewSnapshot->GetVersion());
+	}
+}
+
+FParamsSnapshotPtr FParamsRegistry::GetSnapshot() const
+{
+	FReadScopeLock SnapshotLock(SnapshotMutex);
+	return Snapshot;
+}
+
+FParamRegistryDataPtr FParamsRegistry::FindParamInTree(const UScriptStruct* Type, const FName& ID) const
+{
+	if (const TMap<FName, FParamRegistryDataPtr>* Params = ParamsTree.Find(Type))
+	{
+		if (const FParamRegistryDataPtr* Param = Params->Find(ID))
+		{
+			return *Param;
+		}
+	}
+	return nullptr;
+}
+
+void FParamsRegistry::ResetFailedParams()
+{
+	FailedParamsNumber.Reset();
+#if WITH_EDITOR
+	FScopeLock AddParamLock(&AddParamMutex);
+	FailedParamsByFile.Empty();
+#endif
+}
+
 int32 FParamsRegistry::GetFailedParamsNumber() const
 {
 	return FailedParamsNumber.GetValue();
@@ -560,14 +618,228 @@ bool FParamsRegistry::LoadParamFromDisk(
 		UE_LOG(LogParams, Warning, TEXT("FParamsRegistry::LoadParamFromDisk: Validation failed for  '%s'"), *Context);
 		return false;
 	}
+	Get().PublishSnapshot();
 
 	Get().OnParamsReloaded.Broadcast();
 	return true;
 }
+
+void FParamsRegistry::ReloadParamFiles(const TArray<FString>& ChangedFiles, const TArray<FString>& RemovedFiles)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FParamsRegistry::ReloadParamFiles);
+	check(IsInGameThread());
+
+	if (ParamsInitialization)
+	{
+		// A full reload is in progress, so apply the files after it to be sure we don't lose the last change.
+		CallWhenInitialized(
+			[this, ChangedFiles, RemovedFiles]()
+			{
+				ReloadParamFiles(ChangedFiles, RemovedFiles);
+			});
+		return;
+	}
+
+	TArray<FString> FullChangedFiles;
+	for (const FString& File : ChangedFiles)
+		FullChangedFiles.AddUnique(FPaths::ConvertRelativePathToFull(File));
+
+	TSet<FString> AffectedFiles;
+	for (const FString& File : RemovedFiles)
+		AffectedFiles.Add(FPaths::ConvertRelativePathToFull(File));
+
+	// Parse changed files. Files which can't be read or deserialized (e.g. are saved halfway) keep their params.
+	TArray<FJsonDataWithMeta> DataWithContexts;
+	FCriticalSection AddDataMutex;
+	TArray<bool> LoadedFiles;
+	LoadedFiles.SetNumZeroed(FullChangedFiles.Num());
+
+	auto HandleFile = [&](int32 Index)
+	{
+		const FString& FilePath = FullChangedFiles[Index];
+
+		FString JsonString;
+		if (FFileHelper::LoadFileToString(JsonString, &IPlatformFile::GetPlatformPhysical(), *FilePath))
+		{
+			LoadedFiles[Index] = FParamsUtils::LoadJsonFromString(JsonString, DataWithContexts, FilePath, &AddDataMutex);
+		}
+	};
+
+	ParallelFor(FullChangedFiles.Num(), HandleFile, EParallelForFlags::Unbalanced);
+
+	for (int32 Index = 0; Index < FullChangedFiles.Num(); Index++)
+	{
+		if (LoadedFiles[Index])
+		{
+			AffectedFiles.Add(FullChangedFiles[Index]);
+		}
+		else
+		{
+			UE_LOG(
+				LogParams,
+				Warning,
+				TEXT("FParamsRegistry::ReloadParamFiles: can't load '%s', its params are kept unchanged"),
+				*FullChangedFiles[Index]);
+		}
+	}
+
+	// Failures of the affected files are counted again while their params are rebuilt.
+	{
+		FScopeLock AddParamLock(&AddParamMutex);
+		for (const FString& File : AffectedFiles)
+		{
+			int32 FileFailedParams = 0;
+			if (FailedParamsByFile.RemoveAndCopyValue(File, FileFailedParams))
+				FailedParamsNumber.Subtract(FileFailedParams);
+		}
+	}
+
+	// Build new params outside of the registry lock.
+	TMap<FParamRegistryInfo, FParamRegistryDataPtr> NewParams;
+	for (const FJsonDataWithMeta& DataWithContext : DataWithContexts)
+	{
+		if (!AffectedFiles.Contains(DataWithContext.ContextualPath))
+			continue;
+
+		FParamRegistryInfo Info;
+		if (!ReadParamHeader(DataWithContext, Info))
+			continue;
+
+		const TSharedPtr<FJsonObject>* DataObject = nullptr;
+		if (!DataWithContext.Data->TryGetObjectField(FParamsRegistryLocal::DataKey, DataObject))
+		{
+			UE_LOG(
+				LogParams,
+				Warning,
+				TEXT("FParamsRegistry::ReloadParamFiles: Can't read 'data' field from JSON: Name='%s', Context='%s'"),
+				*Info.Name.ToString(),
+				*DataWithContext.GetContext());
+			continue;
+		}
+
+		if (NewParams.Contains(Info))
+		{
+			UE_LOG(
+				LogParams,
+				Error,
+				TEXT("FParamsRegistry::ReloadParamFiles: Name dublication found! Name='%s' Struct='%s' Context='%s'"),
+				*Info.Name.ToString(),
+				*Info.Type->GetName(),
+				*DataWithContext.GetContext());
+			continue;
+		}
+
+		const FParamRegistryMeta Meta { DataWithContext.ContextualPath, DataWithContext.ContextualIndex, true, false };
+		if (FParamRegistryDataPtr Param = MakeParam(Info, &Meta, *DataObject))
+		{
+			NewParams.Add(Info, Param);
+		}
+	}
+
+	// Swap all affected params in one batch.
+	TArray<FParamRegistryInfo> ChangedParams;
+	{
+		FScopeLock AddParamLock(&AddParamMutex);
+
+		for (const FString& File : AffectedFiles)
+		{
+			const TSet<FParamRegistryInfo>* FileParams = ParamFilesIndex.Find(File);
+			if (!FileParams)
+				continue;
+
+			for (const FParamRegistryInfo& Info : FileParams->Array())
+			{
+				if (NewParams.Contains(Info))
+					continue;
+
+				TMap<FName, FParamRegistryDataPtr>& DataTypeMap = ParamsTree.FindChecked(Info.Type);
+				if (DataTypeMap.FindChecked(Info.Name)->Meta.bIsChanged)
+				{
+					UE_LOG(
+						LogParams,
+						Warning,
+						TEXT("FParamsRegistry::ReloadParamFiles: param '%s' has unsaved changes and is kept"),
+						*Info.Name.ToString());
+					continue;
+				}
+
+				DataTypeMap.Remove(Info.Name);
+				ParamFilesIndex[File].Remove(Info);
+				ChangedParams.Add(Info);
+			}
+		}
+
+		for (const TPair<FParamRegistryInfo, FParamRegistryDataPtr>& NewParam : NewParams)
+		{
+			if (const FParamRegistryDataPtr OldParam = FindParamInTree(NewParam.Key.Type, NewParam.Key.Name))
+			{
+				if (OldParam->Meta.bIsChanged)
+				{
+					UE_LOG(
+						LogParams,
+						Warning,
+						TEXT("FParamsRegistry::ReloadParamFiles: param '%s' has unsaved changes and is kept"),
+						*NewParam.Key.Name.ToString());
+					continue;
+				}
+
+				const FString OldFullPath = FPaths::ConvertRelativePathToFull(OldParam->Meta.FilePath);
+				if (OldFullPath != NewParam.Value->Meta.FilePath && !AffectedFiles.Contains(OldFullPath))
+				{
+					UE_LOG(
+						LogParams,
+						Error,
+						TEXT(
+							"FParamsRegistry::ReloadParamFiles: Name dublication found! Name='%s' Struct='%s' Path='%s'. Already loaded struct path: '%s'"),
+						*NewParam.Key.Name.ToString(),
+						*NewParam.Key.Type->GetName(),
+						*NewParam.Value->Meta.FilePath,
+						*OldParam->Meta.FilePath);
+					continue;
+				}
+			}
+
+			InsertParam(NewParam.Value);
+			ChangedParams.Add(NewParam.Key);
+		}
+	}
+
+	if (ChangedParams.Num() > 0)
+	{
+		PublishSnapshot();
+	}
+
+	UE_LOG(
+		LogParams,
+		Log,
+		TEXT("FParamsRegistry::ReloadParamFiles: %d files reloaded, %d params changed"),
+		AffectedFiles.Num(),
+		ChangedParams.Num());
+
+	for (const FParamRegistryInfo& Info : ChangedParams)
+	{
+		if (FOnParamChanged* Delegate = ParamChangedDelegates.Find(Info))
+		{
+			Delegate->Broadcast(Info);
+		}
+		OnAnyParamChanged.Broadcast(Info);
+	}
+
+	if (ChangedParams.Num() > 0)
+	{
+		OnParamsReloaded.Broadcast();
+	}
+}
+
+FParamsRegistry::FOnParamChanged& FParamsRegistry::OnParamChanged(const FParamRegistryInfo& Param)
+{
+	return ParamChangedDelegates.FindOrAdd(Param);
+}
 #endif
 
 void FParamsRegistry::FinishParamsInitialization()
 {
+	PublishSnapshot();
 	ParamsInitialization.AtomicSet(false);
 
 	AsyncTask(
@@ -586,11 +858,11 @@ void FParamsRegistry::FinishParamsInitialization()
 		});
 }
 
-void FParamsRegistry::GetParamsFromServer()
+void FParamsRegistry::GetParamsFromServer(bool bFullSync)
 {
 	if (UParamsSettings::Get()->EnableParamsServer)
 	{
-		FRequestParamsFromServerTask::RequestParamsFromServer();
+		FRequestParamsFromServerTask::RequestParamsFromServer(bFullSync);
 	}
 	else
 	{
@@ -602,13 +874,17 @@ int32 FParamsRegistry::CheckParamsRefcounts()
 {
 	int32 ParamsCount = 0;
 
+	const FParamsSnapshotPtr CurrentSnapshot = GetSnapshot();
+
 	for (const auto& DataTypeMap : ParamsTree)
 	{
 		for (const auto& Param : DataTypeMap.Value)
 		{
 			if (Param.Value)
 			{
-				const int32 ReferenceCount = Param.Value.GetSharedReferenceCount();
+				// The published snapshot holds its own reference.
+				const bool bIsInSnapshot = CurrentSnapshot && CurrentSnapshot->Find(DataTypeMap.Key, Param.Key);
+				const int32 ReferenceCount = Param.Value.GetSharedReferenceCount() - (bIsInSnapshot ? 1 : 0);
 
 				if (ReferenceCount != 1)
 				{
@@ -633,7 +909,7 @@ void FParamsRegistry::ReloadParams(IPlatformFile* PlatformFile, const TArray<FSt
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*(FString("FParamsRegistry::ReloadParams [") + PlatformFile->GetName() + "]"));
 
-	FailedParamsNumber.Reset();
+	ResetFailedParams();
 	UsedInstancedObjectsPtrs.Empty();
 
 	TArray<FString> Filenames;
@@ -679,52 +955,88 @@ bool FParamsRegistry::AddParam(
 	TSharedPtr<FJsonObject> JsonData)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FParamsRegistry::AddParam);
-	bool bRes = false;
 
+	FParamRegistryDataPtr Param = MakeParam(ParamInfo, ParamMeta, JsonData);
+	if (!Param)
+		return false;
+
+	FScopeLock AddParamLock(&AddParamMutex);
+	InsertParam(Param);
+
+	return true;
+}
+
+FParamRegistryDataPtr FParamsRegistry::MakeParam(
+	const FParamRegistryInfo& ParamInfo,
+	const FParamRegistryMeta* ParamMeta,
+	TSharedPtr<FJsonObject> JsonData)
+{
 	TArray<uint8> Data;
 
-	if (FParamsUtils::FillDataFromJson(ParamInfo.Type, Data, JsonData))
-	{
-		const FString CPPClassName =
-			FString::Printf(TEXT("%s%s"), ParamInfo.Type->GetPrefixCPP(), *ParamInfo.Type->GetName());
+	if (!FParamsUtils::FillDataFromJson(ParamInfo.Type, Data, JsonData))
+		return nullptr;
 
-		if (ParamsValidation::FParamsValidationManager::Get().ValidateParam(CPPClassName, Data.GetData()))
+	const FString CPPClassName =
+		FString::Printf(TEXT("%s%s"), ParamInfo.Type->GetPrefixCPP(), *ParamInfo.Type->GetName());
+
+	if (!ParamsValidation::FParamsValidationManager::Get().ValidateParam(CPPClassName, Data.GetData()))
+	{
+		FailedParamsNumber.Increment();
+#if WITH_EDITOR
+		if (ParamMeta != nullptr && !ParamMeta->FilePath.IsEmpty())
 		{
 			FScopeLock AddParamLock(&AddParamMutex);
+			FailedParamsByFile.FindOrAdd(FPaths::ConvertRelativePathToFull(ParamMeta->FilePath))++;
+		}
+#endif
+		UE_LOG(
+			LogParams,
+			Warning,
+			TEXT("AddParam: validation failed for object: Name = %s, Type = %s."),
+			*ParamInfo.Name.ToString(),
+			*CPPClassName);
+		return nullptr;
+	}
 
-			TMap<FName, FParamRegistryDataPtr>& DataTypeMap = ParamsTree.FindOrAdd(ParamInfo.Type);
-			DataTypeMap.Remove(ParamInfo.Name);
-
-			FParamRegistryDataPtr* Param = &DataTypeMap.Add(ParamInfo.Name);
-			*Param = MakeShared<FParamRegistryData>();
-			(*Param)->Info = ParamInfo;
+	FParamRegistryDataPtr Param = MakeShared<FParamRegistryData, ESPMode::ThreadSafe>();
+	Param->Info = ParamInfo;
 
 #if WITH_EDITOR
-			if (ParamMeta != nullptr)
-			{
-				(*Param)->Meta = *ParamMeta;
-			}
+	if (ParamMeta != nullptr)
+	{
+		Param->Meta = *ParamMeta;
+	}
 #endif
-			(*Param)->Data = Data;
+	Param->Data = MoveTemp(Data);
 
-			SavePointersToInstancedObjects(*Param);
+	return Param;
+}
 
-			bRes = true;
-		}
-		else
+void FParamsRegistry::InsertParam(FParamRegistryDataPtr Param)
+{
+	const FParamRegistryInfo& ParamInfo = Param->Info;
+
+	TMap<FName, FParamRegistryDataPtr>& DataTypeMap = ParamsTree.FindOrAdd(ParamInfo.Type);
+
+#if WITH_EDITOR
+	if (const FParamRegistryDataPtr* OldParam = DataTypeMap.Find(ParamInfo.Name))
+	{
+		const FString OldFullPath = FPaths::ConvertRelativePathToFull((*OldParam)->Meta.FilePath);
+		if (TSet<FParamRegistryInfo>* OldFileParams = ParamFilesIndex.Find(OldFullPath))
 		{
-			FailedParamsNumber.Increment();
-			UE_LOG(
-				LogParams,
-				Warning,
-				TEXT("AddParam: validation failed for object: Name = %s, Type = %s."),
-				*ParamInfo.Name.ToString(),
-				*CPPClassName);
-			bRes = false;
+			OldFileParams->Remove(ParamInfo);
 		}
 	}
 
-	return bRes;
+	if (!Param->Meta.FilePath.IsEmpty())
+	{
+		ParamFilesIndex.FindOrAdd(FPaths::ConvertRelativePathToFull(Param->Meta.FilePath)).Add(ParamInfo);
+	}
+#endif
+
+	DataTypeMap.Add(ParamInfo.Name, Param);
+
+	SavePointersToInstancedObjects(Param);
 }
 
 void FParamsRegistry::AddParamsFromJsonObjects(const TArray<FJsonDataWithMeta>& DataWithContexts, bool IsDataFromDisk)
@@ -749,37 +1061,9 @@ void FParamsRegistry::AddParamsFromJsonObjects(const TArray<FJsonDataWithMeta>&
 		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(
 			*(FString("FParamsRegistry::AddParamsFromJsonObjects [") + Context + "]: HandleObject"));
 
-		const TSharedPtr<FJsonObject>* HeaderObject = nullptr;
-		if (!JsonObject->TryGetObjectField(FParamsRegistryLocal::HeaderKey, HeaderObject))
-		{
-			UE_LOG(LogParams, Warning, TEXT("Init: Can't read 'header' field from JSON: Context='%s'"), *Context)
-			return;
-		}
 		FParamRegistryInfo Info;
-		if (!FJsonObjectConverter::JsonObjectToUStruct(HeaderObject->ToSharedRef(), &Info))
-		{
-			UE_LOG(
-				LogParams,
-				Warning,
-				TEXT("Init: Can't convert JSON 'header' object to struct: Context='%s'"),
-				*Context)
+		if (!ReadParamHeader(DataWithContext, Info))
 			return;
-		}
-		if (Info.Name.IsNone() || !Info.Name.IsValid())
-		{
-			UE_LOG(LogParams, Warning, TEXT("Init: Name is invalid or None! Context='%s'"), *Context)
-			return;
-		}
-		if (!IsValid(Info.Type))
-		{
-			UE_LOG(
-				LogParams,
-				Warning,
-				TEXT("Init: Invalid type! Name='%s', Context='%s'"),
-				*Info.Name.ToString(),
-				*Context)
-			return;
-		}
 
 		const FParamRegistryMeta* MetaPtr = nullptr;
 #if WITH_EDITOR
@@ -837,11 +1121,102 @@ void FParamsRegistry::AddParamsFromJsonObjects(const TArray<FJsonDataWithMeta>&
 				*Context);
 			return;
 		}
+
+		FScopeLock AddParamLock(&AddParamMutex);
+		if (IsDataFromDisk)
+		{
+			ServerParamFiles.Remove(Info);
+		}
+		else
+		{
+			ServerParamFiles.Add(Info, DataWithContext.ContextualPath);
+		}
 	};
 
 	ParallelFor(DataWithContexts.Num(), HandleObject, EParallelForFlags::ForceSingleThread);
 }
 
+void FParamsRegistry::RemoveUnlistedServerParams(const TSet<FString>& ListedFiles, const TArray<FString>& IncompleteURLs)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FParamsRegistry::RemoveUnlistedServerParams);
+
+	FScopeLock AddParamLock(&AddParamMutex);
+
+	int32 RemovedParams = 0;
+	for (auto It = ServerParamFiles.CreateIterator(); It; ++It)
+	{
+		if (ListedFiles.Contains(It.Value()))
+			continue;
+		if (IncompleteURLs.ContainsByPredicate([&It](const FString& IncompleteURL)
+				{ return FParamsServerManifest::IsUnderURL(It.Value(), IncompleteURL); }))
+			continue;
+
+		const FParamRegistryInfo& Info = It.Key();
+		if (TMap<FName, FParamRegistryDataPtr>* DataTypeMap = ParamsTree.Find(Info.Type))
+		{
+			DataTypeMap->Remove(Info.Name);
+		}
+#if WITH_EDITOR
+		if (TSet<FParamRegistryInfo>* FileParams = ParamFilesIndex.Find(FPaths::ConvertRelativePathToFull(It.Value())))
+		{
+			FileParams->Remove(Info);
+		}
+#endif
+		UE_LOG(
+			LogParams,
+			Verbose,
+			TEXT("FParamsRegistry::RemoveUnlistedServerParams: '%s' is removed, '%s' isn't on the server anymore"),
+			*Info.Name.ToString(),
+			*It.Value());
+
+		It.RemoveCurrent();
+		++RemovedParams;
+	}
+
+	if (RemovedParams > 0)
+	{
+		UE_LOG(
+			LogParams,
+			Log,
+			TEXT("FParamsRegistry::RemoveUnlistedServerParams: %d params of deleted server files are removed"),
+			RemovedParams);
+	}
+}
+
+bool FParamsRegistry::ReadParamHeader(const FJsonDataWithMeta& DataWithContext, FParamRegistryInfo& OutInfo) const
+{
+	const FString Context = DataWithContext.GetContext();
+
+	const TSharedPtr<FJsonObject>* HeaderObject = nullptr;
+	if (!DataWithContext.Data->TryGetObjectField(FParamsRegistryLocal::HeaderKey, HeaderObject))
+	{
+		UE_LOG(LogParams, Warning, TEXT("Init: Can't read 'header' field from JSON: Context='%s'"), *Context)
+		return false;
+	}
+	if (!FJsonObjectConverter::JsonObjectToUStruct(HeaderObject->ToSharedRef(), &OutInfo))
+	{
+		UE_LOG(LogParams, Warning, TEXT("Init: Can't convert JSON 'header' object to struct: Context='%s'"), *Context)
+		return false;
+	}
+	if (OutInfo.Name.IsNone() || !OutInfo.Name.IsValid())
+	{
+		UE_LOG(LogParams, Warning, TEXT("Init: Name is invalid or None! Context='%s'"), *Context)
+		return false;
+	}
+	if (!IsValid(OutInfo.Type))
+	{
+		UE_LOG(
+			LogParams,
+			Warning,
+			TEXT("Init: Invalid type! Name='%s', Context='%s'"),
+			*OutInfo.Name.ToString(),
+			*Context)
+		return false;
+	}
+
+	return true;
+}
+
 void FParamsRegistry::SavePointersToInstancedObjects(FParamRegistryDataPtr Param)
 {
 	const UScriptStruct* Type = Param->Info.Type;
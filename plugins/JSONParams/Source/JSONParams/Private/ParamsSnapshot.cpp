@@ -0,0 +1,74 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "ParamsSnapshot.h"
+
+
+FParamsSnapshot::FParamsSnapshot(
+	const TMap<UScriptStruct*, TMap<FName, FParamRegistryDataPtr>>& ParamsTree,
+	uint32 InVersion)
+	: Version(InVersion)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FParamsSnapshot::FParamsSnapshot);
+
+	for (const auto& DataTypeMap : ParamsTree)
+	{
+		NumParams += DataTypeMap.Value.Num();
+	}
+
+	// Keep load factor <= 0.5 to have short probe sequences.
+	const uint32 NumSlots = FMath::RoundUpToPowerOfTwo(FMath::Max(NumParams * 2, 16));
+	Slots.SetNum(NumSlots);
+	SlotsMask = NumSlots - 1;
+
+	for (const auto& DataTypeMap : ParamsTree)
+	{
+		for (const auto& Param : DataTypeMap.Value)
+		{
+			uint32 Index = GetSlotHash(DataTypeMap.Key, Param.Key) & SlotsMask;
+			while (Slots[Index].Type != nullptr)
+			{
+				Index = (Index + 1) & SlotsMask;
+			}
+
+			Slots[Index].Type = DataTypeMap.Key;
+			Slots[Index].Name = Param.Key;
+			Slots[Index].Param = Param.Value;
+		}
+	}
+}
+
+const FParamRegistryDataPtr* FParamsSnapshot::Find(const UScriptStruct* Type, const FName& Name) const
+{
+	if (Type == nullptr)
+		return nullptr;
+
+	uint32 Index = GetSlotHash(Type, Name) & SlotsMask;
+	while (Slots[Index].Type != nullptr)
+	{
+		const FSlot& Slot = Slots[Index];
+		if (Slot.Type == Type && Slot.Name == Name)
+			return &Slot.Param;
+
+		Index = (Index + 1) & SlotsMask;
+	}
+
+	return nullptr;
+}
+
+uint32 FParamsSnapshot::GetSlotHash(const UScriptStruct* Type, const FName& Name)
+{
+	return HashCombine(PointerHash(Type), GetTypeHash(Name));
+}
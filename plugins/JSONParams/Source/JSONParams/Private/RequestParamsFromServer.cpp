@@ -22,14 +22,104 @@
 #include "HttpModule.h"
 #include "Interfaces/IHttpResponse.h"
 #include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
 
 
+FString FParamsServerManifest::GetCacheDir()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("JSONParams"), TEXT("ServerCache"));
+}
+
+FString FParamsServerManifest::GetCachedFilePath(const FString& URL)
+{
+	return FPaths::Combine(GetCacheDir(), FMD5::HashAnsiString(*URL) + TEXT(".uparam"));
+}
+
+FString FParamsServerManifest::GetContentHash(const FString& Content)
+{
+	const FTCHARToUTF8 Utf8Content(*Content);
+
+	FMD5 Md5;
+	Md5.Update(reinterpret_cast<const uint8*>(Utf8Content.Get()), Utf8Content.Length());
+
+	FMD5Hash Hash;
+	Hash.Set(Md5);
+	return LexToString(Hash);
+}
+
+bool FParamsServerManifest::IsUnderURL(const FString& URL, const FString& ParentURL)
+{
+	if (!URL.StartsWith(ParentURL))
+		return false;
+
+	return URL.Len() == ParentURL.Len() || ParentURL.EndsWith(TEXT("/")) || URL[ParentURL.Len()] == TEXT('/');
+}
+
+bool FParamsServerManifest::Load()
+{
+	const FString ManifestPath = FPaths::Combine(GetCacheDir(), TEXT("Manifest.json"));
+
+	FString JsonString;
+	if (!FPaths::FileExists(ManifestPath) || !FFileHelper::LoadFileToString(JsonString, *ManifestPath))
+		return false;
+
+	if (!FJsonObjectConverter::JsonObjectStringToUStruct(JsonString, this, 0, 0))
+	{
+		UE_LOG(LogParams, Warning, TEXT("FParamsServerManifest::Load: Can't parse '%s', it's ignored"), *ManifestPath);
+		Files.Empty();
+		return false;
+	}
+
+	return true;
+}
+
+bool FParamsServerManifest::Save() const
+{
+	const FString ManifestPath = FPaths::Combine(GetCacheDir(), TEXT("Manifest.json"));
+
+	FString JsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(*this, JsonString)
+		|| !FFileHelper::SaveStringToFile(JsonString, *ManifestPath))
+	{
+		UE_LOG(LogParams, Warning, TEXT("FParamsServerManifest::Save: Can't save '%s'"), *ManifestPath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FParamsServerManifest::LoadCachedFile(const FString& URL, FString& OutContent) const
+{
+	const FParamsServerManifestEntry* Entry = Files.Find(URL);
+	if (!Entry)
+		return false;
+
+	const FString CachedFilePath = GetCachedFilePath(URL);
+	if (!FPaths::FileExists(CachedFilePath) || !FFileHelper::LoadFileToString(OutContent, *CachedFilePath))
+		return false;
+
+	return GetContentHash(OutContent) == Entry->ContentHash;
+}
+
+bool FParamsServerManifest::SaveCachedFile(const FString& URL, const FString& Content)
+{
+	return FFileHelper::SaveStringToFile(
+		Content,
+		*GetCachedFilePath(URL),
+		FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+FThreadSafeBool FRequestParamsFromServerTask::bFullSyncDone = false;
+
 void FRequestParamsFromServerTask::DoWork()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(
 		*(FString("FRequestParamsFromServer::DoWork [") + UParamsSettings::Get()->GetParamsServerURL() + "]"));
 
-	Worker = MakeShareable(new FRequestParamsFromServerWorker());
+	const double StartTime = FPlatformTime::Seconds();
+
+	Worker = MakeShareable(new FRequestParamsFromServerWorker(bFullSync || !bFullSyncDone));
 
 	Worker->RequestFolderContent(UParamsSettings::Get()->GetParamsServerURL());
 
@@ -41,35 +131,91 @@ void FRequestParamsFromServerTask::DoWork()
 
 		FScopeLock RequestsLock(&This.RequestsMutex);
 
-		while (This.RequestsToReprocess.Num())
+		while (This.RequestsToReprocess.Num() && This.Requests.Num() < This.MaxConcurrentRequests)
 		{
 			// We are re-processing request here due to the specification in the docs:
 			// "A request can be re-used but not while still being processed."
 			This.ProcessRequest(This.RequestsToReprocess[0]);
 		}
 
-		return This.Requests.Num() == 0;
+		while (This.PendingRequests.Num() && This.Requests.Num() < This.MaxConcurrentRequests)
+		{
+			const TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> NextRequest = This.PendingRequests[0];
+			This.PendingRequests.RemoveAt(0, 1, false);
+			This.ProcessRequest(NextRequest);
+		}
+
+		return !This.HasActiveRequests();
 	};
 
-	FGenericPlatformProcess::ConditionalSleep(WaitAndCheckAllRequests, 1.f);
+	FGenericPlatformProcess::ConditionalSleep(WaitAndCheckAllRequests, 0.05f);
 
 	UE_LOG(
 		LogParams,
 		Log,
 		TEXT(
-			"FRequestParamsFromServer::DoWork: Downloading stage finished. Stats: HasConnection=%d, ConnectionErrorCounter=%d, ErrorCounter=%d"),
+			"FRequestParamsFromServer::DoWork: Downloading stage finished in %.2f s. Stats: HasConnection=%d, ConnectionErrorCounter=%d, ErrorCounter=%d, Downloaded=%d (%lld bytes), NotModified=%d, Unchanged=%d"),
+		FPlatformTime::Seconds() - StartTime,
 		static_cast<int32>(Worker->HasConnection),
 		Worker->ConnectionErrorCounter.GetValue(),
-		Worker->ErrorCounter.GetValue());
+		Worker->ErrorCounter.GetValue(),
+		Worker->DownloadedFiles.GetValue(),
+		Worker->DownloadedBytes.GetValue(),
+		Worker->NotModifiedFiles.GetValue(),
+		Worker->UnchangedFiles.GetValue());
 
 	if (Worker->HasConnection
 		&& Worker->ConnectionErrorCounter.GetValue() <= UParamsSettings::Get()->MaxConnectionErrors
 		&& Worker->ErrorCounter.GetValue() <= UParamsSettings::Get()->MaxErrors)
+	{
+		if (Worker->IncompleteURLs.Num())
+		{
+			UE_LOG(
+				LogParams,
+				Warning,
+				TEXT("FRequestParamsFromServer::DoWork: %d folders or files weren't synced, params under them are kept"),
+				Worker->IncompleteURLs.Num());
+		}
+
+		TSet<FString> ListedFiles;
+		Worker->NewManifest.Files.GetKeys(ListedFiles);
+		FParamsRegistry::Get().RemoveUnlistedServerParams(ListedFiles, Worker->IncompleteURLs);
 		FParamsRegistry::Get().AddParamsFromJsonObjects(Worker->DataWithContexts);
+		bFullSyncDone = true;
+
+		if (Worker->bUseCache)
+		{
+			for (const TPair<FString, FParamsServerManifestEntry>& OldFile : Worker->OldManifest.Files)
+			{
+				if (Worker->NewManifest.Files.Contains(OldFile.Key))
+					continue;
+
+				// Not seen this time, the local copy stays for the next sync
+				if (Worker->IsIncomplete(OldFile.Key))
+				{
+					Worker->NewManifest.Files.Add(OldFile.Key, OldFile.Value);
+					continue;
+				}
+				IFileManager::Get().Delete(*FParamsServerManifest::GetCachedFilePath(OldFile.Key));
+			}
+			Worker->NewManifest.Save();
+		}
+	}
 
 	FParamsRegistry::Get().FinishParamsInitialization();
 }
 
+FRequestParamsFromServerWorker::FRequestParamsFromServerWorker(bool bInFullSync)
+	: bUseCache(UParamsSettings::Get()->EnableParamsServerCache)
+	, bFullSync(bInFullSync)
+	, MaxConcurrentRequests(FMath::Max(1, UParamsSettings::Get()->MaxConcurrentRequests))
+{
+	if (bUseCache)
+	{
+		OldManifest.Load();
+	}
+}
+
 void FRequestParamsFromServerWorker::RequestFolderContent(FString URL)
 {
 	const FHttpRequestRef Request = CreateRequest(URL);
@@ -87,6 +233,8 @@ void FRequestParamsFromServerWorker::RequestFolderContent(FString URL)
 		if (!FJsonObjectConverter::JsonArrayStringToUStruct(Response->GetContentAsString(), &Data))
 		{
 			UE_LOG(LogParams, Warning, TEXT("FRequestParamsFromServer::RequestFolderContent: Can't parse responce"))
+			This.MarkIncomplete(Request->GetURL());
+			This.FreeRequest(Request);
 			return;
 		}
 
@@ -108,7 +256,7 @@ void FRequestParamsFromServerWorker::RequestFolderContent(FString URL)
 					Verbose,
 					TEXT("FRequestParamsFromServer::RequestFolderContent: File: %s"),
 					*Content.Name)
-				This.RequestFile(Request->GetURL() / Content.Name);
+				This.RequestFile(Request->GetURL() / Content.Name, Content.MTime);
 			}
 		}
 
@@ -117,34 +265,117 @@ void FRequestParamsFromServerWorker::RequestFolderContent(FString URL)
 
 	Request->OnProcessRequestComplete().BindLambda(OnComplete);
 
-	ProcessRequest(Request);
+	EnqueueRequest(Request);
 }
 
-void FRequestParamsFromServerWorker::RequestFile(FString URL)
+void FRequestParamsFromServerWorker::RequestFile(FString URL, FString MTime)
 {
+	FString CachedContent;
+	const FParamsServerManifestEntry* CachedEntry = bUseCache ? OldManifest.Files.Find(URL) : nullptr;
+	if (CachedEntry && !OldManifest.LoadCachedFile(URL, CachedContent))
+	{
+		CachedEntry = nullptr;
+	}
+
+	// Autoindex says the file wasn't touched since the last sync, so there is no need to ask for it at all.
+	if (CachedEntry && !MTime.IsEmpty() && CachedEntry->MTime == MTime)
+	{
+		UnchangedFiles.Increment();
+		AddFileContent(URL, *CachedEntry, CachedContent, false);
+		return;
+	}
+
 	const FHttpRequestRef Request = CreateRequest(URL);
 
-	auto OnComplete = [WeakThis = GetWeakThis()](FHttpRequestPtr Request, FHttpResponsePtr Response, bool Connected)
+	if (CachedEntry)
+	{
+		if (!CachedEntry->ETag.IsEmpty())
+			Request->SetHeader(TEXT("If-None-Match"), CachedEntry->ETag);
+		if (!CachedEntry->LastModified.IsEmpty())
+			Request->SetHeader(TEXT("If-Modified-Since"), CachedEntry->LastModified);
+	}
+
+	auto OnComplete = [WeakThis = GetWeakThis(),
+					   URL,
+					   MTime,
+					   bHasCachedEntry = CachedEntry != nullptr,
+					   CachedEntry = CachedEntry ? *CachedEntry : FParamsServerManifestEntry(),
+					   CachedContent](FHttpRequestPtr Request, FHttpResponsePtr Response, bool Connected)
 	{
 		if (!WeakThis.IsValid())
 			return;
 		FRequestParamsFromServerWorker& This = *WeakThis.Pin();
 
+		if (bHasCachedEntry && Connected && Response.IsValid()
+			&& Response->GetResponseCode() == EHttpResponseCodes::NotModified)
+		{
+			This.HasConnection = true;
+			This.NotModifiedFiles.Increment();
+
+			FParamsServerManifestEntry Entry = CachedEntry;
+			Entry.MTime = MTime;
+			This.AddFileContent(URL, Entry, CachedContent, false);
+
+			This.FreeRequest(Request);
+			return;
+		}
+
 		if (!This.CheckResponse(Request, Response, Connected))
 			return;
 
-		FParamsUtils::LoadJsonFromString(
-			Response->GetContentAsString(),
-			This.DataWithContexts,
-			Request->GetURL(),
-			&This.DataWithContextsMutex);
+		const FString Content = Response->GetContentAsString();
+
+		FParamsServerManifestEntry Entry;
+		Entry.MTime = MTime;
+		Entry.ETag = Response->GetHeader(TEXT("ETag"));
+		Entry.LastModified = Response->GetHeader(TEXT("Last-Modified"));
+		Entry.ContentHash = FParamsServerManifest::GetContentHash(Content);
+
+		This.DownloadedFiles.Increment();
+		This.DownloadedBytes.Add(Response->GetContentLength());
+
+		const bool bChanged = !bHasCachedEntry || CachedEntry.ContentHash != Entry.ContentHash;
+		if (This.bUseCache && bChanged)
+		{
+			FParamsServerManifest::SaveCachedFile(URL, Content);
+		}
+
+		This.AddFileContent(URL, Entry, Content, bChanged);
 
 		This.FreeRequest(Request);
 	};
 
 	Request->OnProcessRequestComplete().BindLambda(OnComplete);
 
-	ProcessRequest(Request);
+	EnqueueRequest(Request);
+}
+
+void FRequestParamsFromServerWorker::MarkIncomplete(const FString& URL)
+{
+	FScopeLock DataLock(&DataWithContextsMutex);
+	IncompleteURLs.Add(URL);
+}
+
+bool FRequestParamsFromServerWorker::IsIncomplete(const FString& URL)
+{
+	FScopeLock DataLock(&DataWithContextsMutex);
+	return IncompleteURLs.ContainsByPredicate([&URL](const FString& IncompleteURL)
+		{ return FParamsServerManifest::IsUnderURL(URL, IncompleteURL); });
+}
+
+void FRequestParamsFromServerWorker::AddFileContent(
+	const FString& URL,
+	const FParamsServerManifestEntry& Entry,
+	const FString& Content,
+	bool bChanged)
+{
+	if (bChanged || bFullSync)
+	{
+		FParamsUtils::LoadJsonFromString(Content, DataWithContexts, URL, &DataWithContextsMutex);
+	}
+
+	FScopeLock DataLock(&DataWithContextsMutex);
+	NewManifest.Files.Add(URL, Entry);
 }
 
 TSharedRef<IHttpRequest, ESPMode::ThreadSafe> FRequestParamsFromServerWorker::CreateRequest(FString URL)
@@ -168,10 +399,38 @@ void FRequestParamsFromServerWorker::ProcessRequest(TSharedPtr<IHttpRequest, ESP
 	Request->ProcessRequest();
 }
 
+void FRequestParamsFromServerWorker::EnqueueRequest(TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request)
+{
+	FScopeLock RequestsLock(&RequestsMutex);
+
+	if (Requests.Num() < MaxConcurrentRequests)
+	{
+		ProcessRequest(Request);
+	}
+	else
+	{
+		PendingRequests.Add(Request);
+	}
+}
+
 void FRequestParamsFromServerWorker::FreeRequest(TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request)
 {
 	FScopeLock RequestsLock(&RequestsMutex);
 	Requests.Remove(Request);
+
+	// Retries are started from the task thread only, see FRequestParamsFromServerTask::DoWork
+	while (PendingRequests.Num() && Requests.Num() < MaxConcurrentRequests)
+	{
+		const TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> NextRequest = PendingRequests[0];
+		PendingRequests.RemoveAt(0, 1, false);
+		ProcessRequest(NextRequest);
+	}
+}
+
+bool FRequestParamsFromServerWorker::HasActiveRequests()
+{
+	FScopeLock RequestsLock(&RequestsMutex);
+	return Requests.Num() || PendingRequests.Num() || RequestsToReprocess.Num();
 }
 
 bool FRequestParamsFromServerWorker::CheckResponse(
@@ -202,6 +461,7 @@ bool FRequestParamsFromServerWorker::CheckResponse(
 				LogParams,
 				Error,
 				TEXT("FRequestParamsFromServer::RequestFolderContent: Connection failed, aborting."));
+			MarkIncomplete(Request->GetURL());
 			FreeRequest(Request);
 			return false;
 		}
@@ -222,6 +482,7 @@ bool FRequestParamsFromServerWorker::CheckResponse(
 				Warning,
 				TEXT("FRequestParamsFromServer::RequestFolderContent: Request failed, skipping. Responce code: [%d]"),
 				ResponseCode);
+			MarkIncomplete(Request->GetURL());
 			FreeRequest(Request);
 			return false;
 		}
@@ -233,6 +494,7 @@ bool FRequestParamsFromServerWorker::CheckResponse(
 				Error,
 				TEXT("FRequestParamsFromServer::RequestFolderContent: Request failed, aborting. Responce code: [ %d ]"),
 				ResponseCode);
+			MarkIncomplete(Request->GetURL());
 			FreeRequest(Request);
 			return false;
 		}
@@ -0,0 +1,172 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "ParamsRegistry.h"
+#include "VSPTests.h"
+
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+
+#if WITH_EDITOR
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace ParamsRegistryBenchmarkLocal
+{
+	constexpr int32 ParamsNum = 1000;
+	constexpr int32 ReadersNum = 8;
+	constexpr int32 ReloadsNum = 20;
+
+	FString MakeParamsFile(int32 Iteration)
+	{
+		FString Json = TEXT("[");
+		for (int32 Index = 0; Index < ParamsNum; Index++)
+		{
+			Json += FString::Printf(
+				TEXT("%s{\"header\":{\"Type\":\"/Script/JSONParams.ParamRegistryMeta\",\"Name\":\"SnapshotBench_%d\"},")
+					TEXT("\"data\":{\"ParamIndex\":%d}}"),
+				Index > 0 ? TEXT(",") : TEXT(""),
+				Index,
+				Iteration);
+		}
+		return Json + TEXT("]");
+	}
+
+	// Runs readers on dedicated threads while the game thread keeps reloading the params file.
+	template<typename T_ReadFunc>
+	void RunReaders(
+		FAutomationTestBase& Test,
+		const TCHAR* ModeName,
+		const FString& FilePath,
+		T_ReadFunc ReadFunc,
+		int64& OutMisses)
+	{
+		TAtomic<bool> bStop { false };
+		TArray<TFuture<TPair<int64, int64>>> Readers;
+
+		for (int32 Reader = 0; Reader < ReadersNum; Reader++)
+		{
+			Readers.Add(Async(
+				EAsyncExecution::Thread,
+				[&bStop, &ReadFunc, Reader]()
+				{
+					return ReadFunc(bStop, Reader);
+				}));
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		double ReloadTime = 0.0;
+		for (int32 Reload = 0; Reload < ReloadsNum; Reload++)
+		{
+			FFileHelper::SaveStringToFile(MakeParamsFile(Reload), *FilePath);
+
+			const double ReloadStartTime = FPlatformTime::Seconds();
+			FParamsRegistry::Get().ReloadParamFiles({ FilePath }, {});
+			ReloadTime += FPlatformTime::Seconds() - ReloadStartTime;
+		}
+		bStop = true;
+
+		int64 Reads = 0;
+		OutMisses = 0;
+		for (TFuture<TPair<int64, int64>>& Reader : Readers)
+		{
+			const TPair<int64, int64> Result = Reader.Get();
+			Reads += Result.Key;
+			OutMisses += Result.Value;
+		}
+		const double Duration = FPlatformTime::Seconds() - StartTime;
+
+		Test.AddInfo(FString::Printf(
+			TEXT("%s: %d readers, %lld reads in %.3f s (%.1f M reads/s), %d reloads took %.3f ms on average"),
+			ModeName,
+			ReadersNum,
+			Reads,
+			Duration,
+			Reads / Duration / 1000000.0,
+			ReloadsNum,
+			ReloadTime / ReloadsNum * 1000.0));
+	}
+}
+
+VSP_TEST(JSONParams, SnapshotReadContention, TestsFlags)
+{
+	using namespace ParamsRegistryBenchmarkLocal;
+
+	FParamsRegistry& Registry = FParamsRegistry::Get();
+	const FString FilePath =
+		FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("SnapshotReadContention.uparam"));
+
+	FFileHelper::SaveStringToFile(MakeParamsFile(0), *FilePath);
+	Registry.ReloadParamFiles({ FilePath }, {});
+
+	TArray<FName> Names;
+	for (int32 Index = 0; Index < ParamsNum; Index++)
+		Names.Add(*FString::Printf(TEXT("SnapshotBench_%d"), Index));
+
+	if (!FParamsRegistry::GetParam<FParamRegistryMeta>(Names[0]))
+	{
+		AddWarning(TEXT("Registry is not initialized, benchmark is skipped"));
+		return true;
+	}
+
+	int64 Misses = 0;
+
+	RunReaders(
+		*this,
+		TEXT("GetParam"),
+		FilePath,
+		[&Names](const TAtomic<bool>& bStop, int32 Reader)
+		{
+			int64 Reads = 0;
+			int64 ReaderMisses = 0;
+			for (int32 Index = Reader; !bStop; Index = (Index + 1) % ParamsNum)
+			{
+				ReaderMisses += FParamsRegistry::GetParam<FParamRegistryMeta>(Names[Index]) ? 0 : 1;
+				Reads++;
+			}
+			return TPair<int64, int64>(Reads, ReaderMisses);
+		},
+		Misses);
+	VSP_EXPECT_EQ(Misses, 0);
+
+	RunReaders(
+		*this,
+		TEXT("TParamHandle"),
+		FilePath,
+		[&Names](const TAtomic<bool>& bStop, int32 Reader)
+		{
+			TArray<TParamHandle<FParamRegistryMeta>> Handles;
+			for (const FName& Name : Names)
+				Handles.Emplace(Name);
+
+			int64 Reads = 0;
+			int64 ReaderMisses = 0;
+			for (int32 Index = Reader; !bStop; Index = (Index + 1) % ParamsNum)
+			{
+				ReaderMisses += Handles[Index].Get() ? 0 : 1;
+				Reads++;
+			}
+			return TPair<int64, int64>(Reads, ReaderMisses);
+		},
+		Misses);
+	VSP_EXPECT_EQ(Misses, 0);
+
+	Registry.ReloadParamFiles({}, { FilePath });
+	IFileManager::Get().Delete(*FilePath);
+
+	return true;
+}
+
+#endif
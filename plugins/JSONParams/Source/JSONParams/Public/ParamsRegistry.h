@@ -15,6 +15,7 @@
 */ 
 #pragma once
 
+#include "ParamsSnapshot.h"
 #include "UObject/StrongObjectPtr.h"
 #include "Utils/ParamsUtils.h"
 
@@ -23,11 +24,9 @@
 class UParamsSettings;
 class UJSONParamsBrowserDataSource;
 class FJSONParamsEditorModule;
+class FJSONParamsHotReloader;
 class FJSONParamsModule;
 struct FRequestParamsFromServerTask;
-struct FParamRegistryData;
-
-using FParamRegistryDataPtr = TSharedPtr<FParamRegistryData>;
 
 template<typename T_ParamType>
 struct FParamSharedPtr
@@ -57,6 +56,42 @@ private:
 	FParamRegistryDataPtr DataPtr = nullptr;
 };
 
+// Resolves the param once and caches it until the registry publishes a new snapshot.
+// Dereference is a single relaxed atomic load and compare, without locks and hashing.
+// The handle itself is not thread safe: use one handle per thread or owner.
+template<typename T_ParamType>
+struct TParamHandle
+{
+	TParamHandle() = default;
+
+	explicit TParamHandle(const FName& InName) : Name(InName)
+	{
+	}
+
+	const T_ParamType* Get() const;
+
+	const T_ParamType* operator->() const
+	{
+		return Get();
+	}
+
+	explicit operator bool() const
+	{
+		return Get() != nullptr;
+	}
+
+	const FName& GetName() const
+	{
+		return Name;
+	}
+
+private:
+	FName Name = NAME_None;
+
+	mutable FParamRegistryDataPtr CachedParam;
+	mutable uint32 CachedVersion = 0;
+};
+
 
 USTRUCT(BlueprintType)
 struct JSONPARAMS_API FParamRegistryInfo
@@ -122,6 +157,7 @@ struct JSONPARAMS_API FParamsRegistry
 	friend FRequestParamsFromServerTask;
 	friend FJSONParamsModule;
 	friend FJSONParamsEditorModule;
+	friend FJSONParamsHotReloader;
 	friend UParamsSettings;
 	friend UJSONParamsBrowserDataSource;
 
@@ -139,6 +175,15 @@ struct JSONPARAMS_API FParamsRegistry
 	template<typename T_ParamType>
 	static FParamSharedPtr<const T_ParamType> GetParam(const FParamRegistryInfo& Param);
 
+	// Looks param up in the current snapshot and returns the version of this snapshot.
+	static FParamRegistryDataPtr ResolveParam(const UScriptStruct* Type, const FName& ID, uint32& OutVersion);
+
+	// Version of the published snapshot, changes on every registry change. 0 means nothing is published yet.
+	uint32 GetSnapshotVersion() const
+	{
+		return SnapshotVersion.Load(EMemoryOrder::Relaxed);
+	}
+
 	int32 GetFailedParamsNumber() const;
 
 	FText GetRegistryInfoText() const;
@@ -167,6 +212,16 @@ struct JSONPARAMS_API FParamsRegistry
 	static void ModifyParamChangedState(const UScriptStruct* Type, const FName& ID, bool IsChanged = true);
 	static bool LoadParamFromDisk(UScriptStruct* Type, const FName& Name, const FString& FilePath, int32 IndexInFile);
 
+	// Re-parses only the given param files and swaps affected params in one batch.
+	// Unlike Init() the registry stays readable: GetParam keeps working and holders of old pointers keep old values.
+	void ReloadParamFiles(const TArray<FString>& ChangedFiles, const TArray<FString>& RemovedFiles);
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnParamChanged, const FParamRegistryInfo&);
+	// Fired by ReloadParamFiles for the param after it was replaced, added or removed.
+	FOnParamChanged& OnParamChanged(const FParamRegistryInfo& Param);
+	// Fired by ReloadParamFiles for every replaced, added or removed param.
+	FOnParamChanged OnAnyParamChanged;
+
 	DECLARE_MULTICAST_DELEGATE(FOnParamsInitStarted);
 	FOnParamsInitStarted OnParamsInitStarted;
 
@@ -181,14 +236,27 @@ protected:
 
 #if WITH_EDITOR
 	FCriticalSection EditorParamUniqueNameCheckMutex;
+
+	// Full file path -> params loaded from it. Guarded by AddParamMutex.
+	TMap<FString, TSet<FParamRegistryInfo>> ParamFilesIndex;
+	TMap<FParamRegistryInfo, FOnParamChanged> ParamChangedDelegates;
+	// Full file path -> number of its params that failed validation, so a reload replaces its share of FailedParamsNumber. Guarded by AddParamMutex.
+	TMap<FString, int32> FailedParamsByFile;
 #endif
 
 	FCriticalSection AddParamMutex;
+	// Param -> server file URL it was last loaded from. Guarded by AddParamMutex.
+	TMap<FParamRegistryInfo, FString> ServerParamFiles;
+
+	// Readers hold SnapshotMutex only to take the pointer, the lookup itself runs on immutable data.
+	mutable FRWLock SnapshotMutex;
+	FParamsSnapshotPtr Snapshot;
+	TAtomic<uint32> SnapshotVersion { 0 };
 
 	FThreadSafeBool ParamsInitialization;
 	FThreadSafeCounter FailedParamsNumber;
 
-	void GetParamsFromServer();
+	void GetParamsFromServer(bool bFullSync);
 	int32 CheckParamsRefcounts();
 
 	void ReloadParams(IPlatformFile* PlatformFile, const TArray<FString>& ParamsPaths);
@@ -205,8 +273,25 @@ protected:
 private:
 	void Init();
 
+	// Builds a snapshot from ParamsTree and makes it visible to readers.
+	void PublishSnapshot();
+	FParamsSnapshotPtr GetSnapshot() const;
+	FParamRegistryDataPtr FindParamInTree(const UScriptStruct* Type, const FName& ID) const;
+
 	void AddParamsFromJsonObjects(const TArray<FJsonDataWithMeta>& DataWithContexts, bool IsDataFromDisk = false);
+	bool ReadParamHeader(const FJsonDataWithMeta& DataWithContext, FParamRegistryInfo& OutInfo) const;
+	// Removes params loaded from server files that are no longer listed by the server.
+	// Files under IncompleteURLs are kept, their listing or download didn't finish.
+	void RemoveUnlistedServerParams(const TSet<FString>& ListedFiles, const TArray<FString>& IncompleteURLs);
+
+	FParamRegistryDataPtr MakeParam(
+		const FParamRegistryInfo& ParamInfo,
+		const FParamRegistryMeta* ParamMeta,
+		TSharedPtr<FJsonObject> JsonData);
+	// Should be called under AddParamMutex.
+	void InsertParam(FParamRegistryDataPtr Param);
 	void FinishParamsInitialization();
+	void ResetFailedParams();
 
 	void SavePointersToInstancedObjects(FParamRegistryDataPtr Param);
 
@@ -239,6 +324,17 @@ const T_ParamType* FParamSharedPtr<T_ParamType>::operator->() const
 	return static_cast<const T_ParamType*>(static_cast<void*>(DataPtr->Data.GetData()));
 }
 
+template<typename T_ParamType>
+const T_ParamType* TParamHandle<T_ParamType>::Get() const
+{
+	if (CachedVersion != FParamsRegistry::Get().GetSnapshotVersion())
+	{
+		CachedParam = FParamsRegistry::ResolveParam(T_ParamType::StaticStruct(), Name, CachedVersion);
+	}
+
+	return CachedParam ? static_cast<const T_ParamType*>(static_cast<void*>(CachedParam->Data.GetData())) : nullptr;
+}
+
 template<typename T_ParamType>
 FParamSharedPtr<const T_ParamType> FParamRegistryInfo::Get() const
 {
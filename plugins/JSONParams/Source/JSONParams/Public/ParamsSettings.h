@@ -61,6 +61,12 @@ public:
 	UPROPERTY(EditAnywhere, Config, Category = "File Params")
 	TArray<FDirectoryPath> ParamFilesRootPaths { {} };
 
+#if WITH_EDITORONLY_DATA
+	// Watch param root paths and reload only changed files without full registry re-init.
+	UPROPERTY(EditAnywhere, Config, Category = "File Params")
+	bool EnableParamsHotReload = true;
+#endif
+
 	UPROPERTY(EditAnywhere, Config, Category = "Params Server")
 	bool EnableParamsServer = false;
 
@@ -72,6 +78,14 @@ public:
 	UPROPERTY(EditAnywhere, Config, Category = "Params Server", AdvancedDisplay)
 	int32 MaxErrors = 5;
 
+	// How many requests to params server can be processed at the same time.
+	UPROPERTY(EditAnywhere, Config, Category = "Params Server", AdvancedDisplay, meta = (ClampMin = 1))
+	int32 MaxConcurrentRequests = 16;
+
+	// Keep a manifest and local copies of server files in Saved dir to download only changed files.
+	UPROPERTY(EditAnywhere, Config, Category = "Params Server", AdvancedDisplay)
+	bool EnableParamsServerCache = true;
+
 private:
 	static bool IsEnvVariable(const FString& Variable);
 	FString GetEnvVariable(const FString& Variable) const;
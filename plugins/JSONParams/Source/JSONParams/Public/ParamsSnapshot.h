@@ -0,0 +1,57 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+
+struct FParamRegistryData;
+
+using FParamRegistryDataPtr = TSharedPtr<FParamRegistryData, ESPMode::ThreadSafe>;
+
+// Immutable flat copy of the params tree. Registry publishes a new one on every change, readers never see it mutate.
+// Open addressing table with linear probing keyed by (struct, name), so a lookup is a single hash and a few compares.
+struct JSONPARAMS_API FParamsSnapshot
+{
+	FParamsSnapshot(const TMap<UScriptStruct*, TMap<FName, FParamRegistryDataPtr>>& ParamsTree, uint32 InVersion);
+
+	const FParamRegistryDataPtr* Find(const UScriptStruct* Type, const FName& Name) const;
+
+	uint32 GetVersion() const
+	{
+		return Version;
+	}
+
+	int32 Num() const
+	{
+		return NumParams;
+	}
+
+private:
+	struct FSlot
+	{
+		const UScriptStruct* Type = nullptr;
+		FName Name = NAME_None;
+		FParamRegistryDataPtr Param;
+	};
+
+	static uint32 GetSlotHash(const UScriptStruct* Type, const FName& Name);
+
+	TArray<FSlot> Slots;
+	uint32 SlotsMask = 0;
+	int32 NumParams = 0;
+	uint32 Version = 0;
+};
+
+using FParamsSnapshotPtr = TSharedPtr<const FParamsSnapshot, ESPMode::ThreadSafe>;
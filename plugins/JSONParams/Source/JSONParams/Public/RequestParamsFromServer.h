@@ -47,34 +47,105 @@ struct FNGINXContent
 	FString MTime = "";
 };
 
+// State of a server file after the last successful sync.
+USTRUCT()
+struct FParamsServerManifestEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FString MTime = "";
+
+	UPROPERTY()
+	FString ETag = "";
+
+	UPROPERTY()
+	FString LastModified = "";
+
+	UPROPERTY()
+	FString ContentHash = "";
+};
+
+// Local manifest of params server files. Local copies of files are kept next to it, so unchanged files aren't downloaded.
+USTRUCT()
+struct FParamsServerManifest
+{
+	GENERATED_BODY()
+
+	// URL -> file state
+	UPROPERTY()
+	TMap<FString, FParamsServerManifestEntry> Files;
+
+	static FString GetCacheDir();
+	static FString GetCachedFilePath(const FString& URL);
+	static FString GetContentHash(const FString& Content);
+	// True if URL is ParentURL itself or lies in the folder ParentURL.
+	static bool IsUnderURL(const FString& URL, const FString& ParentURL);
+
+	bool Load();
+	bool Save() const;
+
+	// Returns false if there is no local copy or it doesn't match the manifest.
+	bool LoadCachedFile(const FString& URL, FString& OutContent) const;
+	static bool SaveCachedFile(const FString& URL, const FString& Content);
+};
+
 struct FRequestParamsFromServerWorker : public TSharedFromThis<FRequestParamsFromServerWorker, ESPMode::ThreadSafe>
 {
+	explicit FRequestParamsFromServerWorker(bool bInFullSync);
+
+	// Requests in flight, their number is limited by MaxConcurrentRequests.
 	TArray<TSharedPtr<IHttpRequest, ESPMode::ThreadSafe>> Requests;
+	// New requests waiting for a free slot.
+	TArray<TSharedPtr<IHttpRequest, ESPMode::ThreadSafe>> PendingRequests;
+	// Failed requests to retry, they can be re-processed only from the task thread.
 	TArray<TSharedPtr<IHttpRequest, ESPMode::ThreadSafe>> RequestsToReprocess;
 	FCriticalSection RequestsMutex;
 
+	// Guards DataWithContexts and NewManifest.
 	TArray<FJsonDataWithMeta> DataWithContexts;
+	FParamsServerManifest NewManifest;
+	// Folders and files that were skipped or failed, the server may still have anything under them.
+	TArray<FString> IncompleteURLs;
 	FCriticalSection DataWithContextsMutex;
 
+	// Read only after construction.
+	FParamsServerManifest OldManifest;
+	bool bUseCache = false;
+	// Unchanged files are added to DataWithContexts too, e.g. on registry init.
+	bool bFullSync = true;
+	int32 MaxConcurrentRequests = 1;
+
 	// Connection controller
 	FThreadSafeBool HasConnection;
 	FThreadSafeCounter ConnectionErrorCounter;
 	FThreadSafeCounter ErrorCounter = 0;
 
+	// Stats
+	FThreadSafeCounter DownloadedFiles;
+	FThreadSafeCounter NotModifiedFiles;
+	FThreadSafeCounter UnchangedFiles;
+	FThreadSafeCounter64 DownloadedBytes;
+
 	TWeakPtr<FRequestParamsFromServerWorker, ESPMode::ThreadSafe> GetWeakThis()
 	{
 		return AsShared();
 	};
 
 	void RequestFolderContent(FString URL);
-	void RequestFile(FString URL);
+	void RequestFile(FString URL, FString MTime);
+	void MarkIncomplete(const FString& URL);
+	bool IsIncomplete(const FString& URL);
 
 	// Create simple GET request
 	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateRequest(FString URL);
+	// Start processing request if there is a free slot or put it to PendingRequests.
+	void EnqueueRequest(TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request);
 	// Start processing request and add to Requests queue we are waiting before data process starts.
 	void ProcessRequest(TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request);
-	// Remove process from Requests queue. E.g. it's complete.
+	// Remove process from Requests queue and start the next pending one. E.g. it's complete.
 	void FreeRequest(TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request);
+	bool HasActiveRequests();
 	/*
 	 * Check response and retry request if it's failed
 	 * Return false if request can't be processed
@@ -83,6 +154,9 @@ struct FRequestParamsFromServerWorker : public TSharedFromThis<FRequestParamsFro
 		TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request,
 		TSharedPtr<IHttpResponse, ESPMode::ThreadSafe> Response,
 		bool Connected);
+
+	// Register file in the new manifest and pass its content further if needed.
+	void AddFileContent(const FString& URL, const FParamsServerManifestEntry& Entry, const FString& Content, bool bChanged);
 };
 
 struct FRequestParamsFromServerTask : public FNonAbandonableTask
@@ -90,16 +164,25 @@ struct FRequestParamsFromServerTask : public FNonAbandonableTask
 	friend class FAutoDeleteAsyncTask<FRequestParamsFromServerTask>;
 
 public:
+	explicit FRequestParamsFromServerTask(bool bInFullSync) : bFullSync(bInFullSync)
+	{
+	}
+
 	virtual ~FRequestParamsFromServerTask() = default;
 
-	static void RequestParamsFromServer(FQueuedThreadPool* InQueuedPool = GBackgroundPriorityThreadPool)
+	// With bFullSync == false only params from files changed since the last sync are added to the registry.
+	static void RequestParamsFromServer(bool bFullSync, FQueuedThreadPool* InQueuedPool = GBackgroundPriorityThreadPool)
 	{
-		(new FAutoDeleteAsyncTask<FRequestParamsFromServerTask>())->StartBackgroundTask(InQueuedPool);
+		(new FAutoDeleteAsyncTask<FRequestParamsFromServerTask>(bFullSync))->StartBackgroundTask(InQueuedPool);
 	}
 
 protected:
 	virtual void DoWork();
 
+	bool bFullSync = true;
+	// Delta sync makes sense only after all server params were added to the registry once.
+	static FThreadSafeBool bFullSyncDone;
+
 	TSharedPtr<FRequestParamsFromServerWorker, ESPMode::ThreadSafe> Worker;
 	TWeakPtr<FRequestParamsFromServerWorker, ESPMode::ThreadSafe> GetWeakWorker()
 	{
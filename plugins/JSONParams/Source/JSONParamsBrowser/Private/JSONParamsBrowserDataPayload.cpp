@@ -66,7 +66,7 @@ bool FJSONParamsBrowserDataPayload::IsParamValid() const
 
 void FJSONParamsBrowserDataPayload::UpdateThumbnail(FAssetThumbnail& InThumbnail) const
 {
-	if (const TSharedPtr<FParamRegistryData> ParamRegistryDataSharedPtr = ParamRegistryDataPtr.Pin())
+	if (const FParamRegistryDataPtr ParamRegistryDataSharedPtr = ParamRegistryDataPtr.Pin())
 	{
 		const FAssetData tempAssetData(
 			NAME_None,
@@ -79,7 +79,7 @@ void FJSONParamsBrowserDataPayload::UpdateThumbnail(FAssetThumbnail& InThumbnail
 
 const FParamRegistryMeta* FJSONParamsBrowserDataPayload::GetMeta() const
 {
-	if (const TSharedPtr<FParamRegistryData> ParamRegistryDataSharedPtr = ParamRegistryDataPtr.Pin())
+	if (const FParamRegistryDataPtr ParamRegistryDataSharedPtr = ParamRegistryDataPtr.Pin())
 		return &ParamRegistryDataSharedPtr->Meta;
 
 	return nullptr;
@@ -41,5 +41,5 @@ private:
 	FName Name;
 	UScriptStruct* Type;
 
-	TWeakPtr<FParamRegistryData> ParamRegistryDataPtr;
+	TWeakPtr<FParamRegistryData, ESPMode::ThreadSafe> ParamRegistryDataPtr;
 };
@@ -32,6 +32,7 @@ public class JSONParamsEditor : ModuleRules
 				"ContentBrowserData",
 				"BlueprintGraph",
 				"Kismet",
+				"DirectoryWatcher",
 			});
 	}
 }
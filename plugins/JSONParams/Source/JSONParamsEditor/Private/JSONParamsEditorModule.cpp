@@ -64,6 +64,8 @@ void FJSONParamsEditorModule::StartupModule()
 		FOnGetPropertyTypeCustomizationInstance::CreateStatic(&FParamRegistryInfoCustomization::MakeInstance));
 
 	PropertyModule.NotifyCustomizationModuleChanged();
+
+	HotReloader.Start();
 }
 
 void FJSONParamsEditorModule::ShutdownModule()
@@ -71,6 +73,8 @@ void FJSONParamsEditorModule::ShutdownModule()
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 
+	HotReloader.Stop();
+
 	UToolMenus::UnRegisterStartupCallback(this);
 
 	UToolMenus::UnregisterOwner(this);
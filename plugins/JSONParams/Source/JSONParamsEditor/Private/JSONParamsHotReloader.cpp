@@ -0,0 +1,103 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "JSONParamsHotReloader.h"
+
+#include "ParamsRegistry.h"
+#include "ParamsSettings.h"
+
+#include "DirectoryWatcherModule.h"
+
+
+void FJSONParamsHotReloader::Start()
+{
+	if (!UParamsSettings::Get()->EnableParamsHotReload)
+		return;
+
+	FDirectoryWatcherModule& DirectoryWatcherModule =
+		FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+	if (!DirectoryWatcher)
+		return;
+
+	for (const FString& RootPath : UParamsSettings::Get()->GetParamsRootPaths())
+	{
+		const FString FullRootPath = FPaths::ConvertRelativePathToFull(RootPath);
+		if (WatchedPaths.Contains(FullRootPath) || !FPaths::DirectoryExists(FullRootPath))
+			continue;
+
+		FDelegateHandle Handle;
+		DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(
+			FullRootPath,
+			IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FJSONParamsHotReloader::OnDirectoryChanged),
+			Handle);
+		WatchedPaths.Add(FullRootPath, Handle);
+	}
+}
+
+void FJSONParamsHotReloader::Stop()
+{
+	if (FDirectoryWatcherModule* DirectoryWatcherModule =
+			FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+	{
+		if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+		{
+			for (const TPair<FString, FDelegateHandle>& WatchedPath : WatchedPaths)
+			{
+				DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(WatchedPath.Key, WatchedPath.Value);
+			}
+		}
+	}
+
+	WatchedPaths.Empty();
+}
+
+void FJSONParamsHotReloader::OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
+{
+	const FString& Wildcard = UParamsSettings::Get()->ParamFileNameWildcard;
+
+	TArray<FString> ChangedFiles;
+	TArray<FString> RemovedFiles;
+
+	for (const FFileChangeData& FileChange : FileChanges)
+	{
+		if (FileChange.Action == FFileChangeData::FCA_RescanRequired)
+		{
+			UE_LOG(LogParams, Log, TEXT("FJSONParamsHotReloader: rescan requested, doing full reload"));
+			FParamsRegistry::Get().Init();
+			return;
+		}
+
+		if (!FPaths::GetCleanFilename(FileChange.Filename).MatchesWildcard(Wildcard))
+			continue;
+
+		const FString FullPath = FPaths::ConvertRelativePathToFull(FileChange.Filename);
+		if (FileChange.Action == FFileChangeData::FCA_Removed)
+		{
+			ChangedFiles.Remove(FullPath);
+			RemovedFiles.AddUnique(FullPath);
+		}
+		else
+		{
+			RemovedFiles.Remove(FullPath);
+			ChangedFiles.AddUnique(FullPath);
+		}
+	}
+
+	if (ChangedFiles.Num() > 0 || RemovedFiles.Num() > 0)
+	{
+		FParamsRegistry::Get().ReloadParamFiles(ChangedFiles, RemovedFiles);
+	}
+}
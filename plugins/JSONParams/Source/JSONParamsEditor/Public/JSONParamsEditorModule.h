@@ -16,6 +16,7 @@
 #pragma once
 
 #include "Input/Reply.h"
+#include "JSONParamsHotReloader.h"
 
 
 class JSONPARAMSEDITOR_API FJSONParamsEditorModule : public IModuleInterface
@@ -42,6 +43,8 @@ private:
 private:
 	TSharedPtr<class FUICommandList> PluginCommands;
 
+	FJSONParamsHotReloader HotReloader;
+
 	void OnBeginPIE(bool bIsSimulating);
 	FReply OnReInit();
 };
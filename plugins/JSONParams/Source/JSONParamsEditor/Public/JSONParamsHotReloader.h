@@ -0,0 +1,32 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+#include "IDirectoryWatcher.h"
+
+
+// Watches param root paths and pushes changed param files into the registry incremental reload.
+class JSONPARAMSEDITOR_API FJSONParamsHotReloader
+{
+public:
+	void Start();
+	void Stop();
+
+private:
+	void OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+
+	TMap<FString, FDelegateHandle> WatchedPaths;
+};
@@ -39,6 +39,27 @@ void UTGBaseLayer::PostEditChangeProperty(FPropertyChangedEvent& PropertyChanged
 
 UTextureRenderTarget2D* UTGBaseLayer::Generate(const FTGTerrainInfo& TerrainInfo)
 {
+	PrepareWeights(TerrainInfo);
+
+	TArray<uint8> Weights;
+	if (!GenerateWeights(TerrainInfo, Weights))
+		return nullptr;
+
+	return DrawWeights(Weights, TerrainInfo.Size, TerrainInfo.bFullRange);
+}
+
+void UTGBaseLayer::PrepareWeights(const FTGTerrainInfo& TerrainInfo)
+{
+}
+
+bool UTGBaseLayer::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
+{
+	return false;
+}
+
+UTextureRenderTarget2D* UTGBaseLayer::DrawWeights(const TArray<uint8>& InWeights, FIntPoint Resolution, bool bFullRange)
+{
+	RenderTarget = DrawWeightmap(InWeights, GeneratorName, Resolution, bFullRange);
 	return GetRenderTarget();
 }
 
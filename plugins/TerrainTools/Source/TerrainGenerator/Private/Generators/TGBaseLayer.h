@@ -22,12 +22,19 @@
 #include "GameFramework/Actor.h"
 #include "TGBaseLayer.generated.h"
 
+// Inputs of a generator, the rasters are owned by the caller and shared read-only between generators
 struct FTGTerrainInfo
 {
-	TArray<uint8> ObjectsMask;
-	TArray<float> DecodedHeight;
+	TArrayView<const uint8> ObjectsMask;
+	TArrayView<const float> DecodedHeight;
 	FIntPoint Size;
 	bool bFullRange = false;
+
+	// False when generators run in parallel and must not open slow tasks
+	bool bReportProgress = true;
+
+	// Weights of the layers listed in UTGBaseLayer::DependsOn
+	TMap<FName, TArrayView<const uint8>> LayerWeights;
 };
 
 class FLinearColors_ChannelRange
@@ -101,7 +108,20 @@ public:
 
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo);
+	// Generates the weights and draws them, returns nullptr if the layer has nothing to output
+	UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo);
+
+	// Game thread part of the generation, runs before GenerateWeights, e.g. to read textures
+	virtual void PrepareWeights(const FTGTerrainInfo& TerrainInfo);
+
+	// CPU part of the generation, may run in parallel with other generators
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights);
+
+	UTextureRenderTarget2D* DrawWeights(const TArray<uint8>& InWeights, FIntPoint Resolution, bool bFullRange);
+
+	// Layers generated before this one, their weights are passed in FTGTerrainInfo::LayerWeights
+	UPROPERTY(EditInstanceOnly, Category = "Generation")
+	TArray<FName> DependsOn;
 
 	UPROPERTY(VisibleInstanceOnly, Category = "Adjustments")
 	FName AffectedLayer;
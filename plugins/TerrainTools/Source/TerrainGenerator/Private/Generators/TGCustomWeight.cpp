@@ -30,8 +30,10 @@ UTGCustomWeight::UTGCustomWeight()
 	GeneratorName = TEXT("CustomWeight");
 }
 
-UTextureRenderTarget2D* UTGCustomWeight::Generate(const FTGTerrainInfo& TerrainInfo)
+void UTGCustomWeight::PrepareWeights(const FTGTerrainInfo& TerrainInfo)
 {
+	TexPixels.Empty();
+
 	if (Mask)
 	{
 		RenderTarget = FTerrainUtils::GetOrCreateTransientRenderTarget2D(
@@ -47,25 +49,23 @@ UTextureRenderTarget2D* UTGCustomWeight::Generate(const FTGTerrainInfo& TerrainI
 		FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
 		const FLinearColor Rect =
 			FLinearColor(0, 0, RenderTargetResource->GetSizeX(), RenderTargetResource->GetSizeY());
-		TArray<FLinearColor> TexPixels = UTerrainGeneratorHelper::SampleRTData(GetRenderTarget(), Rect);
-
-		TArray<uint8> RenderData;
-		RenderData.Reserve(TexPixels.Num());
-		for (float Element : FLinearColors_ChannelRange { TexPixels, GetChannel() })
-		{
-			RenderData.Emplace_GetRef() = ToWeight(ApplyAdjustments(Element));
-		}
+		TexPixels = UTerrainGeneratorHelper::SampleRTData(GetRenderTarget(), Rect);
+	}
+}
 
-		RenderTarget = DrawWeightmap(
-			RenderData,
-			GeneratorName,
-			FIntPoint { RenderTarget->SizeX, RenderTarget->SizeY },
-			TerrainInfo.bFullRange);
+bool UTGCustomWeight::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
+{
+	if (TexPixels.Num() == 0)
+		return false;
 
-		return GetRenderTarget();
+	OutWeights.Reset(TexPixels.Num());
+	for (float Element : FLinearColors_ChannelRange { TexPixels, GetChannel() })
+	{
+		OutWeights.Emplace_GetRef() = ToWeight(ApplyAdjustments(Element));
 	}
 
-	return nullptr;
+	TexPixels.Empty();
+	return true;
 }
 
 float FLinearColor::*UTGCustomWeight::GetChannel() const
@@ -37,7 +37,8 @@ class UTGCustomWeight : public UTGBaseLayer
 public:
 	UTGCustomWeight();
 
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo) override;
+	virtual void PrepareWeights(const FTGTerrainInfo& TerrainInfo) override;
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights) override;
 
 	UPROPERTY(EditInstanceOnly, Category = "CustomWeight")
 	TSoftObjectPtr<UTexture2D> Mask;
@@ -47,4 +48,7 @@ public:
 
 private:
 	float FLinearColor::*GetChannel() const;
+
+	// Mask texture read on the game thread by PrepareWeights
+	TArray<FLinearColor> TexPixels;
 };
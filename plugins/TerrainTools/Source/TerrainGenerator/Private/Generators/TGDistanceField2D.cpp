@@ -27,21 +27,19 @@ UTGDistanceField::UTGDistanceField()
 	GeneratorName = TEXT("DistanceField");
 }
 
-UTextureRenderTarget2D* UTGDistanceField::Generate(const FTGTerrainInfo& TerrainInfo)
+bool UTGDistanceField::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
 {
-	if (TerrainInfo.ObjectsMask.Num() > 0)
-	{
-		TArray<uint8> Data = TerrainInfo.ObjectsMask;
-		FSignedDistanceField2D TGSignedDistanceField2D { Scale, TerrainInfo.Size.X, TerrainInfo.Size.Y };
-		Data = TGSignedDistanceField2D.Generate(Data);
+	if (TerrainInfo.ObjectsMask.Num() == 0)
+		return false;
 
-		for (uint8& Iter : Data)
-		{
-			Iter = ApplyAdjustments(Iter);
-		}
+	TArray<uint8> Data(TerrainInfo.ObjectsMask.GetData(), TerrainInfo.ObjectsMask.Num());
+	FSignedDistanceField2D TGSignedDistanceField2D { Scale, TerrainInfo.Size.X, TerrainInfo.Size.Y };
+	OutWeights = TGSignedDistanceField2D.Generate(Data);
 
-		RenderTarget = DrawWeightmap(Data, GeneratorName, TerrainInfo.Size, TerrainInfo.bFullRange);
+	for (uint8& Iter : OutWeights)
+	{
+		Iter = ApplyAdjustments(Iter);
 	}
 
-	return GetRenderTarget();
+	return true;
 }
@@ -29,7 +29,7 @@ class UTGDistanceField : public UTGBaseLayer
 	GENERATED_BODY()
 public:
 	UTGDistanceField();
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo) override;
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights) override;
 
 	UPROPERTY(EditInstanceOnly, Category = "DistanceField")
 	int32 Scale = 3;
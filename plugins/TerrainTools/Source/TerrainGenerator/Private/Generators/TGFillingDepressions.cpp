@@ -17,6 +17,7 @@
 
 #include "Generators/TGFillingDepressions.h"
 
+#include "Generators/TGPriorityFlood.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include <queue>
 
@@ -27,7 +28,7 @@ UTGFillingDepressions::UTGFillingDepressions()
 }
 
 
-UTextureRenderTarget2D* UTGFillingDepressions::Generate(const FTGTerrainInfo& TerrainInfo)
+bool UTGFillingDepressions::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
 {
 	TArray<float> Elevation = FillDepressions(TerrainInfo);
 
@@ -46,13 +47,44 @@ UTextureRenderTarget2D* UTGFillingDepressions::Generate(const FTGTerrainInfo& Te
 		Iter = FMath::Clamp(Iter, MinHeight / 100.f * HMax, MaxHeight / 100.f * HMax);
 	}
 
-	RenderTarget = DrawWeightmap(RemapToWeight(Elevation), GeneratorName, TerrainInfo.Size, TerrainInfo.bFullRange);
-
-	return GetRenderTarget();
+	OutWeights = RemapToWeight(Elevation);
+	return true;
 }
 
 
 TArray<float> UTGFillingDepressions::FillDepressions(const FTGTerrainInfo& TerrainInfo) const
+{
+	if (Mode == FDM_PlanchonDarboux)
+		return FillDepressionsPlanchonDarboux(TerrainInfo);
+
+	// same layout as FElevationModel
+	const int32 Height = TerrainInfo.Size.X;
+	const int32 Width = TerrainInfo.Size.Y;
+	const float NoDataValue = MIN_flt;
+	TArray<float> Elevation(TerrainInfo.DecodedHeight.GetData(), TerrainInfo.DecodedHeight.Num());
+
+	switch (Mode)
+	{
+	case FDM_PriorityFloodEpsilon:
+		FTGPriorityFlood::FillEpsilon(Elevation, Width, Height, NoDataValue, Epsilon);
+		break;
+
+	case FDM_PriorityFloodTiled:
+		FTGPriorityFlood::FillTiled(Elevation, Width, Height, NoDataValue, TileSize);
+		break;
+
+	default:
+		FTGPriorityFlood::Fill(Elevation, Width, Height, NoDataValue);
+		break;
+	}
+
+	if (bResolveFlats && Mode != FDM_PriorityFloodEpsilon)
+		FTGPriorityFlood::ResolveFlats(Elevation, Width, Height, NoDataValue, FlatIncrement);
+
+	return Elevation;
+}
+
+TArray<float> UTGFillingDepressions::FillDepressionsPlanchonDarboux(const FTGTerrainInfo& TerrainInfo) const
 {
 	// Stage 1: Initialization of the surface to m
 
@@ -60,8 +92,8 @@ TArray<float> UTGFillingDepressions::FillDepressions(const FTGTerrainInfo& Terra
 	const int32 Width = TerrainInfo.Size.Y;
 
 	FElevationModel ElevationModel { Width, Height };
-	ElevationModel.Elevation = TerrainInfo.DecodedHeight;
-	const float Volume = FMath::Max(TerrainInfo.DecodedHeight);
+	ElevationModel.Elevation = TArray<float>(TerrainInfo.DecodedHeight.GetData(), TerrainInfo.DecodedHeight.Num());
+	const float Volume = FMath::Max(ElevationModel.Elevation);
 	// A transient surface that converging to the depression-filled DEM
 	FElevationModel Water { Width, Height };
 	Water.SetNoData();
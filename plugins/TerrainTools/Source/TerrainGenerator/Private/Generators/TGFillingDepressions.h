@@ -114,6 +114,19 @@ struct FElevationModel
 */
 };
 
+UENUM()
+enum ETGFillingDepressionsMode
+{
+	// Iterative sweeps, Planchon and Darboux
+	FDM_PlanchonDarboux,
+	// Priority-Flood, filled areas are flat
+	FDM_PriorityFlood,
+	// Priority-Flood+Epsilon, filled areas drain to their spill cells
+	FDM_PriorityFloodEpsilon,
+	// Priority-Flood over tiles filled in parallel, same result as FDM_PriorityFlood
+	FDM_PriorityFloodTiled,
+};
+
 UCLASS(EditInlineNew)
 class UTGFillingDepressions : public UTGBaseLayer
 {
@@ -122,7 +135,7 @@ class UTGFillingDepressions : public UTGBaseLayer
 public:
 	UTGFillingDepressions();
 
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo) override;
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights) override;
 
 	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 0, ClampMax = 100), Category = "FillingDepressions")
 	int32 MinHeight = 0;
@@ -130,12 +143,28 @@ public:
 	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 0, ClampMax = 100), Category = "FillingDepressions")
 	int32 MaxHeight = 100;
 
-	UPROPERTY(VisibleInstanceOnly, Category = "FillingDepressions")
+	// Slope left on filled cells by FDM_PlanchonDarboux and FDM_PriorityFloodEpsilon, the latter keeps the smallest step at 0
+	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 0), Category = "FillingDepressions")
 	float Epsilon = 0.f;
 
+	UPROPERTY(EditInstanceOnly, Category = "FillingDepressions")
+	TEnumAsByte<ETGFillingDepressionsMode> Mode = FDM_PlanchonDarboux;
+
+	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 16), Category = "FillingDepressions")
+	int32 TileSize = 512;
+
+	// Adds a gradient to the flats left by FDM_PriorityFlood and FDM_PriorityFloodTiled
+	UPROPERTY(EditInstanceOnly, Category = "FillingDepressions")
+	bool bResolveFlats = false;
+
+	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 0, EditCondition = "bResolveFlats"), Category = "FillingDepressions")
+	float FlatIncrement = 0.001f;
+
 	TArray<float> FillDepressions(const FTGTerrainInfo& TerrainInfo) const;
 
 private:
+	TArray<float> FillDepressionsPlanchonDarboux(const FTGTerrainInfo& TerrainInfo) const;
+
 	/*
 	*	Neighbor Index
 	*	5  6  7
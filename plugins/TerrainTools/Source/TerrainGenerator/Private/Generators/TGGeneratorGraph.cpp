@@ -0,0 +1,140 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "Generators/TGGeneratorGraph.h"
+
+#include "Algo/AllOf.h"
+#include "Async/ParallelFor.h"
+#include "Misc/App.h"
+#include "Misc/ScopedSlowTask.h"
+
+
+bool FTGGeneratorGraph::Build(const TMap<FName, UTGBaseLayer*>& InGenerators, FString& OutError)
+{
+	Generators.Reset();
+	Waves.Reset();
+
+	for (const TPair<FName, UTGBaseLayer*>& Iter : InGenerators)
+	{
+		if (IsValid(Iter.Value))
+			Generators.Add(Iter.Key, Iter.Value);
+	}
+
+	for (const TPair<FName, UTGBaseLayer*>& Iter : Generators)
+	{
+		for (const FName Dependency : Iter.Value->DependsOn)
+		{
+			if (!Generators.Contains(Dependency))
+			{
+				OutError = FString::Printf(
+					TEXT("Layer %s depends on %s which has no generator"),
+					*Iter.Key.ToString(),
+					*Dependency.ToString());
+				return false;
+			}
+		}
+	}
+
+	TSet<FName> Generated;
+	while (Generated.Num() < Generators.Num())
+	{
+		TArray<FName> Wave;
+		for (const TPair<FName, UTGBaseLayer*>& Iter : Generators)
+		{
+			if (Generated.Contains(Iter.Key))
+				continue;
+
+			const bool bReady = Algo::AllOf(
+				Iter.Value->DependsOn,
+				[&Generated](const FName Dependency) { return Generated.Contains(Dependency); });
+			if (bReady)
+				Wave.Add(Iter.Key);
+		}
+
+		if (Wave.Num() == 0)
+		{
+			TArray<FString> Remaining;
+			for (const TPair<FName, UTGBaseLayer*>& Iter : Generators)
+			{
+				if (!Generated.Contains(Iter.Key))
+					Remaining.Add(Iter.Key.ToString());
+			}
+			OutError = FString::Printf(TEXT("Layers %s depend on each other"), *FString::Join(Remaining, TEXT(", ")));
+			Waves.Reset();
+			return false;
+		}
+
+		Generated.Append(Wave);
+		Waves.Add(MoveTemp(Wave));
+	}
+
+	return true;
+}
+
+void FTGGeneratorGraph::Run(
+	const FTGTerrainInfo& BaseInfo,
+	const TMap<FName, TArray<uint8>>& ObjectsMasks,
+	TMap<FName, TArray<uint8>>& OutWeights) const
+{
+	FScopedSlowTask SlowTask(Waves.Num(), FText::FromString(TEXT("Generate: Weightmaps")), BaseInfo.bReportProgress);
+	SlowTask.MakeDialog();
+
+	for (const TArray<FName>& Wave : Waves)
+	{
+		SlowTask.EnterProgressFrame();
+
+		TArray<FTGTerrainInfo> WaveInfos;
+		WaveInfos.Reserve(Wave.Num());
+		for (const FName Layer : Wave)
+		{
+			UTGBaseLayer* Generator = Generators.FindChecked(Layer);
+			FTGTerrainInfo& Info = WaveInfos.Add_GetRef(BaseInfo);
+			Info.bReportProgress = BaseInfo.bReportProgress && Wave.Num() == 1;
+			if (const TArray<uint8>* ObjectsMask = ObjectsMasks.Find(Layer))
+				Info.ObjectsMask = *ObjectsMask;
+
+			for (const FName Dependency : Generator->DependsOn)
+			{
+				if (const TArray<uint8>* Weights = OutWeights.Find(Dependency))
+					Info.LayerWeights.Add(Dependency, *Weights);
+			}
+
+			Generator->AffectedLayer = Layer;
+			Generator->PrepareWeights(Info);
+		}
+
+		TArray<TArray<uint8>> WaveWeights;
+		WaveWeights.SetNum(Wave.Num());
+		TArray<bool> WaveGenerated;
+		WaveGenerated.Init(false, Wave.Num());
+
+		ParallelFor(
+			Wave.Num(),
+			[&](int32 Index)
+			{
+				UTGBaseLayer* Generator = Generators.FindChecked(Wave[Index]);
+				WaveGenerated[Index] = Generator->GenerateWeights(WaveInfos[Index], WaveWeights[Index]);
+			},
+			Wave.Num() == 1 || !FApp::ShouldUseThreadingForPerformance());
+
+		// Moved arrays keep their buffers, so views of the earlier waves stay valid
+		for (int32 Index = 0; Index < Wave.Num(); Index++)
+		{
+			if (WaveGenerated[Index])
+				OutWeights.Add(Wave[Index], MoveTemp(WaveWeights[Index]));
+		}
+	}
+}
@@ -0,0 +1,52 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "TGBaseLayer.h"
+
+/**
+ * @brief   Generators of the weightmap layers ordered by UTGBaseLayer::DependsOn.
+ * @details Layers of a wave depend only on layers of the previous waves, so every wave is generated in parallel.
+ */
+class FTGGeneratorGraph
+{
+public:
+	// Fails on a dependency on a missing layer or on a cycle, OutError names the layers
+	bool Build(const TMap<FName, UTGBaseLayer*>& InGenerators, FString& OutError);
+
+	const TArray<TArray<FName>>& GetWaves() const
+	{
+		return Waves;
+	}
+
+	/**
+	 * @brief   Runs PrepareWeights on the calling thread and GenerateWeights in parallel, wave by wave.
+	 * @param   BaseInfo     - inputs shared by all layers, ObjectsMask and LayerWeights are set per layer
+	 * @param   ObjectsMasks - masks of the objects tagged with the layer names
+	 * @param   OutWeights   - weights of the layers which have output
+	 */
+	void Run(
+		const FTGTerrainInfo& BaseInfo,
+		const TMap<FName, TArray<uint8>>& ObjectsMasks,
+		TMap<FName, TArray<uint8>>& OutWeights) const;
+
+private:
+	TMap<FName, UTGBaseLayer*> Generators;
+	TArray<TArray<FName>> Waves;
+};
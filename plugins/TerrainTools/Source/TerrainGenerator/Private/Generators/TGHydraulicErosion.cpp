@@ -16,7 +16,6 @@
 
 #include "Generators/TGHydraulicErosion.h"
 
-#include "Async/ParallelFor.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "Misc/FeedbackContext.h"
 #include "TerrainGeneratorHelper.h"
@@ -27,11 +26,11 @@ UTGHydraulicErosion::UTGHydraulicErosion()
 	GeneratorName = TEXT("HydraulicErosion");
 }
 
-UTextureRenderTarget2D* UTGHydraulicErosion::Generate(const FTGTerrainInfo& TerrainInfo)
+bool UTGHydraulicErosion::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
 {
-	TArray<float> HeightData = TerrainInfo.DecodedHeight;
+	TArray<float> HeightData(TerrainInfo.DecodedHeight.GetData(), TerrainInfo.DecodedHeight.Num());
 
-	Erode(HeightData, TerrainInfo.Size.GetMax(), NumIterations, bResetSeed);
+	Erode(HeightData, TerrainInfo.Size, NumIterations, bResetSeed, TerrainInfo.bReportProgress);
 
 	for (int32 Iter = 0; Iter < HeightData.Num(); Iter++)
 	{
@@ -58,239 +57,68 @@ UTextureRenderTarget2D* UTGHydraulicErosion::Generate(const FTGTerrainInfo& Terr
 		Iter = FMath::Clamp(Iter, MinHeight / 100.f * HMax, MaxHeight / 100.f * HMax);
 	}
 
-	const TArray<uint8> WeightData = RemapToWeight(HeightData);
-
-	RenderTarget = DrawWeightmap(WeightData, GeneratorName, TerrainInfo.Size, TerrainInfo.bFullRange);
-
-	return GetRenderTarget();
-}
-
-void UTGHydraulicErosion::Erode(TArray<float>& Map, int32 MapSize, int32 Iterations, bool ResetSeed)
-{
-
-	GWarn->BeginSlowTask(FText::FromString(TEXT("Generate: Hydraulic Erosion")), true, false);
-
-	Initialize(MapSize, ResetSeed);
-
-	const uint32 ThreadId = FPlatformTLS::GetCurrentThreadId();
-
-	ParallelFor(
-		Iterations,
-		[&](int32 Iter)
-		{
-			if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
-			{
-				GWarn->UpdateProgress(Iter, Iterations);
-			}
-
-			// Create water droplet at random point on map
-			float PosX = FMath::RandRange(0.f, MapSize - 1.f);
-			float PosY = FMath::RandRange(0.f, MapSize - 1.f);
-			float DirX = 0;
-			float DirY = 0;
-			float Speed = InitialSpeed;
-			float Water = InitialWaterVolume;
-			float Sediment = 0;
-
-			for (int32 Lifetime = 0; Lifetime < MaxDropletLifetime; Lifetime++)
-			{
-				const int32 NodeX = FMath::TruncToInt(PosX);
-				const int32 NodeY = FMath::TruncToInt(PosY);
-				const int32 DropletIndex = NodeY * MapSize + NodeX;
-				// Calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
-				const float CellOffsetX = PosX - NodeX;
-				const float CellOffsetY = PosY - NodeY;
-
-				// Calculate droplet's height and direction of flow with bilinear interpolation of surrounding heights
-				const FHeightAndGradient HeightAndGradient = CalculateHeightAndGradient(Map, MapSize, PosX, PosY);
-				;
-
-				// Update the droplet's direction and position (move position 1 unit regardless of speed)
-				DirX = (DirX * Inertia - HeightAndGradient.GradientX * (1 - Inertia));
-				DirY = (DirY * Inertia - HeightAndGradient.GradientY * (1 - Inertia));
-
-				// Normalize direction
-				const float Length = FMath::Sqrt(DirX * DirX + DirY * DirY);
-				if (Length != 0)
-				{
-					DirX /= Length;
-					DirY /= Length;
-				}
-				PosX += DirX;
-				PosY += DirY;
-
-				// Stop simulating droplet if it's not moving or has flowed over edge of map
-				if ((DirX == 0 && DirY == 0) || PosX < 0 || PosX >= MapSize - 1 || PosY < 0 || PosY >= MapSize - 1)
-				{
-					break;
-				}
-
-				// Find the droplet's new height and calculate the DeltaHeight
-				const float NewHeight = CalculateHeightAndGradient(Map, MapSize, PosX, PosY).Height;
-				const float DeltaHeight = NewHeight - HeightAndGradient.Height;
-
-				// Calculate the droplet's sediment capacity (higher when moving fast down a slope and contains lots of water)
-				const float SedimentCapacity =
-					FMath::Max(-DeltaHeight * Speed * Water * SedimentCapacityFactor, MinSedimentCapacity);
-
-				// If carrying more sediment than capacity, or if flowing uphill:
-				if (Sediment > SedimentCapacity || DeltaHeight > 0)
-				{
-					// If moving uphill (deltaHeight > 0) try fill up to the current height, otherwise deposit a fraction of the excess sediment
-					const float AmountToDeposit = (DeltaHeight > 0) ? FMath::Min(DeltaHeight, Sediment)
-																	: (Sediment - SedimentCapacity) * DepositSpeed;
-					Sediment -= AmountToDeposit;
-
-					// Add the sediment to the four nodes of the current cell using bilinear interpolation
-					// Deposition is not distributed over a radius (like erosion) so that it can fill small pits
-					Map[DropletIndex] += AmountToDeposit * (1 - CellOffsetX) * (1 - CellOffsetY);
-					Map[DropletIndex + 1] += AmountToDeposit * CellOffsetX * (1 - CellOffsetY);
-					Map[FMath::Min(DropletIndex + MapSize, Map.Num() - 1)] +=
-						AmountToDeposit * (1 - CellOffsetX) * CellOffsetY;
-					Map[FMath::Min(DropletIndex + MapSize + 1, Map.Num() - 1)] +=
-						AmountToDeposit * CellOffsetX * CellOffsetY;
-				}
-				else
-				{
-					// Erode a fraction of the droplet's current carry capacity.
-					// Clamp the erosion to the change in height so that it doesn't dig a hole in the terrain behind the droplet
-					const float AmountToErode = FMath::Min((SedimentCapacity - Sediment) * ErodeSpeed, -DeltaHeight);
-
-					// Use erosion brush to erode from all nodes inside the droplet's erosion radius
-					for (int32 BrushPointIndex = 0; BrushPointIndex < ErosionBrushIndices[DropletIndex].Num();
-						 BrushPointIndex++)
-					{
-						const int32 NodeIndex = ErosionBrushIndices[DropletIndex][BrushPointIndex];
-						const float WeighedErodeAmount =
-							AmountToErode * ErosionBrushWeights[DropletIndex][BrushPointIndex];
-						const float DeltaSediment =
-							(Map[NodeIndex] < WeighedErodeAmount) ? Map[NodeIndex] : WeighedErodeAmount;
-						Map[NodeIndex] -= DeltaSediment;
-						Sediment += DeltaSediment;
-					}
-				}
-
-				// Update droplet's speed and water content
-				Speed = FMath::Sqrt(Speed * Speed + DeltaHeight * Gravity);
-				Water *= (1 - EvaporateSpeed);
-			}
-		},
-		!FApp::ShouldUseThreadingForPerformance());
-	GWarn->EndSlowTask();
+	OutWeights = RemapToWeight(HeightData);
+	return true;
 }
 
-void UTGHydraulicErosion::Initialize(int32 MapSize, bool bReset)
+void UTGHydraulicErosion::Erode(
+	TArray<float>& Map,
+	FIntPoint MapSize,
+	int32 Iterations,
+	bool ResetSeed,
+	bool bReportProgress)
 {
-	ErosionBrushWeights.Empty();
-	ErosionBrushIndices.Empty();
+	// Droplets run in batches so the progress moves
+	constexpr int32 DropletsPerBatch = 4096;
 
-	if (bReset || CurrentSeed != Seed)
+	if (ResetSeed || CurrentSeed != Seed)
 	{
-		RandomStream.Initialize(Seed);
 		CurrentSeed = Seed;
+		NumRuns = 0;
 	}
 
-	if (ErosionBrushIndices.Num() == 0 || CurrentErosionRadius != ErosionRadius || CurrentMapSize != MapSize)
-	{
-		InitializeBrushIndices(MapSize, ErosionRadius);
-		CurrentErosionRadius = ErosionRadius;
-		CurrentMapSize = MapSize;
-	}
-}
-
-void UTGHydraulicErosion::InitializeBrushIndices(const int32 MapSize, const int32 Radius)
-{
-	ErosionBrushIndices.SetNumZeroed(MapSize * MapSize);
-	ErosionBrushWeights.SetNumZeroed(MapSize * MapSize);
-
-	TArray<int32> OffsetsX;
-	TArray<int32> OffsetsY;
-	TArray<float> Weights;
+	FHydraulicErosionSettings Settings = MakeSolverSettings();
+	Settings.Seed = HashCombine(GetTypeHash(CurrentSeed), GetTypeHash(NumRuns++));
+	Settings.NumDroplets = FMath::Min(Iterations, DropletsPerBatch);
+	const int32 NumBatches = FMath::DivideAndRoundUp(Iterations, DropletsPerBatch);
 
-	OffsetsX.SetNum(Radius * Radius * 4);
-	OffsetsY.SetNum(Radius * Radius * 4);
-	Weights.SetNum(Radius * Radius * 4);
-	float WeightSum = 0;
-	int32 AddIndex = 0;
+	if (bReportProgress)
+		GWarn->BeginSlowTask(FText::FromString(TEXT("Generate: Hydraulic Erosion")), true, false);
 
-	for (int32 i = 0; i < ErosionBrushIndices.Num(); i++)
+	FHydraulicErosionSolver Solver({ Map, MapSize }, Settings);
+	for (int32 Batch = 0; Batch < NumBatches; Batch++)
 	{
-		const int32 CentreX = i % MapSize;
-		const int32 CentreY = i / MapSize;
-
-		if (CentreY <= Radius || CentreY >= MapSize - Radius || CentreX <= Radius + 1 || CentreX >= MapSize - Radius)
-		{
-			WeightSum = 0;
-			AddIndex = 0;
-
-			for (int32 y = -Radius; y <= Radius; y++)
-			{
-				for (int32 x = -Radius; x <= Radius; x++)
-				{
-					const float SqrDst = x * x + y * y;
-
-					if (SqrDst < Radius * Radius)
-					{
-						const int32 CoordX = CentreX + x;
-						const int32 CoordY = CentreY + y;
-
-						if (CoordX >= 0 && CoordX < MapSize && CoordY >= 0 && CoordY < MapSize)
-						{
-							const float Weight = 1 - sqrt(SqrDst) / Radius;
-							WeightSum += Weight;
-							Weights[AddIndex] = Weight;
-							OffsetsX[AddIndex] = x;
-							OffsetsY[AddIndex] = y;
-							AddIndex++;
-						}
-					}
-				}
-			}
-		}
-
-		const int32 NumEntries = AddIndex;
-		ErosionBrushIndices[i].SetNum(NumEntries);
-		ErosionBrushWeights[i].SetNum(NumEntries);
+		// the last batch takes only the remaining droplets
+		Solver.SetNumDroplets(FMath::Min(Iterations - Batch * DropletsPerBatch, DropletsPerBatch));
+		Solver.Run(1);
 
-		for (int32 j = 0; j < NumEntries; j++)
-		{
-			ErosionBrushIndices[i][j] = (OffsetsY[j] + CentreY) * MapSize + OffsetsX[j] + CentreX;
-			ErosionBrushWeights[i][j] = Weights[j] / WeightSum;
-		}
+		if (bReportProgress)
+			GWarn->UpdateProgress(Batch + 1, NumBatches);
 	}
+	Map = Solver.GetHeight();
+
+	if (bReportProgress)
+		GWarn->EndSlowTask();
 }
 
-FHeightAndGradient UTGHydraulicErosion::CalculateHeightAndGradient(
-	TArray<float>& Nodes,
-	int32& MapSize,
-	float PosX,
-	float PosY) const
+FHydraulicErosionSettings UTGHydraulicErosion::MakeSolverSettings() const
 {
-	const int32 CoordX = FMath::TruncToInt(PosX);
-	const int32 CoordY = FMath::TruncToInt(PosY);
-
-	// Calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
-	const float X = PosX - CoordX;
-	const float Y = PosY - CoordY;
-
-	// Calculate heights of the four nodes of the droplet's cell
-	const int32 NodeIndexNW = CoordY * MapSize + CoordX;
-	const float HeightNW = Nodes[FMath::Min(NodeIndexNW, Nodes.Num() - 1)];
-	const float HeightNE = Nodes[FMath::Min(NodeIndexNW + 1, Nodes.Num() - 1)];
-	const float HeightSW = Nodes[FMath::Min(NodeIndexNW + MapSize, Nodes.Num() - 1)];
-	const float HeightSE = Nodes[FMath::Min(NodeIndexNW + MapSize + 1, Nodes.Num() - 1)];
-
-	// Calculate droplet's direction of flow with bilinear interpolation of height difference along the edges
-	const float GradientX = (HeightNE - HeightNW) * (1 - Y) + (HeightSE - HeightSW) * Y;
-	const float GradientY = (HeightSW - HeightNW) * (1 - X) + (HeightSE - HeightNE) * X;
-
-	// Calculate height with bilinear interpolation of the heights of the nodes of the cell
-	const float Height =
-		HeightNW * (1 - X) * (1 - Y) + HeightNE * X * (1 - Y) + HeightSW * (1 - X) * Y + HeightSE * X * Y;
-
-	const FHeightAndGradient OutResult { Height, GradientX, GradientY };
-
-	return OutResult;
+	FHydraulicErosionSettings Settings;
+	Settings.Mode = EHydraulicErosionSolverMode::Droplets;
+	Settings.Seed = Seed;
+	Settings.NumDroplets = NumIterations;
+	Settings.ErosionRadius = ErosionRadius;
+	Settings.Inertia = Inertia;
+	Settings.SedimentCapacityFactor = SedimentCapacityFactor;
+	Settings.MinSedimentCapacity = MinSedimentCapacity;
+	Settings.ErodeSpeed = ErodeSpeed;
+	Settings.DepositSpeed = DepositSpeed;
+	Settings.EvaporateSpeed = EvaporateSpeed;
+	Settings.DropletGravity = Gravity;
+	Settings.MaxDropletLifetime = MaxDropletLifetime;
+	Settings.InitialWaterVolume = InitialWaterVolume;
+	Settings.InitialSpeed = InitialSpeed;
+	return Settings;
 }
 
 void UTGHydraulicErosion::RemapHeight(TArray<float>& Data) const
@@ -16,16 +16,10 @@
 
 #pragma once
 
+#include "HydraulicErosionSolver.h"
 #include "TGBaseLayer.h"
 #include "TGHydraulicErosion.generated.h"
 
-struct FHeightAndGradient
-{
-	float Height;
-	float GradientX;
-	float GradientY;
-};
-
 UENUM()
 enum ETGChannels
 {
@@ -41,15 +35,17 @@ class UTGHydraulicErosion : public UTGBaseLayer
 public:
 	UTGHydraulicErosion();
 
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo) override;
-
-	void Erode(TArray<float>& Map, int32 MapSize, int32 Iterations = 1, bool ResetSeed = false);
-
-	void Initialize(int32 MapSize, bool ResetSeed);
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights) override;
 
-	void InitializeBrushIndices(int32 MapSize, int32 Radius);
+	// Runs Iterations droplets over the map with FHydraulicErosionSolver
+	void Erode(
+		TArray<float>& Map,
+		FIntPoint MapSize,
+		int32 Iterations = 1,
+		bool ResetSeed = false,
+		bool bReportProgress = true);
 
-	FHeightAndGradient CalculateHeightAndGradient(TArray<float>& Nodes, int32& MapSize, float PosX, float PosY) const;
+	FHydraulicErosionSettings MakeSolverSettings() const;
 
 	void RemapHeight(TArray<float>& Data) const;
 
@@ -108,11 +104,7 @@ public:
 	int32 MaxHeight = 100;
 
 private:
-	// Indices and weights of erosion brush precomputed for every node
-	TArray<TArray<int32> > ErosionBrushIndices;
-	TArray<TArray<float> > ErosionBrushWeights;
-	FRandomStream RandomStream;
-	int32 CurrentSeed;
-	int32 CurrentErosionRadius;
-	int32 CurrentMapSize;
+	// Seed of the next Erode, advances after every run unless the seed is reset
+	int32 CurrentSeed = 0;
+	int32 NumRuns = 0;
 };
@@ -0,0 +1,603 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "Generators/TGPriorityFlood.h"
+
+#include "Async/ParallelFor.h"
+#include <cmath>
+
+namespace TGPriorityFloodLocal
+{
+	const FIntPoint Neighbors[8] = {
+		{ 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+	};
+	// label of everything outside the raster and of NoData cells in FillTiled
+	constexpr int32 ExteriorLabel = 0;
+
+	struct FOpenCell
+	{
+		float Elevation;
+		int32 Index;
+	};
+
+	// index keeps the order of equal cells deterministic
+	struct FOpenCellLess
+	{
+		bool operator()(const FOpenCell& A, const FOpenCell& B) const
+		{
+			return A.Elevation < B.Elevation || (A.Elevation == B.Elevation && A.Index < B.Index);
+		}
+	};
+
+	bool IsNoData(float Value, float NoDataValue)
+	{
+		// same check as FElevationModel::IsNoData
+		return FMath::Abs(Value - NoDataValue) < DELTA;
+	}
+
+	float NextAfter(float Value)
+	{
+		return std::nextafter(Value, TNumericLimits<float>::Max());
+	}
+
+	// NoData cells never change, tiles read them here instead of the elevations other tiles write
+	TBitArray<> MakeNoDataMask(const TArray<float>& Elevation, float NoDataValue)
+	{
+		TBitArray<> NoData(false, Elevation.Num());
+		for (int32 Index = 0; Index < Elevation.Num(); Index++)
+		{
+			if (IsNoData(Elevation[Index], NoDataValue))
+				NoData[Index] = true;
+		}
+		return NoData;
+	}
+
+	// Connection between two watersheds, or a watershed and the exterior
+	struct FSpill
+	{
+		int32 LabelA;
+		int32 LabelB;
+		float Elevation;
+	};
+
+	// Watersheds of a tile border cells, labels are local to the tile and start from 1
+	struct FTileWatersheds
+	{
+		TArray<int32> Labels;
+		TArray<FSpill> Spills;
+		int32 NumLabels = 0;
+	};
+
+	/**
+	 * Floods Rect from its border and from cells next to NoData, Elevation is accessed within Rect only.
+	 * Epsilon is the minimal step of the gradient towards the spill cell, the smallest representable one if 0.
+	 * Watersheds are optional, their spills to the exterior are recorded for the raster border and NoData only.
+	 */
+	void FloodRect(
+		TArray<float>& Elevation,
+		int32 Width,
+		int32 Height,
+		const FIntRect& Rect,
+		const TBitArray<>& NoData,
+		bool bEpsilon,
+		float Epsilon,
+		FTileWatersheds* Watersheds)
+	{
+		const FIntPoint RectSize = Rect.Size();
+		const auto ToLocal = [&Rect, RectSize](int32 X, int32 Y)
+		{
+			return (Y - Rect.Min.Y) * RectSize.X + X - Rect.Min.X;
+		};
+
+		TBitArray<> Closed(false, RectSize.X * RectSize.Y);
+		TArray<FOpenCell> Open;
+		TArray<int32> Pit;
+		int32 PitHead = 0;
+		if (Watersheds)
+			Watersheds->Labels.Init(ExteriorLabel, RectSize.X * RectSize.Y);
+
+		// seeds
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			for (int32 X = Rect.Min.X; X < Rect.Max.X; X++)
+			{
+				const int32 Index = Y * Width + X;
+				if (NoData[Index])
+				{
+					Closed[ToLocal(X, Y)] = true;
+					continue;
+				}
+
+				const bool bRectBorder =
+					X == Rect.Min.X || Y == Rect.Min.Y || X == Rect.Max.X - 1 || Y == Rect.Max.Y - 1;
+				bool bOutlet = false;
+				for (const FIntPoint& Offset : Neighbors)
+				{
+					const int32 NX = X + Offset.X;
+					const int32 NY = Y + Offset.Y;
+					if (NX < 0 || NY < 0 || NX >= Width || NY >= Height || NoData[NY * Width + NX])
+					{
+						bOutlet = true;
+						break;
+					}
+				}
+
+				if (bRectBorder || bOutlet)
+				{
+					Closed[ToLocal(X, Y)] = true;
+					Open.HeapPush({ Elevation[Index], Index }, FOpenCellLess());
+				}
+			}
+		}
+
+		while (Open.Num() > 0 || PitHead < Pit.Num())
+		{
+			// pit cells don't need the heap, open cells of the same elevation go first for the epsilon gradient
+			int32 Cell;
+			if (PitHead < Pit.Num()
+				&& !(bEpsilon && Open.Num() > 0 && Open.HeapTop().Elevation == Elevation[Pit[PitHead]]))
+			{
+				Cell = Pit[PitHead++];
+				if (PitHead == Pit.Num())
+				{
+					Pit.Reset();
+					PitHead = 0;
+				}
+			}
+			else
+			{
+				FOpenCell OpenCell;
+				Open.HeapPop(OpenCell, FOpenCellLess(), false);
+				Cell = OpenCell.Index;
+			}
+
+			const int32 X = Cell % Width;
+			const int32 Y = Cell / Width;
+			const float CellElevation = Elevation[Cell];
+			const float SpillElevation =
+				bEpsilon ? FMath::Max(NextAfter(CellElevation), CellElevation + Epsilon) : CellElevation;
+
+			int32 Label = ExteriorLabel;
+			if (Watersheds)
+			{
+				int32& CellLabel = Watersheds->Labels[ToLocal(X, Y)];
+				if (CellLabel == ExteriorLabel)
+				{
+					CellLabel = ++Watersheds->NumLabels;
+
+					const bool bRasterBorder = X == 0 || Y == 0 || X == Width - 1 || Y == Height - 1;
+					bool bNoDataNeighbor = false;
+					for (const FIntPoint& Offset : Neighbors)
+					{
+						const int32 NX = X + Offset.X;
+						const int32 NY = Y + Offset.Y;
+						bNoDataNeighbor |= NX >= 0 && NY >= 0 && NX < Width && NY < Height && NoData[NY * Width + NX];
+					}
+					if (bRasterBorder || bNoDataNeighbor)
+						Watersheds->Spills.Add({ CellLabel, ExteriorLabel, CellElevation });
+				}
+				Label = CellLabel;
+			}
+
+			for (const FIntPoint& Offset : Neighbors)
+			{
+				const int32 NX = X + Offset.X;
+				const int32 NY = Y + Offset.Y;
+				if (!Rect.Contains({ NX, NY }))
+					continue;
+
+				const int32 Neighbor = NY * Width + NX;
+				const int32 LocalNeighbor = ToLocal(NX, NY);
+				if (Closed[LocalNeighbor])
+				{
+					if (Watersheds)
+					{
+						const int32 NeighborLabel = Watersheds->Labels[LocalNeighbor];
+						if (NeighborLabel != ExteriorLabel && NeighborLabel != Label)
+						{
+							Watersheds->Spills.Add(
+								{ Label, NeighborLabel, FMath::Max(CellElevation, Elevation[Neighbor]) });
+						}
+					}
+					continue;
+				}
+
+				Closed[LocalNeighbor] = true;
+				if (Watersheds)
+					Watersheds->Labels[LocalNeighbor] = Label;
+
+				if (Elevation[Neighbor] <= SpillElevation)
+				{
+					Elevation[Neighbor] = SpillElevation;
+					Pit.Add(Neighbor);
+				}
+				else
+				{
+					Open.HeapPush({ Elevation[Neighbor], Neighbor }, FOpenCellLess());
+				}
+			}
+		}
+	}
+
+	// Minimax spill elevation of every watershed from the exterior
+	TArray<float> SolveSpillElevations(int32 NumLabels, const TArray<FSpill>& Spills)
+	{
+		// adjacency in CSR layout
+		TArray<int32> EdgeStarts;
+		EdgeStarts.Init(0, NumLabels + 2);
+		for (const FSpill& Spill : Spills)
+		{
+			EdgeStarts[Spill.LabelA + 1]++;
+			EdgeStarts[Spill.LabelB + 1]++;
+		}
+		for (int32 Label = 0; Label < NumLabels + 1; Label++)
+			EdgeStarts[Label + 1] += EdgeStarts[Label];
+
+		TArray<int32> EdgeTargets;
+		TArray<float> EdgeElevations;
+		EdgeTargets.SetNumUninitialized(EdgeStarts.Last());
+		EdgeElevations.SetNumUninitialized(EdgeStarts.Last());
+		TArray<int32> EdgeFill(EdgeStarts.GetData(), NumLabels + 1);
+		for (const FSpill& Spill : Spills)
+		{
+			const int32 EdgeA = EdgeFill[Spill.LabelA]++;
+			EdgeTargets[EdgeA] = Spill.LabelB;
+			EdgeElevations[EdgeA] = Spill.Elevation;
+			const int32 EdgeB = EdgeFill[Spill.LabelB]++;
+			EdgeTargets[EdgeB] = Spill.LabelA;
+			EdgeElevations[EdgeB] = Spill.Elevation;
+		}
+
+		TArray<float> Levels;
+		Levels.Init(TNumericLimits<float>::Max(), NumLabels + 1);
+		TBitArray<> Done(false, NumLabels + 1);
+		TArray<FOpenCell> Open;
+		Levels[ExteriorLabel] = TNumericLimits<float>::Lowest();
+		Open.HeapPush({ Levels[ExteriorLabel], ExteriorLabel }, FOpenCellLess());
+
+		while (Open.Num() > 0)
+		{
+			FOpenCell Top;
+			Open.HeapPop(Top, FOpenCellLess(), false);
+			if (Done[Top.Index])
+				continue;
+			Done[Top.Index] = true;
+
+			for (int32 Edge = EdgeStarts[Top.Index]; Edge < EdgeStarts[Top.Index + 1]; Edge++)
+			{
+				const int32 Target = EdgeTargets[Edge];
+				const float Level = FMath::Max(Top.Elevation, EdgeElevations[Edge]);
+				if (!Done[Target] && Level < Levels[Target])
+				{
+					Levels[Target] = Level;
+					Open.HeapPush({ Level, Target }, FOpenCellLess());
+				}
+			}
+		}
+
+		return Levels;
+	}
+}
+
+void FTGPriorityFlood::Fill(TArray<float>& Elevation, int32 Width, int32 Height, float NoDataValue)
+{
+	using namespace TGPriorityFloodLocal;
+	const TBitArray<> NoData = MakeNoDataMask(Elevation, NoDataValue);
+	FloodRect(Elevation, Width, Height, { 0, 0, Width, Height }, NoData, false, 0.f, nullptr);
+}
+
+void FTGPriorityFlood::FillEpsilon(
+	TArray<float>& Elevation,
+	int32 Width,
+	int32 Height,
+	float NoDataValue,
+	float Epsilon)
+{
+	using namespace TGPriorityFloodLocal;
+	const TBitArray<> NoData = MakeNoDataMask(Elevation, NoDataValue);
+	FloodRect(Elevation, Width, Height, { 0, 0, Width, Height }, NoData, true, FMath::Max(Epsilon, 0.f), nullptr);
+}
+
+void FTGPriorityFlood::FillTiled(
+	TArray<float>& Elevation,
+	int32 Width,
+	int32 Height,
+	float NoDataValue,
+	int32 TileSize)
+{
+	using namespace TGPriorityFloodLocal;
+	check(TileSize > 0);
+
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Width, TileSize);
+	const int32 NumTilesY = FMath::DivideAndRoundUp(Height, TileSize);
+	const auto GetTileRect = [TileSize, Width, Height, NumTilesX](int32 Tile)
+	{
+		const int32 TileX = Tile % NumTilesX;
+		const int32 TileY = Tile / NumTilesX;
+		return FIntRect {
+			TileX * TileSize,
+			TileY * TileSize,
+			FMath::Min((TileX + 1) * TileSize, Width),
+			FMath::Min((TileY + 1) * TileSize, Height)
+		};
+	};
+
+	// tiles are flooded independently, every tile reads and writes only its own cells
+	const TBitArray<> NoData = MakeNoDataMask(Elevation, NoDataValue);
+	TArray<FTileWatersheds> Tiles;
+	Tiles.SetNum(NumTilesX * NumTilesY);
+	ParallelFor(
+		Tiles.Num(),
+		[&](int32 Tile)
+		{
+			FloodRect(Elevation, Width, Height, GetTileRect(Tile), NoData, false, 0.f, &Tiles[Tile]);
+		});
+
+	TArray<int32> LabelBases;
+	LabelBases.SetNumUninitialized(Tiles.Num());
+	int32 NumLabels = 0;
+	for (int32 Tile = 0; Tile < Tiles.Num(); Tile++)
+	{
+		LabelBases[Tile] = NumLabels;
+		NumLabels += Tiles[Tile].NumLabels;
+	}
+
+	const auto GetGlobalLabel = [&Tiles, &LabelBases, &GetTileRect, TileSize, NumTilesX](int32 X, int32 Y)
+	{
+		const int32 Tile = (Y / TileSize) * NumTilesX + X / TileSize;
+		const FIntRect Rect = GetTileRect(Tile);
+		const int32 LocalLabel = Tiles[Tile].Labels[(Y - Rect.Min.Y) * Rect.Width() + X - Rect.Min.X];
+		return LocalLabel == ExteriorLabel ? ExteriorLabel : LabelBases[Tile] + LocalLabel;
+	};
+
+	TArray<FSpill> Spills;
+	for (int32 Tile = 0; Tile < Tiles.Num(); Tile++)
+	{
+		for (const FSpill& Spill : Tiles[Tile].Spills)
+		{
+			Spills.Add({
+				LabelBases[Tile] + Spill.LabelA,
+				Spill.LabelB == ExteriorLabel ? ExteriorLabel : LabelBases[Tile] + Spill.LabelB,
+				Spill.Elevation });
+		}
+	}
+
+	// connections across tile borders, every pair is visited from the cell with the lower tile coordinates
+	const auto AddBorderSpill = [&](int32 X, int32 Y, int32 NX, int32 NY)
+	{
+		if (NX < 0 || NY < 0 || NX >= Width || NY >= Height)
+			return;
+		const int32 Label = GetGlobalLabel(X, Y);
+		const int32 NeighborLabel = GetGlobalLabel(NX, NY);
+		if (Label == ExteriorLabel || NeighborLabel == ExteriorLabel || Label == NeighborLabel)
+			return;
+		Spills.Add({ Label, NeighborLabel, FMath::Max(Elevation[Y * Width + X], Elevation[NY * Width + NX]) });
+	};
+
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			if ((X + 1) % TileSize == 0)
+			{
+				for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+					AddBorderSpill(X, Y, X + 1, Y + OffsetY);
+			}
+			if ((Y + 1) % TileSize == 0)
+			{
+				for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+					AddBorderSpill(X, Y, X + OffsetX, Y + 1);
+			}
+		}
+	}
+
+	const TArray<float> Levels = SolveSpillElevations(NumLabels, Spills);
+
+	ParallelFor(
+		Tiles.Num(),
+		[&](int32 Tile)
+		{
+			const FIntRect Rect = GetTileRect(Tile);
+			const FTileWatersheds& Watersheds = Tiles[Tile];
+			for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+			{
+				for (int32 X = Rect.Min.X; X < Rect.Max.X; X++)
+				{
+					const int32 LocalLabel = Watersheds.Labels[(Y - Rect.Min.Y) * Rect.Width() + X - Rect.Min.X];
+					if (LocalLabel == ExteriorLabel)
+						continue;
+					float& CellElevation = Elevation[Y * Width + X];
+					CellElevation = FMath::Max(CellElevation, Levels[LabelBases[Tile] + LocalLabel]);
+				}
+			}
+		});
+}
+
+void FTGPriorityFlood::ResolveFlats(
+	TArray<float>& Elevation,
+	int32 Width,
+	int32 Height,
+	float NoDataValue,
+	float Increment)
+{
+	using namespace TGPriorityFloodLocal;
+
+	const int32 NumCells = Width * Height;
+	const auto IsValidCell = [&Elevation, Width, Height, NoDataValue](int32 X, int32 Y)
+	{
+		return X >= 0 && Y >= 0 && X < Width && Y < Height && !IsNoData(Elevation[Y * Width + X], NoDataValue);
+	};
+
+	// cells with a lower neighbor and outlets
+	TArray<uint8> Drains;
+	Drains.Init(0, NumCells);
+	ParallelFor(
+		Height,
+		[&](int32 Y)
+		{
+			for (int32 X = 0; X < Width; X++)
+			{
+				const int32 Cell = Y * Width + X;
+				if (!IsValidCell(X, Y))
+					continue;
+				for (const FIntPoint& Offset : Neighbors)
+				{
+					const int32 NX = X + Offset.X;
+					const int32 NY = Y + Offset.Y;
+					if (!IsValidCell(NX, NY) || Elevation[NY * Width + NX] < Elevation[Cell])
+					{
+						Drains[Cell] = 1;
+						break;
+					}
+				}
+			}
+		});
+
+	TArray<int32> LowEdges;
+	TArray<int32> HighEdges;
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			const int32 Cell = Y * Width + X;
+			if (!IsValidCell(X, Y))
+				continue;
+
+			for (const FIntPoint& Offset : Neighbors)
+			{
+				const int32 NX = X + Offset.X;
+				const int32 NY = Y + Offset.Y;
+				if (!IsValidCell(NX, NY))
+					continue;
+
+				const int32 Neighbor = NY * Width + NX;
+				if (Drains[Cell] && !Drains[Neighbor] && Elevation[Neighbor] == Elevation[Cell])
+				{
+					LowEdges.Add(Cell);
+					break;
+				}
+				if (!Drains[Cell] && Elevation[Neighbor] > Elevation[Cell])
+				{
+					HighEdges.Add(Cell);
+					break;
+				}
+			}
+		}
+	}
+
+	// only flats which have a low edge can be drained
+	TArray<int32> Labels;
+	Labels.Init(0, NumCells);
+	int32 NumLabels = 0;
+	TArray<int32> Queue;
+	for (const int32 LowEdge : LowEdges)
+	{
+		if (Labels[LowEdge] != 0)
+			continue;
+
+		Labels[LowEdge] = ++NumLabels;
+		Queue.Reset();
+		Queue.Add(LowEdge);
+		while (Queue.Num() > 0)
+		{
+			const int32 Cell = Queue.Pop(false);
+			for (const FIntPoint& Offset : Neighbors)
+			{
+				const int32 NX = Cell % Width + Offset.X;
+				const int32 NY = Cell / Width + Offset.Y;
+				const int32 Neighbor = NY * Width + NX;
+				if (IsValidCell(NX, NY) && Labels[Neighbor] == 0 && Elevation[Neighbor] == Elevation[Cell])
+				{
+					Labels[Neighbor] = NumLabels;
+					Queue.Add(Neighbor);
+				}
+			}
+		}
+	}
+
+	HighEdges.RemoveAll(
+		[&Labels](int32 Cell)
+		{
+			return Labels[Cell] == 0;
+		});
+
+	TArray<int32> FlatMask;
+	FlatMask.Init(0, NumCells);
+	TArray<int32> FlatHeights;
+	FlatHeights.Init(0, NumLabels + 1);
+
+	// breadth first layers, Visit returns false for already processed cells
+	const auto RunLayers = [&](const TArray<int32>& Seeds, TFunctionRef<bool(int32 Cell, int32 Loops)> Visit)
+	{
+		TArray<int32> Layer = Seeds;
+		TArray<int32> NextLayer;
+		for (int32 Loops = 1; Layer.Num() > 0; Loops++)
+		{
+			NextLayer.Reset();
+			for (const int32 Cell : Layer)
+			{
+				if (!Visit(Cell, Loops))
+					continue;
+				for (const FIntPoint& Offset : Neighbors)
+				{
+					const int32 NX = Cell % Width + Offset.X;
+					const int32 NY = Cell / Width + Offset.Y;
+					const int32 Neighbor = NY * Width + NX;
+					if (IsValidCell(NX, NY) && Labels[Neighbor] == Labels[Cell] && !Drains[Neighbor])
+						NextLayer.Add(Neighbor);
+				}
+			}
+			Swap(Layer, NextLayer);
+		}
+	};
+
+	// away from higher terrain
+	RunLayers(
+		HighEdges,
+		[&](int32 Cell, int32 Loops)
+		{
+			if (FlatMask[Cell] > 0)
+				return false;
+			FlatMask[Cell] = Loops;
+			FlatHeights[Labels[Cell]] = Loops;
+			return true;
+		});
+
+	for (int32& Mask : FlatMask)
+		Mask = -Mask;
+
+	// towards lower terrain, dominates the away gradient
+	RunLayers(
+		LowEdges,
+		[&](int32 Cell, int32 Loops)
+		{
+			if (FlatMask[Cell] > 0)
+				return false;
+			FlatMask[Cell] = FlatMask[Cell] < 0 ? FlatHeights[Labels[Cell]] + FlatMask[Cell] + 2 * Loops : 2 * Loops;
+			return true;
+		});
+
+	// low edges drain already and keep their elevation
+	ParallelFor(
+		Height,
+		[&](int32 Y)
+		{
+			for (int32 Cell = Y * Width; Cell < (Y + 1) * Width; Cell++)
+			{
+				if (Labels[Cell] != 0 && !Drains[Cell])
+					Elevation[Cell] += FlatMask[Cell] * Increment;
+			}
+		});
+}
@@ -0,0 +1,52 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+// Priority-Flood depression filling, R. Barnes, C. Lehman, D. Mulla (2014, 2016)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief   Depression filling over a flat row-major elevation raster.
+ * @details Cells equal to NoDataValue are skipped and act as outlets like the raster border.
+ */
+struct FTGPriorityFlood
+{
+	// Fills depressions to their spill elevations, filled areas become flat
+	static void Fill(TArray<float>& Elevation, int32 Width, int32 Height, float NoDataValue);
+
+	// Filled areas get a gradient of at least Epsilon per cell towards the spill cell (Priority-Flood+Epsilon),
+	// the smallest representable one if Epsilon is 0
+	static void FillEpsilon(
+		TArray<float>& Elevation,
+		int32 Width,
+		int32 Height,
+		float NoDataValue,
+		float Epsilon = 0.f);
+
+	/**
+	 * @brief   Same result as Fill(), tiles are filled in parallel.
+	 * @details Every tile is filled with its border as the outlet, then spill elevations of the tile watersheds
+	 *          are resolved on the graph of their connections across tile borders.
+	 */
+	static void FillTiled(TArray<float>& Elevation, int32 Width, int32 Height, float NoDataValue, int32 TileSize);
+
+	/**
+	 * @brief   Adds a gradient to drainable flats: towards the lower edges and away from the higher edges.
+	 * @details Flat cells are raised by Increment multiplied by the flat mask value (Barnes et al. 2014).
+	 */
+	static void ResolveFlats(TArray<float>& Elevation, int32 Width, int32 Height, float NoDataValue, float Increment);
+};
@@ -16,6 +16,7 @@
 
 #include "Generators/TGSteepness.h"
 
+#include "HeightmapKernels.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "Misc/FeedbackContext.h"
 #include "Misc/ScopedSlowTask.h"
@@ -26,43 +27,46 @@ UTGSteepness::UTGSteepness()
 	GeneratorName = TEXT("Steepness");
 }
 
-UTextureRenderTarget2D* UTGSteepness::Generate(const FTGTerrainInfo& TerrainInfo)
+bool UTGSteepness::GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights)
 {
-	TArray<float> HeightData = GenerateSteepness(TerrainInfo.DecodedHeight, TerrainInfo.Size);
+	TArray<float> HeightData =
+		GenerateSteepness(TerrainInfo.DecodedHeight, TerrainInfo.Size, TerrainInfo.bReportProgress);
 
 	MinHeight = FMath::Min(MinHeight, MaxHeight);
 	MaxHeight = FMath::Max(MinHeight, MaxHeight);
 	const float HMax = FMath::Max(HeightData);
 
-	for (float& Iter : HeightData)
-	{
-		Iter = ApplyAdjustments(Iter);
-		Iter = FMath::Clamp(Iter, MinHeight / 100.f * HMax, MaxHeight / 100.f * HMax);
-	}
-
-	const TArray<uint8> OutResult = RemapToWeight(HeightData);
-	RenderTarget = DrawWeightmap(OutResult, GeneratorName, TerrainInfo.Size, TerrainInfo.bFullRange);
-	return GetRenderTarget();
+	FHeightmapKernels::ForEachRange(
+		HeightData.Num(),
+		[&](int32 Begin, int32 End)
+		{
+			for (int32 Index = Begin; Index < End; Index++)
+			{
+				const float Value = ApplyAdjustments(HeightData[Index]);
+				HeightData[Index] = FMath::Clamp(Value, MinHeight / 100.f * HMax, MaxHeight / 100.f * HMax);
+			}
+		});
+
+	OutWeights = RemapToWeight(HeightData);
+	return true;
 }
 
-TArray<float> UTGSteepness::GenerateSteepness(const TArray<float>& InHeightmap, FIntPoint Size)
+TArray<float> UTGSteepness::GenerateSteepness(TArrayView<const float> InHeightmap, FIntPoint Size, bool bReportProgress)
 {
-	GWarn->BeginSlowTask(FText::FromString(TEXT("Generate: Steepness")), true, false);
-	int32 Progress = 0;
-	int32 TotalProgress = Size.X;
-
 	TArray<float> OutResult;
-	OutResult.SetNum(InHeightmap.Num());
+	OutResult.SetNumUninitialized(InHeightmap.Num());
 
-	for (int32 x = 0; x < Size.X; x++)
+	if (!bReportProgress)
 	{
-		for (int32 y = 0; y < Size.Y; y++)
-		{
-			OutResult[x * Size.Y + y] = GetSteepnessHQ(InHeightmap, Size, x, y);
-		}
-		GWarn->UpdateProgress(Progress++, TotalProgress);
+		FHeightmapKernels::Steepness({ InHeightmap, Size }, { OutResult, Size });
+		return OutResult;
 	}
 
+	GWarn->BeginSlowTask(FText::FromString(TEXT("Generate: Steepness")), true, false);
+	FHeightmapKernels::Steepness(
+		{ InHeightmap, Size },
+		{ OutResult, Size },
+		[](int32 NumTilesDone, int32 NumTiles) { GWarn->UpdateProgress(NumTilesDone, NumTiles); });
 	GWarn->EndSlowTask();
 
 	return OutResult;
@@ -84,18 +88,6 @@ float UTGSteepness::GetSteepnessMQ(const TArray<float>& InHeightmap, FIntPoint S
 	return FMath::Sqrt(DX * DX + DY * DY);
 }
 
-float UTGSteepness::GetSteepnessHQ(const TArray<float>& InHeightmap, FIntPoint Size, const int32 X, const int32 Y)
-{
-	const float Height = GetHeight(GetPixel(InHeightmap, X, Y, Size));
-
-	const float North = GetHeight(GetPixel(InHeightmap, FMath::Clamp(X + 1, 0, Size.X - 1), Y, Size)) - Height;
-	const float South = GetHeight(GetPixel(InHeightmap, X, FMath::Clamp(Y + 1, 0, Size.Y - 1), Size)) - Height;
-	const float East = GetHeight(GetPixel(InHeightmap, FMath::Clamp(X - 1, 0, Size.X - 1), Y, Size)) - Height;
-	const float West = GetHeight(GetPixel(InHeightmap, X, FMath::Clamp(Y - 1, 0, Size.Y - 1), Size)) - Height;
-
-	return FMath::Sqrt(North * North + South * South + East * East + West * West);
-}
-
 float UTGSteepness::GetPixel(const TArray<float>& InHeightmap, const int32 X, const int32 Y, FIntPoint& Size)
 {
 	return InHeightmap[X * Size.X + Y];
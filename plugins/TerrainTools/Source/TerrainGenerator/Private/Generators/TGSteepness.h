@@ -30,7 +30,7 @@ class TERRAINGENERATOR_API UTGSteepness : public UTGBaseLayer
 public:
 	UTGSteepness();
 
-	virtual UTextureRenderTarget2D* Generate(const FTGTerrainInfo& TerrainInfo) override;
+	virtual bool GenerateWeights(const FTGTerrainInfo& TerrainInfo, TArray<uint8>& OutWeights) override;
 
 	UPROPERTY(EditInstanceOnly, meta = (ClampMin = 0, ClampMax = 100), Category = "Adjustments")
 	int32 MinHeight = 0;
@@ -39,10 +39,9 @@ public:
 	int32 MaxHeight = 100;
 
 private:
-	TArray<float> GenerateSteepness(const TArray<float>& InHeightmap, FIntPoint Size);
+	TArray<float> GenerateSteepness(TArrayView<const float> InHeightmap, FIntPoint Size, bool bReportProgress);
 	static float GetSteepnessLQ(const TArray<float>& InHeightmap, FIntPoint Size, int32 X, int32 Y);
 	static float GetSteepnessMQ(const TArray<float>& InHeightmap, FIntPoint Size, int32 X, int32 Y);
-	static float GetSteepnessHQ(const TArray<float>& InHeightmap, FIntPoint Size, int32 X, int32 Y);
 	static float GetPixel(const TArray<float>& InHeightmap, int32 X, int32 Y, FIntPoint& Size);
 	static float GetHeight(float InHeight);
 };
@@ -0,0 +1,581 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "HeightmapKernels.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/App.h"
+
+namespace HeightmapKernelsLocal
+{
+	constexpr int32 NumLanes = 4;
+
+	void ParallelForWithProgress(int32 Num, TFunctionRef<void(int32)> Body, const FHeightmapKernelProgress& Progress)
+	{
+		const uint32 CallingThreadId = FPlatformTLS::GetCurrentThreadId();
+		FThreadSafeCounter NumDone;
+
+		ParallelFor(
+			Num,
+			[&](int32 Index)
+			{
+				Body(Index);
+				const int32 Done = NumDone.Increment();
+				if (Progress && FPlatformTLS::GetCurrentThreadId() == CallingThreadId)
+					Progress(Done, Num);
+			},
+			!FApp::ShouldUseThreadingForPerformance());
+
+		if (Progress)
+			Progress(Num, Num);
+	}
+
+	// Maps the progress of one pass of a multi-pass kernel
+	FHeightmapKernelProgress MakePassProgress(const FHeightmapKernelProgress& Progress, int32 Pass, int32 NumPasses)
+	{
+		if (!Progress)
+			return {};
+
+		return [&Progress, Pass, NumPasses](int32 NumTilesDone, int32 NumTiles)
+		{ Progress(Pass * NumTiles + NumTilesDone, NumPasses * NumTiles); };
+	}
+
+	// VectorOp gets NumLanes pixels which have all neighbours up to Radius inside the row, ScalarOp gets the rest
+	template <typename ScalarOpType, typename VectorOpType>
+	FORCEINLINE void ProcessSpan(
+		int32 MinX,
+		int32 MaxX,
+		int32 Width,
+		int32 Radius,
+		ScalarOpType&& ScalarOp,
+		VectorOpType&& VectorOp)
+	{
+		const int32 VectorMinX = FMath::Clamp(Radius, MinX, MaxX);
+		const int32 VectorMaxX = FMath::Min(MaxX, Width - Radius);
+
+		int32 X = MinX;
+		for (; X < VectorMinX; X++)
+			ScalarOp(X);
+		for (; X + NumLanes <= VectorMaxX; X += NumLanes)
+			VectorOp(X);
+		for (; X < MaxX; X++)
+			ScalarOp(X);
+	}
+
+	// Zero stays zero instead of turning into 0 * inf
+	FORCEINLINE VectorRegister VectorSqrtAccurate(const VectorRegister& Value)
+	{
+		return VectorMultiply(Value, VectorReciprocalSqrtAccurate(VectorMax(Value, VectorSetFloat1(MIN_flt))));
+	}
+
+	// Clamped rows around Y
+	struct FRowNeighbourhood
+	{
+		FRowNeighbourhood(const FConstHeightmapView& In, int32 Y)
+			: Up { In.GetRow(FMath::Max(Y - 1, 0)) }
+			, Row { In.GetRow(Y) }
+			, Down { In.GetRow(FMath::Min(Y + 1, In.Size.Y - 1)) }
+			, LastX { In.Size.X - 1 }
+		{
+		}
+
+		float Left(int32 X) const
+		{
+			return Row[FMath::Max(X - 1, 0)];
+		}
+
+		float Right(int32 X) const
+		{
+			return Row[FMath::Min(X + 1, LastX)];
+		}
+
+		const float* Up;
+		const float* Row;
+		const float* Down;
+		int32 LastX;
+	};
+
+	void CheckStencilViews(const FConstHeightmapView& In, const FIntPoint& OutSize, const void* OutData)
+	{
+		check(In.Size == OutSize);
+		check(In.Data != OutData);
+	}
+}
+
+void FHeightmapKernels::ForEachTile(
+	FIntPoint Size,
+	TFunctionRef<void(const FIntRect& Tile)> Kernel,
+	const FHeightmapKernelProgress& Progress)
+{
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Size.X, TileSize);
+	const int32 NumTiles = NumTilesX * FMath::DivideAndRoundUp(Size.Y, TileSize);
+
+	HeightmapKernelsLocal::ParallelForWithProgress(
+		NumTiles,
+		[&](int32 Tile)
+		{
+			const FIntPoint Min { Tile % NumTilesX * TileSize, Tile / NumTilesX * TileSize };
+			const FIntPoint Max { FMath::Min(Min.X + TileSize, Size.X), FMath::Min(Min.Y + TileSize, Size.Y) };
+			Kernel(FIntRect(Min, Max));
+		},
+		Progress);
+}
+
+void FHeightmapKernels::ForEachRange(
+	int32 Num,
+	TFunctionRef<void(int32 Begin, int32 End)> Kernel,
+	const FHeightmapKernelProgress& Progress)
+{
+	constexpr int32 RangeSize = TileSize * TileSize;
+
+	HeightmapKernelsLocal::ParallelForWithProgress(
+		FMath::DivideAndRoundUp(Num, RangeSize),
+		[&](int32 Range)
+		{
+			const int32 Begin = Range * RangeSize;
+			Kernel(Begin, FMath::Min(Begin + RangeSize, Num));
+		},
+		Progress);
+}
+
+void FHeightmapKernels::UnpackHeight(
+	FConstPackedHeightmapView In,
+	FHeightmapView Out,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	check(In.Size == Out.Size);
+
+	ForEachRange(
+		In.Num(),
+		[&](int32 Begin, int32 End)
+		{
+			const uint16* Source = In.Data;
+			const VectorRegister Scale = VectorSetFloat1(255.f);
+
+			int32 Index = Begin;
+			for (; Index + NumLanes <= End; Index += NumLanes)
+			{
+				const VectorRegisterInt Packed =
+					MakeVectorRegisterInt(Source[Index], Source[Index + 1], Source[Index + 2], Source[Index + 3]);
+				VectorStore(VectorMultiply(VectorIntToFloat(Packed), Scale), Out.Data + Index);
+			}
+			for (; Index < End; Index++)
+				Out.Data[Index] = Source[Index] * 255.f;
+		},
+		Progress);
+}
+
+void FHeightmapKernels::PackHeight(
+	FConstHeightmapView In,
+	FPackedHeightmapView Out,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	check(In.Size == Out.Size);
+
+	ForEachRange(
+		In.Num(),
+		[&](int32 Begin, int32 End)
+		{
+			const VectorRegister Scale = VectorSetFloat1(255.f);
+			const VectorRegister MaxValue = VectorSetFloat1(MAX_uint16);
+
+			int32 Index = Begin;
+			for (; Index + NumLanes <= End; Index += NumLanes)
+			{
+				const VectorRegister Height = VectorDivide(VectorLoad(In.Data + Index), Scale);
+				const VectorRegister Clamped = VectorMin(VectorMax(Height, VectorZero()), MaxValue);
+
+				int32 Packed[NumLanes];
+				VectorIntStore(VectorFloatToInt(Clamped), Packed);
+				for (int32 Lane = 0; Lane < NumLanes; Lane++)
+					Out.Data[Index + Lane] = (uint16)Packed[Lane];
+			}
+			for (; Index < End; Index++)
+				Out.Data[Index] = (uint16)FMath::Clamp(In.Data[Index] / 255.f, (float)MIN_uint16, (float)MAX_uint16);
+		},
+		Progress);
+}
+
+void FHeightmapKernels::Steepness(FConstHeightmapView In, FHeightmapView Out, const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const FRowNeighbourhood Rows(In, Y);
+				float* OutRow = Out.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					1,
+					[&](int32 X)
+					{
+						const float Center = Rows.Row[X];
+						const float Left = Rows.Left(X) - Center;
+						const float Right = Rows.Right(X) - Center;
+						const float Up = Rows.Up[X] - Center;
+						const float Down = Rows.Down[X] - Center;
+						OutRow[X] = FMath::Sqrt(Left * Left + Right * Right + Up * Up + Down * Down);
+					},
+					[&](int32 X)
+					{
+						const VectorRegister Center = VectorLoad(Rows.Row + X);
+						const VectorRegister Left = VectorSubtract(VectorLoad(Rows.Row + X - 1), Center);
+						const VectorRegister Right = VectorSubtract(VectorLoad(Rows.Row + X + 1), Center);
+						const VectorRegister Up = VectorSubtract(VectorLoad(Rows.Up + X), Center);
+						const VectorRegister Down = VectorSubtract(VectorLoad(Rows.Down + X), Center);
+
+						VectorRegister Sum = VectorMultiply(Left, Left);
+						Sum = VectorMultiplyAdd(Right, Right, Sum);
+						Sum = VectorMultiplyAdd(Up, Up, Sum);
+						Sum = VectorMultiplyAdd(Down, Down, Sum);
+						VectorStore(VectorSqrtAccurate(Sum), OutRow + X);
+					});
+			}
+		},
+		Progress);
+}
+
+void FHeightmapKernels::Slope(
+	FConstHeightmapView In,
+	FHeightmapView Out,
+	float CellSize,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+	const float InvTwoCellSize = 0.5f / CellSize;
+
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			const VectorRegister Scale = VectorSetFloat1(InvTwoCellSize);
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const FRowNeighbourhood Rows(In, Y);
+				float* OutRow = Out.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					1,
+					[&](int32 X)
+					{
+						const float DX = (Rows.Right(X) - Rows.Left(X)) * InvTwoCellSize;
+						const float DY = (Rows.Down[X] - Rows.Up[X]) * InvTwoCellSize;
+						OutRow[X] = FMath::Sqrt(DX * DX + DY * DY);
+					},
+					[&](int32 X)
+					{
+						const VectorRegister DX = VectorMultiply(
+							VectorSubtract(VectorLoad(Rows.Row + X + 1), VectorLoad(Rows.Row + X - 1)),
+							Scale);
+						const VectorRegister DY =
+							VectorMultiply(VectorSubtract(VectorLoad(Rows.Down + X), VectorLoad(Rows.Up + X)), Scale);
+						VectorStore(VectorSqrtAccurate(VectorMultiplyAdd(DX, DX, VectorMultiply(DY, DY))), OutRow + X);
+					});
+			}
+		},
+		Progress);
+}
+
+void FHeightmapKernels::Curvature(
+	FConstHeightmapView In,
+	FHeightmapView Out,
+	float CellSize,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+	const float InvCellSizeSquared = 1.f / (CellSize * CellSize);
+
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			const VectorRegister Scale = VectorSetFloat1(InvCellSizeSquared);
+			const VectorRegister CenterWeight = VectorSetFloat1(-4.f);
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const FRowNeighbourhood Rows(In, Y);
+				float* OutRow = Out.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					1,
+					[&](int32 X)
+					{
+						const float Sum = Rows.Left(X) + Rows.Right(X) + Rows.Up[X] + Rows.Down[X];
+						OutRow[X] = (Sum - 4.f * Rows.Row[X]) * InvCellSizeSquared;
+					},
+					[&](int32 X)
+					{
+						VectorRegister Sum = VectorAdd(VectorLoad(Rows.Row + X - 1), VectorLoad(Rows.Row + X + 1));
+						Sum = VectorAdd(Sum, VectorAdd(VectorLoad(Rows.Up + X), VectorLoad(Rows.Down + X)));
+						Sum = VectorMultiplyAdd(VectorLoad(Rows.Row + X), CenterWeight, Sum);
+						VectorStore(VectorMultiply(Sum, Scale), OutRow + X);
+					});
+			}
+		},
+		Progress);
+}
+
+void FHeightmapKernels::Normals(
+	FConstHeightmapView In,
+	THeightmapView<FVector> Out,
+	float CellSize,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+	const float InvTwoCellSize = 0.5f / CellSize;
+
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			const VectorRegister Scale = VectorSetFloat1(-InvTwoCellSize);
+			const VectorRegister One = VectorSetFloat1(1.f);
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const FRowNeighbourhood Rows(In, Y);
+				FVector* OutRow = Out.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					1,
+					[&](int32 X)
+					{
+						const float NX = (Rows.Left(X) - Rows.Right(X)) * InvTwoCellSize;
+						const float NY = (Rows.Up[X] - Rows.Down[X]) * InvTwoCellSize;
+						const float InvLength = FMath::InvSqrt(NX * NX + NY * NY + 1.f);
+						OutRow[X] = FVector(NX * InvLength, NY * InvLength, InvLength);
+					},
+					[&](int32 X)
+					{
+						const VectorRegister NX = VectorMultiply(
+							VectorSubtract(VectorLoad(Rows.Row + X + 1), VectorLoad(Rows.Row + X - 1)),
+							Scale);
+						const VectorRegister NY =
+							VectorMultiply(VectorSubtract(VectorLoad(Rows.Down + X), VectorLoad(Rows.Up + X)), Scale);
+						const VectorRegister InvLength =
+							VectorReciprocalSqrtAccurate(VectorMultiplyAdd(NX, NX, VectorMultiplyAdd(NY, NY, One)));
+
+						float Components[3][NumLanes];
+						VectorStore(VectorMultiply(NX, InvLength), Components[0]);
+						VectorStore(VectorMultiply(NY, InvLength), Components[1]);
+						VectorStore(InvLength, Components[2]);
+						for (int32 Lane = 0; Lane < NumLanes; Lane++)
+							OutRow[X + Lane] = FVector(Components[0][Lane], Components[1][Lane], Components[2][Lane]);
+					});
+			}
+		},
+		Progress);
+}
+
+void FHeightmapKernels::Convolve3x3(
+	FConstHeightmapView In,
+	FHeightmapView Out,
+	const float (&Kernel)[9],
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const FRowNeighbourhood Rows(In, Y);
+				const float* KernelRows[3] = { Rows.Up, Rows.Row, Rows.Down };
+				float* OutRow = Out.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					1,
+					[&](int32 X)
+					{
+						const int32 Columns[3] = { FMath::Max(X - 1, 0), X, FMath::Min(X + 1, Rows.LastX) };
+						float Sum = 0.f;
+						for (int32 KernelY = 0; KernelY < 3; KernelY++)
+						{
+							for (int32 KernelX = 0; KernelX < 3; KernelX++)
+								Sum += Kernel[KernelY * 3 + KernelX] * KernelRows[KernelY][Columns[KernelX]];
+						}
+						OutRow[X] = Sum;
+					},
+					[&](int32 X)
+					{
+						VectorRegister Sum = VectorZero();
+						for (int32 KernelY = 0; KernelY < 3; KernelY++)
+						{
+							for (int32 KernelX = 0; KernelX < 3; KernelX++)
+							{
+								Sum = VectorMultiplyAdd(
+									VectorLoad(KernelRows[KernelY] + X + KernelX - 1),
+									VectorLoadFloat1(&Kernel[KernelY * 3 + KernelX]),
+									Sum);
+							}
+						}
+						VectorStore(Sum, OutRow + X);
+					});
+			}
+		},
+		Progress);
+}
+
+void FHeightmapKernels::ConvolveSeparable(
+	FConstHeightmapView In,
+	FHeightmapView Out,
+	TArrayView<const float> KernelX,
+	TArrayView<const float> KernelY,
+	const FHeightmapKernelProgress& Progress)
+{
+	using namespace HeightmapKernelsLocal;
+	CheckStencilViews(In, Out.Size, Out.Data);
+	check(KernelX.Num() % 2 == 1 && KernelY.Num() % 2 == 1);
+
+	TArray<float> Rows;
+	Rows.SetNumUninitialized(In.Num());
+	const FHeightmapView RowsView { Rows, In.Size };
+
+	const int32 RadiusX = KernelX.Num() / 2;
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const float* Row = In.GetRow(Y);
+				float* OutRow = RowsView.GetRow(Y);
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					RadiusX,
+					[&](int32 X)
+					{
+						float Sum = 0.f;
+						for (int32 Offset = -RadiusX; Offset <= RadiusX; Offset++)
+							Sum += KernelX[Offset + RadiusX] * Row[FMath::Clamp(X + Offset, 0, In.Size.X - 1)];
+						OutRow[X] = Sum;
+					},
+					[&](int32 X)
+					{
+						VectorRegister Sum = VectorZero();
+						for (int32 Offset = -RadiusX; Offset <= RadiusX; Offset++)
+						{
+							Sum = VectorMultiplyAdd(
+								VectorLoad(Row + X + Offset),
+								VectorLoadFloat1(&KernelX[Offset + RadiusX]),
+								Sum);
+						}
+						VectorStore(Sum, OutRow + X);
+					});
+			}
+		},
+		MakePassProgress(Progress, 0, 2));
+
+	const int32 RadiusY = KernelY.Num() / 2;
+	ForEachTile(
+		In.Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				float* OutRow = Out.GetRow(Y);
+				const auto GetSourceRow = [&](int32 Offset)
+				{ return RowsView.GetRow(FMath::Clamp(Y + Offset, 0, In.Size.Y - 1)); };
+
+				ProcessSpan(
+					Tile.Min.X,
+					Tile.Max.X,
+					In.Size.X,
+					0,
+					[&](int32 X)
+					{
+						float Sum = 0.f;
+						for (int32 Offset = -RadiusY; Offset <= RadiusY; Offset++)
+							Sum += KernelY[Offset + RadiusY] * GetSourceRow(Offset)[X];
+						OutRow[X] = Sum;
+					},
+					[&](int32 X)
+					{
+						VectorRegister Sum = VectorZero();
+						for (int32 Offset = -RadiusY; Offset <= RadiusY; Offset++)
+						{
+							Sum = VectorMultiplyAdd(
+								VectorLoad(GetSourceRow(Offset) + X),
+								VectorLoadFloat1(&KernelY[Offset + RadiusY]),
+								Sum);
+						}
+						VectorStore(Sum, OutRow + X);
+					});
+			}
+		},
+		MakePassProgress(Progress, 1, 2));
+}
+
+void FHeightmapKernels::GaussianBlur(
+	FConstHeightmapView In,
+	FHeightmapView Out,
+	float Sigma,
+	const FHeightmapKernelProgress& Progress)
+{
+	const TArray<float> Kernel = MakeGaussianKernel(Sigma);
+	ConvolveSeparable(In, Out, Kernel, Kernel, Progress);
+}
+
+TArray<float> FHeightmapKernels::MakeGaussianKernel(float Sigma)
+{
+	const int32 Radius = Sigma > 0.f ? FMath::CeilToInt(3.f * Sigma) : 0;
+
+	TArray<float> Kernel;
+	Kernel.SetNumUninitialized(2 * Radius + 1);
+
+	float Sum = 0.f;
+	for (int32 Offset = -Radius; Offset <= Radius; Offset++)
+	{
+		const float Weight = Radius > 0 ? FMath::Exp(-(Offset * Offset) / (2.f * Sigma * Sigma)) : 1.f;
+		Kernel[Offset + Radius] = Weight;
+		Sum += Weight;
+	}
+	for (float& Weight : Kernel)
+		Weight /= Sum;
+
+	return Kernel;
+}
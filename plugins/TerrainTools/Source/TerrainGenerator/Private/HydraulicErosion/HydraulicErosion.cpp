@@ -23,9 +23,11 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "Landscape.h"
+#include "LandscapeInfo.h"
 #include "LevelEditor.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Materials/MaterialParameterCollectionInstance.h"
+#include "Misc/ScopedSlowTask.h"
 #include "TerrainGeneratorHelper.h"
 #include "TerrainGeneratorUtils.h"
 
@@ -361,6 +363,67 @@ void AHydraulicErosion::PerformIterations() const
 	HydraulicErosion->TickErosionOnce(ButtonPressIterations);
 }
 
+void AHydraulicErosion::PerformIterationsOnCPU()
+{
+	ALandscape* LandscapeActor = Landscape.Get();
+	if (!LandscapeActor || !LandscapeActor->GetLandscapeInfo())
+		return;
+
+	int32 MinX, MinY, MaxX, MaxY;
+	if (!LandscapeActor->GetLandscapeInfo()->GetLandscapeExtent(MinX, MinY, MaxX, MaxY))
+		return;
+
+	TArray<uint16> PackedHeight;
+	UTerrainGeneratorHelper::TerrainExportHeightmap(LandscapeActor, PackedHeight);
+	const FIntPoint Size { MaxX - MinX + 1, MaxY - MinY + 1 };
+	if (PackedHeight.Num() != Size.X * Size.Y)
+		return;
+
+	// Landscape height is stored around the middle of uint16, 128 units per Z scale
+	const float ZScale = LandscapeActor->GetActorScale().Z / 128.f;
+	TArray<float> Height;
+	Height.SetNumUninitialized(PackedHeight.Num());
+	for (int32 Iter = 0; Iter < Height.Num(); Iter++)
+	{
+		Height[Iter] = (PackedHeight[Iter] - 32768.f) * ZScale;
+	}
+
+	FHydraulicErosionSolver Solver({ Height, Size }, MakeSolverSettings(LandscapeActor->GetActorScale().X));
+	{
+		FScopedSlowTask SlowTask(CPUIterations, FText::FromString(TEXT("Hydraulic Erosion")));
+		SlowTask.MakeDialog();
+		Solver.Run(CPUIterations, [&SlowTask](int32, int32) { SlowTask.EnterProgressFrame(); });
+	}
+
+	const TArray<float>& Eroded = Solver.GetHeight();
+	for (int32 Iter = 0; Iter < Eroded.Num(); Iter++)
+	{
+		PackedHeight[Iter] = (uint16)FMath::Clamp(FMath::RoundToInt(Eroded[Iter] / ZScale + 32768.f), 0, 65535);
+	}
+	UTerrainGeneratorHelper::TerrainImportHeightmap(LandscapeActor, PackedHeight, Size);
+}
+
+FHydraulicErosionSettings AHydraulicErosion::MakeSolverSettings(float CellSize) const
+{
+	FHydraulicErosionSettings Settings;
+	Settings.Mode = HydraulicErosionMode == FreeParticles ? EHydraulicErosionSolverMode::Droplets
+														  : EHydraulicErosionSolverMode::VirtualPipes;
+	Settings.Seed = GetTypeHash(Seed);
+	Settings.DeltaT = DeltaT;
+	Settings.RainAmount = RainAmount;
+	Settings.StartWater = StartWater;
+	Settings.bWaterIsLevel = bWaterIsLevel;
+	Settings.ResetEveryNIterations = ResetEveryNInterations;
+	Settings.Solubility = Solubility;
+	Settings.Evaporation = Evaporation;
+	Settings.VelocityDamping = VelocityDamping;
+	// Centimeters per second squared
+	Settings.Gravity = 980.f;
+	Settings.CellSize = CellSize;
+	Settings.NumDroplets = CPUDroplets;
+	return Settings;
+}
+
 void AHydraulicErosion::SpawnInstanceMeshes(UInstancedStaticMeshComponent* ISMC)
 {
 	ISMC->ClearInstances();
@@ -19,6 +19,7 @@
 #include "CoreMinimal.h"
 
 #include "HydraulicErosionComponent.h"
+#include "HydraulicErosionSolver.h"
 #include "LayerStackBase.h"
 
 #include "HydraulicErosion.generated.h"
@@ -110,6 +111,13 @@ public:
 	UFUNCTION(CallInEditor, Category = "Simulation", meta = (DisplayPriority = 4))
 	void PerformIterations() const;
 
+	// Erodes the Landscape heightmap on the CPU with FHydraulicErosionSolver, FreeParticles runs droplets.
+	UFUNCTION(CallInEditor, Category = "Simulation", meta = (DisplayPriority = 5))
+	void PerformIterationsOnCPU();
+
+	// Settings of the CPU solver in Landscape units: centimeters, CellSize is the quad size of the Landscape.
+	FHydraulicErosionSettings MakeSolverSettings(float CellSize) const;
+
 	UPROPERTY(VisibleInstanceOnly, Category = "Simulation", meta = (DisplayPriority = 1))
 	int32 Iterations = 0;
 
@@ -133,6 +141,13 @@ public:
 	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (DisplayPriority = 1))
 	int32 ButtonPressIterations = 1;
 
+	// How many iterations to perform when pressing the 'Perform Iterations On CPU' button. In FreeParticles mode every iteration runs CPUDroplets droplets.
+	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (DisplayPriority = 1))
+	int32 CPUIterations = 512;
+
+	UPROPERTY(EditInstanceOnly, Category = "Simulation", meta = (DisplayPriority = 1))
+	int32 CPUDroplets = 70000;
+
 	// Generation
 
 	UPROPERTY(EditInstanceOnly, Category = "Generation", meta = (DisplayPriority = 2))
@@ -0,0 +1,420 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "HydraulicErosionSolver.h"
+
+#include "Async/ParallelFor.h"
+#include "Misc/App.h"
+
+namespace HydraulicErosionSolverLocal
+{
+	// Keeps some capacity on flat ground, otherwise slow water there never dissolves anything
+	constexpr float MinTilt = 0.01f;
+
+	struct FDropletSample
+	{
+		float Height;
+		FVector2D Gradient;
+	};
+
+	// Bilinear height and gradient of the cell, the node to the right and below must exist
+	FORCEINLINE FDropletSample SampleDroplet(const float* Nodes, int32 Width, const FVector2D& Position)
+	{
+		const int32 X = FMath::TruncToInt(Position.X);
+		const int32 Y = FMath::TruncToInt(Position.Y);
+		const float U = Position.X - X;
+		const float V = Position.Y - Y;
+
+		const float* NW = Nodes + Y * Width + X;
+		const float HeightNW = NW[0];
+		const float HeightNE = NW[1];
+		const float HeightSW = NW[Width];
+		const float HeightSE = NW[Width + 1];
+
+		FDropletSample Sample;
+		Sample.Height =
+			HeightNW * (1 - U) * (1 - V) + HeightNE * U * (1 - V) + HeightSW * (1 - U) * V + HeightSE * U * V;
+		Sample.Gradient.X = (HeightNE - HeightNW) * (1 - V) + (HeightSE - HeightSW) * V;
+		Sample.Gradient.Y = (HeightSW - HeightNW) * (1 - U) + (HeightSE - HeightNE) * U;
+		return Sample;
+	}
+
+	FORCEINLINE float SampleBilinear(const TArray<float>& Data, FIntPoint Size, float X, float Y)
+	{
+		X = FMath::Clamp(X, 0.f, Size.X - 1.f);
+		Y = FMath::Clamp(Y, 0.f, Size.Y - 1.f);
+		const int32 X0 = FMath::Min(FMath::TruncToInt(X), Size.X - 2);
+		const int32 Y0 = FMath::Min(FMath::TruncToInt(Y), Size.Y - 2);
+		const float U = X - X0;
+		const float V = Y - Y0;
+
+		const float* Row = Data.GetData() + Y0 * Size.X + X0;
+		const float Top = FMath::Lerp(Row[0], Row[1], U);
+		const float Bottom = FMath::Lerp(Row[Size.X], Row[Size.X + 1], U);
+		return FMath::Lerp(Top, Bottom, V);
+	}
+}
+
+FHydraulicErosionSolver::FHydraulicErosionSolver(
+	FConstHeightmapView InHeight,
+	const FHydraulicErosionSettings& InSettings)
+	: Settings { InSettings }
+	, Size { InHeight.Size }
+{
+	check(Size.X >= 2 && Size.Y >= 2);
+
+	Height = TArray<float>(InHeight.Data, InHeight.Num());
+	Sediment.SetNumZeroed(Height.Num());
+	Flow.SetNumZeroed(Height.Num());
+
+	if (Settings.Mode == EHydraulicErosionSolverMode::VirtualPipes)
+	{
+		Water.SetNumZeroed(Height.Num());
+		Flux.SetNumZeroed(Height.Num());
+		Scratch.SetNumUninitialized(Height.Num());
+		ResetWater();
+		return;
+	}
+
+	// The brush of a droplet must not reach the tiles running in the same phase
+	const int32 Radius = FMath::Clamp(Settings.ErosionRadius, 0, FHeightmapKernels::TileSize / 2 - 1);
+	if (Radius == 0)
+	{
+		BrushOffsets.Add(FIntPoint::ZeroValue);
+		BrushWeights.Add(1.f);
+		return;
+	}
+
+	float WeightSum = 0.f;
+	for (int32 Y = -Radius; Y <= Radius; Y++)
+	{
+		for (int32 X = -Radius; X <= Radius; X++)
+		{
+			const float SqrDst = X * X + Y * Y;
+			if (SqrDst < Radius * Radius)
+			{
+				const float Weight = 1.f - FMath::Sqrt(SqrDst) / Radius;
+				BrushOffsets.Emplace(X, Y);
+				BrushWeights.Add(Weight);
+				WeightSum += Weight;
+			}
+		}
+	}
+
+	for (float& Weight : BrushWeights)
+	{
+		Weight /= WeightSum;
+	}
+}
+
+void FHydraulicErosionSolver::Run(int32 Iterations, const FHeightmapKernelProgress& Progress)
+{
+	for (int32 Iter = 0; Iter < Iterations; Iter++)
+	{
+		if (Settings.Mode == EHydraulicErosionSolverMode::VirtualPipes)
+			StepPipes();
+		else
+			StepDroplets();
+
+		Iteration++;
+
+		if (Progress)
+			Progress(Iter + 1, Iterations);
+	}
+}
+
+void FHydraulicErosionSolver::ResetWater()
+{
+	for (int32 Index = 0; Index < Water.Num(); Index++)
+	{
+		Water[Index] =
+			Settings.bWaterIsLevel ? FMath::Max(Settings.StartWater - Height[Index], 0.f) : Settings.StartWater;
+	}
+
+	FMemory::Memzero(Flux.GetData(), Flux.Num() * sizeof(FVector4));
+	FMemory::Memzero(Flow.GetData(), Flow.Num() * sizeof(FVector2D));
+}
+
+void FHydraulicErosionSolver::StepPipes()
+{
+	using namespace HydraulicErosionSolverLocal;
+
+	if (Settings.ResetEveryNIterations > 0 && Iteration > 0 && Iteration % Settings.ResetEveryNIterations == 0)
+	{
+		// The suspended sediment falls back before the water restarts
+		for (int32 Index = 0; Index < Height.Num(); Index++)
+		{
+			Height[Index] += Sediment[Index];
+			Sediment[Index] = 0.f;
+		}
+		ResetWater();
+	}
+
+	const int32 Width = Size.X;
+	const float DeltaT = Settings.DeltaT;
+	const float CellSize = Settings.CellSize;
+	const float CellArea = CellSize * CellSize;
+	const float Rain = DeltaT * Settings.RainAmount;
+	const float Damping = FMath::Exp(-Settings.VelocityDamping * DeltaT);
+	// Pipes have a cross section of CellArea and a length of CellSize
+	const float FluxPerHeight = DeltaT * Settings.Gravity * CellSize;
+
+	// Outflow from the water surface differences, rain is uniform so it only adds to the volume that can leave
+	FHeightmapKernels::ForEachTile(
+		Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32 X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const int32 Index = Y * Width + X;
+					const float Surface = Height[Index] + Water[Index];
+					auto Outflow = [&](float Previous, int32 Neighbour)
+					{
+						const float Difference = Surface - Height[Neighbour] - Water[Neighbour];
+						return FMath::Max(0.f, Previous * Damping + FluxPerHeight * Difference);
+					};
+
+					FVector4& Out = Flux[Index];
+					Out.X = X > 0 ? Outflow(Out.X, Index - 1) : 0.f;
+					Out.Y = X < Size.X - 1 ? Outflow(Out.Y, Index + 1) : 0.f;
+					Out.Z = Y > 0 ? Outflow(Out.Z, Index - Width) : 0.f;
+					Out.W = Y < Size.Y - 1 ? Outflow(Out.W, Index + Width) : 0.f;
+
+					// A cell can't give more water than it holds
+					const float Total = (Out.X + Out.Y + Out.Z + Out.W) * DeltaT;
+					const float Volume = (Water[Index] + Rain) * CellArea;
+					if (Total > Volume)
+						Out = Out * (Volume / Total);
+				}
+			}
+		});
+
+	// Water depth and velocity from the flow through the cell
+	FHeightmapKernels::ForEachTile(
+		Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32 X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const int32 Index = Y * Width + X;
+					const FVector4& Out = Flux[Index];
+					const float FromLeft = X > 0 ? Flux[Index - 1].Y : 0.f;
+					const float FromRight = X < Size.X - 1 ? Flux[Index + 1].X : 0.f;
+					const float FromTop = Y > 0 ? Flux[Index - Width].W : 0.f;
+					const float FromBottom = Y < Size.Y - 1 ? Flux[Index + Width].Z : 0.f;
+
+					const float Depth = Water[Index] + Rain;
+					const float Inflow = FromLeft + FromRight + FromTop + FromBottom;
+					const float Outflow = Out.X + Out.Y + Out.Z + Out.W;
+					const float NewDepth = FMath::Max(0.f, Depth + DeltaT * (Inflow - Outflow) / CellArea);
+					const float MeanDepth = 0.5f * (Depth + NewDepth);
+
+					Water[Index] = NewDepth;
+					Flow[Index] = MeanDepth > KINDA_SMALL_NUMBER
+						? FVector2D(FromLeft - Out.X + Out.Y - FromRight, FromTop - Out.Z + Out.W - FromBottom)
+							* (0.5f / (CellSize * MeanDepth))
+						: FVector2D::ZeroVector;
+				}
+			}
+		});
+
+	// Dissolve up to the capacity of the flow, deposit above it
+	FHeightmapKernels::ForEachTile(
+		Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const float* Row = Height.GetData() + Y * Width;
+				const float* Top = Height.GetData() + FMath::Max(Y - 1, 0) * Width;
+				const float* Bottom = Height.GetData() + FMath::Min(Y + 1, Size.Y - 1) * Width;
+
+				for (int32 X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const int32 Index = Y * Width + X;
+					const FVector2D Gradient(
+						(Row[FMath::Min(X + 1, Size.X - 1)] - Row[FMath::Max(X - 1, 0)]) / (2.f * CellSize),
+						(Bottom[X] - Top[X]) / (2.f * CellSize));
+					const float TangentSquared = Gradient.SizeSquared();
+					const float Tilt = FMath::Max(FMath::Sqrt(TangentSquared / (1.f + TangentSquared)), MinTilt);
+
+					const float Capacity = Settings.Solubility * Tilt * Flow[Index].Size();
+					const float Suspended = Sediment[Index];
+					const float Rate = Capacity > Suspended ? Settings.DissolveRate : Settings.DepositRate;
+					const float Dissolved = Rate * (Capacity - Suspended);
+
+					Scratch[Index] = Row[X] - Dissolved;
+					Sediment[Index] = Suspended + Dissolved;
+				}
+			}
+		});
+	Swap(Height, Scratch);
+
+	// Sediment moves with the water, traced back along the velocity
+	FHeightmapKernels::ForEachTile(
+		Size,
+		[&](const FIntRect& Tile)
+		{
+			for (int32 Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32 X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const int32 Index = Y * Width + X;
+					const FVector2D Back = Flow[Index] * (DeltaT / CellSize);
+					Scratch[Index] = SampleBilinear(Sediment, Size, X - Back.X, Y - Back.Y);
+					Water[Index] = FMath::Max(0.f, Water[Index] - Settings.Evaporation);
+				}
+			}
+		});
+	Swap(Sediment, Scratch);
+}
+
+void FHydraulicErosionSolver::StepDroplets()
+{
+	constexpr int32 TileSize = FHeightmapKernels::TileSize;
+	const uint32 IterationSeed = HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Iteration));
+
+	// The tile grid is shifted every iteration, so droplets stopping at tile edges don't line up
+	FRandomStream Random((int32)IterationSeed);
+	const FIntPoint Offset { Random.RandHelper(TileSize), Random.RandHelper(TileSize) };
+	const FIntPoint NumTiles { FMath::DivideAndRoundUp(Size.X + Offset.X, TileSize),
+							   FMath::DivideAndRoundUp(Size.Y + Offset.Y, TileSize) };
+	const double DropletsPerCell = double(Settings.NumDroplets) / (double(Size.X) * Size.Y);
+
+	// Tiles of the same phase are a whole tile apart, so their droplets never touch the same nodes
+	for (int32 Phase = 0; Phase < 4; Phase++)
+	{
+		const FIntPoint Parity { Phase % 2, Phase / 2 };
+		const FIntPoint NumPhaseTiles { (NumTiles.X - Parity.X + 1) / 2, (NumTiles.Y - Parity.Y + 1) / 2 };
+
+		ParallelFor(
+			NumPhaseTiles.X * NumPhaseTiles.Y,
+			[&](int32 PhaseTile)
+			{
+				const FIntPoint Coord { PhaseTile % NumPhaseTiles.X * 2 + Parity.X,
+										PhaseTile / NumPhaseTiles.X * 2 + Parity.Y };
+				const FIntPoint Min = Coord * TileSize - Offset;
+				const FIntRect Tile(
+					Min.ComponentMax(FIntPoint::ZeroValue),
+					(Min + FIntPoint(TileSize, TileSize)).ComponentMin(Size));
+
+				// Droplets in proportion to the area, the fraction is rounded by the seeded stream of the tile
+				const uint32 TileSeed = HashCombine(IterationSeed, GetTypeHash(Coord.Y * NumTiles.X + Coord.X));
+				FRandomStream TileRandom((int32)TileSeed);
+				const double Expected = DropletsPerCell * Tile.Area();
+				const int32 NumTileDroplets =
+					FMath::FloorToInt(Expected) + (TileRandom.FRand() < FMath::Frac(Expected) ? 1 : 0);
+
+				RunDroplets(Tile, NumTileDroplets, (int32)TileRandom.GetUnsignedInt());
+			},
+			!FApp::ShouldUseThreadingForPerformance());
+	}
+}
+
+void FHydraulicErosionSolver::RunDroplets(const FIntRect& Tile, int32 NumTileDroplets, int32 TileSeed)
+{
+	using namespace HydraulicErosionSolverLocal;
+
+	// Interpolation reads the next node, so positions stay off the last row and column
+	const FVector2D Min(Tile.Min);
+	const FVector2D Max(FMath::Min(Tile.Max.X, Size.X - 1), FMath::Min(Tile.Max.Y, Size.Y - 1));
+	if (Max.X <= Min.X || Max.Y <= Min.Y)
+		return;
+
+	auto IsInside = [&](const FVector2D& Position)
+	{ return Position.X >= Min.X && Position.X < Max.X && Position.Y >= Min.Y && Position.Y < Max.Y; };
+
+	const int32 Width = Size.X;
+	float* Nodes = Height.GetData();
+	FRandomStream Random(TileSeed);
+
+	for (int32 Droplet = 0; Droplet < NumTileDroplets; Droplet++)
+	{
+		FVector2D Position(FMath::Lerp(Min.X, Max.X, Random.FRand()), FMath::Lerp(Min.Y, Max.Y, Random.FRand()));
+		FVector2D Direction = FVector2D::ZeroVector;
+		float Speed = Settings.InitialSpeed;
+		float Water = Settings.InitialWaterVolume;
+		float Carried = 0.f;
+
+		for (int32 Lifetime = 0; Lifetime < Settings.MaxDropletLifetime && IsInside(Position); Lifetime++)
+		{
+			const FIntPoint Node(FMath::TruncToInt(Position.X), FMath::TruncToInt(Position.Y));
+			const int32 NodeIndex = Node.Y * Width + Node.X;
+			const FVector2D CellOffset = Position - FVector2D(Node);
+			const FDropletSample Sample = SampleDroplet(Nodes, Width, Position);
+
+			// Move one cell regardless of the speed
+			Direction = Direction * Settings.Inertia - Sample.Gradient * (1.f - Settings.Inertia);
+			const float Length = Direction.Size();
+			if (Length == 0.f)
+				break;
+
+			Direction /= Length;
+			Position += Direction;
+			if (!IsInside(Position))
+				break;
+
+			const float DeltaHeight = SampleDroplet(Nodes, Width, Position).Height - Sample.Height;
+			Flow[NodeIndex] += Direction * Speed;
+
+			const float Capacity = FMath::Max(
+				-DeltaHeight * Speed * Water * Settings.SedimentCapacityFactor,
+				Settings.MinSedimentCapacity);
+
+			if (Carried > Capacity || DeltaHeight > 0)
+			{
+				// Uphill fills the pit up to the current height, otherwise a fraction of the excess is deposited
+				const float Deposit =
+					DeltaHeight > 0 ? FMath::Min(DeltaHeight, Carried) : (Carried - Capacity) * Settings.DepositSpeed;
+				Carried -= Deposit;
+
+				const int32 Indices[4] = { NodeIndex, NodeIndex + 1, NodeIndex + Width, NodeIndex + Width + 1 };
+				const float Weights[4] = { (1 - CellOffset.X) * (1 - CellOffset.Y),
+										   CellOffset.X * (1 - CellOffset.Y),
+										   (1 - CellOffset.X) * CellOffset.Y,
+										   CellOffset.X * CellOffset.Y };
+				for (int32 Corner = 0; Corner < 4; Corner++)
+				{
+					Nodes[Indices[Corner]] += Deposit * Weights[Corner];
+					Sediment[Indices[Corner]] += Deposit * Weights[Corner];
+				}
+			}
+			else
+			{
+				// Limited by the height difference so the droplet doesn't dig a hole behind itself
+				const float Erode = FMath::Min((Capacity - Carried) * Settings.ErodeSpeed, -DeltaHeight);
+				for (int32 Brush = 0; Brush < BrushOffsets.Num(); Brush++)
+				{
+					const FIntPoint Point = Node + BrushOffsets[Brush];
+					if (Point.X >= 0 && Point.X < Size.X && Point.Y >= 0 && Point.Y < Size.Y)
+					{
+						const float Amount = Erode * BrushWeights[Brush];
+						Nodes[Point.Y * Width + Point.X] -= Amount;
+						Carried += Amount;
+					}
+				}
+			}
+
+			// Gains speed going down
+			Speed = FMath::Sqrt(FMath::Max(0.f, Speed * Speed - DeltaHeight * Settings.DropletGravity));
+			Water *= 1.f - Settings.EvaporateSpeed;
+		}
+	}
+}
@@ -17,10 +17,248 @@
 
 #include "SignedDistanceField2D.h"
 
+#include "Async/ParallelFor.h"
 #include "Misc/ScopedSlowTask.h"
 
+namespace SignedDistanceField2DLocal
+{
+	constexpr float InfDistance = 1e20f;
+	// columns gathered at once in the column pass to read rows contiguously
+	constexpr int32 ColumnsBlock = 16;
+
+	struct FLineScratch
+	{
+		explicit FLineScratch(int32 Num)
+		{
+			F.SetNumUninitialized(Num);
+			V.SetNumUninitialized(Num);
+			Z.SetNumUninitialized(Num + 1);
+		}
+
+		TArray<float> F;
+		TArray<int32> V;
+		TArray<double> Z;
+	};
+
+	// Lower envelope of parabolas rooted at the finite samples, in place
+	void DistanceTransform1D(float* Line, int32 Num, FLineScratch& Scratch)
+	{
+		float* F = Scratch.F.GetData();
+		int32* V = Scratch.V.GetData();
+		double* Z = Scratch.Z.GetData();
+		FMemory::Memcpy(F, Line, Num * sizeof(float));
+
+		int32 K = -1;
+		for (int32 Q = 0; Q < Num; Q++)
+		{
+			if (F[Q] >= InfDistance)
+				continue;
+
+			double S = -TNumericLimits<double>::Max();
+			while (K >= 0)
+			{
+				const int32 P = V[K];
+				S = ((F[Q] + static_cast<double>(Q) * Q) - (F[P] + static_cast<double>(P) * P)) / (2.0 * (Q - P));
+				if (S > Z[K])
+					break;
+				S = -TNumericLimits<double>::Max();
+				K--;
+			}
+
+			K++;
+			V[K] = Q;
+			Z[K] = S;
+		}
+
+		if (K < 0)
+		{
+			for (int32 Q = 0; Q < Num; Q++)
+				Line[Q] = InfDistance;
+			return;
+		}
+
+		Z[K + 1] = TNumericLimits<double>::Max();
+		int32 J = 0;
+		for (int32 Q = 0; Q < Num; Q++)
+		{
+			while (Z[J + 1] < Q)
+				J++;
+			const double Offset = Q - V[J];
+			Line[Q] = static_cast<float>(Offset * Offset + F[V[J]]);
+		}
+	}
+
+	int32 GetNumChunks(int32 NumItems)
+	{
+		return FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() * 4, 1, FMath::Max(NumItems, 1));
+	}
+
+	float ToSignedDistance(float SquaredDistanceBelow, float SquaredDistanceAbove)
+	{
+		// one of them is zero, pixel belongs to its own set
+		return FMath::Sqrt(SquaredDistanceBelow) - FMath::Sqrt(SquaredDistanceAbove);
+	}
+}
+
+void FSignedDistanceField2D::ComputeSquaredDistances(
+	const TArray<uint8>& Mask,
+	int32 InWidth,
+	int32 InHeight,
+	bool bFeatureBelow,
+	TArray<float>& OutSquaredDistances)
+{
+	using namespace SignedDistanceField2DLocal;
+	check(Mask.Num() == InWidth * InHeight);
+
+	OutSquaredDistances.SetNumUninitialized(InWidth * InHeight);
+	float* Distances = OutSquaredDistances.GetData();
+
+	// rows are contiguous in the flat buffer
+	const int32 NumRowChunks = GetNumChunks(InHeight);
+	ParallelFor(
+		NumRowChunks,
+		[&Mask, Distances, InWidth, InHeight, bFeatureBelow, NumRowChunks](int32 Chunk)
+		{
+			FLineScratch Scratch(InWidth);
+			const int32 RowBegin = static_cast<int64>(InHeight) * Chunk / NumRowChunks;
+			const int32 RowEnd = static_cast<int64>(InHeight) * (Chunk + 1) / NumRowChunks;
+			for (int32 Y = RowBegin; Y < RowEnd; Y++)
+			{
+				float* Row = Distances + static_cast<int64>(Y) * InWidth;
+				const uint8* MaskRow = Mask.GetData() + static_cast<int64>(Y) * InWidth;
+				for (int32 X = 0; X < InWidth; X++)
+					Row[X] = (MaskRow[X] < 128) == bFeatureBelow ? 0.f : InfDistance;
+				DistanceTransform1D(Row, InWidth, Scratch);
+			}
+		});
+
+	// columns are gathered by blocks to keep the reads contiguous
+	const int32 NumColumnBlocks = FMath::DivideAndRoundUp(InWidth, ColumnsBlock);
+	ParallelFor(
+		NumColumnBlocks,
+		[Distances, InWidth, InHeight](int32 Block)
+		{
+			FLineScratch Scratch(InHeight);
+			TArray<float> Columns;
+			Columns.SetNumUninitialized(ColumnsBlock * InHeight);
+
+			const int32 ColumnBegin = Block * ColumnsBlock;
+			const int32 NumColumns = FMath::Min(ColumnsBlock, InWidth - ColumnBegin);
+			for (int32 Y = 0; Y < InHeight; Y++)
+			{
+				const float* Row = Distances + static_cast<int64>(Y) * InWidth + ColumnBegin;
+				for (int32 Column = 0; Column < NumColumns; Column++)
+					Columns[Column * InHeight + Y] = Row[Column];
+			}
+
+			for (int32 Column = 0; Column < NumColumns; Column++)
+				DistanceTransform1D(Columns.GetData() + Column * InHeight, InHeight, Scratch);
+
+			for (int32 Y = 0; Y < InHeight; Y++)
+			{
+				float* Row = Distances + static_cast<int64>(Y) * InWidth + ColumnBegin;
+				for (int32 Column = 0; Column < NumColumns; Column++)
+					Row[Column] = Columns[Column * InHeight + Y];
+			}
+		});
+}
+
+TArray<float> FSignedDistanceField2D::GenerateFloat(const TArray<uint8>& InData) const
+{
+	TArray<float> DistancesBelow;
+	TArray<float> DistancesAbove;
+	ComputeSquaredDistances(InData, Width, Height, true, DistancesBelow);
+	ComputeSquaredDistances(InData, Width, Height, false, DistancesAbove);
+
+	TArray<float> OutData;
+	OutData.SetNumUninitialized(Width * Height);
+	ParallelFor(
+		Height,
+		[this, &OutData, &DistancesBelow, &DistancesAbove](int32 Y)
+		{
+			const int32 RowStart = Y * Width;
+			for (int32 Index = RowStart; Index < RowStart + Width; Index++)
+			{
+				OutData[Index] =
+					SignedDistanceField2DLocal::ToSignedDistance(DistancesBelow[Index], DistancesAbove[Index]);
+			}
+		});
+
+	return OutData;
+}
 
 TArray<uint8> FSignedDistanceField2D::Generate(TArray<uint8>& InData)
+{
+	const TArray<float> Distances = GenerateFloat(InData);
+
+	// farther distances saturate anyway, uniform masks give +-1e10 which doesn't fit in int32
+	const float MaxEncodedDistance = 128 / FMath::Max(Scale, 1) + 1;
+
+	TArray<uint8> OutData;
+	OutData.SetNumUninitialized(Width * Height);
+	for (int32 Index = 0; Index < OutData.Num(); Index++)
+	{
+		// truncation and scale match GenerateSSEDT
+		const float Distance = FMath::Clamp(Distances[Index], -MaxEncodedDistance, MaxEncodedDistance);
+		const int32 C = FMath::TruncToInt(Distance) * Scale + 128;
+		OutData[Index] = FMath::Clamp(C, 0, 255);
+	}
+
+	return OutData;
+}
+
+void FSignedDistanceField2D::GenerateTiled(
+	int32 TileSize,
+	int32 MaxDistance,
+	TFunctionRef<void(const FIntRect& Rect, TArray<uint8>& OutMask)> ReadMask,
+	TFunctionRef<void(const FIntRect& Rect, const TArray<float>& Distances)> WriteDistances) const
+{
+	check(TileSize > 0 && MaxDistance >= 0);
+
+	const FIntRect Raster { 0, 0, Width, Height };
+	const float MaxDistanceFloat = MaxDistance;
+	// nearest pixel of the other set is either within the apron or farther than MaxDistance
+	const int32 Apron = MaxDistance + 1;
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Width, TileSize);
+	const int32 NumTilesY = FMath::DivideAndRoundUp(Height, TileSize);
+
+	FScopedSlowTask SlowTask(NumTilesX * NumTilesY, FText::FromString(TEXT("Generating distance field tiles")));
+	TArray<uint8> Mask;
+	TArray<float> TileDistances;
+	for (int32 TileY = 0; TileY < NumTilesY; TileY++)
+	{
+		for (int32 TileX = 0; TileX < NumTilesX; TileX++)
+		{
+			SlowTask.EnterProgressFrame();
+
+			FIntRect Tile { TileX * TileSize, TileY * TileSize, (TileX + 1) * TileSize, (TileY + 1) * TileSize };
+			Tile.Clip(Raster);
+			FIntRect Expanded = Tile;
+			Expanded.InflateRect(Apron);
+			Expanded.Clip(Raster);
+
+			ReadMask(Expanded, Mask);
+			const FIntPoint ExpandedSize = Expanded.Size();
+			const TArray<float> Distances =
+				FSignedDistanceField2D { Scale, ExpandedSize.X, ExpandedSize.Y }.GenerateFloat(Mask);
+
+			const FIntPoint TileSizeXY = Tile.Size();
+			TileDistances.SetNumUninitialized(TileSizeXY.X * TileSizeXY.Y);
+			for (int32 Y = 0; Y < TileSizeXY.Y; Y++)
+			{
+				const int32 SourceRow = (Tile.Min.Y - Expanded.Min.Y + Y) * ExpandedSize.X + Tile.Min.X - Expanded.Min.X;
+				for (int32 X = 0; X < TileSizeXY.X; X++)
+				{
+					TileDistances[Y * TileSizeXY.X + X] =
+						FMath::Clamp(Distances[SourceRow + X], -MaxDistanceFloat, MaxDistanceFloat);
+				}
+			}
+			WriteDistances(Tile, TileDistances);
+		}
+	}
+}
+
+TArray<uint8> FSignedDistanceField2D::GenerateSSEDT(TArray<uint8>& InData)
 {
 	FTGGrid Grid1;
 	Grid1.SetNum(Width);
@@ -21,7 +21,9 @@
 #include "MaterialBakingStructures.h"
 #include "StaticMeshAttributes.h"
 
+#include "Async/ParallelFor.h"
 #include "CanvasItem.h"
+#include "Containers/Ticker.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "Landscape.h"
@@ -32,6 +34,7 @@
 #include "LandscapeStreamingProxy.h"
 #include "Logging/MessageLog.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "RenderCommandFence.h"
 #include "Rendering/Texture2DResource.h"
 #include "ScopedTransaction.h"
 #include "TerrainGeneratorUtils.h"
@@ -39,6 +42,72 @@
 
 #define LOCTEXT_NAMESPACE "UTerrainGeneratorHelper"
 
+namespace TerrainGeneratorHelperLocal
+{
+	bool IsLDRFormat(ETextureRenderTargetFormat Format)
+	{
+		return Format == RTF_RGBA8 || Format == RTF_R8 || Format == RTF_RG8;
+	}
+
+	bool IsHDRFormat(ETextureRenderTargetFormat Format)
+	{
+		return Format == RTF_R16f || Format == RTF_RG16f || Format == RTF_RGBA16f || Format == RTF_R32f
+			|| Format == RTF_RG32f || Format == RTF_RGBA32f;
+	}
+
+	// Warns and returns false if the render target can't be sampled, otherwise clamps InRect to it
+	bool GetSampleRect(UTextureRenderTarget2D* InRenderTarget, FLinearColor InRect, FIntRect& OutRect)
+	{
+		if (!InRenderTarget)
+		{
+			FMessageLog("TerrainGeneratorHelper")
+				.Warning(LOCTEXT("UTerrainGeneratorHelper", "SampleRTData: Render Target must be non-null."));
+			return false;
+		}
+		if (!InRenderTarget->Resource)
+		{
+			FMessageLog("TerrainGeneratorHelper")
+				.Warning(LOCTEXT("UTerrainGeneratorHelper", "SampleRTData: Render Target has been released."));
+			return false;
+		}
+
+		const ETextureRenderTargetFormat Format = InRenderTarget->RenderTargetFormat;
+		if (!IsLDRFormat(Format) && !IsHDRFormat(Format))
+		{
+			FMessageLog("TerrainGeneratorHelper")
+				.Warning(LOCTEXT(
+					"UTerrainGeneratorHelper",
+					"SampleRTData: Currently only 4 channel formats are supported: RTF_RGBA8, RTF_RGBA16f, and "
+					"RTF_RGBA32f."));
+			return false;
+		}
+
+		InRect.R = FMath::Clamp(int(InRect.R), 0, InRenderTarget->SizeX - 1);
+		InRect.G = FMath::Clamp(int(InRect.G), 0, InRenderTarget->SizeY - 1);
+		InRect.B = FMath::Clamp(int(InRect.B), int(InRect.R + 1), InRenderTarget->SizeX);
+		InRect.A = FMath::Clamp(int(InRect.A), int(InRect.G + 1), InRenderTarget->SizeY);
+		OutRect = FIntRect(InRect.R, InRect.G, InRect.B, InRect.A);
+		return true;
+	}
+
+	void ToLinearColors(const TArray<FColor>& InLDR, TArray<FLinearColor>& OutResult)
+	{
+		OutResult.SetNumUninitialized(InLDR.Num());
+		for (int32 i = 0; i < InLDR.Num(); i++)
+		{
+			OutResult[i] =
+				(FLinearColor(float(InLDR[i].R), float(InLDR[i].G), float(InLDR[i].B), float(InLDR[i].A)) / 255.0f);
+		}
+	}
+
+	// Pixels are written by the render thread and handed to the game thread after the fence
+	struct FReadback
+	{
+		TArray<FLinearColor> Pixels;
+		FRenderCommandFence Fence;
+	};
+}
+
 bool UTerrainGeneratorHelper::TerrainExportHeightmapToRenderTarget(
 	ALandscape* InLandscape,
 	UTextureRenderTarget2D* InRenderTarget,
@@ -606,6 +675,98 @@ void UTerrainGeneratorHelper::TerrainImportWeightmapFromRenderTargetToEditingLay
 	InLandscapeProxy->GetLandscapeActor()->SetEditingLayer();
 }
 
+bool UTerrainGeneratorHelper::TerrainImportWeightmaps(
+	ALandscape* InLandscape,
+	const TMap<FName, TArray<uint8>>& InWeights,
+	FIntPoint InSize,
+	FName InEditingLayerName)
+{
+	if (!InLandscape)
+	{
+		FMessageLog("TerrainGeneratorHelper")
+			.Error(FText::FromString("ImportWeightmaps: Landscape must be non-null."));
+		return false;
+	}
+
+	ULandscapeInfo* LandscapeInfo = InLandscape->GetLandscapeInfo();
+	int32 MinX, MinY, MaxX, MaxY;
+	if (!LandscapeInfo || !LandscapeInfo->GetLandscapeExtent(MinX, MinY, MaxX, MaxY))
+		return false;
+
+	const int32 LandscapeWidth = 1 + MaxX - MinX;
+	const int32 LandscapeHeight = 1 + MaxY - MinY;
+	if (InSize.X < LandscapeWidth || InSize.Y < LandscapeHeight)
+	{
+		FMessageLog("TerrainGeneratorHelper")
+			.Error(FText::FromString(
+				"ImportWeightmaps: Weights must be at least as large as landscape on each axis."));
+		return false;
+	}
+
+	const bool bEditLayers = InLandscape->HasLayersContent();
+	if (bEditLayers)
+	{
+		const FLandscapeLayer* EditingLayer = InLandscape->LandscapeLayers.FindByPredicate(
+			[InEditingLayerName](const FLandscapeLayer& InLayer) { return InLayer.Name == InEditingLayerName; });
+		if (EditingLayer)
+		{
+			InLandscape->SetEditingLayer(EditingLayer->Guid);
+		}
+	}
+
+	FScopedTransaction Transaction(FText::FromString("Importing Landscape Layers"));
+
+	TArray<uint8> LayerData;
+	for (const TPair<FName, TArray<uint8>>& Iter : InWeights)
+	{
+		ULandscapeLayerInfoObject* LayerInfoObject = nullptr;
+		if (bEditLayers)
+		{
+			const FLandscapeEditorLayerSettings* EditorLayerSettings = InLandscape->EditorLayerSettings.FindByPredicate(
+				[&Iter](const FLandscapeEditorLayerSettings& InEditorLayerSettings)
+				{
+					return InEditorLayerSettings.LayerInfoObj
+						&& InEditorLayerSettings.LayerInfoObj->LayerName == Iter.Key;
+				});
+			LayerInfoObject = EditorLayerSettings ? EditorLayerSettings->LayerInfoObj : nullptr;
+		}
+		else
+		{
+			const int32 Index = LandscapeInfo->GetLayerInfoIndex(Iter.Key);
+			LayerInfoObject = Index != INDEX_NONE ? LandscapeInfo->Layers[Index].LayerInfoObj : nullptr;
+		}
+
+		if (!IsValid(LayerInfoObject) || Iter.Value.Num() != InSize.X * InSize.Y)
+		{
+			FMessageLog("TerrainGeneratorHelper")
+				.Warning(FText::FromString(
+					FString::Printf(TEXT("ImportWeightmaps: Layer %s is skipped."), *Iter.Key.ToString())));
+			continue;
+		}
+
+		const uint8* Data = Iter.Value.GetData();
+		if (InSize.X != LandscapeWidth || InSize.Y != LandscapeHeight)
+		{
+			LayerData.SetNumUninitialized(LandscapeWidth * LandscapeHeight);
+			for (int32 Row = 0; Row < LandscapeHeight; Row++)
+			{
+				FMemory::Memcpy(&LayerData[Row * LandscapeWidth], Data + Row * InSize.X, LandscapeWidth);
+			}
+			Data = LayerData.GetData();
+		}
+
+		FAlphamapAccessor<false, false> AlphamapAccessor(LandscapeInfo, LayerInfoObject);
+		AlphamapAccessor.SetData(MinX, MinY, MaxX, MaxY, Data, ELandscapeLayerPaintingRestriction::None);
+	}
+
+	if (bEditLayers)
+	{
+		InLandscape->SetEditingLayer();
+	}
+
+	return true;
+}
+
 void UTerrainGeneratorHelper::ExportWeightLayer(ALandscape* InLandscape, FString Dir, FName InLayerName)
 {
 	ULandscapeInfo* LandscapeInfo = InLandscape->GetLandscapeInfo();
@@ -726,7 +887,12 @@ bool UTerrainGeneratorHelper::TerrainImportHeightmap(
 bool UTerrainGeneratorHelper::TerrainExportHeightmap(ALandscape* InLandscape, TArray<uint16>& OutHeightDada)
 {
 	int32 MinX, MinY, MaxX, MaxY;
-	FLandscapeEditDataInterface LandscapeEdit(InLandscape->GetLandscapeInfo());
+	ULandscapeInfo* LandscapeInfo = InLandscape->GetLandscapeInfo();
+	if (!LandscapeInfo || !LandscapeInfo->GetLandscapeExtent(MinX, MinY, MaxX, MaxY))
+		return false;
+
+	OutHeightDada.SetNumZeroed((1 + MaxX - MinX) * (1 + MaxY - MinY));
+	FLandscapeEditDataInterface LandscapeEdit(LandscapeInfo);
 	LandscapeEdit.GetHeightData(MinX, MinY, MaxX, MaxY, OutHeightDada.GetData(), 0);
 
 	return true;
@@ -825,56 +991,62 @@ void UTerrainGeneratorHelper::UpdateDynamicVectorTexture(const TArray<FLinearCol
 }
 
 
-TArray<FColor> UTerrainGeneratorHelper::DownsampleTextureData(TArray<FColor>& Data, int32 Width, int32 Kernel)
+FIntPoint UTerrainGeneratorHelper::GetDownsampledSize(FIntPoint InSize, int32 InKernel)
 {
-	TArray<FColor> Downsampled;
-	Downsampled.Init(FColor(), Data.Num() / (Kernel * Kernel));
-
-	int32 Row = 0;
-	for (int32 i = 0; i < Downsampled.Num(); i++)
-	{
-		TArray<FColor> KernelColors;
-		KernelColors.Init(FColor(0, 0, 0, 255), Kernel * Kernel);
-
-		int32 KernelIndex = i * Kernel;
-		if (KernelIndex % Width == 0 && i != 0)
-		{
-			Row++;
-		}
-
-		KernelIndex += Row * Width * (Kernel - 1);
+	return InKernel > 0 ? InSize / InKernel : FIntPoint::ZeroValue;
+}
 
-		for (int32 k = 0; k < Kernel; ++k)
+void UTerrainGeneratorHelper::DownsampleTextureData(
+	TArrayView<const FColor> InData,
+	FIntPoint InSize,
+	int32 InKernel,
+	TArrayView<FColor> OutData)
+{
+	const FIntPoint OutSize = GetDownsampledSize(InSize, InKernel);
+	check(InData.Num() == InSize.X * InSize.Y);
+	check(OutData.Num() == OutSize.X * OutSize.Y);
+
+	const uint32 Count = InKernel * InKernel;
+	ParallelFor(
+		OutSize.Y,
+		[&](int32 Y)
 		{
-			for (int32 kr = 0; kr < Kernel; ++kr)
+			for (int32 X = 0; X < OutSize.X; X++)
 			{
-				int32 c = KernelIndex + k + (Width * kr);
-				if (c > 0 && c < Data.Num())
+				uint32 R = 0;
+				uint32 G = 0;
+				uint32 B = 0;
+				uint32 A = 0;
+				for (int32 KernelY = 0; KernelY < InKernel; KernelY++)
 				{
-					KernelColors[k * Kernel + kr] = Data[c];
+					const FColor* Row = &InData[(Y * InKernel + KernelY) * InSize.X + X * InKernel];
+					for (int32 KernelX = 0; KernelX < InKernel; KernelX++)
+					{
+						R += Row[KernelX].R;
+						G += Row[KernelX].G;
+						B += Row[KernelX].B;
+						A += Row[KernelX].A;
+					}
 				}
+
+				// Rounded to nearest like the mip chain of the texture
+				FColor& Average = OutData[Y * OutSize.X + X];
+				Average.R = (uint8)((R + Count / 2) / Count);
+				Average.G = (uint8)((G + Count / 2) / Count);
+				Average.B = (uint8)((B + Count / 2) / Count);
+				Average.A = (uint8)((A + Count / 2) / Count);
 			}
-		}
+		});
+}
 
-		int32 AvR = 0;
-		int32 AvG = 0;
-		int32 AvB = 0;
-		int32 AvA = 0;
-		for (int32 j = 0; j < KernelColors.Num(); ++j)
-		{
-			AvR += KernelColors[j].R;
-			AvG += KernelColors[j].G;
-			AvB += KernelColors[j].B;
-			AvA += KernelColors[j].A;
-		}
+TArray<FColor> UTerrainGeneratorHelper::DownsampleTextureData(const TArray<FColor>& Data, int32 Width, int32 Kernel)
+{
+	const FIntPoint Size { Width, Width > 0 ? Data.Num() / Width : 0 };
+	const FIntPoint OutSize = GetDownsampledSize(Size, Kernel);
 
-		FColor KernelAvarage;
-		KernelAvarage.R = (uint8)(AvR / KernelColors.Num());
-		KernelAvarage.G = (uint8)(AvG / KernelColors.Num());
-		KernelAvarage.B = (uint8)(AvB / KernelColors.Num());
-		KernelAvarage.A = (uint8)(AvA / KernelColors.Num());
-		Downsampled[i] = KernelAvarage;
-	}
+	TArray<FColor> Downsampled;
+	Downsampled.SetNumUninitialized(OutSize.X * OutSize.Y);
+	DownsampleTextureData(MakeArrayView(Data.GetData(), Size.X * Size.Y), Size, Kernel, Downsampled);
 
 	return Downsampled;
 }
@@ -1000,58 +1172,78 @@ void UTerrainGeneratorHelper::GetLandscapeCenterAndExtent(
 
 TArray<FLinearColor> UTerrainGeneratorHelper::SampleRTData(UTextureRenderTarget2D* InRenderTarget, FLinearColor InRect)
 {
-	if (!InRenderTarget)
-	{
-		FMessageLog("TerrainGeneratorHelper")
-			.Warning(LOCTEXT("UTerrainGeneratorHelper", "SampleRTData: Render Target must be non-null."));
-		return { FLinearColor(0, 0, 0, 0) };
-	}
-	if (!InRenderTarget->Resource)
-	{
-		FMessageLog("TerrainGeneratorHelper")
-			.Warning(LOCTEXT("UTerrainGeneratorHelper", "SampleRTData: Render Target has been released."));
+	using namespace TerrainGeneratorHelperLocal;
+
+	FIntRect Rect;
+	if (!GetSampleRect(InRenderTarget, InRect, Rect))
 		return { FLinearColor(0, 0, 0, 0) };
-	}
 
 	FTextureRenderTargetResource* RTResource = InRenderTarget->GameThread_GetRenderTargetResource();
-
-	InRect.R = FMath::Clamp(int(InRect.R), 0, InRenderTarget->SizeX - 1);
-	InRect.G = FMath::Clamp(int(InRect.G), 0, InRenderTarget->SizeY - 1);
-	InRect.B = FMath::Clamp(int(InRect.B), int(InRect.R + 1), InRenderTarget->SizeX);
-	InRect.A = FMath::Clamp(int(InRect.A), int(InRect.G + 1), InRenderTarget->SizeY);
-	const FIntRect Rect = FIntRect(InRect.R, InRect.G, InRect.B, InRect.A);
 	FReadSurfaceDataFlags ReadPixelFlags(RCM_MinMax);
 
-	ETextureRenderTargetFormat Format = (InRenderTarget->RenderTargetFormat);
-
-	if ((Format == (RTF_RGBA8)) || (Format == RTF_R8) || (Format == RTF_RG8))
+	TArray<FLinearColor> OutResult;
+	if (IsLDRFormat(InRenderTarget->RenderTargetFormat))
 	{
 		TArray<FColor> OutLDR;
 		RTResource->ReadPixels(OutLDR, ReadPixelFlags, Rect);
-		TArray<FLinearColor> OutResult;
-		OutResult.SetNum(OutLDR.Num());
-		for (int32 i = 0; i < OutLDR.Num(); i++)
-		{
-			OutResult[i] =
-				(FLinearColor(float(OutLDR[i].R), float(OutLDR[i].G), float(OutLDR[i].B), float(OutLDR[i].A)) / 255.0f);
-		}
-		return OutResult;
+		ToLinearColors(OutLDR, OutResult);
 	}
-
-	if ((Format == RTF_R16f) || (Format == RTF_RG16f) || (Format == RTF_RGBA16f) || (Format == RTF_R32f)
-		|| (Format == RTF_RG32f) || (Format == RTF_RGBA32f))
+	else
 	{
-		TArray<FLinearColor> OutResult;
 		RTResource->ReadLinearColorPixels(OutResult, ReadPixelFlags, Rect);
-		return OutResult;
 	}
+	return OutResult;
+}
 
-	FMessageLog("TerrainGeneratorHelper")
-		.Warning(LOCTEXT(
-			"UTerrainGeneratorHelper",
-			"SampleRTData: Currently only 4 channel formats are supported: RTF_RGBA8, RTF_RGBA16f, and RTF_RGBA32f."));
+void UTerrainGeneratorHelper::SampleRTDataAsync(
+	UTextureRenderTarget2D* InRenderTarget,
+	FLinearColor InRect,
+	FTGReadbackCallback OnComplete)
+{
+	using namespace TerrainGeneratorHelperLocal;
+
+	FIntRect Rect;
+	if (!GetSampleRect(InRenderTarget, InRect, Rect))
+	{
+		OnComplete({});
+		return;
+	}
+
+	TSharedRef<FReadback, ESPMode::ThreadSafe> Readback = MakeShared<FReadback, ESPMode::ThreadSafe>();
+	FTextureRenderTargetResource* RTResource = InRenderTarget->GameThread_GetRenderTargetResource();
+	const bool bLDR = IsLDRFormat(InRenderTarget->RenderTargetFormat);
+
+	ENQUEUE_RENDER_COMMAND(SampleRTDataAsync)
+	(
+		[RTResource, Rect, bLDR, Readback](FRHICommandListImmediate& RHICmdList)
+		{
+			FReadSurfaceDataFlags ReadPixelFlags(RCM_MinMax);
+			if (bLDR)
+			{
+				TArray<FColor> OutLDR;
+				RHICmdList.ReadSurfaceData(RTResource->GetRenderTargetTexture(), Rect, OutLDR, ReadPixelFlags);
+				ToLinearColors(OutLDR, Readback->Pixels);
+			}
+			else
+			{
+				RHICmdList.ReadSurfaceData(
+					RTResource->GetRenderTargetTexture(),
+					Rect,
+					Readback->Pixels,
+					ReadPixelFlags);
+			}
+		});
+	Readback->Fence.BeginFence();
 
-	return { FLinearColor(0, 0, 0, 0) };
+	FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+		[Readback, OnComplete = MoveTemp(OnComplete)](float)
+		{
+			if (!Readback->Fence.IsFenceComplete())
+				return true;
+
+			OnComplete(MoveTemp(Readback->Pixels));
+			return false;
+		}));
 }
 
 
@@ -17,8 +17,9 @@
 
 #include "TerrainGeneratorUtils.h"
 
-#include "Async/ParallelFor.h"
+#include "Algo/StableSort.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "HeightmapKernels.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Materials/MaterialInstanceDynamic.h"
 
@@ -137,21 +138,11 @@ FVector2D FTerrainUtils::RoundUpPowerOfTwo(FVector2D Vector)
 	};
 }
 
-TArray<float> FHeightmapUtils::UnpackHeightToFloat(TArray<uint16> InHeightMap)
+TArray<float> FHeightmapUtils::UnpackHeightToFloat(const TArray<uint16>& InHeightMap)
 {
 	TArray<float> OutData;
-	OutData.SetNum(InHeightMap.Num());
-
-	ParallelFor(
-		InHeightMap.Num(),
-		[&](int32 Idx)
-		{
-			const uint8 G = InHeightMap[Idx] & 0xFF;
-			const uint8 R = InHeightMap[Idx] >> 8;
-			OutData[Idx] = ((R * 255 * 256) + (G * 255));
-		},
-		!FApp::ShouldUseThreadingForPerformance());
-
+	OutData.SetNumUninitialized(InHeightMap.Num());
+	FHeightmapKernels::UnpackHeight({ InHeightMap, { InHeightMap.Num(), 1 } }, { OutData, { OutData.Num(), 1 } });
 	return OutData;
 }
 
@@ -191,20 +182,13 @@ TArray<float> FHeightmapUtils::UnpackHeightToFloat(UTextureRenderTarget2D* InRen
 	return { 0.f };
 }
 
-TArray<uint16> FHeightmapUtils::PackHeightTo_uint16(TArray<float> InHeightMap)
+TArray<uint16> FHeightmapUtils::PackHeightTo_uint16(const TArray<float>& InHeightMap)
 {
 	TArray<uint16> EncodedHeight;
-	EncodedHeight.SetNum(InHeightMap.Num());
-
-	ParallelFor(
-		InHeightMap.Num(),
-		[&](int32 Idx)
-		{
-			EncodedHeight[Idx] =
-				(uint16)(FMath::Clamp(InHeightMap[Idx] / 255.f, (float)(MIN_uint16), (float)MAX_uint16));
-		},
-		!FApp::ShouldUseThreadingForPerformance());
-
+	EncodedHeight.SetNumUninitialized(InHeightMap.Num());
+	FHeightmapKernels::PackHeight(
+		{ InHeightMap, { InHeightMap.Num(), 1 } },
+		{ EncodedHeight, { EncodedHeight.Num(), 1 } });
 	return EncodedHeight;
 }
 
@@ -236,26 +220,801 @@ TArray<FColor> FHeightmapUtils::SampleHeightData(UTextureRenderTarget2D* InRende
 	return { FColor(0, 0, 0, 0) };
 }
 
+namespace TerrainGeneratorUtilsLocal
+{
+	// Projects the outline onto the plane through its center, so it winds counter-clockwise around +Z
+	TArray<FVector2D> ProjectPolygon(const TArray<FVector>& Vertices)
+	{
+		const FVector Center = UKismetMathLibrary::GetVectorArrayAverage(Vertices);
+		FVector Normal = FVector::ZeroVector;
+		for (int32 ArrayIndex = 0; ArrayIndex < Vertices.Num(); ArrayIndex++)
+		{
+			const FVector V1 = Vertices[ArrayIndex] - Center;
+			const FVector V2 = Vertices[(ArrayIndex + 1) % Vertices.Num()] - Center;
+			Normal = UKismetMathLibrary::Cross_VectorVector(V1, V2) + Normal;
+		}
+
+		UKismetMathLibrary::Vector_Normalize(Normal);
+		const FRotator Rot = UKismetMathLibrary::MakeRotFromZ(Normal);
+
+		TArray<FVector2D> Points;
+		Points.SetNumUninitialized(Vertices.Num());
+		for (int32 ArrayIndex = 0; ArrayIndex < Vertices.Num(); ArrayIndex++)
+		{
+			const FVector NewVert = UKismetMathLibrary::LessLess_VectorRotator(Vertices[ArrayIndex] - Center, Rot);
+			Points[ArrayIndex] = FVector2D { NewVert.X, NewVert.Y };
+		}
+		return Points;
+	}
+
+	// Linked list ear clipping, a port of https://github.com/mapbox/earcut.
+	// Nodes live in one array and link by index, so splitting the polygon never invalidates them.
+	class FEarcut
+	{
+	public:
+		FEarcut(TArrayView<const FVector2D> InPoints, TArray<int32>& InTriangles)
+			: Points { InPoints }
+			, Triangles { InTriangles }
+		{
+		}
+
+		void Run(TArrayView<const int32> HoleStarts)
+		{
+			const int32 OuterEnd = HoleStarts.Num() > 0 ? HoleStarts[0] : Points.Num();
+			Nodes.Reserve(Points.Num() + 2 * HoleStarts.Num());
+			Triangles.Reserve(3 * (Points.Num() + 2 * HoleStarts.Num()));
+
+			int32 Outer = LinkedList(0, OuterEnd, true);
+			if (Outer == INDEX_NONE || Nodes[Outer].Next == Nodes[Outer].Prev)
+			{
+				return;
+			}
+
+			if (HoleStarts.Num() > 0)
+			{
+				Outer = EliminateHoles(HoleStarts, Outer);
+			}
+
+			// Below a few dozen vertices the plain ear test is faster than maintaining the hash
+			if (Points.Num() > 80)
+			{
+				double MaxX = MinX = Points[0].X;
+				double MaxY = MinY = Points[0].Y;
+				for (int32 Index = 1; Index < OuterEnd; Index++)
+				{
+					MinX = FMath::Min<double>(MinX, Points[Index].X);
+					MinY = FMath::Min<double>(MinY, Points[Index].Y);
+					MaxX = FMath::Max<double>(MaxX, Points[Index].X);
+					MaxY = FMath::Max<double>(MaxY, Points[Index].Y);
+				}
+				const double Size = FMath::Max(MaxX - MinX, MaxY - MinY);
+				InvSize = Size != 0.0 ? 32767.0 / Size : 0.0;
+			}
+
+			EarcutLinked(Outer, 0);
+		}
+
+	private:
+		struct FNode
+		{
+			int32 Index;
+			double X;
+			double Y;
+			int32 Prev = INDEX_NONE;
+			int32 Next = INDEX_NONE;
+			int32 Z = 0;
+			int32 PrevZ = INDEX_NONE;
+			int32 NextZ = INDEX_NONE;
+			bool bSteiner = false;
+		};
+
+		TArrayView<const FVector2D> Points;
+		TArray<int32>& Triangles;
+		TArray<FNode> Nodes;
+		double MinX = 0.0;
+		double MinY = 0.0;
+		double InvSize = 0.0;
+
+		// Twice the signed area of the ring, positive when counter-clockwise
+		double SignedArea(int32 Start, int32 End) const
+		{
+			double Sum = 0.0;
+			for (int32 I = Start, J = End - 1; I < End; J = I++)
+			{
+				Sum += (double(Points[J].X) - Points[I].X) * (double(Points[I].Y) + Points[J].Y);
+			}
+			return Sum;
+		}
+
+		// Negative when P, Q, R turn counter-clockwise
+		double Area(int32 P, int32 Q, int32 R) const
+		{
+			const FNode& A = Nodes[P];
+			const FNode& B = Nodes[Q];
+			const FNode& C = Nodes[R];
+			return (B.Y - A.Y) * (C.X - B.X) - (B.X - A.X) * (C.Y - B.Y);
+		}
+
+		bool Equals(int32 P, int32 Q) const
+		{
+			return Nodes[P].X == Nodes[Q].X && Nodes[P].Y == Nodes[Q].Y;
+		}
+
+		static bool PointInTriangle(
+			double AX,
+			double AY,
+			double BX,
+			double BY,
+			double CX,
+			double CY,
+			double PX,
+			double PY)
+		{
+			return (CX - PX) * (AY - PY) >= (AX - PX) * (CY - PY) && (AX - PX) * (BY - PY) >= (BX - PX) * (AY - PY)
+				&& (BX - PX) * (CY - PY) >= (CX - PX) * (BY - PY);
+		}
+
+		int32 InsertNode(int32 Index, int32 Last)
+		{
+			const int32 P = Nodes.Add(FNode { Index, Points[Index].X, Points[Index].Y });
+			if (Last == INDEX_NONE)
+			{
+				Nodes[P].Prev = P;
+				Nodes[P].Next = P;
+			}
+			else
+			{
+				Nodes[P].Next = Nodes[Last].Next;
+				Nodes[P].Prev = Last;
+				Nodes[Nodes[Last].Next].Prev = P;
+				Nodes[Last].Next = P;
+			}
+			return P;
+		}
+
+		void RemoveNode(int32 P)
+		{
+			const FNode& Node = Nodes[P];
+			Nodes[Node.Next].Prev = Node.Prev;
+			Nodes[Node.Prev].Next = Node.Next;
+			if (Node.PrevZ != INDEX_NONE)
+			{
+				Nodes[Node.PrevZ].NextZ = Node.NextZ;
+			}
+			if (Node.NextZ != INDEX_NONE)
+			{
+				Nodes[Node.NextZ].PrevZ = Node.PrevZ;
+			}
+		}
+
+		int32 LinkedList(int32 Start, int32 End, bool bCounterClockwise)
+		{
+			int32 Last = INDEX_NONE;
+			if (bCounterClockwise == (SignedArea(Start, End) > 0.0))
+			{
+				for (int32 Index = Start; Index < End; Index++)
+				{
+					Last = InsertNode(Index, Last);
+				}
+			}
+			else
+			{
+				for (int32 Index = End - 1; Index >= Start; Index--)
+				{
+					Last = InsertNode(Index, Last);
+				}
+			}
+
+			if (Last != INDEX_NONE && Equals(Last, Nodes[Last].Next))
+			{
+				RemoveNode(Last);
+				Last = Nodes[Last].Next;
+			}
+			return Last;
+		}
+
+		// Drops duplicate and collinear points between Start and End
+		int32 FilterPoints(int32 Start, int32 End = INDEX_NONE)
+		{
+			if (Start == INDEX_NONE)
+			{
+				return Start;
+			}
+			if (End == INDEX_NONE)
+			{
+				End = Start;
+			}
+
+			int32 P = Start;
+			bool bAgain;
+			do
+			{
+				bAgain = false;
+				if (!Nodes[P].bSteiner && (Equals(P, Nodes[P].Next) || Area(Nodes[P].Prev, P, Nodes[P].Next) == 0.0))
+				{
+					RemoveNode(P);
+					P = End = Nodes[P].Prev;
+					if (P == Nodes[P].Next)
+					{
+						break;
+					}
+					bAgain = true;
+				}
+				else
+				{
+					P = Nodes[P].Next;
+				}
+			}
+			while (bAgain || P != End);
+
+			return End;
+		}
+
+		void AddTriangle(int32 A, int32 B, int32 C)
+		{
+			Triangles.Add(Nodes[A].Index);
+			Triangles.Add(Nodes[B].Index);
+			Triangles.Add(Nodes[C].Index);
+		}
+
+		void EarcutLinked(int32 Ear, int32 Pass)
+		{
+			if (Ear == INDEX_NONE)
+			{
+				return;
+			}
+			if (Pass == 0 && InvSize != 0.0)
+			{
+				IndexCurve(Ear);
+			}
+
+			int32 Stop = Ear;
+			while (Nodes[Ear].Prev != Nodes[Ear].Next)
+			{
+				const int32 Prev = Nodes[Ear].Prev;
+				const int32 Next = Nodes[Ear].Next;
+
+				if (InvSize != 0.0 ? IsEarHashed(Ear) : IsEar(Ear))
+				{
+					AddTriangle(Prev, Ear, Next);
+					RemoveNode(Ear);
+
+					// Skipping the next vertex leaves fewer sliver triangles
+					Ear = Nodes[Next].Next;
+					Stop = Ear;
+					continue;
+				}
+
+				Ear = Next;
+				if (Ear == Stop)
+				{
+					// Went around without an ear: filter degenerate points, then cure small self-intersections,
+					// then split the remainder in two along a valid diagonal
+					if (Pass == 0)
+					{
+						EarcutLinked(FilterPoints(Ear), 1);
+					}
+					else if (Pass == 1)
+					{
+						EarcutLinked(CureLocalIntersections(FilterPoints(Ear)), 2);
+					}
+					else
+					{
+						SplitEarcut(Ear);
+					}
+					break;
+				}
+			}
+		}
+
+		bool IsEar(int32 Ear) const
+		{
+			const int32 A = Nodes[Ear].Prev;
+			const int32 C = Nodes[Ear].Next;
+			if (Area(A, Ear, C) >= 0.0)
+			{
+				return false;
+			}
+
+			const FNode& NA = Nodes[A];
+			const FNode& NB = Nodes[Ear];
+			const FNode& NC = Nodes[C];
+			const double X0 = FMath::Min3(NA.X, NB.X, NC.X);
+			const double Y0 = FMath::Min3(NA.Y, NB.Y, NC.Y);
+			const double X1 = FMath::Max3(NA.X, NB.X, NC.X);
+			const double Y1 = FMath::Max3(NA.Y, NB.Y, NC.Y);
+
+			for (int32 P = NC.Next; P != A; P = Nodes[P].Next)
+			{
+				const FNode& N = Nodes[P];
+				if (N.X >= X0 && N.X <= X1 && N.Y >= Y0 && N.Y <= Y1
+					&& PointInTriangle(NA.X, NA.Y, NB.X, NB.Y, NC.X, NC.Y, N.X, N.Y) && Area(N.Prev, P, N.Next) >= 0.0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Same as IsEar, but only walks the points whose z-order falls into the bounds of the triangle
+		bool IsEarHashed(int32 Ear) const
+		{
+			const int32 A = Nodes[Ear].Prev;
+			const int32 C = Nodes[Ear].Next;
+			if (Area(A, Ear, C) >= 0.0)
+			{
+				return false;
+			}
+
+			const FNode& NA = Nodes[A];
+			const FNode& NB = Nodes[Ear];
+			const FNode& NC = Nodes[C];
+			const double X0 = FMath::Min3(NA.X, NB.X, NC.X);
+			const double Y0 = FMath::Min3(NA.Y, NB.Y, NC.Y);
+			const double X1 = FMath::Max3(NA.X, NB.X, NC.X);
+			const double Y1 = FMath::Max3(NA.Y, NB.Y, NC.Y);
+			const int32 MinZ = ZOrder(X0, Y0);
+			const int32 MaxZ = ZOrder(X1, Y1);
+
+			auto Blocks = [&](int32 P)
+			{
+				const FNode& N = Nodes[P];
+				return N.X >= X0 && N.X <= X1 && N.Y >= Y0 && N.Y <= Y1 && P != A && P != C
+					&& PointInTriangle(NA.X, NA.Y, NB.X, NB.Y, NC.X, NC.Y, N.X, N.Y) && Area(N.Prev, P, N.Next) >= 0.0;
+			};
+
+			int32 P = NB.PrevZ;
+			int32 N = NB.NextZ;
+			while (P != INDEX_NONE && Nodes[P].Z >= MinZ && N != INDEX_NONE && Nodes[N].Z <= MaxZ)
+			{
+				if (Blocks(P) || Blocks(N))
+				{
+					return false;
+				}
+				P = Nodes[P].PrevZ;
+				N = Nodes[N].NextZ;
+			}
+			for (; P != INDEX_NONE && Nodes[P].Z >= MinZ; P = Nodes[P].PrevZ)
+			{
+				if (Blocks(P))
+				{
+					return false;
+				}
+			}
+			for (; N != INDEX_NONE && Nodes[N].Z <= MaxZ; N = Nodes[N].NextZ)
+			{
+				if (Blocks(N))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		int32 CureLocalIntersections(int32 Start)
+		{
+			int32 P = Start;
+			do
+			{
+				const int32 A = Nodes[P].Prev;
+				const int32 B = Nodes[Nodes[P].Next].Next;
+				if (!Equals(A, B) && Intersects(A, P, Nodes[P].Next, B) && LocallyInside(A, B) && LocallyInside(B, A))
+				{
+					AddTriangle(A, P, B);
+					RemoveNode(P);
+					RemoveNode(Nodes[P].Next);
+					P = Start = B;
+				}
+				P = Nodes[P].Next;
+			}
+			while (P != Start);
+
+			return FilterPoints(P);
+		}
+
+		void SplitEarcut(int32 Start)
+		{
+			int32 A = Start;
+			do
+			{
+				for (int32 B = Nodes[Nodes[A].Next].Next; B != Nodes[A].Prev; B = Nodes[B].Next)
+				{
+					if (Nodes[A].Index != Nodes[B].Index && IsValidDiagonal(A, B))
+					{
+						int32 C = SplitPolygon(A, B);
+						A = FilterPoints(A, Nodes[A].Next);
+						C = FilterPoints(C, Nodes[C].Next);
+						EarcutLinked(A, 0);
+						EarcutLinked(C, 0);
+						return;
+					}
+				}
+				A = Nodes[A].Next;
+			}
+			while (A != Start);
+		}
+
+		int32 EliminateHoles(TArrayView<const int32> HoleStarts, int32 Outer)
+		{
+			TArray<int32> Queue;
+			Queue.Reserve(HoleStarts.Num());
+			for (int32 Hole = 0; Hole < HoleStarts.Num(); Hole++)
+			{
+				const int32 End = Hole + 1 < HoleStarts.Num() ? HoleStarts[Hole + 1] : Points.Num();
+				const int32 List = LinkedList(HoleStarts[Hole], End, false);
+				if (List == INDEX_NONE)
+				{
+					continue;
+				}
+				if (List == Nodes[List].Next)
+				{
+					Nodes[List].bSteiner = true;
+				}
+				Queue.Add(GetLeftmost(List));
+			}
+
+			Algo::StableSort(Queue, [this](int32 A, int32 B) { return Nodes[A].X < Nodes[B].X; });
+
+			for (const int32 Hole : Queue)
+			{
+				Outer = EliminateHole(Hole, Outer);
+			}
+			return Outer;
+		}
+
+		// Connects the hole to the outer ring with a pair of coincident edges
+		int32 EliminateHole(int32 Hole, int32 Outer)
+		{
+			const int32 Bridge = FindHoleBridge(Hole, Outer);
+			if (Bridge == INDEX_NONE)
+			{
+				return Outer;
+			}
+
+			const int32 BridgeReverse = SplitPolygon(Bridge, Hole);
+			FilterPoints(BridgeReverse, Nodes[BridgeReverse].Next);
+			return FilterPoints(Bridge, Nodes[Bridge].Next);
+		}
+
+		// David Eberly's algorithm for finding a bridge between a hole and the outer polygon
+		int32 FindHoleBridge(int32 Hole, int32 Outer) const
+		{
+			const double HX = Nodes[Hole].X;
+			const double HY = Nodes[Hole].Y;
+			double QX = TNumericLimits<double>::Lowest();
+			int32 M = INDEX_NONE;
+
+			// Find the segment left of the hole vertex intersected by the ray going left
+			int32 P = Outer;
+			do
+			{
+				const FNode& A = Nodes[P];
+				const FNode& B = Nodes[A.Next];
+				if (HY <= A.Y && HY >= B.Y && B.Y != A.Y)
+				{
+					const double X = A.X + (HY - A.Y) * (B.X - A.X) / (B.Y - A.Y);
+					if (X <= HX && X > QX)
+					{
+						QX = X;
+						M = A.X < B.X ? P : A.Next;
+						if (X == HX)
+						{
+							// The hole touches the outer segment, pick the leftmost endpoint
+							return M;
+						}
+					}
+				}
+				P = A.Next;
+			}
+			while (P != Outer);
+
+			if (M == INDEX_NONE)
+			{
+				return INDEX_NONE;
+			}
+
+			// Look for points inside the triangle of the hole point, the intersection and the segment endpoint.
+			// If there are any, connect to the one with the smallest angle to the ray instead.
+			const int32 Stop = M;
+			const double MX = Nodes[M].X;
+			const double MY = Nodes[M].Y;
+			double TanMin = TNumericLimits<double>::Max();
+
+			P = M;
+			do
+			{
+				const FNode& N = Nodes[P];
+				if (HX >= N.X && N.X >= MX && HX != N.X
+					&& PointInTriangle(HY < MY ? HX : QX, HY, MX, MY, HY < MY ? QX : HX, HY, N.X, N.Y))
+				{
+					const double Tan = FMath::Abs(HY - N.Y) / (HX - N.X);
+					if (LocallyInside(P, Hole)
+						&& (Tan < TanMin
+							|| (Tan == TanMin
+								&& (N.X > Nodes[M].X || (N.X == Nodes[M].X && SectorContainsSector(M, P))))))
+					{
+						M = P;
+						TanMin = Tan;
+					}
+				}
+				P = N.Next;
+			}
+			while (P != Stop);
+
+			return M;
+		}
+
+		bool SectorContainsSector(int32 M, int32 P) const
+		{
+			return Area(Nodes[M].Prev, M, Nodes[P].Prev) < 0.0 && Area(Nodes[P].Next, M, Nodes[M].Next) < 0.0;
+		}
+
+		int32 GetLeftmost(int32 Start) const
+		{
+			int32 Leftmost = Start;
+			int32 P = Start;
+			do
+			{
+				const FNode& N = Nodes[P];
+				if (N.X < Nodes[Leftmost].X || (N.X == Nodes[Leftmost].X && N.Y < Nodes[Leftmost].Y))
+				{
+					Leftmost = P;
+				}
+				P = N.Next;
+			}
+			while (P != Start);
+			return Leftmost;
+		}
+
+		// Interleaves the bits of the coordinates quantized to 15 bits
+		int32 ZOrder(double X, double Y) const
+		{
+			uint32 QX = uint32((X - MinX) * InvSize);
+			uint32 QY = uint32((Y - MinY) * InvSize);
+
+			QX = (QX | (QX << 8)) & 0x00FF00FF;
+			QX = (QX | (QX << 4)) & 0x0F0F0F0F;
+			QX = (QX | (QX << 2)) & 0x33333333;
+			QX = (QX | (QX << 1)) & 0x55555555;
+
+			QY = (QY | (QY << 8)) & 0x00FF00FF;
+			QY = (QY | (QY << 4)) & 0x0F0F0F0F;
+			QY = (QY | (QY << 2)) & 0x33333333;
+			QY = (QY | (QY << 1)) & 0x55555555;
+
+			return int32(QX | (QY << 1));
+		}
+
+		void IndexCurve(int32 Start)
+		{
+			int32 P = Start;
+			do
+			{
+				FNode& N = Nodes[P];
+				if (N.Z == 0)
+				{
+					N.Z = ZOrder(N.X, N.Y);
+				}
+				N.PrevZ = N.Prev;
+				N.NextZ = N.Next;
+				P = N.Next;
+			}
+			while (P != Start);
+
+			Nodes[Nodes[P].PrevZ].NextZ = INDEX_NONE;
+			Nodes[P].PrevZ = INDEX_NONE;
+
+			SortLinked(P);
+		}
+
+		// Bottom-up merge sort of the z-order list (Simon Tatham's linked list sort)
+		int32 SortLinked(int32 List)
+		{
+			int32 InSize = 1;
+			int32 NumMerges;
+			do
+			{
+				int32 P = List;
+				int32 Tail = INDEX_NONE;
+				List = INDEX_NONE;
+				NumMerges = 0;
+
+				while (P != INDEX_NONE)
+				{
+					NumMerges++;
+					int32 Q = P;
+					int32 PSize = 0;
+					for (int32 I = 0; I < InSize && Q != INDEX_NONE; I++)
+					{
+						PSize++;
+						Q = Nodes[Q].NextZ;
+					}
+					int32 QSize = InSize;
+
+					while (PSize > 0 || (QSize > 0 && Q != INDEX_NONE))
+					{
+						int32 E;
+						if (PSize != 0 && (QSize == 0 || Q == INDEX_NONE || Nodes[P].Z <= Nodes[Q].Z))
+						{
+							E = P;
+							P = Nodes[P].NextZ;
+							PSize--;
+						}
+						else
+						{
+							E = Q;
+							Q = Nodes[Q].NextZ;
+							QSize--;
+						}
+
+						if (Tail != INDEX_NONE)
+						{
+							Nodes[Tail].NextZ = E;
+						}
+						else
+						{
+							List = E;
+						}
+						Nodes[E].PrevZ = Tail;
+						Tail = E;
+					}
+					P = Q;
+				}
+
+				Nodes[Tail].NextZ = INDEX_NONE;
+				InSize *= 2;
+			}
+			while (NumMerges > 1);
+
+			return List;
+		}
+
+		bool IsValidDiagonal(int32 A, int32 B) const
+		{
+			const FNode& NA = Nodes[A];
+			const FNode& NB = Nodes[B];
+			if (Nodes[NA.Next].Index == NB.Index || Nodes[NA.Prev].Index == NB.Index || IntersectsPolygon(A, B))
+			{
+				return false;
+			}
+
+			// Locally visible, not collinear with its neighbours, or a zero length diagonal between two convex corners
+			return (LocallyInside(A, B) && LocallyInside(B, A) && MiddleInside(A, B)
+					&& (Area(NA.Prev, A, NB.Prev) != 0.0 || Area(A, NB.Prev, B) != 0.0))
+				|| (Equals(A, B) && Area(NA.Prev, A, NA.Next) > 0.0 && Area(NB.Prev, B, NB.Next) > 0.0);
+		}
+
+		static int32 Sign(double Value)
+		{
+			return Value > 0.0 ? 1 : Value < 0.0 ? -1 : 0;
+		}
+
+		// Whether Q lies within the bounds of the collinear segment PR
+		bool OnSegment(int32 P, int32 Q, int32 R) const
+		{
+			const FNode& NP = Nodes[P];
+			const FNode& NQ = Nodes[Q];
+			const FNode& NR = Nodes[R];
+			return NQ.X <= FMath::Max(NP.X, NR.X) && NQ.X >= FMath::Min(NP.X, NR.X) && NQ.Y <= FMath::Max(NP.Y, NR.Y)
+				&& NQ.Y >= FMath::Min(NP.Y, NR.Y);
+		}
+
+		bool Intersects(int32 P1, int32 Q1, int32 P2, int32 Q2) const
+		{
+			const int32 O1 = Sign(Area(P1, Q1, P2));
+			const int32 O2 = Sign(Area(P1, Q1, Q2));
+			const int32 O3 = Sign(Area(P2, Q2, P1));
+			const int32 O4 = Sign(Area(P2, Q2, Q1));
+
+			return (O1 != O2 && O3 != O4) || (O1 == 0 && OnSegment(P1, P2, Q1)) || (O2 == 0 && OnSegment(P1, Q2, Q1))
+				|| (O3 == 0 && OnSegment(P2, P1, Q2)) || (O4 == 0 && OnSegment(P2, Q1, Q2));
+		}
+
+		bool IntersectsPolygon(int32 A, int32 B) const
+		{
+			const int32 AIndex = Nodes[A].Index;
+			const int32 BIndex = Nodes[B].Index;
+			int32 P = A;
+			do
+			{
+				const int32 Next = Nodes[P].Next;
+				const int32 PIndex = Nodes[P].Index;
+				const int32 NextIndex = Nodes[Next].Index;
+				if (PIndex != AIndex && NextIndex != AIndex && PIndex != BIndex && NextIndex != BIndex
+					&& Intersects(P, Next, A, B))
+				{
+					return true;
+				}
+				P = Next;
+			}
+			while (P != A);
+			return false;
+		}
+
+		bool LocallyInside(int32 A, int32 B) const
+		{
+			const FNode& N = Nodes[A];
+			return Area(N.Prev, A, N.Next) < 0.0 ? Area(A, B, N.Next) >= 0.0 && Area(A, N.Prev, B) >= 0.0
+												 : Area(A, B, N.Prev) < 0.0 || Area(A, N.Next, B) < 0.0;
+		}
+
+		bool MiddleInside(int32 A, int32 B) const
+		{
+			const double PX = (Nodes[A].X + Nodes[B].X) / 2.0;
+			const double PY = (Nodes[A].Y + Nodes[B].Y) / 2.0;
+			bool bInside = false;
+			int32 P = A;
+			do
+			{
+				const FNode& N = Nodes[P];
+				const FNode& Next = Nodes[N.Next];
+				if ((N.Y > PY) != (Next.Y > PY) && Next.Y != N.Y
+					&& PX < (Next.X - N.X) * (PY - N.Y) / (Next.Y - N.Y) + N.X)
+				{
+					bInside = !bInside;
+				}
+				P = N.Next;
+			}
+			while (P != A);
+			return bInside;
+		}
+
+		// Links A and B with a diagonal. When on the same ring this splits it in two, otherwise merges both rings.
+		// Returns the copy of B that starts the second ring.
+		int32 SplitPolygon(int32 A, int32 B)
+		{
+			const int32 A2 = Nodes.Add(FNode { Nodes[A].Index, Nodes[A].X, Nodes[A].Y });
+			const int32 B2 = Nodes.Add(FNode { Nodes[B].Index, Nodes[B].X, Nodes[B].Y });
+			const int32 AN = Nodes[A].Next;
+			const int32 BP = Nodes[B].Prev;
+
+			Nodes[A].Next = B;
+			Nodes[B].Prev = A;
+
+			Nodes[A2].Next = AN;
+			Nodes[AN].Prev = A2;
+
+			Nodes[B2].Next = A2;
+			Nodes[A2].Prev = B2;
+
+			Nodes[BP].Next = B2;
+			Nodes[B2].Prev = BP;
+
+			return B2;
+		}
+	};
+}
+
 void FPolygonTriangulationUtils::TriangulatePolygon(const TArray<FVector>& Vertices, TArray<int32>& Triangles)
 {
-	const FVector Center = UKismetMathLibrary::GetVectorArrayAverage(Vertices);
-	FVector Normal = FVector::ZeroVector;
-	for (int32 ArrayIndex = 0; ArrayIndex < Vertices.Num(); ArrayIndex++)
+	if (Vertices.Num() < 3)
 	{
-		const FVector V1 = Vertices[ArrayIndex] - Center;
-		const FVector V2 = Vertices[LoopArrayIndex(ArrayIndex, 1, Vertices.Num())] - Center;
-		Normal = UKismetMathLibrary::Cross_VectorVector(V1, V2) + Normal;
+		Triangles.Reset();
+		return;
 	}
 
-	UKismetMathLibrary::Vector_Normalize(Normal);
-	const FRotator Rot = UKismetMathLibrary::MakeRotFromZ(Normal);
+	const TArray<FVector2D> Points = TerrainGeneratorUtilsLocal::ProjectPolygon(Vertices);
+	Triangles = TriangulatePolygon2D(Points);
+}
+
+TArray<int32> FPolygonTriangulationUtils::TriangulatePolygon2D(
+	TArrayView<const FVector2D> Vertices,
+	TArrayView<const int32> HoleStarts)
+{
+	TArray<int32> Triangles;
+	TerrainGeneratorUtilsLocal::FEarcut(Vertices, Triangles).Run(HoleStarts);
+	return Triangles;
+}
+
+void FPolygonTriangulationUtils::TriangulatePolygonRecursive(const TArray<FVector>& Vertices, TArray<int32>& Triangles)
+{
+	const TArray<FVector2D> Points = TerrainGeneratorUtilsLocal::ProjectPolygon(Vertices);
 
 	TArray<FVertIndex> Vert;
-	Vert.SetNumUninitialized(Vertices.Num());
-	for (int32 ArrayIndex = 0; ArrayIndex < Vertices.Num(); ArrayIndex++)
+	Vert.SetNumUninitialized(Points.Num());
+	for (int32 ArrayIndex = 0; ArrayIndex < Points.Num(); ArrayIndex++)
 	{
-		const FVector NewVert = UKismetMathLibrary::LessLess_VectorRotator(Vertices[ArrayIndex] - Center, Rot);
-		Vert[ArrayIndex] = FVertIndex { ArrayIndex, FVector2D { NewVert.X, NewVert.Y } };
+		Vert[ArrayIndex] = FVertIndex { ArrayIndex, Points[ArrayIndex] };
 	}
 	Vert = FlipPolygon(Vert);
 	TArray<FLineSegment> BuildSeg;
@@ -0,0 +1,287 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "HeightmapKernels.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace HeightmapKernelsTestLocal
+{
+	// Sizes are not multiples of the tile size or the vector width
+	const FIntPoint TestSize { 133, 77 };
+
+	TArray<float> MakeHeights(FIntPoint Size, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<float> Heights;
+		Heights.SetNumUninitialized(Size.X * Size.Y);
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32 X = 0; X < Size.X; X++)
+			{
+				const float Hills = 1000.f * FMath::Sin(X * 0.05f) * FMath::Cos(Y * 0.07f);
+				Heights[Y * Size.X + X] = Hills + Random.FRand() * 50.f;
+			}
+		}
+		return Heights;
+	}
+
+	float At(const TArray<float>& Heights, FIntPoint Size, int32 X, int32 Y)
+	{
+		return Heights[FMath::Clamp(Y, 0, Size.Y - 1) * Size.X + FMath::Clamp(X, 0, Size.X - 1)];
+	}
+
+	// Relative to the largest reference value, summation order differs between the kernels and the references
+	float MaxRelativeDifference(const TArray<float>& A, const TArray<float>& B)
+	{
+		float MaxDifference = 0.f;
+		float MaxValue = 1.f;
+		for (int32 Index = 0; Index < A.Num(); Index++)
+		{
+			MaxDifference = FMath::Max(MaxDifference, FMath::Abs(A[Index] - B[Index]));
+			MaxValue = FMath::Max(MaxValue, FMath::Abs(B[Index]));
+		}
+		return MaxDifference / MaxValue;
+	}
+
+	TArray<float> ReferenceSteepness(const TArray<float>& Heights, FIntPoint Size)
+	{
+		TArray<float> Result;
+		Result.SetNumUninitialized(Heights.Num());
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32 X = 0; X < Size.X; X++)
+			{
+				const float Center = At(Heights, Size, X, Y);
+				float Sum = 0.f;
+				for (const FIntPoint Offset : { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) })
+					Sum += FMath::Square(At(Heights, Size, X + Offset.X, Y + Offset.Y) - Center);
+				Result[Y * Size.X + X] = FMath::Sqrt(Sum);
+			}
+		}
+		return Result;
+	}
+
+	TArray<float> ReferenceConvolve(const TArray<float>& Heights, FIntPoint Size, const TArray<float>& Kernel)
+	{
+		const int32 Radius = FMath::FloorToInt(FMath::Sqrt((float)Kernel.Num())) / 2;
+		const int32 KernelSize = 2 * Radius + 1;
+
+		TArray<float> Result;
+		Result.SetNumUninitialized(Heights.Num());
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32 X = 0; X < Size.X; X++)
+			{
+				float Sum = 0.f;
+				for (int32 OffsetY = -Radius; OffsetY <= Radius; OffsetY++)
+				{
+					for (int32 OffsetX = -Radius; OffsetX <= Radius; OffsetX++)
+					{
+						const float Weight = Kernel[(OffsetY + Radius) * KernelSize + OffsetX + Radius];
+						Sum += Weight * At(Heights, Size, X + OffsetX, Y + OffsetY);
+					}
+				}
+				Result[Y * Size.X + X] = Sum;
+			}
+		}
+		return Result;
+	}
+}
+
+VSP_TEST(HeightmapKernels, PackUnpackMatchesLegacy, TestsFlags)
+{
+	FRandomStream Random(7);
+	TArray<uint16> Packed;
+	for (int32 Index = 0; Index < 10001; Index++)
+		Packed.Add((uint16)Random.RandRange(0, MAX_uint16));
+	Packed[0] = 0;
+	Packed[1] = MAX_uint16;
+
+	TArray<float> Unpacked;
+	Unpacked.SetNumUninitialized(Packed.Num());
+	FHeightmapKernels::UnpackHeight({ Packed, { Packed.Num(), 1 } }, { Unpacked, { Unpacked.Num(), 1 } });
+
+	bool bUnpackMatches = true;
+	for (int32 Index = 0; Index < Packed.Num(); Index++)
+	{
+		const uint8 R = Packed[Index] >> 8;
+		const uint8 G = Packed[Index] & 0xFF;
+		bUnpackMatches &= Unpacked[Index] == (float)((R * 255 * 256) + (G * 255));
+	}
+	VSP_EXPECT_TRUE(bUnpackMatches);
+
+	TArray<float> Heights = Unpacked;
+	for (int32 Index = 0; Index < 1000; Index++)
+		Heights.Add(Random.FRandRange(-1000.f, 255.f * MAX_uint16 + 1000.f));
+
+	TArray<uint16> Repacked;
+	Repacked.SetNumUninitialized(Heights.Num());
+	FHeightmapKernels::PackHeight({ Heights, { Heights.Num(), 1 } }, { Repacked, { Repacked.Num(), 1 } });
+
+	bool bPackMatches = true;
+	for (int32 Index = 0; Index < Heights.Num(); Index++)
+		bPackMatches &= Repacked[Index] == (uint16)FMath::Clamp(Heights[Index] / 255.f, 0.f, (float)MAX_uint16);
+	VSP_EXPECT_TRUE(bPackMatches);
+
+	for (int32 Index = 0; Index < Packed.Num(); Index++)
+		bPackMatches &= Repacked[Index] == Packed[Index];
+	VSP_EXPECT_TRUE(bPackMatches);
+
+	return true;
+}
+
+VSP_TEST(HeightmapKernels, SteepnessMatchesScalar, TestsFlags)
+{
+	using namespace HeightmapKernelsTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 1);
+	TArray<float> Steepness;
+	Steepness.SetNumUninitialized(Heights.Num());
+
+	int32 LastNumTilesDone = 0;
+	int32 LastNumTiles = -1;
+	FHeightmapKernels::Steepness(
+		{ Heights, TestSize },
+		{ Steepness, TestSize },
+		[&](int32 NumTilesDone, int32 NumTiles)
+		{
+			LastNumTilesDone = NumTilesDone;
+			LastNumTiles = NumTiles;
+		});
+
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Steepness, ReferenceSteepness(Heights, TestSize)) < 1e-5f);
+	VSP_EXPECT_EQ(LastNumTiles, 2);
+	VSP_EXPECT_EQ(LastNumTilesDone, LastNumTiles);
+
+	return true;
+}
+
+VSP_TEST(HeightmapKernels, StencilsMatchScalar, TestsFlags)
+{
+	using namespace HeightmapKernelsTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 2);
+	TArray<float> Result;
+	Result.SetNumUninitialized(Heights.Num());
+
+	const float CellSize = 2.f;
+	TArray<float> Reference;
+	Reference.SetNumUninitialized(Heights.Num());
+	for (int32 Y = 0; Y < TestSize.Y; Y++)
+	{
+		for (int32 X = 0; X < TestSize.X; X++)
+		{
+			const float DX = (At(Heights, TestSize, X + 1, Y) - At(Heights, TestSize, X - 1, Y)) / (2.f * CellSize);
+			const float DY = (At(Heights, TestSize, X, Y + 1) - At(Heights, TestSize, X, Y - 1)) / (2.f * CellSize);
+			Reference[Y * TestSize.X + X] = FMath::Sqrt(DX * DX + DY * DY);
+		}
+	}
+	FHeightmapKernels::Slope({ Heights, TestSize }, { Result, TestSize }, CellSize);
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Result, Reference) < 1e-5f);
+
+	const TArray<float> Laplacian { 0.f, 0.25f, 0.f, 0.25f, -1.f, 0.25f, 0.f, 0.25f, 0.f };
+	FHeightmapKernels::Curvature({ Heights, TestSize }, { Result, TestSize }, CellSize);
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Result, ReferenceConvolve(Heights, TestSize, Laplacian)) < 1e-5f);
+
+	const float Kernel[9] = { 1.f, 2.f, 1.f, 0.f, 0.5f, 0.f, -1.f, -2.f, -1.f };
+	FHeightmapKernels::Convolve3x3({ Heights, TestSize }, { Result, TestSize }, Kernel);
+	const TArray<float> KernelArray(Kernel, 9);
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Result, ReferenceConvolve(Heights, TestSize, KernelArray)) < 1e-5f);
+
+	TArray<FVector> Normals;
+	Normals.SetNumUninitialized(Heights.Num());
+	FHeightmapKernels::Normals({ Heights, TestSize }, { Normals, TestSize }, CellSize);
+	bool bNormalsMatch = true;
+	for (int32 Y = 0; Y < TestSize.Y; Y++)
+	{
+		for (int32 X = 0; X < TestSize.X; X++)
+		{
+			const float DX = (At(Heights, TestSize, X + 1, Y) - At(Heights, TestSize, X - 1, Y)) / (2.f * CellSize);
+			const float DY = (At(Heights, TestSize, X, Y + 1) - At(Heights, TestSize, X, Y - 1)) / (2.f * CellSize);
+			const FVector Expected = FVector(-DX, -DY, 1.f).GetSafeNormal();
+			bNormalsMatch &= Normals[Y * TestSize.X + X].Equals(Expected, 1e-5f);
+		}
+	}
+	VSP_EXPECT_TRUE(bNormalsMatch);
+
+	return true;
+}
+
+VSP_TEST(HeightmapKernels, GaussianBlurMatchesScalar, TestsFlags)
+{
+	using namespace HeightmapKernelsTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 3);
+	TArray<float> Blurred;
+	Blurred.SetNumUninitialized(Heights.Num());
+	FHeightmapKernels::GaussianBlur({ Heights, TestSize }, { Blurred, TestSize }, 1.5f);
+
+	const TArray<float> Kernel1D = FHeightmapKernels::MakeGaussianKernel(1.5f);
+	VSP_EXPECT_EQ(Kernel1D.Num(), 11);
+
+	TArray<float> Kernel2D;
+	for (const float WeightY : Kernel1D)
+	{
+		for (const float WeightX : Kernel1D)
+			Kernel2D.Add(WeightX * WeightY);
+	}
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Blurred, ReferenceConvolve(Heights, TestSize, Kernel2D)) < 1e-4f);
+
+	TArray<float> Flat;
+	Flat.Init(1234.f, Heights.Num());
+	FHeightmapKernels::GaussianBlur({ Flat, TestSize }, { Blurred, TestSize }, 4.f);
+	VSP_EXPECT_TRUE(MaxRelativeDifference(Blurred, Flat) < 1e-5f);
+
+	return true;
+}
+
+VSP_TEST(HeightmapKernels, Benchmark, BenchmarkFlags)
+{
+	using namespace HeightmapKernelsTestLocal;
+
+	for (const int32 Size : { 1024, 2048, 4096, 8192 })
+	{
+		const FIntPoint RasterSize { Size, Size };
+		const TArray<float> Heights = MakeHeights(RasterSize, Size);
+		TArray<float> Result;
+		Result.SetNumUninitialized(Heights.Num());
+
+		double StartTime = FPlatformTime::Seconds();
+		FHeightmapKernels::Steepness({ Heights, RasterSize }, { Result, RasterSize });
+		const double SteepnessTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		const TArray<float> Reference = ReferenceSteepness(Heights, RasterSize);
+		const double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		FHeightmapKernels::GaussianBlur({ Heights, RasterSize }, { Result, RasterSize }, 2.f);
+		const double BlurTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(
+			TEXT("%dx%d: steepness %.1f ms, scalar steepness %.1f ms, gaussian blur %.1f ms"),
+			Size,
+			Size,
+			SteepnessTime * 1000.0,
+			ScalarTime * 1000.0,
+			BlurTime * 1000.0));
+	}
+
+	return true;
+}
@@ -0,0 +1,210 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "HydraulicErosionSolver.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace HydraulicErosionSolverTestLocal
+{
+	// Not a multiple of the tile size, so shifted droplet tiles are clipped on both sides
+	const FIntPoint TestSize { 300, 200 };
+
+	TArray<float> MakeHeights(FIntPoint Size, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<float> Heights;
+		Heights.SetNumUninitialized(Size.X * Size.Y);
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32 X = 0; X < Size.X; X++)
+			{
+				const float Hills = 40.f * FMath::Sin(X * 0.05f) * FMath::Cos(Y * 0.07f);
+				Heights[Y * Size.X + X] = 100.f - X * 0.2f + Hills + Random.FRand();
+			}
+		}
+		return Heights;
+	}
+
+	double Sum(const TArray<float>& Values)
+	{
+		double Result = 0.0;
+		for (const float Value : Values)
+		{
+			Result += Value;
+		}
+		return Result;
+	}
+
+	FHydraulicErosionSettings MakeSettings(EHydraulicErosionSolverMode Mode)
+	{
+		FHydraulicErosionSettings Settings;
+		Settings.Mode = Mode;
+		Settings.Seed = 7;
+		Settings.StartWater = 5.f;
+		Settings.Solubility = 0.1f;
+		Settings.DeltaT = 0.02f;
+		Settings.NumDroplets = 20000;
+		return Settings;
+	}
+}
+
+VSP_TEST(HydraulicErosionSolver, PipesConserveWater, TestsFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 1);
+	FHydraulicErosionSolver Solver({ Heights, TestSize }, MakeSettings(EHydraulicErosionSolverMode::VirtualPipes));
+	const double Water = Sum(Solver.GetWater());
+	Solver.Run(64);
+
+	// Closed edges, no rain and no evaporation
+	VSP_EXPECT_TRUE(FMath::Abs(Sum(Solver.GetWater()) - Water) < 1e-4 * Water);
+	VSP_EXPECT_TRUE(Solver.GetHeight() != Heights);
+	VSP_EXPECT_TRUE(Sum(Solver.GetSediment()) > 0.0);
+
+	return true;
+}
+
+VSP_TEST(HydraulicErosionSolver, PipesConserveTerrain, TestsFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 4);
+	FHydraulicErosionSolver Solver({ Heights, TestSize }, MakeSettings(EHydraulicErosionSolverMode::VirtualPipes));
+	Solver.Run(8);
+
+	// Dissolving and depositing only move material between the terrain and the water,
+	// tracing the sediment back along the flow loses a little of it
+	const double Suspended = Sum(Solver.GetSediment());
+	VSP_EXPECT_TRUE(Suspended > 0.0);
+	VSP_EXPECT_TRUE(FMath::Abs(Sum(Solver.GetHeight()) + Suspended - Sum(Heights)) < 0.01 * Suspended);
+
+	return true;
+}
+
+VSP_TEST(HydraulicErosionSolver, PipesFlowDownhill, TestsFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	// Plane falling along X
+	TArray<float> Heights;
+	Heights.SetNumUninitialized(TestSize.X * TestSize.Y);
+	for (int32 Index = 0; Index < Heights.Num(); Index++)
+	{
+		Heights[Index] = 100.f - (Index % TestSize.X) * 0.5f;
+	}
+
+	FHydraulicErosionSolver Solver({ Heights, TestSize }, MakeSettings(EHydraulicErosionSolverMode::VirtualPipes));
+	Solver.Run(8);
+
+	const FVector2D& Flow = Solver.GetFlow()[TestSize.Y / 2 * TestSize.X + TestSize.X / 2];
+	VSP_EXPECT_TRUE(Flow.X > 0.f);
+	VSP_EXPECT_TRUE(FMath::Abs(Flow.Y) < Flow.X * 1e-3f);
+
+	return true;
+}
+
+VSP_TEST(HydraulicErosionSolver, DeterministicForSeed, TestsFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 2);
+
+	for (const EHydraulicErosionSolverMode Mode :
+		 { EHydraulicErosionSolverMode::VirtualPipes, EHydraulicErosionSolverMode::Droplets })
+	{
+		FHydraulicErosionSettings Settings = MakeSettings(Mode);
+		FHydraulicErosionSolver First({ Heights, TestSize }, Settings);
+		FHydraulicErosionSolver Second({ Heights, TestSize }, Settings);
+		First.Run(4);
+		Second.Run(4);
+
+		VSP_EXPECT_TRUE(First.GetHeight() == Second.GetHeight());
+		VSP_EXPECT_TRUE(First.GetSediment() == Second.GetSediment());
+		VSP_EXPECT_TRUE(First.GetFlow() == Second.GetFlow());
+	}
+
+	FHydraulicErosionSettings Settings = MakeSettings(EHydraulicErosionSolverMode::Droplets);
+	FHydraulicErosionSolver First({ Heights, TestSize }, Settings);
+	Settings.Seed++;
+	FHydraulicErosionSolver Second({ Heights, TestSize }, Settings);
+	First.Run(1);
+	Second.Run(1);
+	VSP_EXPECT_TRUE(First.GetHeight() != Second.GetHeight());
+
+	return true;
+}
+
+VSP_TEST(HydraulicErosionSolver, DropletsCarveAndDeposit, TestsFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	const TArray<float> Heights = MakeHeights(TestSize, 3);
+	FHydraulicErosionSolver Solver({ Heights, TestSize }, MakeSettings(EHydraulicErosionSolverMode::Droplets));
+	Solver.Run(4);
+
+	int32 NumEroded = 0;
+	int32 NumRaised = 0;
+	for (int32 Index = 0; Index < Heights.Num(); Index++)
+	{
+		NumEroded += Solver.GetHeight()[Index] < Heights[Index] ? 1 : 0;
+		NumRaised += Solver.GetHeight()[Index] > Heights[Index] ? 1 : 0;
+	}
+
+	VSP_EXPECT_TRUE(NumEroded > 0);
+	VSP_EXPECT_TRUE(NumRaised > 0);
+	VSP_EXPECT_TRUE(Sum(Solver.GetSediment()) > 0.0);
+	// Droplets never remove more than they carry away or put back
+	VSP_EXPECT_TRUE(Sum(Solver.GetHeight()) <= Sum(Heights));
+	VSP_EXPECT_EQ(Solver.GetWater().Num(), 0);
+
+	return true;
+}
+
+VSP_TEST(HydraulicErosionSolver, Benchmark, BenchmarkFlags)
+{
+	using namespace HydraulicErosionSolverTestLocal;
+
+	for (const int32 Size : { 512, 1024, 2048 })
+	{
+		const FIntPoint RasterSize { Size, Size };
+		const TArray<float> Heights = MakeHeights(RasterSize, Size);
+
+		FHydraulicErosionSolver Pipes({ Heights, RasterSize }, MakeSettings(EHydraulicErosionSolverMode::VirtualPipes));
+		double StartTime = FPlatformTime::Seconds();
+		Pipes.Run(16);
+		const double PipesTime = FPlatformTime::Seconds() - StartTime;
+
+		FHydraulicErosionSettings Settings = MakeSettings(EHydraulicErosionSolverMode::Droplets);
+		Settings.NumDroplets = 70000;
+		FHydraulicErosionSolver Droplets({ Heights, RasterSize }, Settings);
+		StartTime = FPlatformTime::Seconds();
+		Droplets.Run(1);
+		const double DropletsTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(
+			TEXT("%dx%d: 16 pipe iterations %.1f ms, 70000 droplets %.1f ms"),
+			Size,
+			Size,
+			PipesTime * 1000.0,
+			DropletsTime * 1000.0));
+	}
+
+	return true;
+}
@@ -0,0 +1,245 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "Algo/Reverse.h"
+#include "TerrainGeneratorUtils.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace PolygonTriangulationTestLocal
+{
+	// Wobbly closed outline like the ones sampled from terraformer splines, counter-clockwise around +Z
+	TArray<FVector> MakeOutline(int32 NumVertices, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<FVector> Vertices;
+		Vertices.SetNumUninitialized(NumVertices);
+		for (int32 Index = 0; Index < NumVertices; Index++)
+		{
+			const float Angle = 2.f * PI * Index / NumVertices;
+			const float Radius = 1000.f + 300.f * FMath::Sin(7.f * Angle) + 30.f * FMath::Sin(131.f * Angle)
+				+ Random.FRandRange(0.f, 10.f);
+			Vertices[Index] = FVector { Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.f };
+		}
+		return Vertices;
+	}
+
+	TArray<FVector2D> To2D(const TArray<FVector>& Vertices)
+	{
+		TArray<FVector2D> Points;
+		Points.Reserve(Vertices.Num());
+		for (const FVector& Vertex : Vertices)
+		{
+			Points.Add(FVector2D { Vertex });
+		}
+		return Points;
+	}
+
+	double RingArea(TArrayView<const FVector2D> Points, int32 Start, int32 End)
+	{
+		double Area = 0.0;
+		for (int32 I = Start, J = End - 1; I < End; J = I++)
+		{
+			Area += double(Points[J].X) * Points[I].Y - double(Points[I].X) * Points[J].Y;
+		}
+		return Area / 2.0;
+	}
+
+	// Sum of the triangle areas, fails on indices out of range and clockwise triangles
+	bool SumTriangleAreas(TArrayView<const FVector2D> Points, const TArray<int32>& Triangles, double& OutArea)
+	{
+		OutArea = 0.0;
+		if (Triangles.Num() % 3 != 0)
+		{
+			return false;
+		}
+		for (int32 Index = 0; Index < Triangles.Num(); Index += 3)
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (!Points.IsValidIndex(Triangles[Index + Corner]))
+				{
+					return false;
+				}
+			}
+			const FVector2D& A = Points[Triangles[Index]];
+			const FVector2D& B = Points[Triangles[Index + 1]];
+			const FVector2D& C = Points[Triangles[Index + 2]];
+			const double Area = (double(B.X) - A.X) * (double(C.Y) - A.Y) - (double(B.Y) - A.Y) * (double(C.X) - A.X);
+			if (Area < 0.0)
+			{
+				return false;
+			}
+			OutArea += Area / 2.0;
+		}
+		return true;
+	}
+}
+
+VSP_TEST(PolygonTriangulation, ConvexAndConcave, TestsFlags)
+{
+	using namespace PolygonTriangulationTestLocal;
+
+	TArray<FVector2D> Star;
+	for (int32 Index = 0; Index < 10; Index++)
+	{
+		const float Angle = 2.f * PI * Index / 10;
+		Star.Add(FVector2D { FMath::Cos(Angle), FMath::Sin(Angle) } * (Index % 2 ? 40.f : 100.f));
+	}
+	const TArray<FVector2D> Square { { 0.f, 0.f }, { 10.f, 0.f }, { 10.f, 10.f }, { 0.f, 10.f } };
+
+	for (const TArray<FVector2D>& Polygon : { Square, Star })
+	{
+		TArray<FVector2D> Reversed = Polygon;
+		Algo::Reverse(Reversed);
+
+		for (const TArray<FVector2D>& Points : { Polygon, Reversed })
+		{
+			const TArray<int32> Triangles = FPolygonTriangulationUtils::TriangulatePolygon2D(Points);
+			double Area;
+			VSP_EXPECT_TRUE(SumTriangleAreas(Points, Triangles, Area));
+			VSP_EXPECT_EQ(Triangles.Num(), 3 * (Points.Num() - 2));
+			VSP_EXPECT_TRUE(FMath::IsNearlyEqual(Area, FMath::Abs(RingArea(Points, 0, Points.Num())), 1e-3));
+		}
+	}
+
+	return true;
+}
+
+VSP_TEST(PolygonTriangulation, Holes, TestsFlags)
+{
+	using namespace PolygonTriangulationTestLocal;
+
+	const TArray<FVector2D> Points {
+		{ 0.f, 0.f }, { 10.f, 0.f }, { 10.f, 10.f }, { 0.f, 10.f },
+		{ 2.f, 2.f }, { 4.f, 2.f }, { 4.f, 4.f }, { 2.f, 4.f },
+		{ 6.f, 6.f }, { 6.f, 8.f }, { 8.f, 8.f }, { 8.f, 6.f }
+	};
+	const TArray<int32> HoleStarts { 4, 8 };
+
+	const TArray<int32> Triangles = FPolygonTriangulationUtils::TriangulatePolygon2D(Points, HoleStarts);
+	double Area;
+	VSP_EXPECT_TRUE(SumTriangleAreas(Points, Triangles, Area));
+	// Every hole adds two bridge edges
+	VSP_EXPECT_EQ(Triangles.Num(), 3 * (Points.Num() + 2 * HoleStarts.Num() - 2));
+	VSP_EXPECT_TRUE(FMath::IsNearlyEqual(Area, 92.0, 1e-6));
+
+	return true;
+}
+
+VSP_TEST(PolygonTriangulation, Degenerate, TestsFlags)
+{
+	using namespace PolygonTriangulationTestLocal;
+
+	VSP_EXPECT_EQ(FPolygonTriangulationUtils::TriangulatePolygon2D(TArray<FVector2D> { { 0.f, 0.f } }).Num(), 0);
+
+	// Duplicate and collinear points are dropped, the closing duplicate too
+	const TArray<FVector2D> Points {
+		{ 0.f, 0.f }, { 5.f, 0.f }, { 5.f, 0.f }, { 10.f, 0.f }, { 10.f, 10.f }, { 0.f, 10.f }, { 0.f, 0.f }
+	};
+	const TArray<int32> Triangles = FPolygonTriangulationUtils::TriangulatePolygon2D(Points);
+	double Area;
+	VSP_EXPECT_TRUE(SumTriangleAreas(Points, Triangles, Area));
+	VSP_EXPECT_TRUE(FMath::IsNearlyEqual(Area, 100.0, 1e-6));
+
+	return true;
+}
+
+VSP_TEST(PolygonTriangulation, MatchesRecursive, TestsFlags)
+{
+	using namespace PolygonTriangulationTestLocal;
+
+	for (const int32 NumVertices : { 3, 4, 16, 64, 200 })
+	{
+		TArray<FVector> Vertices = MakeOutline(NumVertices, NumVertices);
+		// The previous triangulation wound the triangles like the outline, also for clockwise outlines
+		for (const bool bReverse : { false, true })
+		{
+			if (bReverse)
+			{
+				Algo::Reverse(Vertices);
+			}
+			const TArray<FVector2D> Points = To2D(Vertices);
+			const double OutlineArea = RingArea(Points, 0, Points.Num());
+
+			TArray<int32> Expected;
+			FPolygonTriangulationUtils::TriangulatePolygonRecursive(Vertices, Expected);
+			TArray<int32> Actual;
+			FPolygonTriangulationUtils::TriangulatePolygon(Vertices, Actual);
+
+			VSP_EXPECT_EQ(Actual.Num(), Expected.Num());
+			VSP_EXPECT_EQ(Actual.Num(), 3 * (NumVertices - 2));
+
+			// Triangle areas are signed in the outline plane, so both sums equal the outline area
+			for (const TArray<int32>* Triangles : { &Expected, &Actual })
+			{
+				double Area = 0.0;
+				for (int32 Index = 0; Index < Triangles->Num(); Index += 3)
+				{
+					const FVector& A = Vertices[(*Triangles)[Index]];
+					const FVector& B = Vertices[(*Triangles)[Index + 1]];
+					const FVector& C = Vertices[(*Triangles)[Index + 2]];
+					Area += ((B - A) ^ (C - A)).Z / 2.0;
+				}
+				VSP_EXPECT_TRUE(FMath::IsNearlyEqual(Area, OutlineArea, FMath::Abs(OutlineArea) * 1e-4));
+			}
+		}
+	}
+
+	return true;
+}
+
+VSP_TEST(PolygonTriangulation, Benchmark, BenchmarkFlags)
+{
+	using namespace PolygonTriangulationTestLocal;
+
+	// The recursive triangulation recurses once per clipped ear, keep it to small outlines
+	for (const int32 NumVertices : { 250, 500, 1000 })
+	{
+		const TArray<FVector> Vertices = MakeOutline(NumVertices, NumVertices);
+		TArray<int32> Triangles;
+
+		double StartTime = FPlatformTime::Seconds();
+		FPolygonTriangulationUtils::TriangulatePolygonRecursive(Vertices, Triangles);
+		const double RecursiveTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		FPolygonTriangulationUtils::TriangulatePolygon(Vertices, Triangles);
+		const double EarcutTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(
+			TEXT("%d vertices: recursive %.2f ms, ear clipping %.2f ms"),
+			NumVertices,
+			RecursiveTime * 1000.0,
+			EarcutTime * 1000.0));
+	}
+
+	for (const int32 NumVertices : { 10000, 50000, 100000 })
+	{
+		const TArray<FVector2D> Points = To2D(MakeOutline(NumVertices, NumVertices));
+
+		const double StartTime = FPlatformTime::Seconds();
+		const TArray<int32> Triangles = FPolygonTriangulationUtils::TriangulatePolygon2D(Points);
+		const double EarcutTime = FPlatformTime::Seconds() - StartTime;
+
+		VSP_EXPECT_EQ(Triangles.Num(), 3 * (NumVertices - 2));
+		AddInfo(FString::Printf(TEXT("%d vertices: ear clipping %.2f ms"), NumVertices, EarcutTime * 1000.0));
+	}
+
+	return true;
+}
@@ -0,0 +1,218 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "SignedDistanceField2D.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace SignedDistanceField2DTestLocal
+{
+	// Random discs, values >= 128 inside
+	TArray<uint8> MakeMask(int32 Width, int32 Height, int32 NumDiscs, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<uint8> Mask;
+		Mask.Init(0, Width * Height);
+
+		const float MaxRadius = FMath::Max(Width, Height) * 0.1f;
+		for (int32 Disc = 0; Disc < NumDiscs; Disc++)
+		{
+			const FVector2D Center { Random.FRandRange(0.f, Width), Random.FRandRange(0.f, Height) };
+			const float Radius = Random.FRandRange(1.f, MaxRadius);
+			for (int32 Y = 0; Y < Height; Y++)
+			{
+				for (int32 X = 0; X < Width; X++)
+				{
+					if (FVector2D::DistSquared(FVector2D(X, Y), Center) <= Radius * Radius)
+						Mask[Y * Width + X] = 255;
+				}
+			}
+		}
+		return Mask;
+	}
+
+	float BruteForceDistance(const TArray<uint8>& Mask, int32 Width, int32 Height, int32 X, int32 Y)
+	{
+		const bool bAbove = Mask[Y * Width + X] >= 128;
+		float MinSquared = TNumericLimits<float>::Max();
+		for (int32 OtherY = 0; OtherY < Height; OtherY++)
+		{
+			for (int32 OtherX = 0; OtherX < Width; OtherX++)
+			{
+				if ((Mask[OtherY * Width + OtherX] >= 128) != bAbove)
+					MinSquared = FMath::Min<float>(MinSquared, FMath::Square(OtherX - X) + FMath::Square(OtherY - Y));
+			}
+		}
+		const float Distance = FMath::Sqrt(MinSquared);
+		return bAbove ? Distance : -Distance;
+	}
+}
+
+VSP_TEST(SignedDistanceField2D, ExactDistance, TestsFlags)
+{
+	using namespace SignedDistanceField2DTestLocal;
+
+	constexpr int32 Width = 61;
+	constexpr int32 Height = 47;
+	const TArray<uint8> Mask = MakeMask(Width, Height, 6, 1);
+	const TArray<float> Distances = FSignedDistanceField2D { 1, Width, Height }.GenerateFloat(Mask);
+
+	float MaxError = 0.f;
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			const float Expected = BruteForceDistance(Mask, Width, Height, X, Y);
+			MaxError = FMath::Max(MaxError, FMath::Abs(Distances[Y * Width + X] - Expected));
+		}
+	}
+	VSP_EXPECT_TRUE(MaxError < KINDA_SMALL_NUMBER);
+
+	return true;
+}
+
+VSP_TEST(SignedDistanceField2D, MatchesSSEDT, TestsFlags)
+{
+	using namespace SignedDistanceField2DTestLocal;
+
+	constexpr int32 Size = 256;
+	constexpr int32 Scale = 3;
+	TArray<uint8> Mask = MakeMask(Size, Size, 20, 2);
+	FSignedDistanceField2D SDF { Scale, Size, Size };
+	const TArray<uint8> Exact = SDF.Generate(Mask);
+	const TArray<uint8> SSEDT = SDF.GenerateSSEDT(Mask);
+
+	int32 MaxDifference = 0;
+	int32 NumDifferent = 0;
+	bool bNeverFarther = true;
+	for (int32 Index = 0; Index < Exact.Num(); Index++)
+	{
+		const int32 Difference = FMath::Abs(Exact[Index] - SSEDT[Index]);
+		MaxDifference = FMath::Max(MaxDifference, Difference);
+		NumDifferent += Difference > 0 ? 1 : 0;
+		// 8SSEDT may miss the nearest pixel but never finds a nearer one
+		bNeverFarther &= FMath::Abs(Exact[Index] - 128) <= FMath::Abs(SSEDT[Index] - 128);
+	}
+
+	AddInfo(FString::Printf(TEXT("%d pixels differ from 8SSEDT, max difference %d"), NumDifferent, MaxDifference));
+	VSP_EXPECT_TRUE(bNeverFarther);
+	// 8SSEDT error is below 2 pixels for the sparse discs
+	VSP_EXPECT_TRUE(MaxDifference <= 2 * Scale);
+
+	return true;
+}
+
+VSP_TEST(SignedDistanceField2D, UniformMask, TestsFlags)
+{
+	constexpr int32 Width = 17;
+	constexpr int32 Height = 9;
+
+	for (const int32 Scale : { 1, 3, 300 })
+	{
+		FSignedDistanceField2D SDF { Scale, Width, Height };
+
+		TArray<uint8> BelowMask;
+		BelowMask.Init(0, Width * Height);
+		const TArray<uint8> Below = SDF.Generate(BelowMask);
+		VSP_EXPECT_TRUE(Below.FilterByPredicate([](uint8 Value) { return Value != 0; }).Num() == 0);
+
+		TArray<uint8> AboveMask;
+		AboveMask.Init(255, Width * Height);
+		const TArray<uint8> Above = SDF.Generate(AboveMask);
+		VSP_EXPECT_TRUE(Above.FilterByPredicate([](uint8 Value) { return Value != 255; }).Num() == 0);
+	}
+
+	return true;
+}
+
+VSP_TEST(SignedDistanceField2D, TiledMatchesFull, TestsFlags)
+{
+	using namespace SignedDistanceField2DTestLocal;
+
+	constexpr int32 Width = 300;
+	constexpr int32 Height = 200;
+	constexpr int32 MaxDistance = 20;
+	const TArray<uint8> Mask = MakeMask(Width, Height, 15, 3);
+	const FSignedDistanceField2D SDF { 1, Width, Height };
+	const TArray<float> Full = SDF.GenerateFloat(Mask);
+
+	TArray<float> Tiled;
+	Tiled.Init(0.f, Width * Height);
+	SDF.GenerateTiled(
+		64,
+		MaxDistance,
+		[&Mask](const FIntRect& Rect, TArray<uint8>& OutMask)
+		{
+			OutMask.Reset(Rect.Area());
+			for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+				OutMask.Append(Mask.GetData() + Y * Width + Rect.Min.X, Rect.Width());
+		},
+		[&Tiled](const FIntRect& Rect, const TArray<float>& Distances)
+		{
+			for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+			{
+				FMemory::Memcpy(
+					Tiled.GetData() + Y * Width + Rect.Min.X,
+					Distances.GetData() + (Y - Rect.Min.Y) * Rect.Width(),
+					Rect.Width() * sizeof(float));
+			}
+		});
+
+	const float MaxDistanceFloat = MaxDistance;
+	float MaxError = 0.f;
+	for (int32 Index = 0; Index < Full.Num(); Index++)
+	{
+		const float Expected = FMath::Clamp(Full[Index], -MaxDistanceFloat, MaxDistanceFloat);
+		MaxError = FMath::Max(MaxError, FMath::Abs(Tiled[Index] - Expected));
+	}
+	VSP_EXPECT_TRUE(MaxError < KINDA_SMALL_NUMBER);
+
+	return true;
+}
+
+VSP_TEST(SignedDistanceField2D, Benchmark, BenchmarkFlags)
+{
+	using namespace SignedDistanceField2DTestLocal;
+
+	for (const int32 Size : { 512, 1024, 2048, 4096 })
+	{
+		TArray<uint8> Mask = MakeMask(Size, Size, 64, Size);
+		FSignedDistanceField2D SDF { 3, Size, Size };
+
+		double StartTime = FPlatformTime::Seconds();
+		SDF.Generate(Mask);
+		const double ExactTime = FPlatformTime::Seconds() - StartTime;
+
+		// legacy implementation is too slow for the biggest size
+		double SSEDTTime = 0.0;
+		if (Size <= 2048)
+		{
+			StartTime = FPlatformTime::Seconds();
+			SDF.GenerateSSEDT(Mask);
+			SSEDTTime = FPlatformTime::Seconds() - StartTime;
+		}
+
+		AddInfo(FString::Printf(
+			TEXT("%dx%d: exact EDT %.1f ms, 8SSEDT %.1f ms"),
+			Size,
+			Size,
+			ExactTime * 1000.0,
+			SSEDTTime * 1000.0));
+	}
+
+	return true;
+}
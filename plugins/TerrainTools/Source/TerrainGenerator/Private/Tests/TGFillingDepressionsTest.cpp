@@ -0,0 +1,201 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "Editor.h"
+#include "EngineUtils.h"
+#include "Generators/TGFillingDepressions.h"
+#include "Generators/TGPriorityFlood.h"
+#include "Landscape.h"
+#include "LandscapeEdit.h"
+#include "LandscapeInfo.h"
+#include "Misc/FileHelper.h"
+#include "TerrainGeneratorUtils.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace TGFillingDepressionsTestLocal
+{
+	// Rolling hills with noise, lots of small pits and a few big basins
+	TArray<float> MakeTerrain(int32 Size, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<float> Height;
+		Height.SetNumUninitialized(Size * Size);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const float Hills = FMath::Sin(X * 0.05f) * FMath::Cos(Y * 0.07f) * 5000.f;
+				Height[Y * Size + X] = 10000.f + Hills + Random.FRandRange(0.f, 500.f);
+			}
+		}
+		return Height;
+	}
+
+	// -TGBenchmarkHeightmap=<square r16 file> or the first landscape of the editor world
+	bool LoadRealTerrain(TArray<float>& OutHeight, FIntPoint& OutSize, FString& OutSource)
+	{
+		TArray<uint16> Heights;
+		FIntPoint Size = FIntPoint::ZeroValue;
+
+		FString RawPath;
+		TArray<uint8> Raw;
+		if (FParse::Value(FCommandLine::Get(), TEXT("TGBenchmarkHeightmap="), RawPath)
+			&& FFileHelper::LoadFileToArray(Raw, *RawPath))
+		{
+			const int32 SizeXY = FMath::FloorToInt(FMath::Sqrt(Raw.Num() / 2.f));
+			Size = { SizeXY, SizeXY };
+			Heights.SetNumUninitialized(SizeXY * SizeXY);
+			FMemory::Memcpy(Heights.GetData(), Raw.GetData(), Heights.Num() * sizeof(uint16));
+			OutSource = RawPath;
+		}
+		else if (UWorld* World = GEditor ? GEditor->GetEditorWorldContext().World() : nullptr)
+		{
+			for (TActorIterator<ALandscape> It(World); It && Heights.Num() == 0; ++It)
+			{
+				ULandscapeInfo* LandscapeInfo = It->GetLandscapeInfo();
+				int32 MinX, MinY, MaxX, MaxY;
+				if (LandscapeInfo && LandscapeInfo->GetLandscapeExtent(MinX, MinY, MaxX, MaxY))
+				{
+					Size = { MaxX - MinX + 1, MaxY - MinY + 1 };
+					Heights.SetNumZeroed(Size.X * Size.Y);
+					FLandscapeEditDataInterface LandscapeEdit(LandscapeInfo);
+					LandscapeEdit.GetHeightDataFast(MinX, MinY, MaxX, MaxY, Heights.GetData(), 0);
+					OutSource = It->GetActorLabel();
+				}
+			}
+		}
+
+		if (Heights.Num() == 0 || Size.X != Size.Y)
+			return false;
+
+		OutSize = Size;
+		OutHeight = FHeightmapUtils::UnpackHeightToFloat(Heights);
+		return true;
+	}
+
+	TArray<float> Fill(
+		const TArray<float>& Height,
+		FIntPoint Size,
+		ETGFillingDepressionsMode Mode,
+		int32 TileSize = 512)
+	{
+		FTGTerrainInfo TerrainInfo;
+		TerrainInfo.DecodedHeight = Height;
+		TerrainInfo.Size = Size;
+
+		UTGFillingDepressions* Generator = NewObject<UTGFillingDepressions>();
+		Generator->Mode = Mode;
+		Generator->TileSize = TileSize;
+		return Generator->FillDepressions(TerrainInfo);
+	}
+
+	float MaxDifference(const TArray<float>& A, const TArray<float>& B)
+	{
+		float Result = 0.f;
+		for (int32 Index = 0; Index < A.Num(); Index++)
+			Result = FMath::Max(Result, FMath::Abs(A[Index] - B[Index]));
+		return Result;
+	}
+
+	// Every cell has a strictly lower neighbor or lies on the border
+	bool IsDrained(const TArray<float>& Elevation, int32 Size)
+	{
+		for (int32 Y = 1; Y < Size - 1; Y++)
+		{
+			for (int32 X = 1; X < Size - 1; X++)
+			{
+				bool bHasLower = false;
+				for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+				{
+					for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+						bHasLower |= Elevation[(Y + OffsetY) * Size + X + OffsetX] < Elevation[Y * Size + X];
+				}
+				if (!bHasLower)
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+VSP_TEST(TGFillingDepressions, PriorityFloodMatchesPlanchonDarboux, TestsFlags)
+{
+	using namespace TGFillingDepressionsTestLocal;
+
+	const TArray<float> Height = MakeTerrain(200, 1);
+	const FIntPoint Size { 200, 200 };
+	const TArray<float> Reference = Fill(Height, Size, FDM_PlanchonDarboux);
+
+	VSP_EXPECT_EQ(MaxDifference(Fill(Height, Size, FDM_PriorityFlood), Reference), 0.f);
+	VSP_EXPECT_EQ(MaxDifference(Fill(Height, Size, FDM_PriorityFloodTiled, 32), Reference), 0.f);
+	VSP_EXPECT_EQ(MaxDifference(Fill(Height, Size, FDM_PriorityFloodTiled, 57), Reference), 0.f);
+
+	return true;
+}
+
+VSP_TEST(TGFillingDepressions, FilledAreasDrain, TestsFlags)
+{
+	using namespace TGFillingDepressionsTestLocal;
+
+	constexpr int32 Size = 64;
+	TArray<float> Terrain = MakeTerrain(Size, 2);
+	// coarse steps keep the flat gradient below the terrain steps, natural flats appear as well
+	for (float& Height : Terrain)
+		Height = FMath::RoundToFloat(Height / 1000.f) * 1000.f;
+
+	const TArray<float> Epsilon = Fill(Terrain, { Size, Size }, FDM_PriorityFloodEpsilon);
+	VSP_EXPECT_TRUE(IsDrained(Epsilon, Size));
+
+	TArray<float> Flats = Fill(Terrain, { Size, Size }, FDM_PriorityFlood);
+	VSP_EXPECT_TRUE(!IsDrained(Flats, Size));
+	FTGPriorityFlood::ResolveFlats(Flats, Size, Size, MIN_flt, 1.f);
+	VSP_EXPECT_TRUE(IsDrained(Flats, Size));
+
+	return true;
+}
+
+VSP_TEST(TGFillingDepressions, Benchmark, BenchmarkFlags)
+{
+	using namespace TGFillingDepressionsTestLocal;
+
+	TArray<float> Height;
+	FIntPoint Size;
+	FString Source;
+	if (!LoadRealTerrain(Height, Size, Source))
+	{
+		Height = MakeTerrain(2048, 3);
+		Size = { 2048, 2048 };
+		Source = TEXT("synthetic terrain");
+	}
+
+	const auto Measure = [this, &Height, &Size](const TCHAR* Name, ETGFillingDepressionsMode Mode)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TArray<float> Result = Fill(Height, Size, Mode);
+		AddInfo(FString::Printf(TEXT("%s: %.1f ms"), Name, (FPlatformTime::Seconds() - StartTime) * 1000.0));
+		return Result;
+	};
+
+	AddInfo(FString::Printf(TEXT("%s, %dx%d"), *Source, Size.X, Size.Y));
+	const TArray<float> Reference = Measure(TEXT("Planchon-Darboux"), FDM_PlanchonDarboux);
+	VSP_EXPECT_EQ(MaxDifference(Measure(TEXT("Priority-Flood"), FDM_PriorityFlood), Reference), 0.f);
+	VSP_EXPECT_EQ(MaxDifference(Measure(TEXT("Priority-Flood tiled"), FDM_PriorityFloodTiled), Reference), 0.f);
+	Measure(TEXT("Priority-Flood+Epsilon"), FDM_PriorityFloodEpsilon);
+
+	return true;
+}
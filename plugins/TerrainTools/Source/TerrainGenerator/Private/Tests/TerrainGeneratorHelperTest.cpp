@@ -0,0 +1,187 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "TerrainGeneratorHelper.h"
+#include "VSPTests.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace TerrainGeneratorHelperTestLocal
+{
+	TArray<FColor> MakeImage(FIntPoint Size, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<FColor> Image;
+		Image.SetNumUninitialized(Size.X * Size.Y);
+		for (FColor& Pixel : Image)
+		{
+			Pixel.R = (uint8)Random.RandHelper(256);
+			Pixel.G = (uint8)Random.RandHelper(256);
+			Pixel.B = (uint8)Random.RandHelper(256);
+			Pixel.A = (uint8)Random.RandHelper(256);
+		}
+		return Image;
+	}
+
+	// Block average in double precision, rounded to nearest
+	TArray<FColor> ReferenceDownsample(const TArray<FColor>& Image, FIntPoint Size, int32 Kernel)
+	{
+		const FIntPoint OutSize = Size / Kernel;
+		TArray<FColor> Result;
+		Result.SetNumUninitialized(OutSize.X * OutSize.Y);
+		for (int32 Y = 0; Y < OutSize.Y; Y++)
+		{
+			for (int32 X = 0; X < OutSize.X; X++)
+			{
+				double Sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+				for (int32 KernelY = 0; KernelY < Kernel; KernelY++)
+				{
+					for (int32 KernelX = 0; KernelX < Kernel; KernelX++)
+					{
+						const FColor& Pixel = Image[(Y * Kernel + KernelY) * Size.X + X * Kernel + KernelX];
+						Sum[0] += Pixel.R;
+						Sum[1] += Pixel.G;
+						Sum[2] += Pixel.B;
+						Sum[3] += Pixel.A;
+					}
+				}
+				const double Count = Kernel * Kernel;
+				FColor& Average = Result[Y * OutSize.X + X];
+				Average.R = (uint8)FMath::FloorToInt(Sum[0] / Count + 0.5);
+				Average.G = (uint8)FMath::FloorToInt(Sum[1] / Count + 0.5);
+				Average.B = (uint8)FMath::FloorToInt(Sum[2] / Count + 0.5);
+				Average.A = (uint8)FMath::FloorToInt(Sum[3] / Count + 0.5);
+			}
+		}
+		return Result;
+	}
+
+	// Per pixel kernel arrays of the previous implementation, kept as the benchmark baseline
+	TArray<FColor> PerPixelDownsample(const TArray<FColor>& Image, FIntPoint Size, int32 Kernel)
+	{
+		const FIntPoint OutSize = Size / Kernel;
+		TArray<FColor> Result;
+		Result.SetNumUninitialized(OutSize.X * OutSize.Y);
+		for (int32 Index = 0; Index < Result.Num(); Index++)
+		{
+			const int32 X = Index % OutSize.X;
+			const int32 Y = Index / OutSize.X;
+			TArray<FColor> KernelColors;
+			KernelColors.Init(FColor(0, 0, 0, 255), Kernel * Kernel);
+			for (int32 KernelY = 0; KernelY < Kernel; KernelY++)
+			{
+				for (int32 KernelX = 0; KernelX < Kernel; KernelX++)
+				{
+					KernelColors[KernelY * Kernel + KernelX] =
+						Image[(Y * Kernel + KernelY) * Size.X + X * Kernel + KernelX];
+				}
+			}
+
+			int32 Sum[4] = { 0, 0, 0, 0 };
+			for (const FColor& Pixel : KernelColors)
+			{
+				Sum[0] += Pixel.R;
+				Sum[1] += Pixel.G;
+				Sum[2] += Pixel.B;
+				Sum[3] += Pixel.A;
+			}
+			const int32 Count = KernelColors.Num();
+			Result[Index].R = (uint8)(Sum[0] / Count);
+			Result[Index].G = (uint8)(Sum[1] / Count);
+			Result[Index].B = (uint8)(Sum[2] / Count);
+			Result[Index].A = (uint8)(Sum[3] / Count);
+		}
+		return Result;
+	}
+}
+
+VSP_TEST(TerrainGeneratorHelper, DownsampleMatchesReference, TestsFlags)
+{
+	using namespace TerrainGeneratorHelperTestLocal;
+
+	// Sizes are not multiples of the kernels, the partial edge blocks are dropped
+	const FIntPoint Size { 259, 131 };
+	const TArray<FColor> Image = MakeImage(Size, 7);
+
+	for (const int32 Kernel : { 1, 2, 3, 4, 8 })
+	{
+		const FIntPoint OutSize = UTerrainGeneratorHelper::GetDownsampledSize(Size, Kernel);
+		VSP_EXPECT_TRUE(OutSize == Size / Kernel);
+
+		TArray<FColor> Result;
+		Result.SetNumZeroed(OutSize.X * OutSize.Y);
+		UTerrainGeneratorHelper::DownsampleTextureData(Image, Size, Kernel, Result);
+		VSP_EXPECT_TRUE(Result == ReferenceDownsample(Image, Size, Kernel));
+	}
+
+	// Array overload, the height is derived from the number of pixels
+	const TArray<FColor> Downsampled = UTerrainGeneratorHelper::DownsampleTextureData(Image, Size.X, 4);
+	VSP_EXPECT_TRUE(Downsampled == ReferenceDownsample(Image, Size, 4));
+	VSP_EXPECT_TRUE(UTerrainGeneratorHelper::DownsampleTextureData(Image, Size.X, 1) == Image);
+
+	return true;
+}
+
+VSP_TEST(TerrainGeneratorHelper, DownsampleKeepsConstantImage, TestsFlags)
+{
+	const FIntPoint Size { 64, 32 };
+	const FColor Color(10, 200, 255, 3);
+	TArray<FColor> Image;
+	Image.Init(Color, Size.X * Size.Y);
+
+	const TArray<FColor> Result = UTerrainGeneratorHelper::DownsampleTextureData(Image, Size.X, 8);
+	VSP_EXPECT_EQ(Result.Num(), 8 * 4);
+	VSP_EXPECT_TRUE(Result.FilterByPredicate([&](const FColor& Pixel) { return Pixel != Color; }).Num() == 0);
+
+	return true;
+}
+
+VSP_TEST(TerrainGeneratorHelper, DownsampleBenchmark, BenchmarkFlags)
+{
+	using namespace TerrainGeneratorHelperTestLocal;
+
+	for (const int32 Size : { 1024, 2048, 4096 })
+	{
+		const FIntPoint ImageSize { Size, Size };
+		const TArray<FColor> Image = MakeImage(ImageSize, Size);
+
+		for (const int32 Kernel : { 2, 8 })
+		{
+			const FIntPoint OutSize = UTerrainGeneratorHelper::GetDownsampledSize(ImageSize, Kernel);
+			TArray<FColor> Result;
+			Result.SetNumUninitialized(OutSize.X * OutSize.Y);
+
+			double StartTime = FPlatformTime::Seconds();
+			UTerrainGeneratorHelper::DownsampleTextureData(Image, ImageSize, Kernel, Result);
+			const double DownsampleTime = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			const TArray<FColor> Baseline = PerPixelDownsample(Image, ImageSize, Kernel);
+			const double BaselineTime = FPlatformTime::Seconds() - StartTime;
+
+			AddInfo(FString::Printf(
+				TEXT("%dx%d kernel %d: downsample %.1f ms, per pixel arrays %.1f ms"),
+				Size,
+				Size,
+				Kernel,
+				DownsampleTime * 1000.0,
+				BaselineTime * 1000.0));
+		}
+	}
+
+	return true;
+}
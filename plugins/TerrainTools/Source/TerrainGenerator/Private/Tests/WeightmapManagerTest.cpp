@@ -0,0 +1,178 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#include "Generators/TGDistanceField2D.h"
+#include "Generators/TGFillingDepressions.h"
+#include "Generators/TGGeneratorGraph.h"
+#include "Generators/TGSteepness.h"
+#include "VSPTests.h"
+#include "WeightmapManager.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+
+namespace WeightmapManagerTestLocal
+{
+	constexpr int32 Size = 256;
+
+	TArray<float> MakeHeight()
+	{
+		FRandomStream Random(1);
+		TArray<float> Height;
+		Height.SetNumUninitialized(Size * Size);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const float Hills = FMath::Sin(X * 0.05f) * FMath::Cos(Y * 0.07f) * 5000.f;
+				Height[Y * Size + X] = 10000.f + Hills + Random.FRandRange(0.f, 500.f);
+			}
+		}
+		return Height;
+	}
+
+	// Objects tagged Rocks are above the terrain inside a disc
+	FTGDepthCapture MakeDepth()
+	{
+		FTGDepthCapture Depth;
+		Depth.TerrainDepth.Init(1000.f, Size * Size);
+		TArray<float>& Rocks = Depth.ObjectsDepth.Add(TEXT("Rocks"));
+		Rocks.Init(2000.f, Size * Size);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				if (FMath::Square(X - 100) + FMath::Square(Y - 80) < 30 * 30)
+					Rocks[Y * Size + X] = 500.f;
+			}
+		}
+		return Depth;
+	}
+
+	TMap<FName, UTGBaseLayer*> MakeGenerators()
+	{
+		UTGFillingDepressions* Lakes = NewObject<UTGFillingDepressions>();
+		Lakes->Mode = FDM_PriorityFlood;
+
+		TMap<FName, UTGBaseLayer*> Generators;
+		Generators.Add(TEXT("Slope"), NewObject<UTGSteepness>());
+		Generators.Add(TEXT("Rocks"), NewObject<UTGDistanceField>());
+		Generators.Add(TEXT("Lakes"), Lakes);
+		Generators.Add(TEXT("Grass"), NewObject<UTGDistanceField>());
+		return Generators;
+	}
+}
+
+VSP_TEST(WeightmapManager, GeneratorGraphWaves, TestsFlags)
+{
+	TMap<FName, UTGBaseLayer*> Generators;
+	for (const TCHAR* Layer : { TEXT("A"), TEXT("B"), TEXT("C"), TEXT("D") })
+		Generators.Add(Layer, NewObject<UTGSteepness>());
+	Generators[TEXT("B")]->DependsOn = { TEXT("A") };
+	Generators[TEXT("C")]->DependsOn = { TEXT("B"), TEXT("D") };
+
+	FTGGeneratorGraph Graph;
+	FString Error;
+	VSP_EXPECT_TRUE(Graph.Build(Generators, Error));
+
+	const TArray<TArray<FName>> Expected = { { TEXT("A"), TEXT("D") }, { TEXT("B") }, { TEXT("C") } };
+	VSP_EXPECT_TRUE(Graph.GetWaves() == Expected);
+
+	Generators[TEXT("A")]->DependsOn = { TEXT("C") };
+	VSP_EXPECT_TRUE(!Graph.Build(Generators, Error));
+	VSP_EXPECT_TRUE(Graph.GetWaves().Num() == 0);
+
+	Generators[TEXT("A")]->DependsOn = { TEXT("Missing") };
+	VSP_EXPECT_TRUE(!Graph.Build(Generators, Error));
+
+	return true;
+}
+
+VSP_TEST(WeightmapManager, HeadlessMatchesSequential, TestsFlags)
+{
+	using namespace WeightmapManagerTestLocal;
+
+	const TArray<float> Height = MakeHeight();
+	const FTGDepthCapture Depth = MakeDepth();
+	const TMap<FName, UTGBaseLayer*> Generators = MakeGenerators();
+
+	const TArray<uint8> RocksMask = Depth.MakeObjectsMask(TEXT("Rocks"));
+	VSP_EXPECT_EQ(RocksMask.Num(), Size * Size);
+	VSP_EXPECT_EQ(RocksMask[80 * Size + 100], 255);
+	VSP_EXPECT_EQ(RocksMask[0], 0);
+	VSP_EXPECT_EQ(Depth.MakeObjectsMask(TEXT("Grass")).Num(), 0);
+
+	const TMap<FName, TArray<uint8>> Weights =
+		AWeightmapManager::GenerateWeights(Generators, Height, { Size, Size }, Depth, false);
+
+	// Grass has no tagged objects, so its distance field has no output
+	VSP_EXPECT_EQ(Weights.Num(), 3);
+	VSP_EXPECT_TRUE(!Weights.Contains(TEXT("Grass")));
+
+	for (const TPair<FName, UTGBaseLayer*>& Iter : Generators)
+	{
+		const TArray<uint8> ObjectsMask = Depth.MakeObjectsMask(Iter.Key);
+		FTGTerrainInfo TerrainInfo;
+		TerrainInfo.ObjectsMask = ObjectsMask;
+		TerrainInfo.DecodedHeight = Height;
+		TerrainInfo.Size = { Size, Size };
+
+		TArray<uint8> Expected;
+		if (Iter.Value->GenerateWeights(TerrainInfo, Expected))
+			VSP_EXPECT_TRUE(Weights.FindRef(Iter.Key) == Expected);
+	}
+
+	return true;
+}
+
+VSP_TEST(WeightmapManager, CompositeSubtractsLayers, TestsFlags)
+{
+	using namespace WeightmapManagerTestLocal;
+
+	const TArray<float> Height = MakeHeight();
+	const FTGDepthCapture Depth = MakeDepth();
+	const TMap<FName, UTGBaseLayer*> Generators = MakeGenerators();
+
+	const TMap<FName, TArray<uint8>> Weights =
+		AWeightmapManager::GenerateWeights(Generators, Height, { Size, Size }, Depth, false);
+	const TMap<FName, TArray<uint8>> Composited =
+		AWeightmapManager::GenerateWeights(Generators, Height, { Size, Size }, Depth, true);
+	VSP_EXPECT_EQ(Composited.Num(), Weights.Num());
+
+	// The first layer is composited against the untouched other layers
+	auto First = Weights.CreateConstIterator();
+	bool bFirstMatches = true;
+	for (int32 Pixel = 0; Pixel < Size * Size; Pixel++)
+	{
+		int32 Expected = First->Value[Pixel];
+		for (const TPair<FName, TArray<uint8>>& Other : Weights)
+		{
+			if (Other.Key != First->Key)
+				Expected -= Other.Value[Pixel];
+		}
+		bFirstMatches &= Composited[First->Key][Pixel] == FMath::Max(Expected, 0);
+	}
+	VSP_EXPECT_TRUE(bFirstMatches);
+
+	bool bNotAbove = true;
+	for (const TPair<FName, TArray<uint8>>& Iter : Composited)
+	{
+		for (int32 Pixel = 0; Pixel < Size * Size; Pixel++)
+			bNotAbove &= Iter.Value[Pixel] <= Weights[Iter.Key][Pixel];
+	}
+	VSP_EXPECT_TRUE(bNotAbove);
+
+	return true;
+}
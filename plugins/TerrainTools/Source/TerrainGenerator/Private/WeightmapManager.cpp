@@ -21,10 +21,13 @@
 #include "Engine/StaticMeshActor.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Generators/TGBaseLayer.h"
+#include "Generators/TGGeneratorGraph.h"
+#include "HeightmapKernels.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetRenderingLibrary.h"
 #include "LandscapeEdit.h"
 #include "LandscapeStreamingProxy.h"
+#include "Logging/MessageLog.h"
 #include "Misc/FeedbackContext.h"
 #include "Rendering/Texture2DResource.h"
 #include "TerrainGeneratorHelper.h"
@@ -95,7 +98,7 @@ AWeightmapManager::AWeightmapManager()
 
 void AWeightmapManager::Generate()
 {
-	if (!Landscape.Get())
+	if (!Landscape.Get() || bGenerating)
 		return;
 
 	InitializeManager();
@@ -116,53 +119,50 @@ void AWeightmapManager::Generate()
 		DecodedHeight = GetUnpackedHeight();
 	}
 
-	LayerStack.Empty();
 	Resolution = FIntPoint { PackedHeightRT->SizeX, PackedHeightRT->SizeY };
-	const bool bHasLayersContent = Landscape->HasLayersContent();
 
-	for (auto Iter : Generators)
-	{
-		if (IsValid(Iter.Value))
+	TArray<FName> Layers;
+	Generators.GetKeys(Layers);
+
+	// The depth is read back asynchronously so the editor stays responsive
+	bGenerating = true;
+	const TWeakObjectPtr<AWeightmapManager> WeakThis(this);
+	CaptureDepth(
+		Layers,
+		[WeakThis]()
 		{
-			const FTGTerrainInfo TerrainInfo { UpdateObjectsDepth(Iter.Key), DecodedHeight, Resolution, false };
+			if (WeakThis.IsValid())
+				WeakThis->FinishGenerate();
+		});
+}
 
-			Iter.Value->AffectedLayer = Iter.Key;
-			UTextureRenderTarget2D* GeneratedData = Iter.Value->Generate(TerrainInfo);
-			if (GeneratedData)
-				LayerStack.FindOrAdd(Iter.Key, GeneratedData);
-		}
-	}
 
-	if (bComposite)
-	{
-		Composite();
-	}
+void AWeightmapManager::FinishGenerate()
+{
+	bGenerating = false;
 
-	EditingLayerName = GetBaseLayerName();
+	if (!Landscape.Get())
+		return;
 
-	for (TTuple<FName, UTextureRenderTarget2D*>& Iter : LayerStack)
+	const TMap<FName, TArray<uint8>> Weights =
+		GenerateWeights(Generators, DecodedHeight, Resolution, DepthCapture, bComposite);
+
+	LayerStack.Empty();
+	for (const TPair<FName, TArray<uint8>>& Iter : Weights)
 	{
-		if (Landscape->HasLayersContent())
-		{
-			UTerrainGeneratorHelper::TerrainImportWeightmapFromRenderTargetToEditingLayer(
-				Landscape.Get(),
-				Iter.Value,
-				EditingLayerName.ToString(),
-				Iter.Key.ToString());
-		}
-		else
-		{
-			UTerrainGeneratorHelper::TerrainImportWeightmapFromRenderTarget(Landscape.Get(), Iter.Value, Iter.Key);
-		}
+		LayerStack.Add(Iter.Key, Generators.FindChecked(Iter.Key)->DrawWeights(Iter.Value, Resolution, false));
 	}
 
+	EditingLayerName = GetBaseLayerName();
+	UTerrainGeneratorHelper::TerrainImportWeightmaps(Landscape.Get(), Weights, Resolution, EditingLayerName);
+
 	if (bCleanMemory)
 	{
 		PackedHeightRT = nullptr;
-		ObjectDepth = nullptr;
+		ObjectDepths.Empty();
 		TerrainDepth = nullptr;
 		DecodedHeight.Empty();
-		ObjectsDepth.Empty();
+		DepthCapture = {};
 	}
 
 	Modify();
@@ -233,116 +233,204 @@ void AWeightmapManager::GetPackedHeightRT(UTextureRenderTarget2D*& InRenderTarge
 }
 
 
-TArray<uint8> AWeightmapManager::UpdateObjectsDepth(FName Tag)
+void AWeightmapManager::CaptureDepth(const TArray<FName>& Tags, TFunction<void()> OnCaptured)
 {
-	if (Landscape.Get())
+	DepthCapture = {};
+
+	if (!Landscape.Get())
 	{
-		TArray<TWeakObjectPtr<ULandscapeComponent>> LandscapeComponentsLocal;
-		if (bStreamingProxy)
+		OnCaptured();
+		return;
+	}
+
+	TArray<TWeakObjectPtr<ULandscapeComponent>> LandscapeComponentsLocal;
+	if (bStreamingProxy)
+	{
+		for (TObjectIterator<ALandscapeStreamingProxy> It; It; ++It)
 		{
-			for (TObjectIterator<ALandscapeStreamingProxy> It; It; ++It)
+			LandscapeComponentsLocal.Append(It->LandscapeComponents);
+		}
+	}
+	else
+	{
+		for (TObjectIterator<ULandscapeComponent> ComponentIt; ComponentIt; ++ComponentIt)
+		{
+			LandscapeComponentsLocal.Add(*ComponentIt);
+		}
+	}
+
+	if (LandscapeComponentsLocal.Num() == 0)
+	{
+		OnCaptured();
+		return;
+	}
+
+	UpdateSceneCapture();
+	const ETextureRenderTargetFormat Format = RTF_R16f;
+
+	// Capture Objects, every tag to its own target, so all captures are read back together
+	TMap<FName, UTextureRenderTarget2D*> CapturedObjectDepths;
+	for (const FName Tag : Tags)
+	{
+		SceneCapture->ShowOnlyActors.Empty();
+		SceneCapture->ClearShowOnlyComponents();
+		UGameplayStatics::GetAllActorsWithTag(this, Tag, SceneCapture->ShowOnlyActors);
+
+		if (SceneCapture->ShowOnlyActors.Num() == 0)
+			continue;
+
+		TArray<AActor*> RVTActorsTemp;
+		for (AActor* Iter : SceneCapture->ShowOnlyActors)
+		{
+			if (AStaticMeshActor* StaticMeshActor = Cast<AStaticMeshActor>(Iter))
 			{
-				LandscapeComponentsLocal.Append(It->LandscapeComponents);
+				if (StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType
+					== ERuntimeVirtualTextureMainPassType::Never)
+				{
+					StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType =
+						ERuntimeVirtualTextureMainPassType::Always;
+					StaticMeshActor->GetStaticMeshComponent()->MarkRenderStateDirty();
+					RVTActorsTemp.Add(StaticMeshActor);
+				}
 			}
 		}
-		else
+
+		UTextureRenderTarget2D* ObjectDepth = FTerrainUtils::GetOrCreateTransientRenderTarget2D(
+			ObjectDepths.FindRef(Tag),
+			*FString::Printf(TEXT("ObjectDepth_%s"), *Tag.ToString()),
+			Resolution,
+			Format);
+		ObjectDepths.Add(Tag, ObjectDepth);
+		CapturedObjectDepths.Add(Tag, ObjectDepth);
+		SceneCapture->TextureTarget = ObjectDepth;
+		SceneCapture->CaptureScene();
+
+		for (AActor* Iter : RVTActorsTemp)
 		{
-			for (TObjectIterator<ULandscapeComponent> ComponentIt; ComponentIt; ++ComponentIt)
+			if (AStaticMeshActor* StaticMeshActor = Cast<AStaticMeshActor>(Iter))
 			{
-				LandscapeComponentsLocal.Add(*ComponentIt);
+				StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType =
+					ERuntimeVirtualTextureMainPassType::Never;
+				StaticMeshActor->GetStaticMeshComponent()->MarkRenderStateDirty();
 			}
 		}
+	}
 
-		if (LandscapeComponentsLocal.Num() > 0)
-		{
-			UpdateSceneCapture();
-			SceneCapture->ShowOnlyActors.Empty();
-			SceneCapture->ClearShowOnlyComponents();
-			UGameplayStatics::GetAllActorsWithTag(this, Tag, SceneCapture->ShowOnlyActors);
+	if (CapturedObjectDepths.Num() == 0)
+	{
+		OnCaptured();
+		return;
+	}
+
+	// Capture Landscape once for all tags
+	SceneCapture->ShowOnlyActors = { Landscape.Get() };
+	SceneCapture->ClearShowOnlyComponents();
+
+	for (TWeakObjectPtr<ULandscapeComponent> Iter : LandscapeComponentsLocal)
+	{
+		SceneCapture->ShowOnlyComponents.Add(Iter);
+	}
 
-			if (SceneCapture->ShowOnlyActors.Num() > 0)
+	TerrainDepth =
+		FTerrainUtils::GetOrCreateTransientRenderTarget2D(TerrainDepth, TEXT("TerrainDepth"), Resolution, Format);
+	SceneCapture->TextureTarget = TerrainDepth;
+	SceneCapture->CaptureScene();
+
+	// Readbacks are queued behind the captures, OnCaptured runs when the last one has arrived
+	const TSharedRef<int32> NumPending = MakeShared<int32>(CapturedObjectDepths.Num() + 1);
+	const TWeakObjectPtr<AWeightmapManager> WeakThis(this);
+	auto ReadDepth = [&](UTextureRenderTarget2D* InDepth, FName InTag)
+	{
+		const FLinearColor Rect = FLinearColor(0, 0, InDepth->SizeX, InDepth->SizeY);
+		UTerrainGeneratorHelper::SampleRTDataAsync(
+			InDepth,
+			Rect,
+			[WeakThis, NumPending, OnCaptured, InTag](TArray<FLinearColor>&& Pixels)
 			{
-				TArray<AActor*> RVTActorsTemp;
-				for (AActor* Iter : SceneCapture->ShowOnlyActors)
-				{
-					if (AStaticMeshActor* StaticMeshActor = Cast<AStaticMeshActor>(Iter))
-					{
-						if (StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType
-							== ERuntimeVirtualTextureMainPassType::Never)
-						{
-							StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType =
-								ERuntimeVirtualTextureMainPassType::Always;
-							StaticMeshActor->GetStaticMeshComponent()->MarkRenderStateDirty();
-							RVTActorsTemp.Add(StaticMeshActor);
-						}
-					}
-				}
-				ETextureRenderTargetFormat Format = RTF_R16f;
-				// Capture Objects
-				ObjectDepth = FTerrainUtils::GetOrCreateTransientRenderTarget2D(
-					ObjectDepth,
-					TEXT("ObjectDepth"),
-					Resolution,
-					Format);
-				SceneCapture->TextureTarget = ObjectDepth;
-				SceneCapture->CaptureScene();
-
-				for (AActor* Iter : RVTActorsTemp)
+				if (!WeakThis.IsValid())
+					return;
+
+				TArray<float> Depth;
+				Depth.SetNumUninitialized(Pixels.Num());
+				for (int32 Iter = 0; Iter < Pixels.Num(); Iter++)
 				{
-					if (AStaticMeshActor* StaticMeshActor = Cast<AStaticMeshActor>(Iter))
-					{
-						StaticMeshActor->GetStaticMeshComponent()->VirtualTextureRenderPassType =
-							ERuntimeVirtualTextureMainPassType::Never;
-						StaticMeshActor->GetStaticMeshComponent()->MarkRenderStateDirty();
-					}
+					Depth[Iter] = Pixels[Iter].R;
 				}
 
-				// Capture Landscape
-				SceneCapture->ShowOnlyActors = { Landscape.Get() };
-				SceneCapture->ClearShowOnlyComponents();
+				if (InTag.IsNone())
+					WeakThis->DepthCapture.TerrainDepth = MoveTemp(Depth);
+				else
+					WeakThis->DepthCapture.ObjectsDepth.Add(InTag, MoveTemp(Depth));
 
-				for (TWeakObjectPtr<ULandscapeComponent> Iter : LandscapeComponentsLocal)
-				{
-					SceneCapture->ShowOnlyComponents.Add(Iter);
-				}
+				if (--(*NumPending) == 0)
+					OnCaptured();
+			});
+	};
 
-				TerrainDepth = FTerrainUtils::GetOrCreateTransientRenderTarget2D(
-					TerrainDepth,
-					TEXT("TerrainDepth"),
-					Resolution,
-					Format);
-				SceneCapture->TextureTarget = TerrainDepth;
-				SceneCapture->CaptureScene();
+	ReadDepth(TerrainDepth, NAME_None);
+	for (const TPair<FName, UTextureRenderTarget2D*>& Iter : CapturedObjectDepths)
+	{
+		ReadDepth(Iter.Value, Iter.Key);
+	}
+}
 
-				FlushRenderingCommands();
+TMap<FName, TArray<uint8>> AWeightmapManager::GenerateWeights(
+	const TMap<FName, UTGBaseLayer*>& InGenerators,
+	const TArray<float>& InHeight,
+	FIntPoint InSize,
+	const FTGDepthCapture& InDepth,
+	bool bInComposite)
+{
+	TMap<FName, TArray<uint8>> Weights;
 
-				// Extract Mask from depths
-				auto GetPixels = [](UTextureRenderTarget2D* InDepth)
-				{
-					const FTextureRenderTargetResource* RenderTargetResource =
-						InDepth->GameThread_GetRenderTargetResource();
-					const FLinearColor Rect =
-						FLinearColor(0, 0, RenderTargetResource->GetSizeX(), RenderTargetResource->GetSizeY());
-					return UTerrainGeneratorHelper::SampleRTData(InDepth, Rect);
-				};
-
-				TArray<FLinearColor> TerrainDepthPixels = GetPixels(TerrainDepth);
-				TArray<FLinearColor> ObjectsDepthPixels = GetPixels(ObjectDepth);
-
-				TArray<uint8> Data;
-				Data.SetNum(TerrainDepthPixels.Num());
-				for (int32 Iter = 0; Iter < Data.Num(); Iter++)
-				{
-					Data[Iter] = (TerrainDepthPixels[Iter].R - ObjectsDepthPixels[Iter].R) /* - CaptureLocation.Z*/ > 0
-						? 255
-						: 0;
-				}
+	FTGGeneratorGraph Graph;
+	FString Error;
+	if (!Graph.Build(InGenerators, Error))
+	{
+		FMessageLog("TerrainGenerator").Error(FText::FromString(Error));
+		return Weights;
+	}
 
-				return Data;
-			}
-		}
+	TMap<FName, TArray<uint8>> ObjectsMasks;
+	for (const TPair<FName, UTGBaseLayer*>& Iter : InGenerators)
+	{
+		TArray<uint8> ObjectsMask = InDepth.MakeObjectsMask(Iter.Key);
+		if (ObjectsMask.Num() > 0)
+			ObjectsMasks.Add(Iter.Key, MoveTemp(ObjectsMask));
 	}
-	return TArray<uint8> {};
+
+	FTGTerrainInfo TerrainInfo;
+	TerrainInfo.DecodedHeight = InHeight;
+	TerrainInfo.Size = InSize;
+	Graph.Run(TerrainInfo, ObjectsMasks, Weights);
+
+	if (bInComposite)
+	{
+		CompositeWeights(Weights);
+	}
+
+	return Weights;
+}
+
+TArray<uint8> FTGDepthCapture::MakeObjectsMask(FName Tag) const
+{
+	const TArray<float>* ObjectDepth = ObjectsDepth.Find(Tag);
+	if (!ObjectDepth || ObjectDepth->Num() != TerrainDepth.Num())
+		return TArray<uint8> {};
+
+	TArray<uint8> Data;
+	Data.SetNumUninitialized(TerrainDepth.Num());
+	FHeightmapKernels::ForEachRange(
+		Data.Num(),
+		[&](int32 Begin, int32 End)
+		{
+			for (int32 Iter = Begin; Iter < End; Iter++)
+			{
+				Data[Iter] = (TerrainDepth[Iter] - (*ObjectDepth)[Iter]) > 0 ? 255 : 0;
+			}
+		});
+
+	return Data;
 }
 
 void AWeightmapManager::ExportOnDisk()
@@ -430,55 +518,6 @@ void AWeightmapManager::UpdateSceneCapture() const
 }
 
 
-UTextureRenderTarget2D* AWeightmapManager::SubtractWeightmap(
-	UTextureRenderTarget2D* InRenderTargetA,
-	UTextureRenderTarget2D* InRenderTargetB)
-{
-	auto GetPixels = [](UTextureRenderTarget2D* RenderTarget)
-	{
-		const FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
-		const FLinearColor Rect =
-			FLinearColor(0, 0, RenderTargetResource->GetSizeX(), RenderTargetResource->GetSizeY());
-		return UTerrainGeneratorHelper::SampleRTData(RenderTarget, Rect);
-	};
-
-	TArray<FLinearColor> SourceDataA = GetPixels(InRenderTargetA);
-	TArray<FLinearColor> SourceDataB = GetPixels(InRenderTargetB);
-
-	TArray<uint8> NewData;
-	NewData.SetNum(SourceDataA.Num() * 4);
-	for (int32 i = 0; i < SourceDataA.Num(); i++)
-	{
-		const FColor NewColor = (SourceDataA[i] - SourceDataB[i]).ToFColor(false);
-		NewData[i * 4 + 0] = NewColor.B;
-		NewData[i * 4 + 1] = NewColor.G;
-		NewData[i * 4 + 2] = NewColor.R;
-		NewData[i * 4 + 3] = NewColor.A;
-	}
-
-	UTextureRenderTarget2D* NewWeightmap = UKismetRenderingLibrary::CreateRenderTarget2D(
-		this,
-		InRenderTargetA->SizeX,
-		InRenderTargetA->SizeY,
-		InRenderTargetA->RenderTargetFormat);
-	FTextureRenderTargetResource* RTResourceDest = NewWeightmap->GameThread_GetRenderTargetResource();
-
-	ENQUEUE_RENDER_COMMAND(UpdateTexture2D)
-	(
-		[RTResourceDest, Data = MoveTemp(NewData)](FRHICommandListImmediate& RHICmdList)
-		{
-			RHICmdList.UpdateTexture2D(
-				RTResourceDest->GetTexture2DRHI(),
-				0,
-				FUpdateTextureRegion2D(0, 0, 0, 0, RTResourceDest->GetSizeX(), RTResourceDest->GetSizeY()),
-				RTResourceDest->GetSizeX() * sizeof(FColor),
-				Data.GetData());
-		});
-
-	return NewWeightmap;
-}
-
-
 UTexture2D* AWeightmapManager::GenerateWeightmapTexture(UTextureRenderTarget2D* InRenderTarget)
 {
 	FTextureRenderTargetResource* RTResource = InRenderTarget->GameThread_GetRenderTargetResource();
@@ -499,25 +538,26 @@ UTexture2D* AWeightmapManager::GenerateWeightmapTexture(UTextureRenderTarget2D*
 }
 
 
-void AWeightmapManager::Composite()
+void AWeightmapManager::CompositeWeights(TMap<FName, TArray<uint8>>& InOutWeights)
 {
-	GWarn->BeginSlowTask(FText::FromString(TEXT("Composite")), true, false);
-	const int32 TotalProgress = LayerStack.Num();
-	int32 Progress = 0;
-
-	for (auto& IterX : LayerStack)
+	for (TPair<FName, TArray<uint8>>& IterX : InOutWeights)
 	{
-		for (auto& IterY : LayerStack)
+		for (const TPair<FName, TArray<uint8>>& IterY : InOutWeights)
 		{
-			if (IterY.Key != IterX.Key)
-			{
-				IterX.Value = SubtractWeightmap(IterX.Value, IterY.Value);
-			}
-			GWarn->UpdateProgress(Progress++, TotalProgress);
+			if (IterY.Key == IterX.Key || IterY.Value.Num() != IterX.Value.Num())
+				continue;
+
+			FHeightmapKernels::ForEachRange(
+				IterX.Value.Num(),
+				[&](int32 Begin, int32 End)
+				{
+					for (int32 Iter = Begin; Iter < End; Iter++)
+					{
+						IterX.Value[Iter] = FMath::Max(IterX.Value[Iter] - IterY.Value[Iter], 0);
+					}
+				});
 		}
 	}
-	FlushRenderingCommands();
-	GWarn->EndSlowTask();
 }
 
 
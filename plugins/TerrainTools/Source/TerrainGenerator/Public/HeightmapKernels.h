@@ -0,0 +1,155 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Non-owning view over a row-major raster, Size.X values per row.
+ */
+template <typename T>
+struct THeightmapView
+{
+	THeightmapView() = default;
+
+	THeightmapView(T* InData, FIntPoint InSize)
+		: Data { InData }
+		, Size { InSize }
+	{
+	}
+
+	THeightmapView(TArrayView<T> InData, FIntPoint InSize)
+		: Data { InData.GetData() }
+		, Size { InSize }
+	{
+		check(InData.Num() == InSize.X * InSize.Y);
+	}
+
+	template <typename OtherType, typename = typename TEnableIf<TPointerIsConvertibleFromTo<OtherType, T>::Value>::Type>
+	THeightmapView(const THeightmapView<OtherType>& Other)
+		: Data { Other.Data }
+		, Size { Other.Size }
+	{
+	}
+
+	int32 Num() const
+	{
+		return Size.X * Size.Y;
+	}
+
+	T* GetRow(int32 Y) const
+	{
+		return Data + (SIZE_T)Y * Size.X;
+	}
+
+	T& operator()(int32 X, int32 Y) const
+	{
+		return GetRow(Y)[X];
+	}
+
+	T* Data = nullptr;
+	FIntPoint Size = FIntPoint::ZeroValue;
+};
+
+using FHeightmapView = THeightmapView<float>;
+using FConstHeightmapView = THeightmapView<const float>;
+using FPackedHeightmapView = THeightmapView<uint16>;
+using FConstPackedHeightmapView = THeightmapView<const uint16>;
+
+// Called on the calling thread after finished tiles, last call is always (NumTiles, NumTiles)
+using FHeightmapKernelProgress = TFunction<void(int32 NumTilesDone, int32 NumTiles)>;
+
+/**
+ * @brief   Common heightmap operations, tiles are processed in parallel and inner loops use VectorRegister.
+ * @details Neighbourhood kernels clamp reads to the raster edges and require different In and Out rasters.
+ */
+struct TERRAINGENERATOR_API FHeightmapKernels
+{
+	// Tile edge in pixels, a float tile with its source rows stays in L2
+	static constexpr int32 TileSize = 128;
+
+	static void ForEachTile(
+		FIntPoint Size,
+		TFunctionRef<void(const FIntRect& Tile)> Kernel,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Same for per-pixel kernels, the raster is split into TileSize * TileSize ranges
+	static void ForEachRange(
+		int32 Num,
+		TFunctionRef<void(int32 Begin, int32 End)> Kernel,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Landscape height to the heightmap render target scale: 255 per step, R * 255 * 256 + G * 255
+	static void UnpackHeight(
+		FConstPackedHeightmapView In,
+		FHeightmapView Out,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Inverse of UnpackHeight, clamped to uint16 range and truncated
+	static void PackHeight(
+		FConstHeightmapView In,
+		FPackedHeightmapView Out,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Length of the height differences to 4 neighbours
+	static void Steepness(FConstHeightmapView In, FHeightmapView Out, const FHeightmapKernelProgress& Progress = {});
+
+	// Gradient length from central differences, rise over run
+	static void Slope(
+		FConstHeightmapView In,
+		FHeightmapView Out,
+		float CellSize = 1.f,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Laplacian, positive in concave areas
+	static void Curvature(
+		FConstHeightmapView In,
+		FHeightmapView Out,
+		float CellSize = 1.f,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Unit normals from central differences, Z up
+	static void Normals(
+		FConstHeightmapView In,
+		THeightmapView<FVector> Out,
+		float CellSize = 1.f,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Kernel is row-major, Kernel[4] weights the center pixel
+	static void Convolve3x3(
+		FConstHeightmapView In,
+		FHeightmapView Out,
+		const float (&Kernel)[9],
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Rows with KernelX, then columns with KernelY, kernels have odd length and are centered
+	static void ConvolveSeparable(
+		FConstHeightmapView In,
+		FHeightmapView Out,
+		TArrayView<const float> KernelX,
+		TArrayView<const float> KernelY,
+		const FHeightmapKernelProgress& Progress = {});
+
+	static void GaussianBlur(
+		FConstHeightmapView In,
+		FHeightmapView Out,
+		float Sigma,
+		const FHeightmapKernelProgress& Progress = {});
+
+	// Normalized weights for 3 sigma on each side
+	static TArray<float> MakeGaussianKernel(float Sigma);
+};
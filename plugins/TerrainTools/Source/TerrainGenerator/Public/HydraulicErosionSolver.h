@@ -0,0 +1,149 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HeightmapKernels.h"
+
+enum class EHydraulicErosionSolverMode : uint8
+{
+	// Shallow water over virtual pipes between neighbour cells, the CPU counterpart of the ShallowWater mode
+	VirtualPipes,
+	// Independent droplets carving channels, the CPU counterpart of FreeParticles and UTGHydraulicErosion
+	Droplets,
+};
+
+/**
+ * @brief Parameters of FHydraulicErosionSolver, named after AHydraulicErosion and UTGHydraulicErosion.
+ *        Heights and water are in the units of the input heightmap, CellSize is the distance between samples.
+ */
+struct TERRAINGENERATOR_API FHydraulicErosionSettings
+{
+	EHydraulicErosionSolverMode Mode = EHydraulicErosionSolverMode::VirtualPipes;
+	int32 Seed = 0;
+
+	// Virtual pipes
+	float DeltaT = 0.01f;
+	float RainAmount = 0.f;
+	float StartWater = 50.f;
+	bool bWaterIsLevel = false;
+	// Deposits the suspended sediment and restarts the water every N iterations, 0 never resets
+	int32 ResetEveryNIterations = 512;
+	// Sediment capacity per unit of slope and water speed
+	float Solubility = 0.01f;
+	// Water depth lost per iteration
+	float Evaporation = 0.f;
+	float VelocityDamping = 0.1f;
+	// Fractions of the capacity difference dissolved or deposited per iteration
+	float DissolveRate = 0.5f;
+	float DepositRate = 0.5f;
+	float Gravity = 9.81f;
+	float CellSize = 1.f;
+
+	// Droplets
+	int32 NumDroplets = 70000;
+	int32 ErosionRadius = 3;
+	float Inertia = 0.05f;
+	float SedimentCapacityFactor = 4.f;
+	float MinSedimentCapacity = 0.01f;
+	float ErodeSpeed = 0.3f;
+	float DepositSpeed = 0.3f;
+	float EvaporateSpeed = 0.01f;
+	float DropletGravity = 4.f;
+	int32 MaxDropletLifetime = 30;
+	float InitialWaterVolume = 1.f;
+	float InitialSpeed = 1.f;
+};
+
+/**
+ * @brief   Multithreaded CPU hydraulic erosion, runs without render targets.
+ * @details Results depend only on the input and the settings, not on the number of worker threads.
+ *          Virtual pipes update every cell from the previous state of its neighbours, tile by tile.
+ *          Droplets are spawned per tile from a stream seeded by the tile, tiles two apart run together
+ *          in four phases and droplets stop at their tile edge. The tile grid is shifted every iteration
+ *          so the edges don't leave seams.
+ */
+class TERRAINGENERATOR_API FHydraulicErosionSolver
+{
+public:
+	FHydraulicErosionSolver(FConstHeightmapView InHeight, const FHydraulicErosionSettings& InSettings);
+
+	// Pipe steps for VirtualPipes, batches of NumDroplets for Droplets
+	void Run(int32 Iterations, const FHeightmapKernelProgress& Progress = {});
+
+	// Droplets of the following batches, e.g. for a smaller last batch
+	void SetNumDroplets(int32 NumDroplets)
+	{
+		Settings.NumDroplets = NumDroplets;
+	}
+
+	const TArray<float>& GetHeight() const
+	{
+		return Height;
+	}
+
+	// Suspended sediment for VirtualPipes, deposited sediment for Droplets
+	const TArray<float>& GetSediment() const
+	{
+		return Sediment;
+	}
+
+	// Water depth, empty for Droplets
+	const TArray<float>& GetWater() const
+	{
+		return Water;
+	}
+
+	// Water velocity for VirtualPipes, sum of droplet velocities over the run for Droplets
+	const TArray<FVector2D>& GetFlow() const
+	{
+		return Flow;
+	}
+
+	FIntPoint GetSize() const
+	{
+		return Size;
+	}
+
+	int32 GetIteration() const
+	{
+		return Iteration;
+	}
+
+private:
+	void ResetWater();
+	void StepPipes();
+	void StepDroplets();
+	void RunDroplets(const FIntRect& Tile, int32 NumTileDroplets, int32 TileSeed);
+
+	FHydraulicErosionSettings Settings;
+	FIntPoint Size;
+	int32 Iteration = 0;
+
+	TArray<float> Height;
+	TArray<float> Sediment;
+	TArray<float> Water;
+	TArray<FVector2D> Flow;
+
+	// Outflow to the left, right, top and bottom neighbours
+	TArray<FVector4> Flux;
+	TArray<float> Scratch;
+
+	// Droplet erosion brush around the node
+	TArray<FIntPoint> BrushOffsets;
+	TArray<float> BrushWeights;
+};
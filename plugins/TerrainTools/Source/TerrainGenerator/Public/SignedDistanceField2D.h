@@ -30,8 +30,34 @@ public:
 	{
 	}
 
+	// Distance quantized to uint8: 128 on the mask border, Scale per pixel, higher for mask values >= 128
 	TArray<uint8> Generate(TArray<uint8>& InData);
 
+	// Exact signed distance in pixels, positive for mask values >= 128
+	TArray<float> GenerateFloat(const TArray<uint8>& InData) const;
+
+	/**
+	 * @brief   Exact signed distance for rasters which don't fit in memory.
+	 * @details Raster is processed tile by tile, every tile reads an apron of MaxDistance pixels around it,
+	 *          so distances are exact up to MaxDistance and clamped to it.
+	 */
+	void GenerateTiled(
+		int32 TileSize,
+		int32 MaxDistance,
+		TFunctionRef<void(const FIntRect& Rect, TArray<uint8>& OutMask)> ReadMask,
+		TFunctionRef<void(const FIntRect& Rect, const TArray<float>& Distances)> WriteDistances) const;
+
+	// Legacy 8SSEDT, kept as the reference for validation
+	TArray<uint8> GenerateSSEDT(TArray<uint8>& InData);
+
+	// Squared distance to the nearest pixel with (Mask < 128) == bFeatureBelow, Felzenszwalb-Huttenlocher EDT
+	static void ComputeSquaredDistances(
+		const TArray<uint8>& Mask,
+		int32 InWidth,
+		int32 InHeight,
+		bool bFeatureBelow,
+		TArray<float>& OutSquaredDistances);
+
 private:
 	FIntPoint GetPoint(FTGGrid& SdfGrid, const int32 X, const int32 Y) const;
 	void PutPoint(FTGGrid& SdfGrid, const int32 X, const int32 Y, const FIntPoint& SdfPoint);
@@ -24,6 +24,9 @@ class ALandscapeProxy;
 class ULandscapeLayerInfoObject;
 class ULandscapeInfo;
 
+// Receives the pixels read back by SampleRTDataAsync on the game thread, empty if the target could not be read
+using FTGReadbackCallback = TFunction<void(TArray<FLinearColor>&& Pixels)>;
+
 UCLASS()
 class TERRAINGENERATOR_API UTerrainGeneratorHelper : public UBlueprintFunctionLibrary
 {
@@ -61,6 +64,16 @@ public:
 		const FString& InEditingLayerName,
 		const FString& InMaterialLayerName);
 
+	/**
+	 * @brief Imports several layers in one transaction, to the editing layer if the landscape has edit layers.
+	 * @param InWeights - 8 bit weights of InSize keyed by the layer name, InSize must cover the landscape
+	 */
+	static bool TerrainImportWeightmaps(
+		ALandscape* InLandscape,
+		const TMap<FName, TArray<uint8>>& InWeights,
+		FIntPoint InSize,
+		FName InEditingLayerName);
+
 	UFUNCTION(BlueprintCallable, Category = "TerrainGeneratorHelper")
 	static void ExportWeightLayer(ALandscape* InLandscape, FString Dir, FName InLayerName);
 
@@ -103,7 +116,25 @@ public:
 
 	static TArray<FLinearColor> SampleRTData(UTextureRenderTarget2D* InRenderTarget, FLinearColor InRect);
 
-	static TArray<FColor> DownsampleTextureData(TArray<FColor>& Data, int32 Width, int32 Kernel);
+	// Same as SampleRTData without blocking the game thread. The read is enqueued on the render thread and
+	// OnComplete is called from the core ticker once a render fence issued after it has passed.
+	static void SampleRTDataAsync(
+		UTextureRenderTarget2D* InRenderTarget,
+		FLinearColor InRect,
+		FTGReadbackCallback OnComplete);
+
+	// Output size of DownsampleTextureData, partial blocks at the right and bottom edges are dropped
+	static FIntPoint GetDownsampledSize(FIntPoint InSize, int32 InKernel);
+
+	// Box filter over InKernel x InKernel blocks, rows are processed in parallel and nothing is allocated.
+	// OutData must hold GetDownsampledSize(InSize, InKernel) pixels.
+	static void DownsampleTextureData(
+		TArrayView<const FColor> InData,
+		FIntPoint InSize,
+		int32 InKernel,
+		TArrayView<FColor> OutData);
+
+	static TArray<FColor> DownsampleTextureData(const TArray<FColor>& Data, int32 Width, int32 Kernel);
 
 	static UTexture2D* CreateTextureFromBGRA(FColor* InData, int32 InWidth, int32 InHeight);
 
@@ -45,16 +45,38 @@ struct TERRAINGENERATOR_API FTerrainUtils
 
 struct TERRAINGENERATOR_API FHeightmapUtils
 {
-	static TArray<float> UnpackHeightToFloat(TArray<uint16> InHeightMap);
+	static TArray<float> UnpackHeightToFloat(const TArray<uint16>& InHeightMap);
 	static TArray<float> UnpackHeightToFloat(UTextureRenderTarget2D* InRenderTarget);
-	static TArray<uint16> PackHeightTo_uint16(TArray<float> InHeightMap);
+	static TArray<uint16> PackHeightTo_uint16(const TArray<float>& InHeightMap);
 	static TArray<FColor> SampleHeightData(UTextureRenderTarget2D* InRenderTarget);
 };
 
 struct TERRAINGENERATOR_API FPolygonTriangulationUtils
 {
+	/**
+	 * @brief Projects a planar polygon onto its own plane and triangulates it with TriangulatePolygon2D
+	 * @param Vertices  - polygon outline, any winding
+	 * @param Triangles - indices into Vertices, 3 per triangle, wound like the outline
+	 */
 	static void TriangulatePolygon(const TArray<FVector>& Vertices, TArray<int32>& Triangles);
 
+	/**
+	 * @brief Ear clipping over a linked list of the outline (after mapbox earcut). Ears are clipped in place,
+	 *        reflex vertices of large polygons are looked up through a z-order curve hash.
+	 * @param Vertices   - outer ring followed by the hole rings, any winding
+	 * @param HoleStarts - index in Vertices of the first vertex of every hole, ascending
+	 * @return Indices into Vertices, 3 per triangle, counter-clockwise
+	 */
+	static TArray<int32> TriangulatePolygon2D(
+		TArrayView<const FVector2D> Vertices,
+		TArrayView<const int32> HoleStarts = {});
+
+	/**
+	 * @brief Previous recursive triangulation, copies the outline on every clipped ear.
+	 *        Kept as the reference of the tests and benchmarks.
+	 */
+	static void TriangulatePolygonRecursive(const TArray<FVector>& Vertices, TArray<int32>& Triangles);
+
 private:
 	struct FVertIndex
 	{
@@ -32,6 +32,18 @@ enum EWeightmapCompositeMode
 	WBM_Multiplied
 };
 
+// Scene depth rasters of Generate, captured once and shared read-only by all generators
+struct TERRAINGENERATOR_API FTGDepthCapture
+{
+	TArray<float> TerrainDepth;
+
+	// Depth of the objects tagged with the layer name
+	TMap<FName, TArray<float>> ObjectsDepth;
+
+	// 255 where the objects tagged with Tag are above the terrain, empty if there are no such objects
+	TArray<uint8> MakeObjectsMask(FName Tag) const;
+};
+
 USTRUCT()
 struct FTGLayerMask
 {
@@ -64,6 +76,20 @@ public:
 	UFUNCTION(CallInEditor, Category = "Generation")
 	void InitializeManager();
 
+	/**
+	 * @brief   CPU part of Generate, runs without the landscape and the scene capture.
+	 * @details Generators run in parallel in the order of their dependencies.
+	 * @param   InHeight - decoded landscape height, InSize.X values per row
+	 * @param   InDepth  - terrain and objects depth rasters of InSize
+	 * @return  Weights of the generated layers, composited if bInComposite
+	 */
+	static TMap<FName, TArray<uint8>> GenerateWeights(
+		const TMap<FName, UTGBaseLayer*>& InGenerators,
+		const TArray<float>& InHeight,
+		FIntPoint InSize,
+		const FTGDepthCapture& InDepth,
+		bool bInComposite);
+
 	UPROPERTY(EditInstanceOnly, Category = "Generation")
 	TSoftObjectPtr<ALandscape> Landscape;
 
@@ -107,7 +133,7 @@ private:
 	UTextureRenderTarget2D* PackedHeightRT;
 
 	UPROPERTY(Transient)
-	UTextureRenderTarget2D* ObjectDepth;
+	TMap<FName, UTextureRenderTarget2D*> ObjectDepths;
 
 	UPROPERTY(Transient)
 	UTextureRenderTarget2D* TerrainDepth;
@@ -115,19 +141,19 @@ private:
 	UPROPERTY(Transient)
 	TArray<float> DecodedHeight;
 
-	UPROPERTY(Transient)
-	TArray<uint8> ObjectsDepth;
+	FTGDepthCapture DepthCapture;
+
+	// Set while the depth readback of Generate is in flight
+	bool bGenerating = false;
 
 	UPROPERTY()
 	USceneCaptureComponent2D* SceneCapture;
 
-	UTextureRenderTarget2D* SubtractWeightmap(
-		UTextureRenderTarget2D* InRenderTarget,
-		UTextureRenderTarget2D* InRenderTargetB);
 	static UTexture2D* GenerateWeightmapTexture(UTextureRenderTarget2D* InRenderTarget);
-	void Composite();
+	static void CompositeWeights(TMap<FName, TArray<uint8>>& InOutWeights);
 	void GetPackedHeightRT(UTextureRenderTarget2D*& InRenderTarget);
-	TArray<uint8> UpdateObjectsDepth(FName Tag);
+	void CaptureDepth(const TArray<FName>& Tags, TFunction<void()> OnCaptured);
+	void FinishGenerate();
 	TArray<ULandscapeComponent*> GetLandscapeComponents() const;
 	TArray<uint16> GetPackedHeight() const;
 	TArray<float> GetUnpackedHeight() const;
@@ -45,6 +45,7 @@ public class TerrainGenerator : ModuleRules
 				"MeshDescription",
 				"StaticMeshDescription",
 				"Blutility",
+				"VSPTests",
 			}
 			);
 	}
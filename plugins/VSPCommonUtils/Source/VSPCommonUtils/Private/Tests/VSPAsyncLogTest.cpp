@@ -0,0 +1,246 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "VSPAsyncLog.h"
+#include "VSPLog.h"
+#include "VSPTests.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVSPAsyncLogTest, Log, All);
+
+static constexpr int TestsFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+
+namespace VSPAsyncLogTestLocal
+{
+	constexpr int32 ThreadsNum = 4;
+
+	struct FThreadTimings
+	{
+		double TotalSec = 0.0;
+		double MaxCallSec = 0.0;
+	};
+
+	// Logs from several threads at once, returns timings of the log calls
+	FThreadTimings LogFromThreads(int32 MessagesPerThread)
+	{
+		TArray<TFuture<FThreadTimings>> Threads;
+		for (int32 ThreadIndex = 0; ThreadIndex < ThreadsNum; ThreadIndex++)
+		{
+			Threads.Add(Async(
+				EAsyncExecution::Thread,
+				[ThreadIndex, MessagesPerThread]()
+				{
+					FThreadTimings Timings;
+					for (int32 Index = 0; Index < MessagesPerThread; Index++)
+					{
+						const double StartTime = FPlatformTime::Seconds();
+						VSP_LOG_C(LogVSPAsyncLogTest, Log, "AsyncLogOrder {} {}", ThreadIndex, Index);
+						const double CallTime = FPlatformTime::Seconds() - StartTime;
+
+						Timings.TotalSec += CallTime;
+						Timings.MaxCallSec = FMath::Max(Timings.MaxCallSec, CallTime);
+					}
+					return Timings;
+				}));
+		}
+
+		FThreadTimings Result;
+		for (TFuture<FThreadTimings>& Thread : Threads)
+		{
+			const FThreadTimings Timings = Thread.Get();
+			Result.TotalSec += Timings.TotalSec;
+			Result.MaxCallSec = FMath::Max(Result.MaxCallSec, Timings.MaxCallSec);
+		}
+		return Result;
+	}
+
+	// Restores the state defined by console variables
+	void RestoreAsyncLog()
+	{
+		FVSPAsyncLog::Get().Stop();
+		FVSPAsyncLog::BindConsoleVariables();
+	}
+}
+
+VSP_TEST(VSPAsyncLog, MessagesOrder, TestsFlags)
+{
+	using namespace VSPAsyncLogTestLocal;
+
+	constexpr int32 MessagesPerThread = 1000;
+	const FString FilePath = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("AsyncLog.log"));
+	IFileManager::Get().Delete(*FilePath);
+
+	FVSPAsyncLogSettings Settings;
+	Settings.ThreadBufferCapacity = 64;
+	Settings.OverflowPolicy = EVSPAsyncLogOverflowPolicy::Block;
+	Settings.FilePath = FilePath;
+
+	FVSPAsyncLog& AsyncLog = FVSPAsyncLog::Get();
+	const int64 NumDroppedBefore = AsyncLog.GetNumDropped();
+	AsyncLog.Start(Settings);
+	LogFromThreads(MessagesPerThread);
+	AsyncLog.Flush();
+	AsyncLog.Stop();
+	VSP_EXPECT_EQ(AsyncLog.GetNumDropped(), NumDroppedBefore);
+
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *FilePath);
+
+	TArray<int32> NextIndices;
+	NextIndices.Init(0, ThreadsNum);
+	bool bOrdered = true;
+	for (const FString& Line : Lines)
+	{
+		const int32 MessageStart = Line.Find(TEXT("AsyncLogOrder "));
+		if (MessageStart == INDEX_NONE)
+			continue;
+
+		TArray<FString> Tokens;
+		Line.Mid(MessageStart).ParseIntoArrayWS(Tokens);
+		if (Tokens.Num() < 3)
+			continue;
+
+		const int32 ThreadIndex = FCString::Atoi(*Tokens[1]);
+		const int32 Index = FCString::Atoi(*Tokens[2]);
+		bOrdered &= NextIndices.IsValidIndex(ThreadIndex) && NextIndices[ThreadIndex] == Index;
+		if (NextIndices.IsValidIndex(ThreadIndex))
+			NextIndices[ThreadIndex] = Index + 1;
+	}
+
+	VSP_EXPECT_TRUE(bOrdered);
+	for (const int32 NumMessages : NextIndices)
+		VSP_EXPECT_EQ(NumMessages, MessagesPerThread);
+
+	RestoreAsyncLog();
+	IFileManager::Get().Delete(*FilePath);
+
+	return true;
+}
+
+VSP_TEST(VSPAsyncLog, MessagesOrderBetweenThreads, TestsFlags)
+{
+	using namespace VSPAsyncLogTestLocal;
+
+	constexpr int32 ChainLength = 2000;
+	const FString FilePath =
+		FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("AsyncLogChain.log"));
+	IFileManager::Get().Delete(*FilePath);
+
+	FVSPAsyncLogSettings Settings;
+	Settings.ThreadBufferCapacity = 64;
+	Settings.OverflowPolicy = EVSPAsyncLogOverflowPolicy::Block;
+	Settings.FilePath = FilePath;
+
+	FVSPAsyncLog& AsyncLog = FVSPAsyncLog::Get();
+	AsyncLog.Start(Settings);
+
+	// Threads log in turns, so every message happens after the previous one on another thread.
+	// The other producers keep the flusher busy with unrelated messages meanwhile.
+	TAtomic<int32> Turn { 0 };
+	TArray<TFuture<void>> Threads;
+	for (int32 ThreadIndex = 0; ThreadIndex < ThreadsNum; ThreadIndex++)
+	{
+		Threads.Add(Async(
+			EAsyncExecution::Thread,
+			[ThreadIndex, &Turn]()
+			{
+				for (int32 Step = ThreadIndex; Step < ChainLength; Step += ThreadsNum)
+				{
+					while (Turn.Load() != Step)
+						FPlatformProcess::Yield();
+					VSP_LOG_C(LogVSPAsyncLogTest, Log, "AsyncLogChain {}", Step);
+					Turn = Step + 1;
+				}
+			}));
+	}
+	LogFromThreads(ChainLength / ThreadsNum);
+	for (TFuture<void>& Thread : Threads)
+		Thread.Wait();
+
+	AsyncLog.Flush();
+	AsyncLog.Stop();
+
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *FilePath);
+
+	int32 NextStep = 0;
+	bool bOrdered = true;
+	for (const FString& Line : Lines)
+	{
+		const int32 MessageStart = Line.Find(TEXT("AsyncLogChain "));
+		if (MessageStart == INDEX_NONE)
+			continue;
+
+		TArray<FString> Tokens;
+		Line.Mid(MessageStart).ParseIntoArrayWS(Tokens);
+		if (Tokens.Num() < 2)
+			continue;
+
+		bOrdered &= FCString::Atoi(*Tokens[1]) == NextStep;
+		NextStep++;
+	}
+
+	VSP_EXPECT_TRUE(bOrdered);
+	VSP_EXPECT_EQ(NextStep, ChainLength);
+
+	RestoreAsyncLog();
+	IFileManager::Get().Delete(*FilePath);
+
+	return true;
+}
+
+VSP_TEST(VSPAsyncLog, ThroughputAndLatency, BenchmarkFlags)
+{
+	using namespace VSPAsyncLogTestLocal;
+
+	constexpr int32 MessagesPerThread = 10000;
+	FVSPAsyncLog& AsyncLog = FVSPAsyncLog::Get();
+
+	AsyncLog.Stop();
+	const double SyncStartTime = FPlatformTime::Seconds();
+	const FThreadTimings SyncTimings = LogFromThreads(MessagesPerThread);
+	const double SyncDuration = FPlatformTime::Seconds() - SyncStartTime;
+
+	FVSPAsyncLogSettings Settings;
+	Settings.OverflowPolicy = EVSPAsyncLogOverflowPolicy::Block;
+	AsyncLog.Start(Settings);
+	const double AsyncStartTime = FPlatformTime::Seconds();
+	const FThreadTimings AsyncTimings = LogFromThreads(MessagesPerThread);
+	const double AsyncProducersDuration = FPlatformTime::Seconds() - AsyncStartTime;
+	AsyncLog.Flush();
+	const double AsyncDuration = FPlatformTime::Seconds() - AsyncStartTime;
+
+	RestoreAsyncLog();
+
+	constexpr int32 MessagesNum = ThreadsNum * MessagesPerThread;
+	AddInfo(FString::Printf(
+		TEXT("Sync: %d messages from %d threads in %.3f s, %.2f us per call on average, %.2f us max"),
+		MessagesNum,
+		ThreadsNum,
+		SyncDuration,
+		SyncTimings.TotalSec / MessagesNum * 1000000.0,
+		SyncTimings.MaxCallSec * 1000000.0));
+	AddInfo(FString::Printf(
+		TEXT("Async: producers done in %.3f s, written in %.3f s, %.2f us per call on average, %.2f us max"),
+		AsyncProducersDuration,
+		AsyncDuration,
+		AsyncTimings.TotalSec / MessagesNum * 1000000.0,
+		AsyncTimings.MaxCallSec * 1000000.0));
+
+	return true;
+}
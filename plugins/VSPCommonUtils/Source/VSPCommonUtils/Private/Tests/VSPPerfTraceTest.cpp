@@ -0,0 +1,121 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPPerfTrace.h"
+#include "VSPTests.h"
+
+#if UE_TRACE_ENABLED && ENABLE_NAMED_EVENTS
+
+static constexpr int TestsFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+
+namespace VSPPerfTraceTestLocal
+{
+	constexpr int32 IterationsNum = 1000000;
+
+	FORCENOINLINE void ScopeWithArgs(int32 Index, const FString& Label)
+	{
+		VSP_PERF_SCOPE_FCLASS_F(FVSPPerfTraceTest, "%d %s", Index, Label);
+	}
+
+	// The way scopes were built before: name is formatted on every call
+	FORCENOINLINE void PrintfBaseline(int32 Index, const FString& Label)
+	{
+		const FString Name = FString::Printf(TEXT("VSP_FVSPPerfTraceTest_%s %d %s"), ANSI_TO_TCHAR(__func__), Index, *Label);
+		FPlatformMisc::BeginNamedEvent(FColor::Red, *Name);
+		FPlatformMisc::EndNamedEvent();
+	}
+
+	template<typename T_Func>
+	double Measure(T_Func Func)
+	{
+		const FString Label = TEXT("Label");
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < IterationsNum; Index++)
+			Func(Index, Label);
+		return (FPlatformTime::Seconds() - StartTime) * 1000000000.0 / IterationsNum;
+	}
+}
+
+VSP_TEST(VSPPerfTrace, ScopeOverhead, TestsFlags)
+{
+	using namespace VSPPerfTraceTestLocal;
+
+	const bool bVSPChannelEnabled = VSPChannel.IsEnabled();
+	const bool bCpuChannelEnabled = CpuChannel.IsEnabled();
+
+	VSPChannel.Toggle(false);
+	const double DisabledTime = Measure(&ScopeWithArgs);
+
+	VSPChannel.Toggle(true);
+	CpuChannel.Toggle(true);
+	const double EnabledTime = Measure(&ScopeWithArgs);
+
+	const double BaselineTime = Measure(&PrintfBaseline);
+
+	VSPChannel.Toggle(bVSPChannelEnabled);
+	CpuChannel.Toggle(bCpuChannelEnabled);
+
+	AddInfo(FString::Printf(
+		TEXT("%d iterations: disabled %.2f ns, enabled %.2f ns, printf baseline %.2f ns per scope"),
+		IterationsNum,
+		DisabledTime,
+		EnabledTime,
+		BaselineTime));
+
+	return true;
+}
+
+VSP_TEST(VSPPerfTrace, ScopeSpec, TestsFlags)
+{
+	using namespace VSPPerfTraceDetails;
+
+	const bool bVSPChannelEnabled = VSPChannel.IsEnabled();
+	const bool bCpuChannelEnabled = CpuChannel.IsEnabled();
+
+	FScopeSpec Spec;
+	int32 NameBuilds = 0;
+	auto NameBuilder = [&NameBuilds]()
+	{
+		NameBuilds++;
+		return FString(TEXT("VSP_FVSPPerfTraceTest_ScopeSpec"));
+	};
+
+	// the name is needed by the named event even while tracing is off, the trace spec is not
+	VSPChannel.Toggle(false);
+	{
+		const FScope Scope(Spec, NameBuilder, TEXT("%d"), 1);
+	}
+	{
+		const FScope Scope(Spec, NameBuilder, TEXT("%d"), 2);
+	}
+	VSP_EXPECT_EQ(NameBuilds, 1);
+	VSP_EXPECT_TRUE(FCString::Strcmp(Spec.Name.Load(), TEXT("VSP_FVSPPerfTraceTest_ScopeSpec")) == 0);
+	VSP_EXPECT_EQ(Spec.Id.Load(), 0u);
+
+	VSPChannel.Toggle(true);
+	CpuChannel.Toggle(true);
+	{
+		const FScope Scope(Spec, NameBuilder, TEXT("%d"), 3);
+	}
+	VSP_EXPECT_EQ(NameBuilds, 1);
+	VSP_EXPECT_TRUE(Spec.Id.Load() != 0u);
+
+	VSPChannel.Toggle(bVSPChannelEnabled);
+	CpuChannel.Toggle(bCpuChannelEnabled);
+
+	return true;
+}
+
+#endif
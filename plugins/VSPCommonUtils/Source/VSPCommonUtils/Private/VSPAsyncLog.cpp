@@ -0,0 +1,338 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPAsyncLog.h"
+
+#include "Algo/Sort.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "LogVSPDefault.h"
+#include "Misc/OutputDeviceHelper.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarVSPLogAsync(
+	TEXT("vsp.Log.Async"),
+	0,
+	TEXT("Write VSP_LOG messages from the background thread\n")
+	TEXT("0: off\n")
+	TEXT("1: on"));
+
+static TAutoConsoleVariable<int32> CVarVSPLogAsyncOverflowPolicy(
+	TEXT("vsp.Log.AsyncOverflowPolicy"),
+	static_cast<int32>(EVSPAsyncLogOverflowPolicy::Count),
+	TEXT("What a logging thread does when its async log buffer is full\n")
+	TEXT("0: drop the message\n")
+	TEXT("1: wait for the flusher\n")
+	TEXT("2: drop the message and report the number of dropped messages"));
+
+static TAutoConsoleVariable<int32> CVarVSPLogAsyncBufferCapacity(
+	TEXT("vsp.Log.AsyncBufferCapacity"),
+	1024,
+	TEXT("Number of async log messages buffered per logging thread"));
+
+static TAutoConsoleVariable<FString> CVarVSPLogAsyncFile(
+	TEXT("vsp.Log.AsyncFile"),
+	TEXT(""),
+	TEXT("Write async log messages to this file instead of the main log"));
+
+TAtomic<bool> FVSPAsyncLog::bEnabled { false };
+
+struct FVSPAsyncLog::FRecord
+{
+	uint64 Sequence = 0;
+	double Time = 0.0;
+	FName Category;
+	ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
+	// keeps its allocation between records
+	FString Message;
+};
+
+// Single producer (the owning thread), single consumer (the flusher) ring buffer
+struct FVSPAsyncLog::FThreadBuffer
+{
+	explicit FThreadBuffer(int32 Capacity)
+	{
+		Records.SetNum(FMath::RoundUpToPowerOfTwo(FMath::Max(Capacity, 2)));
+		Mask = Records.Num() - 1;
+	}
+
+	TArray<FRecord> Records;
+	uint32 Mask = 0;
+	// next record to write, advanced by the producer
+	TAtomic<uint32> Head { 0 };
+	// next record to read, advanced by the flusher after the record is written
+	TAtomic<uint32> Tail { 0 };
+	// lower bound of the sequence the producer is claiming, MAX_uint64 while it isn't pushing
+	TAtomic<uint64> PendingSequence { MAX_uint64 };
+	// set when the owning thread exits, the buffer is released after draining
+	TAtomic<bool> bOrphan { false };
+};
+
+FVSPAsyncLog& FVSPAsyncLog::Get()
+{
+	static FVSPAsyncLog Instance;
+	return Instance;
+}
+
+void FVSPAsyncLog::BindConsoleVariables()
+{
+	const auto Apply = [](IConsoleVariable*)
+	{
+		FVSPAsyncLog& AsyncLog = Get();
+		if (CVarVSPLogAsync.GetValueOnGameThread() == 0)
+		{
+			AsyncLog.Stop();
+			return;
+		}
+
+		FVSPAsyncLogSettings NewSettings;
+		NewSettings.ThreadBufferCapacity = CVarVSPLogAsyncBufferCapacity.GetValueOnGameThread();
+		NewSettings.OverflowPolicy = static_cast<EVSPAsyncLogOverflowPolicy>(FMath::Clamp(
+			CVarVSPLogAsyncOverflowPolicy.GetValueOnGameThread(),
+			static_cast<int32>(EVSPAsyncLogOverflowPolicy::Drop),
+			static_cast<int32>(EVSPAsyncLogOverflowPolicy::Count)));
+		NewSettings.FilePath = CVarVSPLogAsyncFile.GetValueOnGameThread();
+		AsyncLog.Start(NewSettings);
+	};
+
+	CVarVSPLogAsync.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(Apply));
+	CVarVSPLogAsyncOverflowPolicy.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(Apply));
+	CVarVSPLogAsyncBufferCapacity.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(Apply));
+	CVarVSPLogAsyncFile.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(Apply));
+	Apply(nullptr);
+}
+
+FVSPAsyncLog::~FVSPAsyncLog()
+{
+	// WakeEvent is not returned to the pool, the pool may be already destroyed at this point
+	Stop();
+}
+
+void FVSPAsyncLog::Start(const FVSPAsyncLogSettings& InSettings)
+{
+	check(IsInGameThread());
+	Stop();
+
+	{
+		FScopeLock BuffersLock(&BuffersMutex);
+		Settings = InSettings;
+	}
+	OverflowPolicy = Settings.OverflowPolicy;
+
+	if (!Settings.FilePath.IsEmpty())
+	{
+		FileWriter.Reset(
+			IFileManager::Get().CreateFileWriter(*Settings.FilePath, FILEWRITE_AllowRead | FILEWRITE_Append));
+		if (!FileWriter)
+			UE_LOG(LogVSPDefault, Error, TEXT("Can't open async log file %s, main log is used"), *Settings.FilePath);
+	}
+
+	if (!WakeEvent)
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+
+	bStopping = false;
+	Thread.Reset(FRunnableThread::Create(this, TEXT("VSPAsyncLog"), 0, TPri_BelowNormal));
+	bEnabled = true;
+}
+
+void FVSPAsyncLog::Stop()
+{
+	if (!Thread)
+		return;
+
+	bEnabled = false;
+	bStopping = true;
+	WakeEvent->Trigger();
+	Thread->WaitForCompletion();
+	Thread.Reset();
+	FileWriter.Reset();
+}
+
+void FVSPAsyncLog::Flush()
+{
+	const int64 NumToWrite = NumPushed.Load();
+	while (Thread && NumWritten.Load() < NumToWrite)
+	{
+		WakeEvent->Trigger();
+		FPlatformProcess::Sleep(0.0005f);
+	}
+}
+
+FVSPAsyncLog::FThreadBuffer& FVSPAsyncLog::GetThreadBuffer()
+{
+	struct FThreadBufferHolder
+	{
+		~FThreadBufferHolder()
+		{
+			if (Buffer)
+				Buffer->bOrphan = true;
+		}
+
+		TSharedPtr<FThreadBuffer, ESPMode::ThreadSafe> Buffer;
+	};
+	thread_local FThreadBufferHolder Holder;
+
+	if (!Holder.Buffer)
+	{
+		FScopeLock BuffersLock(&BuffersMutex);
+		Holder.Buffer = MakeShared<FThreadBuffer, ESPMode::ThreadSafe>(Settings.ThreadBufferCapacity);
+		Buffers.Add(Holder.Buffer);
+	}
+	return *Holder.Buffer;
+}
+
+bool FVSPAsyncLog::Push(const FName& Category, ELogVerbosity::Type Verbosity, const TCHAR* Message)
+{
+	FThreadBuffer& Buffer = GetThreadBuffer();
+	const uint32 Head = Buffer.Head.Load(EMemoryOrder::Relaxed);
+
+	while (Head - Buffer.Tail.Load() > Buffer.Mask)
+	{
+		if (OverflowPolicy.Load(EMemoryOrder::Relaxed) != EVSPAsyncLogOverflowPolicy::Block || !IsEnabled())
+		{
+			NumDropped++;
+			return false;
+		}
+
+		WakeEvent->Trigger();
+		FPlatformProcess::Yield();
+	}
+
+	// the flusher holds back records at or above the pending sequence until this one is published
+	Buffer.PendingSequence = NextSequence.Load();
+
+	FRecord& Record = Buffer.Records[Head & Buffer.Mask];
+	Record.Sequence = NextSequence++;
+	Record.Time = FPlatformTime::Seconds() - GStartTime;
+	Record.Category = Category;
+	Record.Verbosity = Verbosity;
+	Record.Message.Reset();
+	Record.Message += Message;
+
+	Buffer.Head = Head + 1;
+	Buffer.PendingSequence = MAX_uint64;
+	NumPushed++;
+	return true;
+}
+
+uint32 FVSPAsyncLog::Run()
+{
+	while (!bStopping)
+	{
+		WakeEvent->Wait(FTimespan::FromSeconds(Settings.FlushIntervalSec));
+		WriteBatch();
+	}
+
+	while (WriteBatch() > 0)
+	{
+	}
+	return 0;
+}
+
+int32 FVSPAsyncLog::WriteBatch()
+{
+	{
+		// only the flusher removes buffers, so the collected pointers stay valid without the lock
+		FScopeLock BuffersLock(&BuffersMutex);
+		Buffers.RemoveAll(
+			[](const TSharedPtr<FThreadBuffer, ESPMode::ThreadSafe>& Buffer)
+			{
+				return Buffer->bOrphan && Buffer->Head.Load() == Buffer->Tail.Load();
+			});
+
+		BatchBuffers.Reset();
+		for (const TSharedPtr<FThreadBuffer, ESPMode::ThreadSafe>& Buffer : Buffers)
+			BatchBuffers.Add(Buffer.Get());
+	}
+
+	// Sequences below the limit are all published: later claims get at least the current NextSequence,
+	// earlier unpublished ones are bounded by PendingSequence of their buffers.
+	uint64 SequenceLimit = NextSequence.Load();
+	for (const FThreadBuffer* Buffer : BatchBuffers)
+		SequenceLimit = FMath::Min(SequenceLimit, Buffer->PendingSequence.Load());
+
+	TArray<uint32, TInlineAllocator<64>> BatchHeads;
+	BatchRecords.Reset();
+	for (FThreadBuffer* Buffer : BatchBuffers)
+	{
+		const uint32 Head = Buffer->Head.Load();
+		uint32 Index = Buffer->Tail.Load(EMemoryOrder::Relaxed);
+		for (; Index != Head && Buffer->Records[Index & Buffer->Mask].Sequence < SequenceLimit; Index++)
+			BatchRecords.Add(&Buffer->Records[Index & Buffer->Mask]);
+		BatchHeads.Add(Index);
+	}
+
+	if (BatchRecords.Num() == 0)
+		return 0;
+
+	// per thread records are ordered already, restore the order between threads
+	Algo::SortBy(
+		BatchRecords,
+		[](const FRecord* Record)
+		{
+			return Record->Sequence;
+		});
+
+	if (FileWriter)
+	{
+		BatchText.Reset();
+		for (const FRecord* Record : BatchRecords)
+		{
+			BatchText += FOutputDeviceHelper::FormatLogLine(
+				Record->Verbosity,
+				Record->Category,
+				*Record->Message,
+				GPrintLogTimes,
+				Record->Time);
+			BatchText += LINE_TERMINATOR;
+		}
+
+		FTCHARToUTF8 BatchTextUTF8(*BatchText, BatchText.Len());
+		FileWriter->Serialize(const_cast<ANSICHAR*>(BatchTextUTF8.Get()), BatchTextUTF8.Length());
+		FileWriter->Flush();
+	}
+	else
+	{
+		for (const FRecord* Record : BatchRecords)
+			GLog->Serialize(*Record->Message, Record->Verbosity, Record->Category, Record->Time);
+	}
+
+	// records are written, slots may be reused
+	for (int32 Index = 0; Index < BatchBuffers.Num(); Index++)
+		BatchBuffers[Index]->Tail = BatchHeads[Index];
+
+	NumWritten += BatchRecords.Num();
+	ReportDropped();
+	return BatchRecords.Num();
+}
+
+void FVSPAsyncLog::ReportDropped()
+{
+	if (OverflowPolicy.Load(EMemoryOrder::Relaxed) != EVSPAsyncLogOverflowPolicy::Count)
+		return;
+
+	const int64 NumDroppedNow = NumDropped.Load();
+	if (NumDroppedNow == NumReportedDropped)
+		return;
+
+	UE_LOG(
+		LogVSPDefault,
+		Warning,
+		TEXT("VSPAsyncLog: %lld messages are dropped because of full buffers, %lld in total"),
+		NumDroppedNow - NumReportedDropped,
+		NumDroppedNow);
+	NumReportedDropped = NumDroppedNow;
+}
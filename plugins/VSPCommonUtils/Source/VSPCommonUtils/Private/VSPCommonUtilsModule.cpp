@@ -15,6 +15,8 @@
 */ 
 #include "VSPCommonUtilsModule.h"
 
+#include "VSPAsyncLog.h"
+
 /*
 #ifndef VSP_DEBUG_ENABLED
 	#error VSP_DEBUG_ENABLED definition missing, check *.Target.cs
@@ -34,10 +36,12 @@
 */
 void FVSPCommonUtilsModule::StartupModule()
 {
+	FVSPAsyncLog::BindConsoleVariables();
 }
 
 void FVSPCommonUtilsModule::ShutdownModule()
 {
+	FVSPAsyncLog::Get().Stop();
 }
 
 // Empty module class is used intentionally as a template for future plugin expansion.
@@ -15,6 +15,8 @@
 */ 
 #include "VSPPerfTrace.h"
 
+#include "Misc/ScopeLock.h"
+
 
 #if ENABLE_NAMED_EVENTS
 
@@ -22,3 +24,87 @@ UE_TRACE_CHANNEL_DEFINE(VSPChannel);
 UE_TRACE_CHANNEL_DEFINE(VSPUEChannel);
 
 #endif
+
+#if UE_TRACE_ENABLED
+
+// Sent once per call site, binds VSP_ScopeArgs attachments to the format string
+VSP_PERF_SCOPE_META_BEGIN(ScopeSpec)
+VSP_PERF_SCOPE_META_FIELD(uint32, SpecId)
+VSP_PERF_SCOPE_META_FIELD(Trace::WideString, Name)
+VSP_PERF_SCOPE_META_FIELD(Trace::WideString, Format)
+VSP_PERF_SCOPE_META_END()
+
+// Sent right after the scope begin event on the same thread
+VSP_PERF_SCOPE_META_BEGIN(ScopeArgs)
+VSP_PERF_SCOPE_META_FIELD(uint32, SpecId)
+VSP_PERF_SCOPE_META_FIELD(uint64, Cycle)
+VSP_PERF_SCOPE_META_FIELD(int64[], Ints)
+VSP_PERF_SCOPE_META_FIELD(double[], Floats)
+VSP_PERF_SCOPE_META_FIELD(Trace::WideString, Strings)
+VSP_PERF_SCOPE_META_END()
+
+namespace VSPPerfTraceDetails
+{
+	const TCHAR* RegisterScopeName(FScopeSpec& Spec, const FString& Name)
+	{
+		static FCriticalSection RegisterMutex;
+		// specs are function local statics, so their names are never released
+		static TArray<TUniquePtr<FString>> Names;
+
+		FScopeLock RegisterLock(&RegisterMutex);
+		const TCHAR* SpecName = Spec.Name.Load();
+		if (SpecName != nullptr)
+			return SpecName;
+
+		SpecName = **Names.Add_GetRef(MakeUnique<FString>(Name));
+		Spec.Name.Store(SpecName);
+		return SpecName;
+	}
+
+	uint32 RegisterScopeSpec(FScopeSpec& Spec, const TCHAR* Format)
+	{
+		static FCriticalSection RegisterMutex;
+
+		FScopeLock RegisterLock(&RegisterMutex);
+		uint32 SpecId = Spec.Id.Load();
+		if (SpecId != 0)
+			return SpecId;
+
+		const TCHAR* SpecName = Spec.Name.Load();
+		SpecId = FCpuProfilerTrace::OutputEventType(SpecName);
+
+		const TCHAR* SpecFormat = Format ? Format : TEXT("");
+		const int32 NameLen = FCString::Strlen(SpecName);
+		const int32 FormatLen = FCString::Strlen(SpecFormat);
+		UE_TRACE_LOG(Cpu, VSP_ScopeSpec, VSPChannel, (NameLen + FormatLen) * sizeof(TCHAR))
+			<< VSP_ScopeSpec.SpecId(SpecId) << VSP_ScopeSpec.Name(SpecName, NameLen)
+			<< VSP_ScopeSpec.Format(SpecFormat, FormatLen);
+
+		Spec.Id.Store(SpecId);
+		return SpecId;
+	}
+
+	void BeginScope(const FScopeSpec& Spec)
+	{
+		FCpuProfilerTrace::OutputBeginEvent(Spec.Id.Load());
+	}
+
+	void EndScope()
+	{
+		FCpuProfilerTrace::OutputEndEvent();
+	}
+
+	void OutputScopeArgs(uint32 SpecId, const FScopeArgs& Args)
+	{
+		const int32 StringsLen = Args.Strings.Len();
+		const uint32 ExtraSize =
+			Args.Ints.Num() * sizeof(int64) + Args.Floats.Num() * sizeof(double) + StringsLen * sizeof(TCHAR);
+		UE_TRACE_LOG(Cpu, VSP_ScopeArgs, VSPChannel, ExtraSize)
+			<< VSP_ScopeArgs.SpecId(SpecId) << VSP_ScopeArgs.Cycle(FPlatformTime::Cycles64())
+			<< VSP_ScopeArgs.Ints(Args.Ints.GetData(), Args.Ints.Num())
+			<< VSP_ScopeArgs.Floats(Args.Floats.GetData(), Args.Floats.Num())
+			<< VSP_ScopeArgs.Strings(Args.Strings.ToString(), StringsLen);
+	}
+}
+
+#endif
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "Logging/LogVerbosity.h"
+#include "VSPAsyncLog.h"
 #include "VSPFormat.h"
 
 namespace VSPLogDetails
@@ -103,6 +104,18 @@ namespace VSPLogDetails
 		return VerbosityLength;
 	}
 
+	template<ELogVerbosity::Type Verbosity>
+	FORCEINLINE bool IsAsyncLogEnabled()
+	{
+		// fatal errors must stop the execution right away, compiled out messages are handled by _UE_LOG
+		if constexpr (
+			(Verbosity & ELogVerbosity::VerbosityMask) == ELogVerbosity::Fatal ||
+			(Verbosity & ELogVerbosity::VerbosityMask) > ELogVerbosity::COMPILED_IN_MINIMUM_VERBOSITY)
+			return false;
+		else
+			return FVSPAsyncLog::IsEnabled();
+	}
+
 	inline static FString& GetMessageBuffer()
 	{
 		// optimization to reduce number of allocations
@@ -0,0 +1,163 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+#include "Containers/StringConv.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/StringBuilder.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// VSPChannel is declared in VSPPerfTrace.h, use it instead of this header
+
+namespace VSPPerfTraceDetails
+{
+	/**
+	 * @brief   Per call site scope description. Must be a function local static, it's zero initialized.
+	 *          Name is filled on the first scope entering, Id on the first one with enabled channel.
+	 */
+	struct FScopeSpec
+	{
+		// 0 until registered in the CPU profiler trace
+		TAtomic<uint32> Id { 0 };
+		// Scope name, lives as long as the process
+		TAtomic<const TCHAR*> Name { nullptr };
+	};
+
+	/**
+	 * @brief   Dynamic scope arguments grouped by type. They are sent as a trace attachment
+	 *          of the scope instead of being formatted into the scope name.
+	 */
+	struct FScopeArgs
+	{
+		TArray<int64, TInlineAllocator<8>> Ints;
+		TArray<double, TInlineAllocator<8>> Floats;
+		// '\n' separated
+		TStringBuilder<256> Strings;
+	};
+
+	template<class ArgType>
+	typename TEnableIf<TIsArithmetic<ArgType>::Value || TIsEnum<ArgType>::Value>::Type AddArg(
+		FScopeArgs& Args,
+		ArgType Arg)
+	{
+		if constexpr (TIsFloatingPoint<ArgType>::Value)
+			Args.Floats.Add(Arg);
+		else
+			Args.Ints.Add(static_cast<int64>(Arg));
+	}
+
+	inline void AddArg(FScopeArgs& Args, const TCHAR* Arg)
+	{
+		Args.Strings.Append(Arg ? Arg : TEXT("nullptr"));
+		Args.Strings.AppendChar(TEXT('\n'));
+	}
+
+	inline void AddArg(FScopeArgs& Args, TCHAR* Arg)
+	{
+		AddArg(Args, static_cast<const TCHAR*>(Arg));
+	}
+
+	inline void AddArg(FScopeArgs& Args, const ANSICHAR* Arg)
+	{
+		AddArg(Args, Arg ? ANSI_TO_TCHAR(Arg) : nullptr);
+	}
+
+	inline void AddArg(FScopeArgs& Args, const FString& Arg)
+	{
+		AddArg(Args, *Arg);
+	}
+
+	inline void AddArg(FScopeArgs& Args, const FName& Arg)
+	{
+		AddArg(Args, *Arg.ToString());
+	}
+
+	inline void AddArg(FScopeArgs& Args, const void* Arg)
+	{
+		Args.Ints.Add(static_cast<int64>(reinterpret_cast<UPTRINT>(Arg)));
+	}
+
+	// Stores the scope name once. Thread safe.
+	VSPCOMMONUTILS_API const TCHAR* RegisterScopeName(FScopeSpec& Spec, const FString& Name);
+	// Registers the scope name and format in the trace once. Thread safe.
+	VSPCOMMONUTILS_API uint32 RegisterScopeSpec(FScopeSpec& Spec, const TCHAR* Format);
+	VSPCOMMONUTILS_API void BeginScope(const FScopeSpec& Spec);
+	VSPCOMMONUTILS_API void EndScope();
+	VSPCOMMONUTILS_API void OutputScopeArgs(uint32 SpecId, const FScopeArgs& Args);
+
+	/**
+	 * @brief   RAII perf scope. Always emits a platform named event, like FScopedNamedEvent does;
+	 *          scope name is built once per call site, arguments are collected only for enabled channel.
+	 */
+	class FScope
+	{
+	public:
+		template<class NameBuilderType, class... ArgsType>
+		FORCEINLINE FScope(
+			FScopeSpec& Spec,
+			NameBuilderType&& NameBuilder,
+			const TCHAR* Format,
+			const ArgsType&... Args)
+		{
+			const TCHAR* Name = Spec.Name.Load();
+			if (Name == nullptr)
+				Name = RegisterScopeName(Spec, NameBuilder());
+
+#if ENABLE_NAMED_EVENTS
+			FPlatformMisc::BeginNamedEvent(FColor::Red, Name);
+#endif
+
+			if (UE_TRACE_CHANNELEXPR_IS_ENABLED(VSPChannel | CpuChannel))
+			{
+				Begin(Spec, Format, Args...);
+			}
+		}
+
+		FORCEINLINE ~FScope()
+		{
+			if (bStarted)
+				EndScope();
+
+#if ENABLE_NAMED_EVENTS
+			FPlatformMisc::EndNamedEvent();
+#endif
+		}
+
+		FScope(const FScope&) = delete;
+		FScope& operator=(const FScope&) = delete;
+
+	private:
+		template<class... ArgsType>
+		FORCENOINLINE void Begin(FScopeSpec& Spec, const TCHAR* Format, const ArgsType&... Args)
+		{
+			uint32 SpecId = Spec.Id.Load();
+			if (SpecId == 0)
+				SpecId = RegisterScopeSpec(Spec, Format);
+
+			BeginScope(Spec);
+			bStarted = true;
+
+			if constexpr (sizeof...(ArgsType) > 0)
+			{
+				FScopeArgs ScopeArgs;
+				(AddArg(ScopeArgs, Args), ...);
+				OutputScopeArgs(SpecId, ScopeArgs);
+			}
+		}
+
+		bool bStarted = false;
+	};
+}
@@ -0,0 +1,122 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+class FRunnableThread;
+
+/** What a logging thread does when its record buffer is full */
+enum class EVSPAsyncLogOverflowPolicy : uint8
+{
+	// record is discarded silently
+	Drop,
+	// logging thread waits for the flusher
+	Block,
+	// record is discarded, flusher reports the number of discarded records
+	Count,
+};
+
+struct FVSPAsyncLogSettings
+{
+	// records per logging thread, rounded up to the power of two
+	// applied to threads which log for the first time after Start()
+	int32 ThreadBufferCapacity = 1024;
+	EVSPAsyncLogOverflowPolicy OverflowPolicy = EVSPAsyncLogOverflowPolicy::Count;
+	// records are written to GLog if empty
+	FString FilePath;
+	float FlushIntervalSec = 0.005f;
+};
+
+/**
+ * @brief     Opt-in asynchronous backend for VSP_LOG.
+ * @details   Every logging thread pushes pre-formatted records into its own lock-free ring buffer,
+ *            the flusher thread writes them in batches to GLog or to a file keeping the global order.
+ *            Fatal messages are always logged synchronously.
+ *            May be enabled with vsp.Log.Async console variable.
+ */
+class VSPCOMMONUTILS_API FVSPAsyncLog : public FRunnable
+{
+public:
+	static FVSPAsyncLog& Get();
+
+	// Starts or stops the backend according to vsp.Log.Async* console variables and follows their changes
+	static void BindConsoleVariables();
+
+	static bool IsEnabled()
+	{
+		return bEnabled.Load(EMemoryOrder::Relaxed);
+	}
+
+	// Game thread only, restarts the flusher if it's running
+	void Start(const FVSPAsyncLogSettings& InSettings);
+	// Writes all pushed records and stops the flusher thread
+	void Stop();
+	// Blocks until all records pushed before the call are written
+	void Flush();
+
+	// Returns false if the record was discarded by the overflow policy
+	bool Push(const FName& Category, ELogVerbosity::Type Verbosity, const TCHAR* Message);
+
+	int64 GetNumWritten() const
+	{
+		return NumWritten.Load();
+	}
+
+	int64 GetNumDropped() const
+	{
+		return NumDropped.Load();
+	}
+
+	virtual uint32 Run() override;
+
+private:
+	struct FRecord;
+	struct FThreadBuffer;
+
+	FVSPAsyncLog() = default;
+	virtual ~FVSPAsyncLog() override;
+
+	FThreadBuffer& GetThreadBuffer();
+	// Returns number of written records
+	int32 WriteBatch();
+	void ReportDropped();
+
+	static TAtomic<bool> bEnabled;
+
+	FVSPAsyncLogSettings Settings;
+	// read by the logging threads, copied from Settings by Start()
+	TAtomic<EVSPAsyncLogOverflowPolicy> OverflowPolicy { EVSPAsyncLogOverflowPolicy::Count };
+	TUniquePtr<FRunnableThread> Thread;
+	FEvent* WakeEvent = nullptr;
+	TAtomic<bool> bStopping { false };
+
+	FCriticalSection BuffersMutex;
+	TArray<TSharedPtr<FThreadBuffer, ESPMode::ThreadSafe>> Buffers;
+
+	// written by the flusher thread only
+	TArray<FThreadBuffer*> BatchBuffers;
+	TArray<FRecord*> BatchRecords;
+	FString BatchText;
+	TUniquePtr<FArchive> FileWriter;
+	int64 NumReportedDropped = 0;
+
+	TAtomic<uint64> NextSequence { 0 };
+	TAtomic<int64> NumPushed { 0 };
+	TAtomic<int64> NumWritten { 0 };
+	TAtomic<int64> NumDropped { 0 };
+};
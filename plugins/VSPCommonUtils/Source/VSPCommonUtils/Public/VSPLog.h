@@ -18,6 +18,15 @@
 #include "Details/VSPLogDetails.h"
 #include "FileCategory.h"
 
+#define _VSP_LOG_CREATE_MESSAGE(Category, Verbosity, Format, ...)                                    \
+	VSPLogDetails::FLogMessageCreator<_FormatArray>::CreateLogMessage<ELogVerbosity::Verbosity>( \
+		ANSI_TO_TCHAR(__FUNCTION__),                                                            \
+		ANSI_TO_TCHAR(__FILE__),                                                                \
+		__LINE__,                                                                               \
+		Category,                                                                               \
+		FMT_COMPILE(TEXT(Format)),                                                              \
+		##__VA_ARGS__)
+
 /**
  * @brief     VSP project version of UE_LOG. Prints the user's message to the log file and console.
  * @details   Has the following advantages over the default macro:
@@ -25,22 +34,28 @@
  *            - Uses VSPFormat as default formatter instead of sprintf
  *            - Checks number of passed arguments, arguments types and format string at compile time
  *            - Aligns messages to make them easier to read
+ *            - Doesn't block on the log output if FVSPAsyncLog is enabled
  */
-#define VSP_LOG_C(Category, Verbosity, Format, ...)                                                      \
-	do                                                                                                  \
-	{                                                                                                   \
-		static constexpr const TCHAR _FormatArray[] = TEXT(Format);                                     \
-		_UE_LOG(                                                                                        \
-			Category,                                                                                   \
-			ELogVerbosity::Verbosity,                                                                   \
-			TEXT("%s"),                                                                                 \
-			VSPLogDetails::FLogMessageCreator<_FormatArray>::CreateLogMessage<ELogVerbosity::Verbosity>( \
-				ANSI_TO_TCHAR(__FUNCTION__),                                                            \
-				ANSI_TO_TCHAR(__FILE__),                                                                \
-				__LINE__,                                                                               \
-				Category,                                                                               \
-				FMT_COMPILE(TEXT(Format)),                                                              \
-				##__VA_ARGS__));                                                                        \
+#define VSP_LOG_C(Category, Verbosity, Format, ...)                                                \
+	do                                                                                            \
+	{                                                                                             \
+		static constexpr const TCHAR _FormatArray[] = TEXT(Format);                               \
+		if (VSPLogDetails::IsAsyncLogEnabled<ELogVerbosity::Verbosity>())                         \
+		{                                                                                         \
+			if (!Category.IsSuppressed(ELogVerbosity::Verbosity))                                 \
+				FVSPAsyncLog::Get().Push(                                                         \
+					Category.GetCategoryName(),                                                   \
+					ELogVerbosity::Verbosity,                                                     \
+					_VSP_LOG_CREATE_MESSAGE(Category, Verbosity, Format, ##__VA_ARGS__));         \
+		}                                                                                         \
+		else                                                                                      \
+		{                                                                                         \
+			_UE_LOG(                                                                              \
+				Category,                                                                         \
+				ELogVerbosity::Verbosity,                                                         \
+				TEXT("%s"),                                                                       \
+				_VSP_LOG_CREATE_MESSAGE(Category, Verbosity, Format, ##__VA_ARGS__));             \
+		}                                                                                         \
 	} while (false)
 
 /**
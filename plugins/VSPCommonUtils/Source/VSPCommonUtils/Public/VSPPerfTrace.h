@@ -45,27 +45,37 @@ UE_TRACE_CHANNEL_EXTERN(VSPUEChannel, VSPCOMMONUTILS_API);
 
 
 // bare perf scopes
+// Scope name is registered once per call site, format arguments are sent as typed trace attachment (VSP_ScopeArgs).
+// Nothing is formatted or allocated while VSPChannel is disabled.
 #if UE_TRACE_ENABLED
 
-	#define VSP_PERF_SCOPE_UCLASS()VSP_PERF_SCOPE_PRIVATE(*StaticClass()->GetName(), )
+	#include "Details/VSPPerfTraceDetails.h"
+
+	#define VSP_PERF_SCOPE_UCLASS() VSP_PERF_SCOPE_PRIVATE(StaticClass()->GetName(), TEXT(""))
 	#define VSP_PERF_SCOPE_UCLASS_F(Format, ...) \
-		VSP_PERF_SCOPE_PRIVATE(*StaticClass()->GetName(), " " Format, ##__VA_ARGS__)
+		VSP_PERF_SCOPE_PRIVATE(StaticClass()->GetName(), TEXT(Format), ##__VA_ARGS__)
 
-	#define VSP_PERF_SCOPE_FCLASS(ClassName)VSP_PERF_SCOPE_PRIVATE(TEXT(#ClassName), )
+	#define VSP_PERF_SCOPE_FCLASS(ClassName) VSP_PERF_SCOPE_PRIVATE(FString(TEXT(#ClassName)), TEXT(""))
 	#define VSP_PERF_SCOPE_FCLASS_F(ClassName, Format, ...) \
-		VSP_PERF_SCOPE_PRIVATE(TEXT(#ClassName), " " Format, ##__VA_ARGS__)
-
-	#define VSP_PERF_SCOPE_PRIVATE(ClassName, Format, ...)                                                              \
-		const auto PREPROCESSOR_JOIN(NamedEventText_, __LINE__) =                                                      \
-			FString::Printf(TEXT("VSP_%s_%s" Format), ClassName, ANSI_TO_TCHAR(__func__), ##__VA_ARGS__);               \
-		FScopedNamedEvent ANONYMOUS_VARIABLE(NamedEvent_)(FColor::Red, *PREPROCESSOR_JOIN(NamedEventText_, __LINE__)); \
-		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(*PREPROCESSOR_JOIN(NamedEventText_, __LINE__), VSPChannel)
-
-
-	#define VSP_TRACE_SCOPE_F(Format, ...)                                                                              \
-		const auto PREPROCESSOR_JOIN(NamedEventText_, __LINE__) = FString::Printf(TEXT("VSP_" Format), ##__VA_ARGS__);  \
-		FScopedNamedEvent ANONYMOUS_VARIABLE(NamedEvent_)(FColor::Red, *PREPROCESSOR_JOIN(NamedEventText_, __LINE__)); \
-		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(*PREPROCESSOR_JOIN(NamedEventText_, __LINE__), VSPChannel)
+		VSP_PERF_SCOPE_PRIVATE(FString(TEXT(#ClassName)), TEXT(Format), ##__VA_ARGS__)
+
+	#define VSP_PERF_SCOPE_PRIVATE(ClassNameExpr, Format, ...)                                               \
+		static VSPPerfTraceDetails::FScopeSpec PREPROCESSOR_JOIN(VSPPerfScopeSpec_, __LINE__);             \
+		const VSPPerfTraceDetails::FScope PREPROCESSOR_JOIN(VSPPerfScope_, __LINE__)(                      \
+			PREPROCESSOR_JOIN(VSPPerfScopeSpec_, __LINE__),                                                 \
+			[VSPPerfScopeFunction = __func__]()                                                             \
+			{ return FString::Printf(TEXT("VSP_%s_%s"), *(ClassNameExpr), ANSI_TO_TCHAR(VSPPerfScopeFunction)); }, \
+			Format,                                                                                         \
+			##__VA_ARGS__)
+
+
+	#define VSP_TRACE_SCOPE_F(Format, ...)                                                       \
+		static VSPPerfTraceDetails::FScopeSpec PREPROCESSOR_JOIN(VSPPerfScopeSpec_, __LINE__); \
+		const VSPPerfTraceDetails::FScope PREPROCESSOR_JOIN(VSPPerfScope_, __LINE__)(          \
+			PREPROCESSOR_JOIN(VSPPerfScopeSpec_, __LINE__),                                     \
+			[]() { return FString(TEXT("VSP_" Format)); },                                      \
+			TEXT(Format),                                                                       \
+			##__VA_ARGS__)
 
 
 #else
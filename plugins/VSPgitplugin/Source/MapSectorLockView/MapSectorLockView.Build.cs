@@ -45,6 +45,7 @@ public class MapSectorLockView : ModuleRules
 				"SlateCore",
 				"Json",
 				"JsonUtilities",
+				"VSPTests",
 				// ... add private dependencies that you statically link with here ...
 			}
 			);
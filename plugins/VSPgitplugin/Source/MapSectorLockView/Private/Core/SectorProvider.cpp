@@ -328,10 +328,11 @@ bool FSectorViewModel::IsSelected() const
 
 // FSectorProvider implementation
 
-void FSectorProvider::Initialize()
+void FSectorProvider::Initialize( const FString& InConfigPath )
 {
-	LoadConfig();
+	LoadConfig( InConfigPath.IsEmpty() ? FPaths::Combine( FPaths::ProjectDir(), TEXT( "Tools" ), TEXT( "MapSectorsConfig" ) ) : InConfigPath );
 	//LoadDefaultData();
+	IndexSectorPoints();
 
 	// Data preparation
 	for ( auto&& MapsPair : Maps )
@@ -390,6 +391,7 @@ void FSectorProvider::OnLayerSelectionChanged( TSharedPtr< IListItem > InItem, E
 	SectorsVmList.Empty();
 	DeSelect();
 	SelectedLayer = InItem;
+	TArray< TArray< FVector2D > > Polygons;
 	if ( SelectedLayer.IsValid() )
 		for ( auto&& SectorPair : Sectors )
 		{
@@ -397,14 +399,15 @@ void FSectorProvider::OnLayerSelectionChanged( TSharedPtr< IListItem > InItem, E
 			if ( SectorPair.Value.LayerGuid == SelectedLayerVm->GetGuid() )
 			{
 				TSharedPtr< FSectorViewModel > SectorVm = MakeShareable( new FSectorViewModel( SectorPair.Value ) );
-				TArray< FSectorPoint > Points;
-				for ( auto&& SectorPointPair : SectorPoints )
-					if ( SectorPointPair.Value.SectorGuid == SectorVm->GetSectorGuid() )
-						Points.Add( SectorPointPair.Value );
-				SectorVm->SetPoints( Points );
+				const TArray< FSectorPoint >* Points = PointsBySector.Find( SectorVm->GetSectorGuid() );
+				SectorVm->SetPoints( Points != nullptr ? *Points : TArray< FSectorPoint >() );
+				TArray< FVector2D >& Polygon = Polygons.AddDefaulted_GetRef();
+				for ( const FSectorPoint& Point : SectorVm->GetPoints() )
+					Polygon.Add( Point.Point );
 				SectorsVmList.Add( SectorVm );
 			}
 		}
+	SectorsIndex.Build( Polygons );
 }
 
 TArray< TSharedPtr< FSectorViewModel > >& FSectorProvider::GetSectors()
@@ -464,12 +467,31 @@ bool FSectorProvider::IsSelectedSector( const TSharedPtr< FSectorViewModel >& In
 	return Founded != nullptr;
 }
 
-void FSectorProvider::LoadConfig()
+int32 FSectorProvider::FindSectorIndexAt( const FVector2D& InLocation ) const
+{
+	return SectorsIndex.FindPolygon( InLocation );
+}
+
+TSharedPtr< FSectorViewModel > FSectorProvider::FindSectorAt( const FVector2D& InLocation ) const
+{
+	const int32 SectorIndex = SectorsIndex.FindPolygon( InLocation );
+	return SectorIndex != INDEX_NONE ? SectorsVmList[ SectorIndex ] : nullptr;
+}
+
+void FSectorProvider::FindSectorsAt( const TArray< FVector2D >& InLocations, TArray< TSharedPtr< FSectorViewModel > >& OutSectors ) const
+{
+	TArray< int32 > SectorIndices;
+	SectorsIndex.FindPolygons( InLocations, SectorIndices );
+	OutSectors.Reset( SectorIndices.Num() );
+	for ( const int32 SectorIndex : SectorIndices )
+		OutSectors.Add( SectorIndex != INDEX_NONE ? SectorsVmList[ SectorIndex ] : nullptr );
+}
+
+void FSectorProvider::LoadConfig( const FString& ConfigPath )
 {
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
 	// Check config folder
-	const FString ConfigPath = FPaths::Combine( FPaths::ProjectDir(), TEXT( "Tools" ), TEXT( "MapSectorsConfig" ) );
 	if ( !PlatformFile.DirectoryExists( *ConfigPath ) )
 	UE_LOG( MapSectorLockLog, Error, TEXT("Configuration directory \"%s\" not found."), *ConfigPath );
 
@@ -612,6 +634,14 @@ void FSectorProvider::LoadConfig()
 	}
 }
 
+void FSectorProvider::IndexSectorPoints()
+{
+	// Points of each sector in one pass, selecting a layer then doesn't scan all the points of the map for every sector
+	PointsBySector.Empty();
+	for ( auto&& SectorPointPair : SectorPoints )
+		PointsBySector.FindOrAdd( SectorPointPair.Value.SectorGuid ).Add( SectorPointPair.Value );
+}
+
 // TODO: Remove it. It`s unusable debug function. Now this logic implemented in configs files and in "void LoadData()"
 void FSectorProvider::LoadDefaultData()
 {
@@ -18,6 +18,7 @@
 #include "CoreMinimal.h"
 
 #include "Models.h"
+#include "SectorSpatialIndex.h"
 #include "Widgets/SListWidget.h"
 
 class FMapViewModel : public IListItem
@@ -117,7 +118,8 @@ private:
 class FSectorProvider
 {
 public:
-	void Initialize();
+	/** Load the maps from the config directory, Tools/MapSectorsConfig of the project by default */
+	void Initialize( const FString& InConfigPath = FString() );
 
 	// Maps methods for binding
 	TArray< TSharedPtr< IListItem > >& GetMapsItems();
@@ -137,8 +139,14 @@ public:
 	void RemoveSelection( const TSharedPtr< FSectorViewModel >& InSectorVm );
 	bool IsSelectedSector( const TSharedPtr< FSectorViewModel >& InSectorVm );
 
+	// Sectors of the selected layer under a location, in map coordinates
+	int32 FindSectorIndexAt( const FVector2D& InLocation ) const;
+	TSharedPtr< FSectorViewModel > FindSectorAt( const FVector2D& InLocation ) const;
+	void FindSectorsAt( const TArray< FVector2D >& InLocations, TArray< TSharedPtr< FSectorViewModel > >& OutSectors ) const;
+
 private:
-	void LoadConfig();
+	void LoadConfig( const FString& ConfigPath );
+	void IndexSectorPoints();
 	void LoadDefaultData();
 public: // TODO: Make it private
 	void SaveConfig();
@@ -150,6 +158,7 @@ private:
 	TMap< FGuid, FLayer > Layers;
 	TMap< FGuid, FSector > Sectors;
 	TMap< FGuid, FSectorPoint > SectorPoints;
+	TMap< FGuid, TArray< FSectorPoint > > PointsBySector;
 
 	// Bindable properties
 	TArray< TSharedPtr< IListItem > > MapsItems;
@@ -159,5 +168,6 @@ private:
 	TSharedPtr< IListItem > SelectedLayer = nullptr;
 
 	TArray< TSharedPtr< FSectorViewModel > > SectorsVmList;
+	FSectorSpatialIndex SectorsIndex;
 	TMap< FString, TArray< TSharedPtr< FSectorViewModel > > > SelectedSectorsVm;
 };
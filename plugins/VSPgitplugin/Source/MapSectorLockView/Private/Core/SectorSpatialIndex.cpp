@@ -0,0 +1,167 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "SectorSpatialIndex.h"
+
+#include "Async/ParallelFor.h"
+
+namespace SectorSpatialIndexLocal
+{
+	/** Cells per side at most, whatever the number of sectors */
+	const int32 MaxCellsPerSide = 256;
+	/** Points resolved by one task of FindPolygons */
+	const int32 PointsPerTask = 1024;
+
+	/** FBox2D::IsInside leaves out the edges */
+	bool IsInsideOrOn( const FBox2D& InBox, const FVector2D& InPoint );
+}
+
+bool SectorSpatialIndexLocal::IsInsideOrOn( const FBox2D& InBox, const FVector2D& InPoint )
+{
+	return InBox.bIsValid
+		&& InPoint.X >= InBox.Min.X && InPoint.X <= InBox.Max.X
+		&& InPoint.Y >= InBox.Min.Y && InPoint.Y <= InBox.Max.Y;
+}
+
+void FSectorSpatialIndex::Build( const TArray< TArray< FVector2D > >& InPolygons )
+{
+	Reset();
+
+	Polygons = InPolygons;
+	for ( const TArray< FVector2D >& Polygon : Polygons )
+	{
+		FBox2D PolygonBox( ForceInit );
+		for ( const FVector2D& Point : Polygon )
+			PolygonBox += Point;
+		PolygonBounds.Add( PolygonBox );
+		if ( PolygonBox.bIsValid )
+			Bounds += PolygonBox;
+	}
+	if ( !Bounds.bIsValid )
+		return;
+
+	// About one polygon per cell
+	const int32 CellsPerSide = FMath::Clamp( FMath::CeilToInt( FMath::Sqrt( static_cast< float >( Polygons.Num() ) ) ), 1, SectorSpatialIndexLocal::MaxCellsPerSide );
+	CellsX = CellsPerSide;
+	CellsY = CellsPerSide;
+	const FVector2D BoundsSize = Bounds.GetSize();
+	CellSize = FVector2D(
+		BoundsSize.X > KINDA_SMALL_NUMBER ? BoundsSize.X / CellsX : 1.f,
+		BoundsSize.Y > KINDA_SMALL_NUMBER ? BoundsSize.Y / CellsY : 1.f );
+
+	// Count then fill, the polygons of a cell stay in increasing order
+	TArray< int32 > CellCounts;
+	CellCounts.SetNumZeroed( CellsX * CellsY );
+	TArray< FIntRect > PolygonCells;
+	PolygonCells.SetNum( Polygons.Num() );
+	for ( int32 PolygonIndex = 0; PolygonIndex < Polygons.Num(); PolygonIndex++ )
+	{
+		FIntRect& Cells = PolygonCells[ PolygonIndex ];
+		if ( !PolygonBounds[ PolygonIndex ].bIsValid )
+		{
+			Cells = FIntRect( 0, 0, -1, -1 );
+			continue;
+		}
+		GetCell( PolygonBounds[ PolygonIndex ].Min, Cells.Min.X, Cells.Min.Y );
+		GetCell( PolygonBounds[ PolygonIndex ].Max, Cells.Max.X, Cells.Max.Y );
+		for ( int32 CellY = Cells.Min.Y; CellY <= Cells.Max.Y; CellY++ )
+			for ( int32 CellX = Cells.Min.X; CellX <= Cells.Max.X; CellX++ )
+				CellCounts[ CellY * CellsX + CellX ]++;
+	}
+
+	CellStarts.SetNumUninitialized( CellCounts.Num() + 1 );
+	CellStarts[ 0 ] = 0;
+	for ( int32 CellIndex = 0; CellIndex < CellCounts.Num(); CellIndex++ )
+		CellStarts[ CellIndex + 1 ] = CellStarts[ CellIndex ] + CellCounts[ CellIndex ];
+
+	CellPolygons.SetNumUninitialized( CellStarts.Last() );
+	TArray< int32 > CellFill( CellStarts.GetData(), CellCounts.Num() );
+	for ( int32 PolygonIndex = 0; PolygonIndex < Polygons.Num(); PolygonIndex++ )
+	{
+		const FIntRect& Cells = PolygonCells[ PolygonIndex ];
+		for ( int32 CellY = Cells.Min.Y; CellY <= Cells.Max.Y; CellY++ )
+			for ( int32 CellX = Cells.Min.X; CellX <= Cells.Max.X; CellX++ )
+				CellPolygons[ CellFill[ CellY * CellsX + CellX ]++ ] = PolygonIndex;
+	}
+}
+
+void FSectorSpatialIndex::Reset()
+{
+	Polygons.Empty();
+	PolygonBounds.Empty();
+	Bounds = FBox2D( ForceInit );
+	CellSize = FVector2D::UnitVector;
+	CellsX = 0;
+	CellsY = 0;
+	CellStarts.Empty();
+	CellPolygons.Empty();
+}
+
+int32 FSectorSpatialIndex::FindPolygon( const FVector2D& InPoint ) const
+{
+	int32 CellX, CellY;
+	if ( !GetCell( InPoint, CellX, CellY ) )
+		return INDEX_NONE;
+
+	const int32 CellIndex = CellY * CellsX + CellX;
+	for ( int32 Index = CellStarts[ CellIndex + 1 ] - 1; Index >= CellStarts[ CellIndex ]; Index-- )
+	{
+		const int32 PolygonIndex = CellPolygons[ Index ];
+		if ( SectorSpatialIndexLocal::IsInsideOrOn( PolygonBounds[ PolygonIndex ], InPoint ) && IsPointInPolygon( InPoint, Polygons[ PolygonIndex ] ) )
+			return PolygonIndex;
+	}
+	return INDEX_NONE;
+}
+
+void FSectorSpatialIndex::FindPolygons( const TArray< FVector2D >& InPoints, TArray< int32 >& OutPolygons ) const
+{
+	OutPolygons.SetNumUninitialized( InPoints.Num() );
+	const int32 TaskCount = FMath::DivideAndRoundUp( InPoints.Num(), SectorSpatialIndexLocal::PointsPerTask );
+	ParallelFor(
+		TaskCount,
+		[&]( int32 InTaskIndex )
+		{
+			const int32 First = InTaskIndex * SectorSpatialIndexLocal::PointsPerTask;
+			const int32 Last = FMath::Min( First + SectorSpatialIndexLocal::PointsPerTask, InPoints.Num() );
+			for ( int32 PointIndex = First; PointIndex < Last; PointIndex++ )
+				OutPolygons[ PointIndex ] = FindPolygon( InPoints[ PointIndex ] );
+		},
+		TaskCount <= 1 );
+}
+
+bool FSectorSpatialIndex::IsPointInPolygon( const FVector2D& InPoint, const TArray< FVector2D >& InPolygon )
+{
+	// Even-odd rule: count the edges crossed by a ray going right from the point
+	bool bInside = false;
+	for ( int32 Index = 0, PrevIndex = InPolygon.Num() - 1; Index < InPolygon.Num(); PrevIndex = Index++ )
+	{
+		const FVector2D& Point = InPolygon[ Index ];
+		const FVector2D& PrevPoint = InPolygon[ PrevIndex ];
+		if ( ( Point.Y > InPoint.Y ) != ( PrevPoint.Y > InPoint.Y ) &&
+			InPoint.X < ( PrevPoint.X - Point.X ) * ( InPoint.Y - Point.Y ) / ( PrevPoint.Y - Point.Y ) + Point.X )
+			bInside = !bInside;
+	}
+	return bInside;
+}
+
+bool FSectorSpatialIndex::GetCell( const FVector2D& InPoint, int32& OutCellX, int32& OutCellY ) const
+{
+	if ( CellsX == 0 || !SectorSpatialIndexLocal::IsInsideOrOn( Bounds, InPoint ) )
+		return false;
+
+	OutCellX = FMath::Clamp( FMath::FloorToInt( ( InPoint.X - Bounds.Min.X ) / CellSize.X ), 0, CellsX - 1 );
+	OutCellY = FMath::Clamp( FMath::FloorToInt( ( InPoint.Y - Bounds.Min.Y ) / CellSize.Y ), 0, CellsY - 1 );
+	return true;
+}
@@ -0,0 +1,49 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Uniform grid over the bounds of sector polygons, a point is only tested against the polygons of its cell
+*/
+class FSectorSpatialIndex
+{
+public:
+	/** Index the polygons, the queries return their index in InPolygons */
+	void Build( const TArray< TArray< FVector2D > >& InPolygons );
+	void Reset();
+
+	/** Last polygon (the top one when drawn in order) holding the point, INDEX_NONE if none */
+	int32 FindPolygon( const FVector2D& InPoint ) const;
+	/** FindPolygon of every point, large batches are split over the task graph */
+	void FindPolygons( const TArray< FVector2D >& InPoints, TArray< int32 >& OutPolygons ) const;
+
+	static bool IsPointInPolygon( const FVector2D& InPoint, const TArray< FVector2D >& InPolygon );
+
+private:
+	bool GetCell( const FVector2D& InPoint, int32& OutCellX, int32& OutCellY ) const;
+
+	TArray< TArray< FVector2D > > Polygons;
+	TArray< FBox2D > PolygonBounds;
+	FBox2D Bounds { ForceInit };
+	FVector2D CellSize { FVector2D::UnitVector };
+	int32 CellsX = 0;
+	int32 CellsY = 0;
+	/** Polygons of cell N are CellPolygons[ CellStarts[ N ] ] to CellPolygons[ CellStarts[ N + 1 ] - 1 ], in increasing order */
+	TArray< int32 > CellStarts;
+	TArray< int32 > CellPolygons;
+};
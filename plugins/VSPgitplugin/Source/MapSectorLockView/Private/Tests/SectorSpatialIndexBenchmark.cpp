@@ -0,0 +1,185 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPTests.h"
+
+#include "Core/SectorProvider.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace SectorSpatialIndexBenchmarkLocal
+{
+	const TCHAR* const MapName = TEXT( "BenchMap" );
+	const TCHAR* const LayerName = TEXT( "Main" );
+	/** Sectors per side of the map */
+	const int32 SectorsPerSide = 64;
+	const int32 PointsPerSector = 8;
+	const double MapSize = 100000.0;
+	/** Queries resolved with the index */
+	const int32 QueriesNum = 100000;
+	/** Queries also resolved by testing every sector, as the view did before the index */
+	const int32 BruteForceQueriesNum = 2000;
+
+	/** Octagons touching their neighbours, with jittered corners so that some overlap and some leave gaps */
+	FString MakeSectorConfig( int32 InX, int32 InY, FRandomStream& InRandom )
+	{
+		const double CellSize = MapSize / SectorsPerSide;
+		const FVector2D Center( ( InX + 0.5 ) * CellSize, ( InY + 0.5 ) * CellSize );
+		FString Points;
+		for ( int32 PointIndex = 0; PointIndex < PointsPerSector; PointIndex++ )
+		{
+			const double Angle = 2.0 * PI * PointIndex / PointsPerSector;
+			const double Radius = CellSize * InRandom.FRandRange( 0.45f, 0.6f );
+			Points += FString::Printf(
+				TEXT( "%s{ \"X\": %f, \"Y\": %f }" ),
+				PointIndex > 0 ? TEXT( ", " ) : TEXT( "" ),
+				Center.X + Radius * FMath::Cos( Angle ),
+				Center.Y + Radius * FMath::Sin( Angle ) );
+		}
+		return FString::Printf(
+			TEXT( "{ \"Name\": \"Sector_%d_%d\", \"LinkedMap\": \"Content/%s/Sector_%d_%d.umap\", " )
+			TEXT( "\"DefaultColor\": { \"R\": 255, \"G\": 255, \"B\": 255, \"A\": 50 }, " )
+			TEXT( "\"HoveredColor\": { \"R\": 255, \"G\": 255, \"B\": 255, \"A\": 127 }, " )
+			TEXT( "\"Points\": [ %s ] }" ),
+			InX,
+			InY,
+			MapName,
+			InX,
+			InY,
+			*Points );
+	}
+
+	/** Map, layer and sector configs laid out as Tools/MapSectorsConfig of a project */
+	bool WriteMapConfig( const FString& InConfigPath )
+	{
+		const FString MapPath = InConfigPath / MapName;
+		const FString LayerPath = MapPath / LayerName;
+		const FString ContentPath = FString::Printf( TEXT( "Content/%s/%s.umap" ), MapName, MapName );
+		bool bSuccessful = FFileHelper::SaveStringToFile(
+			FString::Printf(
+				TEXT( "{ \"Name\": \"%s\", \"ContentPath\": \"%s\", \"DefaultImage\": \"\", " )
+				TEXT( "\"DefaultImageSize\": { \"X\": 2048, \"Y\": 2048 }, \"Layers\": [ \"%s\" ] }" ),
+				MapName,
+				*ContentPath,
+				LayerName ),
+			*( MapPath / FString::Printf( TEXT( "%s_MapConfig.json" ), MapName ) ) );
+
+		FRandomStream Random( 1 );
+		FString SectorNames;
+		for ( int32 Y = 0; Y < SectorsPerSide; Y++ )
+			for ( int32 X = 0; X < SectorsPerSide; X++ )
+			{
+				const FString SectorName = FString::Printf( TEXT( "Sector_%d_%d" ), X, Y );
+				SectorNames += FString::Printf( TEXT( "%s\"%s\"" ), SectorNames.IsEmpty() ? TEXT( "" ) : TEXT( ", " ), *SectorName );
+				bSuccessful &= FFileHelper::SaveStringToFile(
+					MakeSectorConfig( X, Y, Random ),
+					*( LayerPath / FString::Printf( TEXT( "%s_SectorConfig.json" ), *SectorName ) ) );
+			}
+
+		bSuccessful &= FFileHelper::SaveStringToFile(
+			FString::Printf(
+				TEXT( "{ \"Name\": \"%s\", \"Image\": \"\", \"TopLeftReal\": { \"X\": 0, \"Y\": 0 }, " )
+				TEXT( "\"BottomRightReal\": { \"X\": %f, \"Y\": %f }, \"ParentMapContentPath\": \"%s\", \"Sectors\": [ %s ] }" ),
+				LayerName,
+				MapSize,
+				MapSize,
+				*ContentPath,
+				*SectorNames ),
+			*( LayerPath / FString::Printf( TEXT( "%s_LayerConfig.json" ), LayerName ) ) );
+		return bSuccessful;
+	}
+
+	/** Top sector under the location, testing them all from the top one down */
+	TSharedPtr< FSectorViewModel > FindSectorBruteForce( const TArray< TArray< FVector2D > >& InPolygons, FSectorProvider& InProvider, const FVector2D& InLocation )
+	{
+		for ( int32 SectorIndex = InPolygons.Num() - 1; SectorIndex >= 0; SectorIndex-- )
+			if ( FSectorSpatialIndex::IsPointInPolygon( InLocation, InPolygons[ SectorIndex ] ) )
+				return InProvider.GetSectors()[ SectorIndex ];
+		return nullptr;
+	}
+}
+
+VSP_TEST( MapSectorLockView, SectorQueries, BenchmarkFlags )
+{
+	using namespace SectorSpatialIndexBenchmarkLocal;
+
+	const FString ConfigPath = FPaths::ConvertRelativePathToFull( FPaths::AutomationTransientDir() / TEXT( "MapSectorsConfig" ) );
+	IFileManager::Get().DeleteDirectory( *ConfigPath, false, true );
+
+	double StartTime = FPlatformTime::Seconds();
+	VSP_EXPECT_TRUE( WriteMapConfig( ConfigPath ) );
+	const double WriteTime = FPlatformTime::Seconds() - StartTime;
+
+	// Loading selects the first map and layer, which builds the index
+	StartTime = FPlatformTime::Seconds();
+	FSectorProvider Provider;
+	Provider.Initialize( ConfigPath );
+	const double LoadTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( Provider.GetSectors().Num(), SectorsPerSide * SectorsPerSide );
+
+	FRandomStream Random( 2 );
+	TArray< FVector2D > Locations;
+	Locations.Reserve( QueriesNum );
+	for ( int32 Index = 0; Index < QueriesNum; Index++ )
+		Locations.Add( FVector2D( Random.FRandRange( -0.05f, 1.05f ) * MapSize, Random.FRandRange( -0.05f, 1.05f ) * MapSize ) );
+
+	// One location at a time, as hovering does
+	StartTime = FPlatformTime::Seconds();
+	int32 Hits = 0;
+	for ( const FVector2D& Location : Locations )
+		Hits += Provider.FindSectorAt( Location ).IsValid() ? 1 : 0;
+	const double SingleTime = FPlatformTime::Seconds() - StartTime;
+
+	// All at once, as resolving the sectors of assets does
+	StartTime = FPlatformTime::Seconds();
+	TArray< TSharedPtr< FSectorViewModel > > Sectors;
+	Provider.FindSectorsAt( Locations, Sectors );
+	const double BulkTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( Sectors.Num(), QueriesNum );
+
+	TArray< TArray< FVector2D > > Polygons;
+	for ( const TSharedPtr< FSectorViewModel >& SectorVm : Provider.GetSectors() )
+	{
+		TArray< FVector2D >& Polygon = Polygons.AddDefaulted_GetRef();
+		for ( const FSectorPoint& Point : SectorVm->GetPoints() )
+			Polygon.Add( Point.Point );
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	int32 Mismatches = 0;
+	for ( int32 Index = 0; Index < BruteForceQueriesNum; Index++ )
+		Mismatches += FindSectorBruteForce( Polygons, Provider, Locations[ Index ] ) != Sectors[ Index ] ? 1 : 0;
+	const double BruteForceTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( Mismatches, 0 );
+
+	AddInfo( FString::Printf(
+		TEXT( "%d sectors: config written in %.3f s, loaded and indexed in %.3f s" ),
+		Provider.GetSectors().Num(),
+		WriteTime,
+		LoadTime ) );
+	AddInfo( FString::Printf(
+		TEXT( "%d queries (%d hits): %.3f ms one by one, %.3f ms in bulk; testing every sector %.3f ms per thousand queries" ),
+		QueriesNum,
+		Hits,
+		SingleTime * 1000.0,
+		BulkTime * 1000.0,
+		BruteForceTime * 1000.0 * 1000.0 / BruteForceQueriesNum ) );
+
+	IFileManager::Get().DeleteDirectory( *ConfigPath, false, true );
+	return true;
+}
@@ -247,8 +247,9 @@ void SMapLayoutView::OnMouseEnter( const FGeometry& MyGeometry, const FPointerEv
 void SMapLayoutView::OnMouseLeave( const FPointerEvent& MouseEvent )
 {
 	HoveredSectionSlotToolTip = FText();
-	for ( TSharedPtr< SSectorWidget >& SectorWidgetPtr : SectorWidgetList )
-		SectorWidgetPtr->MouseLeave();
+	if ( SectorWidgetList.IsValidIndex( HoveredSectorIndex ) )
+		SectorWidgetList[ HoveredSectorIndex ]->MouseLeave();
+	HoveredSectorIndex = INDEX_NONE;
 }
 
 FReply SMapLayoutView::OnMouseMove( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent )
@@ -258,16 +259,20 @@ FReply SMapLayoutView::OnMouseMove( const FGeometry& MyGeometry, const FPointerE
 		const FVector2D LocalPos = MyGeometry.AbsoluteToLocal( MouseEvent.GetScreenSpacePosition() ) / ScrollPanel->
 			GetZoomLevel();
 
-		for ( TSharedPtr< SSectorWidget >& SectorWidgetPtr : SectorWidgetList )
-			SectorWidgetPtr->HoveredTest( LocalPos );
-		bool bIsSomeHovered = false;
-		for ( TSharedPtr< SSectorWidget >& SectorWidgetPtr : SectorWidgetList )
-			if ( SectorWidgetPtr->IsHovered() )
-			{
-				bIsSomeHovered = true;
-				RebuildToolTip( SectorWidgetPtr->GetSectorViewModel() );
-			}
-		if ( !bIsSomeHovered )
+		// Back to map coordinates, the sectors index only tests the polygons around the cursor
+		const FVector2D MapPos = ( LocalPos - ScrollPanel->GetPhysicalOffset() ) / ScaleVM + OffsetVM;
+		const int32 SectorIndex = SectorProvider.Pin()->FindSectorIndexAt( MapPos );
+		if ( SectorIndex != HoveredSectorIndex )
+		{
+			if ( SectorWidgetList.IsValidIndex( HoveredSectorIndex ) )
+				SectorWidgetList[ HoveredSectorIndex ]->MouseLeave();
+			HoveredSectorIndex = SectorWidgetList.IsValidIndex( SectorIndex ) ? SectorIndex : INDEX_NONE;
+			if ( HoveredSectorIndex != INDEX_NONE )
+				SectorWidgetList[ HoveredSectorIndex ]->MouseEnter();
+		}
+		if ( HoveredSectorIndex != INDEX_NONE )
+			RebuildToolTip( SectorWidgetList[ HoveredSectorIndex ]->GetSectorViewModel() );
+		else
 			HoveredSectionSlotToolTip = FText();
 
 		return FReply::Handled();
@@ -278,25 +283,24 @@ FReply SMapLayoutView::OnMouseMove( const FGeometry& MyGeometry, const FPointerE
 
 FReply SMapLayoutView::OnMouseButtonDown( const FGeometry& MyGeometry, const FPointerEvent& MouseEvent )
 {
-	for ( TSharedPtr< SSectorWidget, ESPMode::Fast >& SectorWidget : SectorWidgetList )
-		if ( SectorWidget->IsHovered() )
+	if ( SectorWidgetList.IsValidIndex( HoveredSectorIndex ) )
+	{
+		TSharedPtr< FSectorViewModel >& SectorVm = SectorWidgetList[ HoveredSectorIndex ]->GetSectorViewModel();
+		if ( SectorProvider.Pin()->IsSelectedSector( SectorVm ) )
 		{
-			TSharedPtr< FSectorViewModel >& SectorVm = SectorWidget->GetSectorViewModel();
-			if ( SectorProvider.Pin()->IsSelectedSector( SectorVm ) )
-			{
-				if ( bIsCtrlHolded )
-					SectorProvider.Pin()->RemoveSelection( SectorVm );
-				else
-					SectorProvider.Pin()->DeSelect();
-			}
+			if ( bIsCtrlHolded )
+				SectorProvider.Pin()->RemoveSelection( SectorVm );
 			else
-			{
-				if ( bIsCtrlHolded )
-					SectorProvider.Pin()->AddSelectedSector( SectorVm );
-				else
-					SectorProvider.Pin()->SetSelectedSector( SectorVm );
-			}
+				SectorProvider.Pin()->DeSelect();
+		}
+		else
+		{
+			if ( bIsCtrlHolded )
+				SectorProvider.Pin()->AddSelectedSector( SectorVm );
+			else
+				SectorProvider.Pin()->SetSelectedSector( SectorVm );
 		}
+	}
 
 	return FReply::Handled();
 }
@@ -409,6 +413,7 @@ void SMapLayoutView::OnLayerSelected( TSharedPtr< IListItem > InItem, ESelectInf
 	const TSharedPtr< IListItem > LayerItem = SectorProvider.Pin()->GetSelectedLayer();
 	SectorsViewLayer->ClearChildren();
 	SectorWidgetList.Empty();
+	HoveredSectorIndex = INDEX_NONE;
 
 	if ( LayerItem == nullptr )
 		return;
@@ -79,6 +79,7 @@ private:
 	TSharedPtr< SComboBox< TSharedPtr< IListItem > > > MapsComboBox = nullptr;
 	TSharedPtr< SComboBox< TSharedPtr< IListItem > > > LayersComboBox = nullptr;
 	TArray< TSharedPtr< SSectorWidget > > SectorWidgetList;
+	int32 HoveredSectorIndex = INDEX_NONE;
 	TSharedPtr< SZoomablePanel > ScrollPanel = nullptr;
 	TWeakPtr< FSectorProvider > SectorProvider = nullptr;
 	TSharedPtr< SOverlay > SectorsViewLayer = nullptr;
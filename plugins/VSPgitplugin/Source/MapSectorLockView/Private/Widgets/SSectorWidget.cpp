@@ -217,6 +217,11 @@ bool SSectorWidget::HoveredTest( const FVector2D& LocalPos )
 	return bIsHovered;
 }
 
+void SSectorWidget::MouseEnter()
+{
+	bIsHovered = true;
+}
+
 void SSectorWidget::MouseLeave()
 {
 	bIsHovered = false;
@@ -45,6 +45,7 @@ public:
 
 	int32 DrawSector( const FOnPaintHandlerParams& InParams, const TArray< FVector2D >& InPoints );
 	bool HoveredTest( const FVector2D& LocalPos );
+	void MouseEnter();
 	void MouseLeave();
 
 	virtual bool IsHovered() const override;
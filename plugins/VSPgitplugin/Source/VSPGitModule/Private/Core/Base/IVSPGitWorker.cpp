@@ -19,13 +19,13 @@
 
 bool FVSPGitWorkerBase::UpdateModelStates() const
 {
-	return FVSPGitProvider::AccessProvider().UpdateGitModelStates( StatesFromGit );
+	return FVSPGitProvider::AccessProvider().UpdateGitModelStates( StatesFromGit, StatusScope );
 }
 
 bool FVSPGitLfsWorkerBase::UpdateModelStates() const
 {
 	bool bSuccessful = true;
 	bSuccessful &= FVSPGitProvider::AccessProvider().UpdateGitLfsModelLockStates( LockStatesFromGitLfs );
-	bSuccessful &= FVSPGitProvider::AccessProvider().UpdateGitModelStates( StatesFromGit );
+	bSuccessful &= FVSPGitProvider::AccessProvider().UpdateGitModelStates( StatesFromGit, StatusScope );
 	return bSuccessful;
 };
@@ -51,6 +51,8 @@ public:
 
 protected:
 	TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > > StatesFromGit;
+	/** Directories (relative to the repository root) whose cached states StatesFromGit replaces, "" being the whole repository */
+	TArray< FString > StatusScope = { FString() };
 };
 
 class FVSPGitLfsWorkerBase : public FVSPGitWorkerBase
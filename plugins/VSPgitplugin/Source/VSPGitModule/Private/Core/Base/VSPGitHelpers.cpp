@@ -14,6 +14,15 @@
 * limitations under the License.
 */ 
 #include "VSPGitHelpers.h"
+// Engine headers
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeCounter.h"
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_UNIX
+#include <fcntl.h>
+#endif
 // Module headers
 #include "SourceControlHelpers.h"
 #include "VSPGitModule.h"
@@ -24,7 +33,39 @@
 
 namespace VSPGitHelpersLocal
 {
+	/** Above it, a scoped status costs about as much as a full one and its pathspecs get too long */
+	const int32 MaxStatusDirectories = 64;
+
 	FString FilenameFromGitStatus( const FString& InResult );
+
+	/** Keep both ends of the pipe out of the children, posix_spawn clears the flag on the ones it makes their stdin and stdout */
+	void SetCloseOnExec( void* InReadPipe, void* InWritePipe );
+
+	/** Jobs shared by the threads running them, alive until the last of those threads is done with it */
+	struct FConcurrentJobs
+	{
+		TFunction< void( int32 ) > Job;
+		int32 JobCount = 0;
+		FThreadSafeCounter NextJob;
+		FThreadSafeCounter DoneJobs;
+		/** Triggered by whichever thread finishes the last job */
+		FEvent* AllDoneEvent = FPlatformProcess::GetSynchEventFromPool( true );
+
+		~FConcurrentJobs()
+		{
+			FPlatformProcess::ReturnSynchEventToPool( AllDoneEvent );
+		}
+
+		void RunJobs()
+		{
+			for ( int32 JobIndex = NextJob.Increment() - 1; JobIndex < JobCount; JobIndex = NextJob.Increment() - 1 )
+			{
+				Job( JobIndex );
+				if ( DoneJobs.Increment() == JobCount )
+					AllDoneEvent->Trigger();
+			}
+		}
+	};
 }
 
 VSPGitHelpers::FGitLfsLockInfo::FGitLfsLockInfo( const FString& InStatus )
@@ -197,6 +238,14 @@ FString VSPGitHelpersLocal::FilenameFromGitStatus( const FString& InResult )
 	return InResult.RightChop( 3 );
 }
 
+void VSPGitHelpersLocal::SetCloseOnExec( void* InReadPipe, void* InWritePipe )
+{
+#if PLATFORM_UNIX
+	fcntl( static_cast< FPipeHandle* >( InReadPipe )->GetHandle(), F_SETFD, FD_CLOEXEC );
+	fcntl( static_cast< FPipeHandle* >( InWritePipe )->GetHandle(), F_SETFD, FD_CLOEXEC );
+#endif
+}
+
 void VSPGitHelpers::GetMissingVsExistingFiles(
 	const TArray< FString >& InFiles,
 	TArray< FString >& OutMissingFiles,
@@ -309,4 +358,76 @@ TArray< FString > VSPGitHelpers::CheckAndMakeRelativeFilenames(
 	return RelativeFiles;
 }
 
+bool VSPGitHelpers::GetStatusDirectories( const TArray< FString >& InFileNames, const FString& InRepoRoot, TArray< FString >& OutDirectories )
+{
+	TArray< FString > Directories;
+	for ( const FString& RelativeFile : CheckAndMakeRelativeFilenames( InFileNames, InRepoRoot ) )
+	{
+		const FString Directory = FPaths::GetPath( RelativeFile );
+		if ( Directory.IsEmpty() || Directory.StartsWith( TEXT( ".." ) ) )
+			return false;
+		Directories.AddUnique( Directory + TEXT( "/" ) );
+	}
+
+	// Sorted, a directory comes right before the ones nested in it
+	Directories.Sort();
+	OutDirectories.Reset();
+	for ( FString& Directory : Directories )
+		if ( OutDirectories.Num() == 0 || !Directory.StartsWith( OutDirectories.Last() ) )
+			OutDirectories.Add( MoveTemp( Directory ) );
+
+	return OutDirectories.Num() <= VSPGitHelpersLocal::MaxStatusDirectories;
+}
+
+bool VSPGitHelpers::CreateStdOutPipe( void*& OutReadPipe, void*& OutWritePipe )
+{
+	// On Windows the read end is already kept out of the children
+	if ( !FPlatformProcess::CreatePipe( OutReadPipe, OutWritePipe ) )
+		return false;
+	VSPGitHelpersLocal::SetCloseOnExec( OutReadPipe, OutWritePipe );
+	return true;
+}
+
+bool VSPGitHelpers::CreateStdInPipe( void*& OutReadPipe, void*& OutWritePipe )
+{
+	if ( !FPlatformProcess::CreatePipe( OutReadPipe, OutWritePipe ) )
+		return false;
+#if PLATFORM_WINDOWS
+	// The pipe is made for reading the child output: swap which end the child inherits
+	::SetHandleInformation( OutReadPipe, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+	::SetHandleInformation( OutWritePipe, HANDLE_FLAG_INHERIT, 0 );
+#endif
+	VSPGitHelpersLocal::SetCloseOnExec( OutReadPipe, OutWritePipe );
+	return true;
+}
+
+FCriticalSection& VSPGitHelpers::GetProcessStartLock()
+{
+	static FCriticalSection ProcessStartLock;
+	return ProcessStartLock;
+}
+
+void VSPGitHelpers::RunConcurrently( int32 InJobCount, int32 InMaxThreads, TFunction< void( int32 ) > InJob )
+{
+	if ( InJobCount <= 1 || InMaxThreads <= 1 || GThreadPool == nullptr )
+	{
+		for ( int32 JobIndex = 0; JobIndex < InJobCount; JobIndex++ )
+			InJob( JobIndex );
+		return;
+	}
+
+	TSharedRef< VSPGitHelpersLocal::FConcurrentJobs, ESPMode::ThreadSafe > Jobs = MakeShared< VSPGitHelpersLocal::FConcurrentJobs, ESPMode::ThreadSafe >();
+	Jobs->Job = MoveTemp( InJob );
+	Jobs->JobCount = InJobCount;
+
+	// A pool thread starting after all jobs were taken finds nothing left to do
+	const int32 PoolThreads = FMath::Min( InJobCount, InMaxThreads ) - 1;
+	for ( int32 ThreadIndex = 0; ThreadIndex < PoolThreads; ThreadIndex++ )
+		Async( EAsyncExecution::ThreadPool, [Jobs]() { Jobs->RunJobs(); } );
+
+	Jobs->RunJobs();
+	// Only jobs already started by a pool thread are left
+	Jobs->AllDoneEvent->Wait();
+}
+
 #undef LOCTEXT_NAMESPACE
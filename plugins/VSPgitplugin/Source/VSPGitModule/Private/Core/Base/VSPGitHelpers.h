@@ -16,6 +16,7 @@
 #pragma once
 
 // Engine headers
+#include "HAL/CriticalSection.h"
 
 namespace VSPGitHelpers
 {
@@ -148,7 +149,31 @@ namespace VSPGitHelpers
 
 	TArray< FString > CheckAndMakeRelativeFilenames( const TArray< FString >& InFileNames, const FString& InRelativeTo );
 
+	/**
+	* Directories (relative to the repository root, with a trailing slash) holding the given files, nested ones left out.
+	* False when a status of the whole repository is better: files at the root, outside the repository or too many directories.
+	*/
+	bool GetStatusDirectories( const TArray< FString >& InFileNames, const FString& InRepoRoot, TArray< FString >& OutDirectories );
+
 	FString RelativeByRepoPathToFull( const FString& InRelativePath );
 
 	TArray< FString > RelativeByRepoPathToFull( const TArray< FString >& InRelativePaths );
+
+	/** Pipe for the stdout of a child process: the child inherits the write end, the read end is ours */
+	bool CreateStdOutPipe( void*& OutReadPipe, void*& OutWritePipe );
+
+	/** Pipe for the stdin of a child process: the child inherits the read end, the write end is ours */
+	bool CreateStdInPipe( void*& OutReadPipe, void*& OutWritePipe );
+
+	/**
+	* Held from the creation of the pipes of a child process until our copies of its ends are closed.
+	* On Windows a child started meanwhile would inherit them all and hold them open for as long as it runs.
+	*/
+	FCriticalSection& GetProcessStartLock();
+
+	/**
+	* Run InJob for each index from 0 to InJobCount - 1, on at most InMaxThreads threads of GThreadPool, and return once all are done.
+	* The calling thread runs jobs too, so a pool busy with other work (the calling worker itself is one) slows it down but can't stall it.
+	*/
+	void RunConcurrently( int32 InJobCount, int32 InMaxThreads, TFunction< void( int32 ) > InJob );
 }
@@ -0,0 +1,639 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitHistoryCache.h"
+// Engine headers
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+// Module headers
+#include "VSPGitModule.h"
+
+namespace VSPGitHistoryCacheLocal
+{
+	/** "VSPGHIST" */
+	const uint64 IndexMagic = 0x5453494847505356ull;
+	/** Bumped whenever the layout below changes, the index is then built again */
+	const uint32 IndexVersion = 2;
+	/** Length of a full SHA1 in hexadecimal */
+	const int32 HashLength = 40;
+	/** Incremental updates appended before the segments are merged into one */
+	const int32 MaxSegments = 32;
+
+	// Index file: segments one after the other, the full build first, then one per incremental update.
+	// Segment: header, commits (oldest first), paths (sorted by UTF-8 bytes), entries (grouped by path, newest first), UTF-8 strings.
+	// Offsets are from the segment start and strings are referenced by offset and length into its string table,
+	// entries refer to commits by their index in the whole file.
+	struct FIndexHeader
+	{
+		uint64 Magic;
+		uint32 Version;
+		uint32 SegmentSize; ///< Bytes up to the next segment, a multiple of 8
+		uint32 FirstCommit; ///< Commits of the segments before this one
+		uint32 CommitCount;
+		uint32 PathCount;
+		uint32 EntryCount;
+		uint32 CommitsOffset;
+		uint32 PathsOffset;
+		uint32 EntriesOffset;
+		uint32 StringsOffset;
+		uint32 StringsSize;
+		uint32 RepoRoot;
+		uint32 RepoRootLength;
+		ANSICHAR TipCommit[ HashLength ];
+	};
+
+	struct FIndexCommit
+	{
+		ANSICHAR Hash[ HashLength ];
+		int64 Timestamp;
+		uint32 UserName;
+		uint32 UserNameLength;
+		uint32 Description;
+		uint32 DescriptionLength;
+	};
+
+	struct FIndexPath
+	{
+		uint32 Name;
+		uint32 NameLength;
+		uint32 FirstEntry;
+		uint32 EntryCount;
+	};
+
+	struct FIndexEntry
+	{
+		uint32 Commit;
+		uint32 RenamedFrom;
+		uint32 RenamedFromLength;
+		uint32 Status;
+	};
+
+	/** Byte order of UTF-8 strings, the order of the path table */
+	int32 CompareUtf8( const uint8* InLeft, uint32 InLeftLength, const uint8* InRight, uint32 InRightLength );
+
+	void AddString( TArray< uint8 >& InOutStrings, const FString& InString, uint32& OutOffset, uint32& OutLength );
+
+	void CopyHash( const FString& InHash, ANSICHAR ( &OutHash )[ HashLength ] );
+
+	bool IsSectionInside( int64 InSegmentSize, uint32 InOffset, uint32 InCount, uint32 InItemSize );
+
+	const FIndexHeader& GetHeader( const uint8* InSegment );
+}
+
+int32 VSPGitHistoryCacheLocal::CompareUtf8( const uint8* InLeft, uint32 InLeftLength, const uint8* InRight, uint32 InRightLength )
+{
+	const int32 Result = FMemory::Memcmp( InLeft, InRight, FMath::Min( InLeftLength, InRightLength ) );
+	if ( Result != 0 )
+		return Result;
+	return InLeftLength < InRightLength ? -1 : ( InLeftLength > InRightLength ? 1 : 0 );
+}
+
+void VSPGitHistoryCacheLocal::AddString( TArray< uint8 >& InOutStrings, const FString& InString, uint32& OutOffset, uint32& OutLength )
+{
+	const FTCHARToUTF8 Utf8String( *InString );
+	OutOffset = InOutStrings.Num();
+	OutLength = Utf8String.Length();
+	InOutStrings.Append( reinterpret_cast< const uint8* >( Utf8String.Get() ), Utf8String.Length() );
+}
+
+void VSPGitHistoryCacheLocal::CopyHash( const FString& InHash, ANSICHAR ( &OutHash )[ HashLength ] )
+{
+	for ( int32 Index = 0; Index < HashLength; Index++ )
+		OutHash[ Index ] = Index < InHash.Len() ? static_cast< ANSICHAR >( InHash[ Index ] ) : '0';
+}
+
+bool VSPGitHistoryCacheLocal::IsSectionInside( int64 InSegmentSize, uint32 InOffset, uint32 InCount, uint32 InItemSize )
+{
+	return static_cast< int64 >( InOffset ) + static_cast< int64 >( InCount ) * InItemSize <= InSegmentSize;
+}
+
+const VSPGitHistoryCacheLocal::FIndexHeader& VSPGitHistoryCacheLocal::GetHeader( const uint8* InSegment )
+{
+	return *reinterpret_cast< const FIndexHeader* >( InSegment );
+}
+
+//--------------------------------------------------------------
+// Builder
+const TCHAR* FVSPGitHistoryCache::FBuilder::GetLogFormat()
+{
+	// One record per commit: marker, hash, author name, author date and message separated by \x02,
+	// followed by the status and path records of the changed files
+	return TEXT( "%x01%H%x02%an%x02%at%x02%B" );
+}
+
+void FVSPGitHistoryCache::FBuilder::AddLogRecord( const FString& InRecord )
+{
+	if ( InRecord.StartsWith( TEXT( "\x01" ) ) )
+	{
+		TArray< FString > Fields;
+		InRecord.RightChop( 1 ).ParseIntoArray( Fields, TEXT( "\x02" ), false );
+		Fields.SetNum( 4 );
+
+		FCommit& Commit = LogCommits.AddDefaulted_GetRef();
+		Commit.Hash = MoveTemp( Fields[ 0 ] );
+		Commit.UserName = MoveTemp( Fields[ 1 ] );
+		Commit.Timestamp = FCString::Atoi64( *Fields[ 2 ] );
+		// The description 'git log --pretty=medium' gives: the lines of the message without the empty ones
+		TArray< FString > MessageLines;
+		Fields[ 3 ].ParseIntoArrayLines( MessageLines );
+		for ( const FString& MessageLine : MessageLines )
+		{
+			Commit.Description += MessageLine;
+			Commit.Description += TEXT( "\n" );
+		}
+
+		LogStatus.Reset();
+		LogRenamedFrom.Reset();
+		return;
+	}
+
+	if ( LogCommits.Num() == 0 )
+		return;
+
+	// The first status of a commit comes right after the line feed ending its message
+	if ( LogStatus.IsEmpty() )
+	{
+		LogStatus = InRecord.TrimStart();
+		return;
+	}
+
+	// Renames and copies give the original path first
+	const bool bHasTwoPaths = LogStatus[ 0 ] == TEXT( 'R' ) || LogStatus[ 0 ] == TEXT( 'C' );
+	if ( bHasTwoPaths && LogRenamedFrom.IsEmpty() )
+	{
+		LogRenamedFrom = InRecord;
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Commit = LogCommits.Num() - 1;
+	Entry.Status = LogStatus[ 0 ];
+	// Copies leave the original where it is, the history of the copy starts with it
+	if ( LogStatus[ 0 ] == TEXT( 'R' ) )
+		Entry.RenamedFrom = MoveTemp( LogRenamedFrom );
+	LogEntries.Emplace( InRecord, MoveTemp( Entry ) );
+
+	LogStatus.Reset();
+	LogRenamedFrom.Reset();
+}
+
+void FVSPGitHistoryCache::FBuilder::FinishLog()
+{
+	const int32 FirstLogCommit = Commits.Num();
+	const int32 LogCommitCount = LogCommits.Num();
+	for ( int32 Index = LogCommitCount - 1; Index >= 0; Index-- )
+		Commits.Add( MoveTemp( LogCommits[ Index ] ) );
+
+	TMap< FString, TArray< FEntry > > LogFileEntries;
+	for ( TPair< FString, FEntry >& LogEntry : LogEntries )
+	{
+		LogEntry.Value.Commit = FirstLogCommit + LogCommitCount - 1 - LogEntry.Value.Commit;
+		LogFileEntries.FindOrAdd( LogEntry.Key ).Add( MoveTemp( LogEntry.Value ) );
+	}
+	// Newer than all the changes already there
+	for ( TPair< FString, TArray< FEntry > >& LogFileEntry : LogFileEntries )
+		Entries.FindOrAdd( LogFileEntry.Key ).Insert( MoveTemp( LogFileEntry.Value ), 0 );
+
+	LogCommits.Reset();
+	LogEntries.Reset();
+	LogStatus.Reset();
+	LogRenamedFrom.Reset();
+}
+
+//--------------------------------------------------------------
+// Cache
+FVSPGitHistoryCache& FVSPGitHistoryCache::Get()
+{
+	static FVSPGitHistoryCache HistoryCache;
+	return HistoryCache;
+}
+
+FVSPGitHistoryCache::~FVSPGitHistoryCache()
+{
+	UnmapIndex();
+}
+
+void FVSPGitHistoryCache::Configure( const FString& InRepoRoot )
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( RepoRoot == InRepoRoot && IndexData != nullptr )
+		return;
+
+	RepoRoot = InRepoRoot;
+	MapIndex();
+}
+
+void FVSPGitHistoryCache::Shutdown()
+{
+	FScopeLock ScopeLock( &Lock );
+	UnmapIndex();
+	RepoRoot.Empty();
+}
+
+FString FVSPGitHistoryCache::GetTipCommit() const
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( IndexData == nullptr )
+		return FString();
+
+	const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( IndexData + SegmentOffsets.Last() );
+	return FString( VSPGitHistoryCacheLocal::HashLength, Header.TipCommit );
+}
+
+bool FVSPGitHistoryCache::NeedsCompaction() const
+{
+	FScopeLock ScopeLock( &Lock );
+	return SegmentOffsets.Num() >= VSPGitHistoryCacheLocal::MaxSegments;
+}
+
+void FVSPGitHistoryCache::LoadInto( FBuilder& OutBuilder ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( IndexData == nullptr )
+		return;
+
+	OutBuilder.Commits.Reset( CommitCount );
+	for ( const int64 SegmentOffset : SegmentOffsets )
+	{
+		const uint8* Segment = IndexData + SegmentOffset;
+		const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( Segment );
+		const VSPGitHistoryCacheLocal::FIndexCommit* Commits = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexCommit* >( Segment + Header.CommitsOffset );
+		for ( uint32 CommitIndex = 0; CommitIndex < Header.CommitCount; CommitIndex++ )
+		{
+			const VSPGitHistoryCacheLocal::FIndexCommit& IndexCommit = Commits[ CommitIndex ];
+			FBuilder::FCommit& Commit = OutBuilder.Commits.AddDefaulted_GetRef();
+			Commit.Hash = FString( VSPGitHistoryCacheLocal::HashLength, IndexCommit.Hash );
+			Commit.UserName = GetIndexString( Segment, IndexCommit.UserName, IndexCommit.UserNameLength );
+			Commit.Timestamp = IndexCommit.Timestamp;
+			Commit.Description = GetIndexString( Segment, IndexCommit.Description, IndexCommit.DescriptionLength );
+		}
+	}
+
+	// Newest segment first, the changes of a file stay newest first
+	OutBuilder.Entries.Reset();
+	for ( int32 SegmentIndex = SegmentOffsets.Num() - 1; SegmentIndex >= 0; SegmentIndex-- )
+	{
+		const uint8* Segment = IndexData + SegmentOffsets[ SegmentIndex ];
+		const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( Segment );
+		const VSPGitHistoryCacheLocal::FIndexPath* Paths = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexPath* >( Segment + Header.PathsOffset );
+		const VSPGitHistoryCacheLocal::FIndexEntry* Entries = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexEntry* >( Segment + Header.EntriesOffset );
+		for ( uint32 PathIndex = 0; PathIndex < Header.PathCount; PathIndex++ )
+		{
+			const VSPGitHistoryCacheLocal::FIndexPath& IndexPath = Paths[ PathIndex ];
+			TArray< FBuilder::FEntry >& FileEntries = OutBuilder.Entries.FindOrAdd( GetIndexString( Segment, IndexPath.Name, IndexPath.NameLength ) );
+			for ( uint32 EntryIndex = IndexPath.FirstEntry; EntryIndex < IndexPath.FirstEntry + IndexPath.EntryCount && EntryIndex < Header.EntryCount; EntryIndex++ )
+			{
+				FBuilder::FEntry& Entry = FileEntries.AddDefaulted_GetRef();
+				Entry.Commit = Entries[ EntryIndex ].Commit;
+				Entry.Status = static_cast< TCHAR >( Entries[ EntryIndex ].Status );
+				Entry.RenamedFrom = GetIndexString( Segment, Entries[ EntryIndex ].RenamedFrom, Entries[ EntryIndex ].RenamedFromLength );
+			}
+		}
+	}
+}
+
+bool FVSPGitHistoryCache::Save( const FBuilder& InBuilder, const FString& InTipCommit )
+{
+	FString IndexRepoRoot;
+	{
+		FScopeLock ScopeLock( &Lock );
+		IndexRepoRoot = RepoRoot;
+	}
+	if ( IndexRepoRoot.IsEmpty() )
+		return false;
+
+	TArray< uint8 > Segment;
+	MakeSegment( InBuilder, InTipCommit, IndexRepoRoot, 0, Segment );
+
+	// Written aside first, the mapped index stays readable meanwhile
+	const FString IndexFilename = GetIndexFilename();
+	const FString TempFilename = IndexFilename + TEXT( ".tmp" );
+	if ( !FFileHelper::SaveArrayToFile( Segment, *TempFilename ) )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("Failed to write the history index %s"), *TempFilename );
+		return false;
+	}
+
+	FScopeLock ScopeLock( &Lock );
+	// A mapped file can't be replaced on every platform
+	UnmapIndex();
+	if ( !IFileManager::Get().Move( *IndexFilename, *TempFilename, true, true ) )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("Failed to replace the history index %s"), *IndexFilename );
+		IFileManager::Get().Delete( *TempFilename );
+	}
+	return MapIndex();
+}
+
+bool FVSPGitHistoryCache::Append( const FBuilder& InBuilder, const FString& InTipCommit )
+{
+	FString IndexRepoRoot;
+	uint32 FirstCommit = 0;
+	{
+		FScopeLock ScopeLock( &Lock );
+		if ( IndexData == nullptr )
+			return false;
+		IndexRepoRoot = RepoRoot;
+		FirstCommit = CommitCount;
+	}
+
+	TArray< uint8 > Segment;
+	MakeSegment( InBuilder, InTipCommit, IndexRepoRoot, FirstCommit, Segment );
+
+	FScopeLock ScopeLock( &Lock );
+	// The file must be the one mapped, the index is otherwise built again
+	const FString IndexFilename = GetIndexFilename();
+	if ( IndexData == nullptr || CommitCount != FirstCommit || IFileManager::Get().FileSize( *IndexFilename ) != IndexSize )
+		return false;
+
+	// A mapped file can't be written to on every platform
+	UnmapIndex();
+	{
+		TUniquePtr< FArchive > Writer( IFileManager::Get().CreateFileWriter( *IndexFilename, FILEWRITE_Append ) );
+		if ( Writer )
+			Writer->Serialize( Segment.GetData(), Segment.Num() );
+		if ( !Writer || !Writer->Close() )
+			UE_LOG( VSPGitLog, Warning, TEXT("Failed to append to the history index %s"), *IndexFilename );
+	}
+	// A partly written segment fails the checks, then the index is built again
+	return MapIndex();
+}
+
+void FVSPGitHistoryCache::MakeSegment( const FBuilder& InBuilder, const FString& InTipCommit, const FString& InRepoRoot, uint32 InFirstCommit, TArray< uint8 >& OutSegment )
+{
+	TArray< uint8 > Strings;
+	VSPGitHistoryCacheLocal::FIndexHeader Header;
+	FMemory::Memzero( Header );
+	Header.Magic = VSPGitHistoryCacheLocal::IndexMagic;
+	Header.Version = VSPGitHistoryCacheLocal::IndexVersion;
+	Header.FirstCommit = InFirstCommit;
+	VSPGitHistoryCacheLocal::CopyHash( InTipCommit, Header.TipCommit );
+	VSPGitHistoryCacheLocal::AddString( Strings, InRepoRoot, Header.RepoRoot, Header.RepoRootLength );
+
+	TArray< VSPGitHistoryCacheLocal::FIndexCommit > Commits;
+	Commits.Reserve( InBuilder.Commits.Num() );
+	for ( const FBuilder::FCommit& Commit : InBuilder.Commits )
+	{
+		VSPGitHistoryCacheLocal::FIndexCommit& IndexCommit = Commits.AddZeroed_GetRef();
+		VSPGitHistoryCacheLocal::CopyHash( Commit.Hash, IndexCommit.Hash );
+		IndexCommit.Timestamp = Commit.Timestamp;
+		VSPGitHistoryCacheLocal::AddString( Strings, Commit.UserName, IndexCommit.UserName, IndexCommit.UserNameLength );
+		VSPGitHistoryCacheLocal::AddString( Strings, Commit.Description, IndexCommit.Description, IndexCommit.DescriptionLength );
+	}
+
+	// Paths are looked up by binary search over their UTF-8 bytes
+	TArray< TPair< TArray< uint8 >, const TArray< FBuilder::FEntry >* > > SortedPaths;
+	SortedPaths.Reserve( InBuilder.Entries.Num() );
+	for ( const TPair< FString, TArray< FBuilder::FEntry > >& FileEntries : InBuilder.Entries )
+	{
+		const FTCHARToUTF8 Utf8Path( *FileEntries.Key );
+		TArray< uint8 > Utf8Bytes( reinterpret_cast< const uint8* >( Utf8Path.Get() ), Utf8Path.Length() );
+		SortedPaths.Emplace( MoveTemp( Utf8Bytes ), &FileEntries.Value );
+	}
+	SortedPaths.Sort( []( const TPair< TArray< uint8 >, const TArray< FBuilder::FEntry >* >& InLeft, const TPair< TArray< uint8 >, const TArray< FBuilder::FEntry >* >& InRight )
+	{
+		return VSPGitHistoryCacheLocal::CompareUtf8( InLeft.Key.GetData(), InLeft.Key.Num(), InRight.Key.GetData(), InRight.Key.Num() ) < 0;
+	} );
+
+	TArray< VSPGitHistoryCacheLocal::FIndexPath > Paths;
+	TArray< VSPGitHistoryCacheLocal::FIndexEntry > Entries;
+	Paths.Reserve( SortedPaths.Num() );
+	for ( const TPair< TArray< uint8 >, const TArray< FBuilder::FEntry >* >& SortedPath : SortedPaths )
+	{
+		VSPGitHistoryCacheLocal::FIndexPath& IndexPath = Paths.AddZeroed_GetRef();
+		IndexPath.Name = Strings.Num();
+		IndexPath.NameLength = SortedPath.Key.Num();
+		Strings.Append( SortedPath.Key );
+		IndexPath.FirstEntry = Entries.Num();
+		IndexPath.EntryCount = SortedPath.Value->Num();
+		for ( const FBuilder::FEntry& Entry : *SortedPath.Value )
+		{
+			VSPGitHistoryCacheLocal::FIndexEntry& IndexEntry = Entries.AddZeroed_GetRef();
+			IndexEntry.Commit = InFirstCommit + Entry.Commit;
+			IndexEntry.Status = Entry.Status;
+			if ( !Entry.RenamedFrom.IsEmpty() )
+				VSPGitHistoryCacheLocal::AddString( Strings, Entry.RenamedFrom, IndexEntry.RenamedFrom, IndexEntry.RenamedFromLength );
+		}
+	}
+
+	Header.CommitCount = Commits.Num();
+	Header.PathCount = Paths.Num();
+	Header.EntryCount = Entries.Num();
+	Header.CommitsOffset = Align( sizeof( Header ), 8 );
+	Header.PathsOffset = Header.CommitsOffset + Commits.Num() * Commits.GetTypeSize();
+	Header.EntriesOffset = Header.PathsOffset + Paths.Num() * Paths.GetTypeSize();
+	Header.StringsOffset = Header.EntriesOffset + Entries.Num() * Entries.GetTypeSize();
+	Header.StringsSize = Strings.Num();
+	// The next segment starts aligned for its commits
+	Header.SegmentSize = Align( Header.StringsOffset + Header.StringsSize, 8 );
+
+	OutSegment.Reset( Header.SegmentSize );
+	OutSegment.Append( reinterpret_cast< const uint8* >( &Header ), sizeof( Header ) );
+	OutSegment.SetNumZeroed( Header.CommitsOffset );
+	OutSegment.Append( reinterpret_cast< const uint8* >( Commits.GetData() ), Commits.Num() * Commits.GetTypeSize() );
+	OutSegment.Append( reinterpret_cast< const uint8* >( Paths.GetData() ), Paths.Num() * Paths.GetTypeSize() );
+	OutSegment.Append( reinterpret_cast< const uint8* >( Entries.GetData() ), Entries.Num() * Entries.GetTypeSize() );
+	OutSegment.Append( Strings );
+	OutSegment.SetNumZeroed( Header.SegmentSize );
+}
+
+bool FVSPGitHistoryCache::GetHistory( const FString& InFile, TArray< FVSPGitHistoryEntry >& OutHistory ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( IndexData == nullptr )
+		return false;
+
+	// Like 'git log --follow': at a rename, carry on with the changes of the original path older than it.
+	// Segments hold newer commits than the ones before them, a path is looked for from the newest down.
+	FString Path = InFile;
+	uint32 OlderThanCommit = MAX_uint32;
+	bool bKnownFile = false;
+	for ( int32 SegmentIndex = SegmentOffsets.Num() - 1; SegmentIndex >= 0; SegmentIndex-- )
+	{
+		const uint8* Segment = IndexData + SegmentOffsets[ SegmentIndex ];
+		const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( Segment );
+		const VSPGitHistoryCacheLocal::FIndexCommit* Commits = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexCommit* >( Segment + Header.CommitsOffset );
+		const VSPGitHistoryCacheLocal::FIndexPath* Paths = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexPath* >( Segment + Header.PathsOffset );
+		const VSPGitHistoryCacheLocal::FIndexEntry* Entries = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexEntry* >( Segment + Header.EntriesOffset );
+
+		for ( uint32 Renames = 0; Renames <= Header.EntryCount; Renames++ )
+		{
+			const int32 PathIndex = FindPath( Segment, FTCHARToUTF8( *Path ) );
+			if ( PathIndex == INDEX_NONE )
+				break;
+			bKnownFile = true;
+
+			FString RenamedFrom;
+			const VSPGitHistoryCacheLocal::FIndexPath& IndexPath = Paths[ PathIndex ];
+			for ( uint32 EntryIndex = IndexPath.FirstEntry; EntryIndex < IndexPath.FirstEntry + IndexPath.EntryCount && EntryIndex < Header.EntryCount; EntryIndex++ )
+			{
+				const VSPGitHistoryCacheLocal::FIndexEntry& IndexEntry = Entries[ EntryIndex ];
+				if ( IndexEntry.Commit >= OlderThanCommit || IndexEntry.Commit < Header.FirstCommit || IndexEntry.Commit - Header.FirstCommit >= Header.CommitCount )
+					continue;
+
+				const VSPGitHistoryCacheLocal::FIndexCommit& IndexCommit = Commits[ IndexEntry.Commit - Header.FirstCommit ];
+				FVSPGitHistoryEntry& HistoryEntry = OutHistory.AddDefaulted_GetRef();
+				HistoryEntry.CommitId = FString( VSPGitHistoryCacheLocal::HashLength, IndexCommit.Hash );
+				HistoryEntry.UserName = GetIndexString( Segment, IndexCommit.UserName, IndexCommit.UserNameLength );
+				HistoryEntry.Date = FDateTime::FromUnixTimestamp( IndexCommit.Timestamp );
+				HistoryEntry.Description = GetIndexString( Segment, IndexCommit.Description, IndexCommit.DescriptionLength );
+				HistoryEntry.Status = static_cast< TCHAR >( IndexEntry.Status );
+				HistoryEntry.Filename = Path;
+
+				if ( IndexEntry.RenamedFromLength > 0 )
+				{
+					RenamedFrom = GetIndexString( Segment, IndexEntry.RenamedFrom, IndexEntry.RenamedFromLength );
+					OlderThanCommit = IndexEntry.Commit;
+					break;
+				}
+			}
+
+			// The original path may have older changes in this segment too
+			if ( RenamedFrom.IsEmpty() )
+				break;
+			Path = MoveTemp( RenamedFrom );
+		}
+	}
+
+	return bKnownFile;
+}
+
+bool FVSPGitHistoryCache::MapIndex()
+{
+	UnmapIndex();
+
+	const FString IndexFilename = GetIndexFilename();
+	if ( !IFileManager::Get().FileExists( *IndexFilename ) )
+		return false;
+
+	MappedHandle = FPlatformFileManager::Get().GetPlatformFile().OpenMapped( *IndexFilename );
+	if ( MappedHandle != nullptr )
+		MappedRegion = MappedHandle->MapRegion( 0, MappedHandle->GetFileSize() );
+	if ( MappedRegion != nullptr )
+	{
+		IndexData = MappedRegion->GetMappedPtr();
+		IndexSize = MappedRegion->GetMappedSize();
+	}
+	else if ( FFileHelper::LoadFileToArray( LoadedIndex, *IndexFilename ) )
+	{
+		IndexData = LoadedIndex.GetData();
+		IndexSize = LoadedIndex.Num();
+	}
+	if ( IndexData == nullptr )
+	{
+		UnmapIndex();
+		return false;
+	}
+
+	// A stale, foreign or damaged index (a segment partly appended too) is just built again
+	int64 SegmentOffset = 0;
+	while ( SegmentOffset < IndexSize )
+	{
+		const int64 MaxSegmentSize = IndexSize - SegmentOffset;
+		const uint8* Segment = IndexData + SegmentOffset;
+		const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( Segment );
+		const bool bValidSegment = MaxSegmentSize >= static_cast< int64 >( sizeof( VSPGitHistoryCacheLocal::FIndexHeader ) )
+			&& Header.Magic == VSPGitHistoryCacheLocal::IndexMagic
+			&& Header.Version == VSPGitHistoryCacheLocal::IndexVersion
+			&& Header.SegmentSize >= sizeof( VSPGitHistoryCacheLocal::FIndexHeader )
+			&& Header.SegmentSize <= MaxSegmentSize
+			&& Header.SegmentSize % 8 == 0
+			&& Header.FirstCommit == CommitCount
+			&& VSPGitHistoryCacheLocal::IsSectionInside( Header.SegmentSize, Header.CommitsOffset, Header.CommitCount, sizeof( VSPGitHistoryCacheLocal::FIndexCommit ) )
+			&& VSPGitHistoryCacheLocal::IsSectionInside( Header.SegmentSize, Header.PathsOffset, Header.PathCount, sizeof( VSPGitHistoryCacheLocal::FIndexPath ) )
+			&& VSPGitHistoryCacheLocal::IsSectionInside( Header.SegmentSize, Header.EntriesOffset, Header.EntryCount, sizeof( VSPGitHistoryCacheLocal::FIndexEntry ) )
+			&& VSPGitHistoryCacheLocal::IsSectionInside( Header.SegmentSize, Header.StringsOffset, Header.StringsSize, 1 )
+			&& GetIndexString( Segment, Header.RepoRoot, Header.RepoRootLength ) == RepoRoot;
+		if ( !bValidSegment )
+		{
+			UnmapIndex();
+			return false;
+		}
+
+		SegmentOffsets.Add( SegmentOffset );
+		CommitCount += Header.CommitCount;
+		SegmentOffset += Header.SegmentSize;
+	}
+	if ( SegmentOffsets.Num() == 0 )
+	{
+		UnmapIndex();
+		return false;
+	}
+
+	UE_LOG( VSPGitLog, Log, TEXT("History index %s: %u commits in %d segments"), *IndexFilename, CommitCount, SegmentOffsets.Num() );
+	return true;
+}
+
+void FVSPGitHistoryCache::UnmapIndex()
+{
+	delete MappedRegion;
+	MappedRegion = nullptr;
+	delete MappedHandle;
+	MappedHandle = nullptr;
+	LoadedIndex.Empty();
+	IndexData = nullptr;
+	IndexSize = 0;
+	SegmentOffsets.Reset();
+	CommitCount = 0;
+}
+
+FString FVSPGitHistoryCache::GetIndexFilename() const
+{
+	return FPaths::ProjectSavedDir() / TEXT( "SourceControl" ) / TEXT( "VSPGitHistory.idx" );
+}
+
+FString FVSPGitHistoryCache::GetIndexString( const uint8* InSegment, uint32 InOffset, uint32 InLength ) const
+{
+	const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( InSegment );
+	if ( InLength == 0 || static_cast< uint64 >( InOffset ) + InLength > Header.StringsSize )
+		return FString();
+
+	const FUTF8ToTCHAR String( reinterpret_cast< const ANSICHAR* >( InSegment + Header.StringsOffset + InOffset ), InLength );
+	return FString( String.Length(), String.Get() );
+}
+
+int32 FVSPGitHistoryCache::FindPath( const uint8* InSegment, const FTCHARToUTF8& InUtf8Path ) const
+{
+	const VSPGitHistoryCacheLocal::FIndexHeader& Header = VSPGitHistoryCacheLocal::GetHeader( InSegment );
+	const VSPGitHistoryCacheLocal::FIndexPath* Paths = reinterpret_cast< const VSPGitHistoryCacheLocal::FIndexPath* >( InSegment + Header.PathsOffset );
+	const uint8* Strings = InSegment + Header.StringsOffset;
+
+	int32 Low = 0;
+	int32 High = static_cast< int32 >( Header.PathCount ) - 1;
+	while ( Low <= High )
+	{
+		const int32 Middle = Low + ( High - Low ) / 2;
+		const VSPGitHistoryCacheLocal::FIndexPath& IndexPath = Paths[ Middle ];
+		if ( static_cast< uint64 >( IndexPath.Name ) + IndexPath.NameLength > Header.StringsSize )
+			return INDEX_NONE;
+
+		const int32 Result = VSPGitHistoryCacheLocal::CompareUtf8(
+			Strings + IndexPath.Name,
+			IndexPath.NameLength,
+			reinterpret_cast< const uint8* >( InUtf8Path.Get() ),
+			InUtf8Path.Length() );
+		if ( Result == 0 )
+			return Middle;
+		if ( Result < 0 )
+			Low = Middle + 1;
+		else
+			High = Middle - 1;
+	}
+	return INDEX_NONE;
+}
@@ -0,0 +1,139 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+// Engine headers
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** One change of a file as recorded by the history cache */
+struct FVSPGitHistoryEntry
+{
+	FString CommitId; ///< Full SHA1 of the commit
+	FString UserName; ///< Author name, without the email
+	FDateTime Date; ///< Author date
+	FString Description; ///< Non-empty lines of the commit message, each followed by a line feed
+	TCHAR Status = TEXT( 'M' ); ///< Status letter of 'git log --name-status' ('A', 'M', 'R'...)
+	FString Filename; ///< Path of the file at that commit, relative to the repository root
+};
+
+/**
+* Log of the current branch indexed by file, saved to disk and read back through a memory mapping,
+* so the history of a file doesn't need a 'git log' of its own, even right after the editor started.
+* It is built from one 'git log --name-status -z' pass, then each batch of commits added on top of it
+* is appended to the file as a segment of its own, until there are enough segments to merge them.
+*/
+class FVSPGitHistoryCache
+{
+public:
+	/** New content of the index, the current one plus the commits of a log run */
+	class FBuilder
+	{
+	public:
+		/** Format to give 'git log --name-status -z' for its records to be understood by AddLogRecord */
+		static const TCHAR* GetLogFormat();
+
+		/** Feed one NUL separated record of the log */
+		void AddLogRecord( const FString& InRecord );
+		/** Put the commits of the log run (newest first) on top of the ones already there */
+		void FinishLog();
+		/** Commits fed since the last FinishLog */
+		int32 GetLogCommitCount() const { return LogCommits.Num(); }
+
+	private:
+		friend class FVSPGitHistoryCache;
+
+		struct FCommit
+		{
+			FString Hash;
+			FString UserName;
+			int64 Timestamp = 0;
+			FString Description;
+		};
+
+		struct FEntry
+		{
+			int32 Commit = 0; ///< Index in Commits
+			TCHAR Status = 0;
+			FString RenamedFrom;
+		};
+
+		/** Oldest first, so newer commits don't move the older ones */
+		TArray< FCommit > Commits;
+		/** Changes of each file, newest first */
+		TMap< FString, TArray< FEntry > > Entries;
+
+		/** Log run being parsed: commits newest first, entries pointing into LogCommits */
+		TArray< FCommit > LogCommits;
+		TArray< TPair< FString, FEntry > > LogEntries;
+		FString LogStatus;
+		FString LogRenamedFrom;
+	};
+
+	static FVSPGitHistoryCache& Get();
+
+	/** Map the index saved for the repository when it changes */
+	void Configure( const FString& InRepoRoot );
+	/** Unmap the index, Configure maps it again */
+	void Shutdown();
+
+	/** Commit the index was built up to, empty without an index */
+	FString GetTipCommit() const;
+	/** Whether the segments are worth merging, by loading them into a builder and saving it */
+	bool NeedsCompaction() const;
+	/** Fill the builder with the content of the index, for adding newer commits on top of it */
+	void LoadInto( FBuilder& OutBuilder ) const;
+	/** Save the builder content as the index of InTipCommit and switch to it */
+	bool Save( const FBuilder& InBuilder, const FString& InTipCommit );
+	/** Append the builder commits, all newer than the index tip, as a segment leading to InTipCommit */
+	bool Append( const FBuilder& InBuilder, const FString& InTipCommit );
+
+	/** History of the file (relative to the repository root) newest first, following renames; false when the index doesn't know the file */
+	bool GetHistory( const FString& InFile, TArray< FVSPGitHistoryEntry >& OutHistory ) const;
+
+private:
+	FVSPGitHistoryCache() = default;
+	~FVSPGitHistoryCache();
+
+	/** Segment of the builder content, its entries numbering commits from InFirstCommit */
+	static void MakeSegment( const FBuilder& InBuilder, const FString& InTipCommit, const FString& InRepoRoot, uint32 InFirstCommit, TArray< uint8 >& OutSegment );
+
+	bool MapIndex();
+	void UnmapIndex();
+	FString GetIndexFilename() const;
+
+	/** UTF-8 string of the segment string table, empty if out of bounds */
+	FString GetIndexString( const uint8* InSegment, uint32 InOffset, uint32 InLength ) const;
+	/** Index of the file in the sorted path table of the segment, INDEX_NONE if missing */
+	int32 FindPath( const uint8* InSegment, const FTCHARToUTF8& InUtf8Path ) const;
+
+	mutable FCriticalSection Lock;
+	FString RepoRoot;
+
+	IMappedFileHandle* MappedHandle = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+	/** Content of the index when the platform can't map files */
+	TArray< uint8 > LoadedIndex;
+	const uint8* IndexData = nullptr;
+	int64 IndexSize = 0;
+	/** Start of each segment in IndexData, oldest first */
+	TArray< int64 > SegmentOffsets;
+	/** Commits of all the segments */
+	uint32 CommitCount = 0;
+};
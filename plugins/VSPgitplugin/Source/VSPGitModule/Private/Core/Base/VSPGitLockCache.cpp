@@ -0,0 +1,178 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitLockCache.h"
+// Engine headers
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+// Module headers
+#include "VSPGitModule.h"
+
+namespace VSPGitLockCacheLocal
+{
+	/** Interval between two refreshes of the whole table right after it changed */
+	const double MinRefreshIntervalSeconds = 30.0;
+	/** Interval between two refreshes of the whole table when it doesn't change for long */
+	const double MaxRefreshIntervalSeconds = 60.0 * 10.0;
+
+	bool IsSameLock( const VSPGitHelpers::FGitLfsLockInfo& InLeft, const VSPGitHelpers::FGitLfsLockInfo& InRight );
+}
+
+bool VSPGitLockCacheLocal::IsSameLock( const VSPGitHelpers::FGitLfsLockInfo& InLeft, const VSPGitHelpers::FGitLfsLockInfo& InRight )
+{
+	return InLeft.Id == InRight.Id && InLeft.LockUser == InRight.LockUser;
+}
+
+FVSPGitLockCache& FVSPGitLockCache::Get()
+{
+	static FVSPGitLockCache LockCache;
+	return LockCache;
+}
+
+FVSPGitLockCache::FVSPGitLockCache( const FString& InSnapshotFilename )
+	: SnapshotFilename( InSnapshotFilename.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT( "SourceControl" ) / TEXT( "VSPGitLfsLocks.txt" ) : InSnapshotFilename )
+{}
+
+void FVSPGitLockCache::Configure( const FString& InRepoRoot )
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( RepoRoot == InRepoRoot )
+		return;
+
+	RepoRoot = InRepoRoot;
+	Locks.Empty();
+	bHasLocks = false;
+	RefreshIntervalSeconds = VSPGitLockCacheLocal::MinRefreshIntervalSeconds;
+	LoadSnapshot();
+}
+
+void FVSPGitLockCache::Reset()
+{
+	FScopeLock ScopeLock( &Lock );
+	Locks.Empty();
+	bHasLocks = false;
+	RefreshIntervalSeconds = VSPGitLockCacheLocal::MinRefreshIntervalSeconds;
+}
+
+bool FVSPGitLockCache::NeedsFullRefresh() const
+{
+	FScopeLock ScopeLock( &Lock );
+	if ( !bHasLocks )
+		return true;
+
+	const FTimespan ElapsedTime = FDateTime::UtcNow() - FullRefreshTime;
+	return ElapsedTime.GetTotalSeconds() >= RefreshIntervalSeconds;
+}
+
+bool FVSPGitLockCache::HasLocks() const
+{
+	FScopeLock ScopeLock( &Lock );
+	return bHasLocks;
+}
+
+double FVSPGitLockCache::GetRefreshIntervalSeconds() const
+{
+	FScopeLock ScopeLock( &Lock );
+	return RefreshIntervalSeconds;
+}
+
+void FVSPGitLockCache::SetAllLocks( const FLockMap& InLocks )
+{
+	FScopeLock ScopeLock( &Lock );
+
+	bool bChanged = !bHasLocks || Locks.Num() != InLocks.Num();
+	for ( auto LockIt = InLocks.CreateConstIterator(); LockIt && !bChanged; ++LockIt )
+	{
+		const TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >* CachedLock = Locks.Find( LockIt.Key() );
+		bChanged = CachedLock == nullptr || !VSPGitLockCacheLocal::IsSameLock( CachedLock->Get(), LockIt.Value().Get() );
+	}
+
+	// Others are busy locking files: look again soon, otherwise less and less often
+	RefreshIntervalSeconds = bChanged
+		? VSPGitLockCacheLocal::MinRefreshIntervalSeconds
+		: FMath::Min( RefreshIntervalSeconds * 2.0, VSPGitLockCacheLocal::MaxRefreshIntervalSeconds );
+	FullRefreshTime = FDateTime::UtcNow();
+	bHasLocks = true;
+
+	if ( bChanged )
+	{
+		Locks = InLocks;
+		SaveSnapshot();
+	}
+}
+
+void FVSPGitLockCache::SetFileLocks( const TArray< FString >& InFiles, const FLockMap& InLocks )
+{
+	FScopeLock ScopeLock( &Lock );
+
+	bool bChanged = false;
+	for ( const FString& File : InFiles )
+	{
+		const TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >* NewLock = InLocks.Find( File );
+		const TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >* CachedLock = Locks.Find( File );
+		if ( NewLock == nullptr )
+			bChanged |= Locks.Remove( File ) > 0;
+		else if ( CachedLock == nullptr || !VSPGitLockCacheLocal::IsSameLock( CachedLock->Get(), NewLock->Get() ) )
+		{
+			Locks.Add( File, *NewLock );
+			bChanged = true;
+		}
+	}
+
+	if ( bChanged )
+		SaveSnapshot();
+}
+
+FVSPGitLockCache::FLockMap FVSPGitLockCache::GetLocks() const
+{
+	FScopeLock ScopeLock( &Lock );
+	return Locks;
+}
+
+// Snapshot format: the repository root on the first line, then one lock per line as printed by 'git lfs locks'
+void FVSPGitLockCache::LoadSnapshot()
+{
+	TArray< FString > Lines;
+	if ( !FFileHelper::LoadFileToStringArray( Lines, *SnapshotFilename ) || Lines.Num() == 0 || Lines[ 0 ] != RepoRoot )
+		return;
+
+	for ( int32 Index = 1; Index < Lines.Num(); Index++ )
+	{
+		TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > LockInfo = MakeShared< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >( Lines[ Index ] );
+		if ( !LockInfo->LocalFilename.IsEmpty() )
+			Locks.Add( LockInfo->LocalFilename, LockInfo );
+	}
+
+	// The snapshot ages like a table fetched when it was written
+	bHasLocks = true;
+	FullRefreshTime = IFileManager::Get().GetTimeStamp( *SnapshotFilename );
+	UE_LOG( VSPGitLog, Log, TEXT("Loaded %d Git LFS locks from %s"), Locks.Num(), *SnapshotFilename );
+}
+
+void FVSPGitLockCache::SaveSnapshot() const
+{
+	TArray< FString > Lines;
+	Lines.Reserve( Locks.Num() + 1 );
+	Lines.Add( RepoRoot );
+	for ( const auto& LockPair : Locks )
+		Lines.Add( FString::Printf( TEXT( "%s\t%s\tID:%d" ), *LockPair.Key, *LockPair.Value->LockUser, LockPair.Value->Id ) );
+
+	if ( !FFileHelper::SaveStringArrayToFile( Lines, *SnapshotFilename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM ) )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("Failed to save the Git LFS locks to %s"), *SnapshotFilename );
+	}
+}
@@ -0,0 +1,68 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+// Engine headers
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+// Module headers
+#include "VSPGitHelpers.h"
+
+/**
+* Local copy of the Git LFS lock table, saved to disk so the editor starts with the locks known last time.
+* The whole table is asked from the server rarely, less often while it doesn't change,
+* and the locks of single files are refreshed on their own when they matter (status of an opened asset, checkout).
+*/
+class FVSPGitLockCache
+{
+public:
+	typedef TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > FLockMap;
+
+	static FVSPGitLockCache& Get();
+
+	/** The snapshot goes to the project Saved directory unless told otherwise */
+	explicit FVSPGitLockCache( const FString& InSnapshotFilename = FString() );
+
+	/** Load the snapshot of the repository when it changes */
+	void Configure( const FString& InRepoRoot );
+	/** Forget the table, the next refresh asks the server for all of it */
+	void Reset();
+
+	/** Whether the whole table is due for a refresh from the server */
+	bool NeedsFullRefresh() const;
+	/** Whether there is a table at all, from the server or the snapshot */
+	bool HasLocks() const;
+	/** Current interval between two refreshes of the whole table */
+	double GetRefreshIntervalSeconds() const;
+
+	/** Replace the whole table, the refresh interval shrinks when someone locked or unlocked files and grows otherwise */
+	void SetAllLocks( const FLockMap& InLocks );
+	/** Replace the locks of the given files only (relative to the repository root) */
+	void SetFileLocks( const TArray< FString >& InFiles, const FLockMap& InLocks );
+	FLockMap GetLocks() const;
+
+private:
+	void LoadSnapshot();
+	void SaveSnapshot() const;
+
+	const FString SnapshotFilename;
+	mutable FCriticalSection Lock;
+	FString RepoRoot;
+	FLockMap Locks;
+	bool bHasLocks = false;
+	FDateTime FullRefreshTime;
+	double RefreshIntervalSeconds = 0.0;
+};
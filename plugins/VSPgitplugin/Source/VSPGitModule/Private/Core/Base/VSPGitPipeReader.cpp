@@ -0,0 +1,135 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitPipeReader.h"
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_UNIX
+#include <errno.h>
+#include <poll.h>
+#endif
+
+namespace VSPGitPipeReaderLocal
+{
+	/** Longest sleep between two peeks, bounds the latency added to short commands */
+	const float MaxBackoffSeconds = 0.005f;
+}
+
+FVSPGitPipeReader::FVSPGitPipeReader( void* InReadPipe )
+	: ReadPipe( InReadPipe )
+	, bClosed( InReadPipe == nullptr )
+{}
+
+bool FVSPGitPipeReader::Read( TArray< uint8 >& OutData, double InTimeoutSeconds )
+{
+	OutData.Reset();
+	if ( bClosed )
+		return false;
+
+	const double Deadline = FPlatformTime::Seconds() + InTimeoutSeconds;
+#if PLATFORM_UNIX
+	pollfd PollFd;
+	PollFd.fd = static_cast< FPipeHandle* >( ReadPipe )->GetHandle();
+	PollFd.events = POLLIN;
+	while ( true )
+	{
+		PollFd.revents = 0;
+		const int32 TimeoutMs = FMath::Max( 0, FMath::CeilToInt( ( Deadline - FPlatformTime::Seconds() ) * 1000.0 ) );
+		const int32 Result = poll( &PollFd, 1, TimeoutMs );
+		if ( Result < 0 && errno == EINTR )
+			continue;
+		if ( Result == 0 )
+			return false;
+
+		if ( Result > 0 && FPlatformProcess::ReadPipeToArray( ReadPipe, OutData ) && OutData.Num() > 0 )
+			return true;
+		// Nothing to read after a wake up: the write end is closed on every side
+		if ( Result < 0 || ( PollFd.revents & ( POLLHUP | POLLERR | POLLNVAL ) ) != 0 )
+		{
+			bClosed = true;
+			return false;
+		}
+	}
+#else
+	float BackoffSeconds = 0.f;
+	while ( true )
+	{
+#if PLATFORM_WINDOWS
+		DWORD Available = 0;
+		if ( !::PeekNamedPipe( ReadPipe, nullptr, 0, nullptr, &Available, nullptr ) )
+		{
+			// ERROR_BROKEN_PIPE once the output is drained and the writers are gone
+			bClosed = true;
+			return false;
+		}
+		if ( Available > 0 && FPlatformProcess::ReadPipeToArray( ReadPipe, OutData ) && OutData.Num() > 0 )
+			return true;
+#else
+		if ( FPlatformProcess::ReadPipeToArray( ReadPipe, OutData ) && OutData.Num() > 0 )
+			return true;
+#endif
+		if ( FPlatformTime::Seconds() >= Deadline )
+			return false;
+		FPlatformProcess::Sleep( BackoffSeconds );
+		BackoffSeconds = FMath::Min( BackoffSeconds * 2.f + 0.0001f, VSPGitPipeReaderLocal::MaxBackoffSeconds );
+	}
+#endif
+}
+
+FVSPGitLineSplitter::FVSPGitLineSplitter( TFunctionRef< void( const FString& ) > InOnLine, bool bInNulSeparated )
+	: OnLine( InOnLine )
+	, bNulSeparated( bInNulSeparated )
+{}
+
+void FVSPGitLineSplitter::Append( const TArray< uint8 >& InData )
+{
+	int32 LineStart = 0;
+	for ( int32 Index = 0; Index < InData.Num(); Index++ )
+	{
+		// Progress output rewrites its line with a lone carriage return
+		const bool bSeparator = bNulSeparated
+			? InData[ Index ] == '\0'
+			: InData[ Index ] == '\n' || InData[ Index ] == '\r';
+		if ( !bSeparator )
+			continue;
+
+		if ( PendingLine.Num() > 0 )
+		{
+			// The line started in a previous chunk
+			PendingLine.Append( InData.GetData() + LineStart, Index - LineStart );
+			EmitLine( PendingLine.GetData(), PendingLine.Num() );
+			PendingLine.Reset();
+		}
+		else
+			EmitLine( InData.GetData() + LineStart, Index - LineStart );
+		LineStart = Index + 1;
+	}
+	PendingLine.Append( InData.GetData() + LineStart, InData.Num() - LineStart );
+}
+
+void FVSPGitLineSplitter::Flush()
+{
+	EmitLine( PendingLine.GetData(), PendingLine.Num() );
+	PendingLine.Reset();
+}
+
+void FVSPGitLineSplitter::EmitLine( const uint8* InStart, int32 InLength )
+{
+	if ( InLength == 0 )
+		return;
+
+	const FUTF8ToTCHAR Line( reinterpret_cast< const ANSICHAR* >( InStart ), InLength );
+	OnLine( FString( Line.Length(), Line.Get() ) );
+}
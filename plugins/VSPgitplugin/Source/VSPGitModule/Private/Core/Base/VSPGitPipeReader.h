@@ -0,0 +1,58 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+// Engine headers
+#include "CoreMinimal.h"
+
+/**
+* Reads the output of a git process as it comes instead of spinning on the pipe:
+* poll() on Unix, a backed off peek where anonymous pipes can't be waited on.
+* The parent copy of the pipe write end must be closed for the reader to see the end of the output.
+*/
+class FVSPGitPipeReader
+{
+public:
+	FVSPGitPipeReader( void* InReadPipe = nullptr );
+
+	/** Wait for the next chunk of output, false if the timeout expired or the pipe was closed first */
+	bool Read( TArray< uint8 >& OutData, double InTimeoutSeconds );
+	/** Every writer is gone and all the output was read (not detected on every platform) */
+	bool IsClosed() const { return bClosed; }
+
+private:
+	void* ReadPipe;
+	bool bClosed;
+};
+
+/** Cut UTF-8 output into lines (or NUL separated records) as chunks arrive, keeping only the unfinished last one */
+class FVSPGitLineSplitter
+{
+public:
+	/** InOnLine gets every non empty line, without its end of line characters; it must outlive the splitter */
+	FVSPGitLineSplitter( TFunctionRef< void( const FString& ) > InOnLine, bool bInNulSeparated = false );
+
+	void Append( const TArray< uint8 >& InData );
+	/** Hand out the last line when the output did not end with a line feed */
+	void Flush();
+
+private:
+	void EmitLine( const uint8* InStart, int32 InLength );
+
+	TFunctionRef< void( const FString& ) > OnLine;
+	bool bNulSeparated;
+	TArray< uint8 > PendingLine;
+};
@@ -0,0 +1,479 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitProcessPool.h"
+// Engine headers
+#include "Misc/ScopeLock.h"
+// Module headers
+#include "VSPGitHelpers.h"
+#include "VSPGitModule.h"
+
+namespace VSPGitProcessPoolLocal
+{
+	/** Helpers started per command, further requests wait for one of them */
+	const int32 MaxProcessesPerCommand = 2;
+	/** Requests written ahead of reading their answers, few enough for neither pipe to fill up */
+	const int32 MaxPipelinedRequests = 16;
+	/** A helper silent for that long is considered hung */
+	const double ResponseTimeoutSeconds = 30.0;
+	/** How often a helper waited on is checked for being alive */
+	const double ProcessCheckSeconds = 0.5;
+	/** Helpers cache .gitattributes and .gitignore, restart them from time to time to pick up changes */
+	const double MaxProcessAgeSeconds = 60.0;
+
+	void AppendUtf8( TArray< uint8 >& OutData, const FString& InString, uint8 InDelimiter );
+
+	FString Utf8ToString( const TArray< uint8 >& InData );
+
+	FVSPGitObjectInfo ParseObjectInfo( const FString& InLine );
+}
+
+void VSPGitProcessPoolLocal::AppendUtf8( TArray< uint8 >& OutData, const FString& InString, uint8 InDelimiter )
+{
+	const FTCHARToUTF8 Utf8String( *InString );
+	OutData.Append( reinterpret_cast< const uint8* >( Utf8String.Get() ), Utf8String.Length() );
+	OutData.Add( InDelimiter );
+}
+
+FString VSPGitProcessPoolLocal::Utf8ToString( const TArray< uint8 >& InData )
+{
+	const FUTF8ToTCHAR String( reinterpret_cast< const ANSICHAR* >( InData.GetData() ), InData.Num() );
+	return FString( String.Length(), String.Get() );
+}
+
+// Parse "<sha1> <type> <size>", or "<object> missing" / "<object> ambiguous" into an invalid info
+FVSPGitObjectInfo VSPGitProcessPoolLocal::ParseObjectInfo( const FString& InLine )
+{
+	FVSPGitObjectInfo Info;
+	TArray< FString > Words;
+	InLine.ParseIntoArray( Words, TEXT( " " ) );
+	if ( Words.Num() == 3 && Words[ 2 ].IsNumeric() )
+	{
+		Info.Hash = MoveTemp( Words[ 0 ] );
+		Info.Type = MoveTemp( Words[ 1 ] );
+		Info.Size = FCString::Atoi64( *Words[ 2 ] );
+	}
+	return Info;
+}
+
+FVSPGitBatchProcess::FVSPGitBatchProcess( const FString& InGitBinPath, const FString& InRepoRoot, const FString& InCommand )
+	: GitBinPath( InGitBinPath )
+	, RepoRoot( InRepoRoot )
+	, Command( InCommand )
+{}
+
+FVSPGitBatchProcess::~FVSPGitBatchProcess()
+{
+	Stop();
+}
+
+bool FVSPGitBatchProcess::Start()
+{
+	Stop();
+
+	FString Params;
+	if ( !RepoRoot.IsEmpty() )
+		Params = FString::Printf( TEXT( "-C \"%s\" " ), *RepoRoot );
+	Params += Command;
+
+	FScopeLock ProcessStartLock( &VSPGitHelpers::GetProcessStartLock() );
+	if ( !VSPGitHelpers::CreateStdOutPipe( StdOutRead, StdOutWrite ) || !VSPGitHelpers::CreateStdInPipe( StdInRead, StdInWrite ) )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("Cant create pipes for 'git %s'."), *Params );
+		Stop();
+		return false;
+	}
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+
+	ProcessHandle = FPlatformProcess::CreateProc(
+		*GitBinPath,
+		*Params,
+		bLaunchDetached,
+		bLaunchHidden,
+		bLaunchReallyHidden,
+		nullptr,
+		0,
+		nullptr,
+		StdOutWrite,
+		StdInRead );
+	if ( !ProcessHandle.IsValid() )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("Cant create proccess for 'git %s'."), *Params );
+		Stop();
+		return false;
+	}
+
+	// The child has its own copies: without ours, a dead helper shows up as a closed pipe
+	FPlatformProcess::ClosePipe( StdInRead, StdOutWrite );
+	StdInRead = StdOutWrite = nullptr;
+	StdOutReader = FVSPGitPipeReader( StdOutRead );
+
+	StartTime = FPlatformTime::Seconds();
+	UE_LOG( VSPGitLog, Verbose, TEXT("--- Started helper 'git %s'"), *Params );
+	return true;
+}
+
+void FVSPGitBatchProcess::Stop()
+{
+	if ( ProcessHandle.IsValid() )
+	{
+		// Helpers wait on stdin forever, there is nothing left to flush
+		if ( FPlatformProcess::IsProcRunning( ProcessHandle ) )
+			FPlatformProcess::TerminateProc( ProcessHandle );
+		FPlatformProcess::CloseProc( ProcessHandle );
+		ProcessHandle = FProcHandle();
+	}
+	if ( StdOutRead != nullptr || StdOutWrite != nullptr )
+		FPlatformProcess::ClosePipe( StdOutRead, StdOutWrite );
+	if ( StdInRead != nullptr || StdInWrite != nullptr )
+		FPlatformProcess::ClosePipe( StdInRead, StdInWrite );
+	StdOutRead = StdOutWrite = StdInRead = StdInWrite = nullptr;
+	StdOutReader = FVSPGitPipeReader();
+
+	Buffer.Reset();
+	BufferOffset = 0;
+}
+
+bool FVSPGitBatchProcess::IsRunning()
+{
+	return ProcessHandle.IsValid() && FPlatformProcess::IsProcRunning( ProcessHandle );
+}
+
+double FVSPGitBatchProcess::GetAge() const
+{
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+bool FVSPGitBatchProcess::Write( const TArray< uint8 >& InRequest )
+{
+	int32 Written = 0;
+	return StdInWrite != nullptr
+		&& FPlatformProcess::WritePipe( StdInWrite, InRequest.GetData(), InRequest.Num(), &Written )
+		&& Written == InRequest.Num();
+}
+
+bool FVSPGitBatchProcess::ReadUntil( uint8 InDelimiter, TArray< uint8 >& OutData )
+{
+	int32 SearchFrom = BufferOffset;
+	while ( true )
+	{
+		for ( int32 Index = SearchFrom; Index < Buffer.Num(); Index++ )
+			if ( Buffer[ Index ] == InDelimiter )
+			{
+				OutData.Reset();
+				OutData.Append( Buffer.GetData() + BufferOffset, Index - BufferOffset );
+				BufferOffset = Index + 1;
+				return true;
+			}
+
+		// FillBuffer drops the consumed head, keep the search position relative to the unread data
+		const int32 Searched = Buffer.Num() - BufferOffset;
+		if ( !FillBuffer() )
+			return false;
+		SearchFrom = BufferOffset + Searched;
+	}
+}
+
+bool FVSPGitBatchProcess::ReadBytes( int32 InCount, TArray< uint8 >& OutData )
+{
+	while ( Buffer.Num() - BufferOffset < InCount )
+		if ( !FillBuffer() )
+			return false;
+
+	OutData.Reset();
+	OutData.Append( Buffer.GetData() + BufferOffset, InCount );
+	BufferOffset += InCount;
+	return true;
+}
+
+bool FVSPGitBatchProcess::ReadBytes( int64 InCount, TFunctionRef< bool( const uint8* InData, int32 InNum ) > InSink )
+{
+	bool bSinkReading = true;
+	while ( InCount > 0 )
+	{
+		// FillBuffer drops the consumed head, so the buffer holds one pipe chunk at a time
+		if ( BufferOffset == Buffer.Num() && !FillBuffer() )
+			return false;
+
+		const int32 Num = static_cast< int32 >( FMath::Min< int64 >( InCount, Buffer.Num() - BufferOffset ) );
+		if ( bSinkReading )
+			bSinkReading = InSink( Buffer.GetData() + BufferOffset, Num );
+		BufferOffset += Num;
+		InCount -= Num;
+	}
+	return true;
+}
+
+bool FVSPGitBatchProcess::FillBuffer()
+{
+	const double WaitStartTime = FPlatformTime::Seconds();
+	TArray< uint8 > Data;
+	while ( !StdOutReader.Read( Data, VSPGitProcessPoolLocal::ProcessCheckSeconds ) )
+	{
+		if ( StdOutReader.IsClosed() || !IsRunning() )
+		{
+			// Pick up whatever the helper wrote before exiting
+			if ( !StdOutReader.Read( Data, 0.0 ) )
+				return false;
+			break;
+		}
+		if ( FPlatformTime::Seconds() - WaitStartTime > VSPGitProcessPoolLocal::ResponseTimeoutSeconds )
+		{
+			UE_LOG( VSPGitLog, Warning, TEXT("Helper 'git %s' does not answer."), *Command );
+			return false;
+		}
+	}
+
+	if ( BufferOffset > 0 )
+	{
+		Buffer.RemoveAt( 0, BufferOffset, false );
+		BufferOffset = 0;
+	}
+	Buffer.Append( MoveTemp( Data ) );
+	return true;
+}
+
+FVSPGitProcessPool& FVSPGitProcessPool::Get()
+{
+	static FVSPGitProcessPool ProcessPool;
+	return ProcessPool;
+}
+
+void FVSPGitProcessPool::Configure( const FString& InGitBinPath, const FString& InRepoRoot )
+{
+	FScopeLock ScopeLock( &ProcessesLock );
+	if ( GitBinPath == InGitBinPath && RepoRoot == InRepoRoot )
+		return;
+
+	// Helpers busy with a request are stopped by their last user
+	Processes.Empty();
+	GitBinPath = InGitBinPath;
+	RepoRoot = InRepoRoot;
+}
+
+void FVSPGitProcessPool::Shutdown()
+{
+	FScopeLock ScopeLock( &ProcessesLock );
+	Processes.Empty();
+}
+
+bool FVSPGitProcessPool::GetObjectInfos( const TArray< FString >& InObjectNames, TArray< FVSPGitObjectInfo >& OutInfos )
+{
+	using namespace VSPGitProcessPoolLocal;
+
+	return RunRequest(
+		TEXT( "cat-file --batch-check" ),
+		[&InObjectNames, &OutInfos]( FVSPGitBatchProcess& Process )
+		{
+			OutInfos.Reset( InObjectNames.Num() );
+			TArray< uint8 > Request;
+			TArray< uint8 > Line;
+			for ( int32 First = 0; First < InObjectNames.Num(); First += MaxPipelinedRequests )
+			{
+				const int32 Last = FMath::Min( First + MaxPipelinedRequests, InObjectNames.Num() );
+				Request.Reset();
+				for ( int32 Index = First; Index < Last; Index++ )
+					AppendUtf8( Request, InObjectNames[ Index ], '\n' );
+				if ( !Process.Write( Request ) )
+					return false;
+
+				for ( int32 Index = First; Index < Last; Index++ )
+				{
+					if ( !Process.ReadUntil( '\n', Line ) )
+						return false;
+					OutInfos.Add( ParseObjectInfo( Utf8ToString( Line ) ) );
+				}
+			}
+			return true;
+		} );
+}
+
+bool FVSPGitProcessPool::StreamObjectContent(
+	const FString& InObjectName,
+	int32 InHeadSize,
+	FVSPGitObjectInfo& OutInfo,
+	TFunctionRef< bool( const uint8* InData, int32 InNum, int64 InOffset ) > InSink )
+{
+	using namespace VSPGitProcessPoolLocal;
+
+	const bool bResult = RunRequest(
+		TEXT( "cat-file --batch" ),
+		[&InObjectName, InHeadSize, &OutInfo, &InSink]( FVSPGitBatchProcess& Process )
+		{
+			TArray< uint8 > Request;
+			AppendUtf8( Request, InObjectName, '\n' );
+			TArray< uint8 > Line;
+			if ( !Process.Write( Request ) || !Process.ReadUntil( '\n', Line ) )
+				return false;
+
+			OutInfo = ParseObjectInfo( Utf8ToString( Line ) );
+			if ( !OutInfo.IsValid() )
+				return true;
+
+			TArray< uint8 > Head;
+			const int32 HeadSize = static_cast< int32 >( FMath::Min< int64 >( OutInfo.Size, FMath::Max( InHeadSize, 0 ) ) );
+			if ( !Process.ReadBytes( HeadSize, Head ) )
+				return false;
+
+			int64 Offset = 0;
+			bool bSinkReading = InSink( Head.GetData(), Head.Num(), Offset );
+			Offset += Head.Num();
+			const bool bRead = Process.ReadBytes(
+				OutInfo.Size - HeadSize,
+				[&InSink, &Offset, &bSinkReading]( const uint8* InData, int32 InNum )
+				{
+					bSinkReading = bSinkReading && InSink( InData, InNum, Offset );
+					Offset += InNum;
+					return bSinkReading;
+				} );
+			// The content is terminated by an extra newline
+			return bRead && Process.ReadUntil( '\n', Line );
+		} );
+
+	return bResult && OutInfo.IsValid();
+}
+
+bool FVSPGitProcessPool::GetAttributes(
+	const TArray< FString >& InAttributes,
+	const TArray< FString >& InFiles,
+	TMap< FString, TMap< FString, FString > >& OutAttributes )
+{
+	using namespace VSPGitProcessPoolLocal;
+
+	// Answers are "<path> NUL <attribute> NUL <value> NUL" for each attribute of each path
+	const FString Command = TEXT( "check-attr --stdin -z " ) + FString::Join( InAttributes, TEXT( " " ) );
+	return RunRequest(
+		Command,
+		[&InAttributes, &InFiles, &OutAttributes]( FVSPGitBatchProcess& Process )
+		{
+			OutAttributes.Reset();
+			TArray< uint8 > Request;
+			TArray< uint8 > Path;
+			TArray< uint8 > Attribute;
+			TArray< uint8 > Value;
+			for ( int32 First = 0; First < InFiles.Num(); First += MaxPipelinedRequests )
+			{
+				const int32 Last = FMath::Min( First + MaxPipelinedRequests, InFiles.Num() );
+				Request.Reset();
+				for ( int32 Index = First; Index < Last; Index++ )
+					AppendUtf8( Request, InFiles[ Index ], '\0' );
+				if ( !Process.Write( Request ) )
+					return false;
+
+				for ( int32 Index = First; Index < Last; Index++ )
+				{
+					TMap< FString, FString >& FileAttributes = OutAttributes.Add( InFiles[ Index ] );
+					for ( int32 AttributeIndex = 0; AttributeIndex < InAttributes.Num(); AttributeIndex++ )
+					{
+						if ( !Process.ReadUntil( '\0', Path ) || !Process.ReadUntil( '\0', Attribute ) || !Process.ReadUntil( '\0', Value ) )
+							return false;
+						FileAttributes.Add( Utf8ToString( Attribute ), Utf8ToString( Value ) );
+					}
+				}
+			}
+			return true;
+		} );
+}
+
+bool FVSPGitProcessPool::GetIgnoredFiles( const TArray< FString >& InFiles, TArray< FString >& OutIgnoredFiles )
+{
+	using namespace VSPGitProcessPoolLocal;
+
+	// With --non-matching every path gets an answer "<source> NUL <line> NUL <pattern> NUL <path> NUL",
+	// where the source is empty for paths matching no rule and the pattern starts with '!' for negated rules
+	return RunRequest(
+		TEXT( "check-ignore --stdin -z --non-matching --verbose" ),
+		[&InFiles, &OutIgnoredFiles]( FVSPGitBatchProcess& Process )
+		{
+			OutIgnoredFiles.Reset();
+			TArray< uint8 > Request;
+			TArray< uint8 > Source;
+			TArray< uint8 > LineNumber;
+			TArray< uint8 > Pattern;
+			TArray< uint8 > Path;
+			for ( int32 First = 0; First < InFiles.Num(); First += MaxPipelinedRequests )
+			{
+				const int32 Last = FMath::Min( First + MaxPipelinedRequests, InFiles.Num() );
+				Request.Reset();
+				for ( int32 Index = First; Index < Last; Index++ )
+					AppendUtf8( Request, InFiles[ Index ], '\0' );
+				if ( !Process.Write( Request ) )
+					return false;
+
+				for ( int32 Index = First; Index < Last; Index++ )
+				{
+					if ( !Process.ReadUntil( '\0', Source )
+						|| !Process.ReadUntil( '\0', LineNumber )
+						|| !Process.ReadUntil( '\0', Pattern )
+						|| !Process.ReadUntil( '\0', Path ) )
+						return false;
+					if ( Source.Num() > 0 && ( Pattern.Num() == 0 || Pattern[ 0 ] != '!' ) )
+						OutIgnoredFiles.Add( InFiles[ Index ] );
+				}
+			}
+			return true;
+		} );
+}
+
+bool FVSPGitProcessPool::RunRequest( const FString& InCommand, TFunctionRef< bool( FVSPGitBatchProcess& ) > InRequest )
+{
+	const FVSPGitBatchProcessPtr Process = AcquireProcess( InCommand );
+
+	if ( Process->GetAge() > VSPGitProcessPoolLocal::MaxProcessAgeSeconds )
+		Process->Stop();
+
+	const bool bStarted = Process->IsRunning() || Process->Start();
+	bool bResult = bStarted && InRequest( *Process );
+	if ( bStarted && !bResult )
+	{
+		// The helper crashed before or during the request, or its answers got out of sync: retry on a fresh one
+		UE_LOG( VSPGitLog, Warning, TEXT("Restarting helper 'git %s'."), *InCommand );
+		bResult = Process->Start() && InRequest( *Process );
+	}
+	if ( !bResult )
+		Process->Stop();
+
+	Process->Lock.Unlock();
+	return bResult;
+}
+
+FVSPGitProcessPool::FVSPGitBatchProcessPtr FVSPGitProcessPool::AcquireProcess( const FString& InCommand )
+{
+	FVSPGitBatchProcessPtr Process;
+	{
+		FScopeLock ScopeLock( &ProcessesLock );
+		TArray< FVSPGitBatchProcessPtr >& CommandProcesses = Processes.FindOrAdd( InCommand );
+		for ( const FVSPGitBatchProcessPtr& CommandProcess : CommandProcesses )
+			if ( CommandProcess->Lock.TryLock() )
+				return CommandProcess;
+
+		if ( CommandProcesses.Num() < VSPGitProcessPoolLocal::MaxProcessesPerCommand )
+		{
+			Process = MakeShared< FVSPGitBatchProcess, ESPMode::ThreadSafe >( GitBinPath, RepoRoot, InCommand );
+			Process->Lock.Lock();
+			CommandProcesses.Add( Process );
+			return Process;
+		}
+
+		Process = CommandProcesses[ NextProcess++ % CommandProcesses.Num() ];
+	}
+
+	// All helpers for the command are busy, queue up on one of them
+	Process->Lock.Lock();
+	return Process;
+}
@@ -0,0 +1,136 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+// Engine headers
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+// Module headers
+#include "VSPGitPipeReader.h"
+
+/**
+* Long-lived git helper process, e.g. 'git cat-file --batch' or 'git check-attr --stdin'.
+* Requests are written to its stdin and answers read back from its stdout, the caller holds Lock meanwhile.
+*/
+class FVSPGitBatchProcess
+{
+public:
+	FVSPGitBatchProcess( const FString& InGitBinPath, const FString& InRepoRoot, const FString& InCommand );
+	~FVSPGitBatchProcess();
+
+	bool Start();
+	void Stop();
+	bool IsRunning();
+	/** Seconds since the helper was started */
+	double GetAge() const;
+
+	/** Write a raw request to the helper stdin */
+	bool Write( const TArray< uint8 >& InRequest );
+	/** Read the helper answer up to the delimiter (not included), waits until it arrives */
+	bool ReadUntil( uint8 InDelimiter, TArray< uint8 >& OutData );
+	/** Read exactly InCount bytes of the helper answer */
+	bool ReadBytes( int32 InCount, TArray< uint8 >& OutData );
+	/** Hand the next InCount bytes of the helper answer to InSink as they arrive, skip the rest once it returns false */
+	bool ReadBytes( int64 InCount, TFunctionRef< bool( const uint8* InData, int32 InNum ) > InSink );
+
+	/** Taken by the thread talking to the helper */
+	FCriticalSection Lock;
+
+private:
+	/** Crashes and ages helpers in the tests */
+	friend class FVSPGitProcessPoolTestAccess;
+
+	/** Append the next chunk of stdout to Buffer, false if the helper died or hangs */
+	bool FillBuffer();
+
+	FString GitBinPath;
+	FString RepoRoot;
+	FString Command;
+
+	FProcHandle ProcessHandle;
+	double StartTime = 0.0;
+	void* StdOutRead = nullptr;
+	void* StdOutWrite = nullptr;
+	void* StdInRead = nullptr;
+	void* StdInWrite = nullptr;
+	FVSPGitPipeReader StdOutReader;
+
+	/** Read but not consumed stdout, starting at BufferOffset */
+	TArray< uint8 > Buffer;
+	int32 BufferOffset = 0;
+};
+
+/** Object information as given by 'git cat-file --batch-check' */
+struct FVSPGitObjectInfo
+{
+	FString Hash; ///< SHA1 Id of the object
+	FString Type; ///< "blob", "tree", "commit" or "tag"
+	int64 Size = -1; ///< Size of the object (in bytes), -1 if the object is missing
+
+	bool IsValid() const { return Size >= 0; }
+};
+
+/**
+* Pool of git helpers answering object and path queries over their stdin/stdout,
+* so those queries skip the process start of a plain git command.
+* Helpers are started on first use and restarted after a crash.
+*/
+class FVSPGitProcessPool
+{
+public:
+	static FVSPGitProcessPool& Get();
+
+	/** Restart the helpers when the git binary or the repository changes */
+	void Configure( const FString& InGitBinPath, const FString& InRepoRoot );
+	/** Stop all helpers, they are started again by the next query */
+	void Shutdown();
+
+	/** 'git cat-file --batch-check', one info per object name ("<rev>:<path>", SHA1...) */
+	bool GetObjectInfos( const TArray< FString >& InObjectNames, TArray< FVSPGitObjectInfo >& OutInfos );
+	/**
+	* 'git cat-file --batch', raw content of the object without any filters applied, handed to InSink as it arrives:
+	* the first InHeadSize bytes (or the whole object if smaller) in one piece, then the rest chunk by chunk.
+	* The rest of the object is skipped once InSink returns false. InOffset is 0 again if the request is retried.
+	*/
+	bool StreamObjectContent(
+		const FString& InObjectName,
+		int32 InHeadSize,
+		FVSPGitObjectInfo& OutInfo,
+		TFunctionRef< bool( const uint8* InData, int32 InNum, int64 InOffset ) > InSink );
+	/** 'git check-attr --stdin', values of the attributes of each file ("set", "unset", "unspecified" or the value) */
+	bool GetAttributes(
+		const TArray< FString >& InAttributes,
+		const TArray< FString >& InFiles,
+		TMap< FString, TMap< FString, FString > >& OutAttributes );
+	/** 'git check-ignore --stdin', the files matched by an ignore rule */
+	bool GetIgnoredFiles( const TArray< FString >& InFiles, TArray< FString >& OutIgnoredFiles );
+
+private:
+	friend class FVSPGitProcessPoolTestAccess;
+
+	typedef TSharedPtr< FVSPGitBatchProcess, ESPMode::ThreadSafe > FVSPGitBatchProcessPtr;
+
+	/** Run the request on a locked helper for the command, restarting the helper once if the request failed */
+	bool RunRequest( const FString& InCommand, TFunctionRef< bool( FVSPGitBatchProcess& ) > InRequest );
+	FVSPGitBatchProcessPtr AcquireProcess( const FString& InCommand );
+
+	FCriticalSection ProcessesLock;
+	TMap< FString, TArray< FVSPGitBatchProcessPtr > > Processes;
+	int32 NextProcess = 0;
+
+	FString GitBinPath;
+	FString RepoRoot;
+};
@@ -20,9 +20,18 @@
 #include "VSPGitModule.h"
 #include "GitLowLevelCommands.h"
 #include "Core/Base/VSPGitHelpers.h"
+#include "Core/Base/VSPGitLockCache.h"
 
 #define LOCTEXT_NAMESPACE "FVSPGitModule"
 
+namespace GitHighLevelWorkersLocal
+{
+	/** Status asked for that many files at most gets their locks from the server too, each file costs a request */
+	const int32 MaxLockRefreshFiles = 8;
+	/** Histories asked at the same time, each one is a 'git log' of its own */
+	const int32 MaxConcurrentHistories = 4;
+}
+
 const FDateTime GitHighLevelWorkers::StartMeasureTheTime( const FString& InName )
 {
 	switch ( GitLowLevelCommands::GitLogMode )
@@ -82,15 +91,19 @@ bool GitHighLevelWorkers::FConnectWorker::Execute( FVSPGitWork& InWork )
 
 	TSharedRef< FConnect, ESPMode::ThreadSafe > Operation = StaticCastSharedRef< FConnect >( InWork.Operation );
 
-	if ( InWork.Settings->GetCurrentRepoSettings()->bUsingGitLfsLocking )
+	// The saved snapshot is good enough to start with, the background task refreshes it
+	if ( InWork.Settings->GetCurrentRepoSettings()->bUsingGitLfsLocking && !FVSPGitLockCache::Get().HasLocks() )
 	{
 		FSourceControlResultInfo LfsResult;
-		const bool bLfsCommandSuccessful = GitLowLevelCommands::GetAllLocks( LfsResult, LockStatesFromGitLfs );
-		// if (!bLfsCommandSuccessful)
+		TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > AllLocks;
+		if ( GitLowLevelCommands::GetAllLocks( LfsResult, AllLocks ) )
+			FVSPGitLockCache::Get().SetAllLocks( AllLocks );
+		// else
 		// {
 		// 	UE_LOG(VSPGitLog, Error, TEXT("Command 'git lfs locks' failed. Check the availability of the remotes"));
 		// }
 	}
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
 	InWork.bCommandSuccessful = GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
 		StatesFromGit,
@@ -115,15 +128,43 @@ bool GitHighLevelWorkers::FUpdateStatusWorker::Execute( FVSPGitWork& InWork )
 
 	const auto Operation = StaticCastSharedRef< FUpdateStatus >( InWork.Operation );
 
+	// The files asked for only need their directories refreshed
+	TArray< FString > StatusDirectories;
+	if ( InWork.Files.Num() > 0 && VSPGitHelpers::GetStatusDirectories( InWork.Files, InWork.Settings->GetCurrentRepoSettings()->RepoRoot, StatusDirectories ) )
+		StatusScope = StatusDirectories;
+	else
+		StatusDirectories.Reset();
+
 	InWork.bCommandSuccessful = GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
+		StatusDirectories,
 		StatesFromGit,
 		Operation->ResultInfo );
+	if ( !InWork.bCommandSuccessful )
+		// Keep the cached states rather than dropping them
+		StatusScope.Reset();
+
+	// A few files asked for are the ones opened in the editor, worth asking the server who locks them
+	if ( InWork.Settings->GetCurrentRepoSettings()->bUsingGitLfsLocking && InWork.Files.Num() > 0 && InWork.Files.Num() <= GitHighLevelWorkersLocal::MaxLockRefreshFiles )
+	{
+		TArray< FString > LockableFiles;
+		GitLowLevelCommands::GetLockableFiles( InWork.Files, InWork.Settings->GetCurrentRepoSettings()->LockableRules, LockableFiles );
+		const TArray< FString > RelativeLockableFiles = VSPGitHelpers::CheckAndMakeRelativeFilenames(
+			LockableFiles,
+			InWork.Settings->GetCurrentRepoSettings()->RepoRoot );
+		FSourceControlResultInfo LfsResult;
+		TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > FileLocks;
+		if ( RelativeLockableFiles.Num() > 0 && GitLowLevelCommands::GetFileLocks( RelativeLockableFiles, LfsResult, FileLocks ) )
+			FVSPGitLockCache::Get().SetFileLocks( RelativeLockableFiles, FileLocks );
+	}
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
+
 	if ( Operation->ShouldUpdateHistory() )
 	{
 		TArray< FString > RelativeFilePaths = VSPGitHelpers::CheckAndMakeRelativeFilenames( InWork.Files, InWork.Settings->GetCurrentRepoSettings()->RepoRoot );
 		TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > > CachedStates;
 		FVSPGitProvider::AccessProvider().GetState( InWork.Files, CachedStates, EStateCacheUsage::Use );
+		TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > > HistoryStates;
 		for ( auto&& FilePath : RelativeFilePaths )
 		{
 			auto StatePredicate = [FilePath]( TSharedRef< ISourceControlState, ESPMode::ThreadSafe > State )
@@ -134,16 +175,35 @@ bool GitHighLevelWorkers::FUpdateStatusWorker::Execute( FVSPGitWork& InWork )
 			if ( SCState == nullptr )
 				SCState = CachedStates.FindByPredicate( StatePredicate );
 
-			if ( SCState == nullptr )
-				continue;
-
-			TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > > History;
-			if ( ( *SCState )->IsConflicted() )
-				// In case of a merge conflict, we first need to get the tip of the "remote branch" (MERGE_HEAD)
-				GitLowLevelCommands::RunGetHistory( FilePath, true, Operation->ResultInfo, History );
-			// Get the history of the file in the current branch
-			InWork.bCommandSuccessful &= GitLowLevelCommands::RunGetHistory( FilePath, false, Operation->ResultInfo, History );
-			Histories.Add( ( *SCState )->GetFilename(), History );
+			if ( SCState != nullptr )
+				HistoryStates.Add( *SCState );
+		}
+
+		// The logs of different files are independent, run a few at once
+		TArray< TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > > > FileHistories;
+		TArray< FSourceControlResultInfo > HistoryResults;
+		TArray< bool > HistorySuccessful;
+		FileHistories.SetNum( HistoryStates.Num() );
+		HistoryResults.SetNum( HistoryStates.Num() );
+		HistorySuccessful.Init( false, HistoryStates.Num() );
+		VSPGitHelpers::RunConcurrently(
+			HistoryStates.Num(),
+			GitHighLevelWorkersLocal::MaxConcurrentHistories,
+			[&]( int32 InStateIndex )
+			{
+				const FString& FilePath = HistoryStates[ InStateIndex ]->GetFilename();
+				if ( HistoryStates[ InStateIndex ]->IsConflicted() )
+					// In case of a merge conflict, we first need to get the tip of the "remote branch" (MERGE_HEAD)
+					GitLowLevelCommands::RunGetHistory( FilePath, true, HistoryResults[ InStateIndex ], FileHistories[ InStateIndex ] );
+				// Get the history of the file in the current branch
+				HistorySuccessful[ InStateIndex ] = GitLowLevelCommands::RunGetHistory( FilePath, false, HistoryResults[ InStateIndex ], FileHistories[ InStateIndex ] );
+			} );
+
+		for ( int32 StateIndex = 0; StateIndex < HistoryStates.Num(); StateIndex++ )
+		{
+			Operation->ResultInfo.Append( HistoryResults[ StateIndex ] );
+			InWork.bCommandSuccessful &= HistorySuccessful[ StateIndex ];
+			Histories.Add( HistoryStates[ StateIndex ]->GetFilename(), MoveTemp( FileHistories[ StateIndex ] ) );
 		}
 	}
 
@@ -157,7 +217,7 @@ bool GitHighLevelWorkers::FUpdateStatusWorker::Execute( FVSPGitWork& InWork )
 bool GitHighLevelWorkers::FUpdateStatusWorker::UpdateModelStates() const
 {
 	FVSPGitProvider::AccessProvider().UpdateHistories( Histories );
-	return FVSPGitProvider::AccessProvider().UpdateGitModelStates( StatesFromGit );
+	return FVSPGitLfsWorkerBase::UpdateModelStates();
 }
 
 //--------------------------------------------------------------
@@ -169,7 +229,10 @@ bool GitHighLevelWorkers::FMarkForAddWorker::Execute( FVSPGitWork& InWork )
 	check( InWork.Operation->GetName() == GetName() );
 
 	FSourceControlResultInfo ResultInfo;
-	InWork.bCommandSuccessful = GitLowLevelCommands::RunGitCommand( TEXT( "add" ), TArray< FString >(), InWork.Files, ResultInfo, InWork.OutputQueue );
+	// One ignored path makes git refuse the whole "add", so leave them out beforehand
+	TArray< FString > FilesToAdd = InWork.Files;
+	GitLowLevelCommands::RemoveIgnoredFiles( FilesToAdd );
+	InWork.bCommandSuccessful = FilesToAdd.Num() == 0 || GitLowLevelCommands::RunGitCommand( TEXT( "add" ), TArray< FString >(), FilesToAdd, ResultInfo, InWork.OutputQueue );
 	// now update the status of our files
 	InWork.bCommandSuccessful &= GitLowLevelCommands::UpdateStatus( InWork.Settings->GetCurrentRepoSettings()->LockableRules, StatesFromGit, ResultInfo );
 	InWork.Operation->AppendResultInfo( ResultInfo );
@@ -469,7 +532,11 @@ bool GitHighLevelWorkers::FLfsLocksWorker::Execute( FVSPGitWork& InWork )
 
 	TSharedRef< FLfsLocks, ESPMode::ThreadSafe > Operation = StaticCastSharedRef< FLfsLocks >( InWork.Operation );
 
-	InWork.bCommandSuccessful = GitLowLevelCommands::GetAllLocks( Operation->ResultInfo, LockStatesFromGitLfs );
+	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > AllLocks;
+	InWork.bCommandSuccessful = GitLowLevelCommands::GetAllLocks( Operation->ResultInfo, AllLocks );
+	if ( InWork.bCommandSuccessful )
+		FVSPGitLockCache::Get().SetAllLocks( AllLocks );
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
 	InWork.bCommandSuccessful &= GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
 		StatesFromGit,
@@ -498,20 +565,45 @@ bool GitHighLevelWorkers::FLockWorker::Execute( FVSPGitWork& InWork )
 
 	InWork.bCommandSuccessful = true;
 	TQueue< FString > Queue;
+	TArray< FString > LockableFiles;
+	GitLowLevelCommands::GetLockableFiles( InWork.Files, InWork.Settings->GetCurrentRepoSettings()->LockableRules, LockableFiles );
 	TArray< FString > RelativeFilePaths = VSPGitHelpers::CheckAndMakeRelativeFilenames(
-		InWork.Files,
+		LockableFiles,
 		InWork.Settings->GetCurrentRepoSettings()->RepoRoot );
+
+	// Verify pass: the server tells who holds the files right now, whatever the cached table says
+	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > FileLocks;
+	if ( GitLowLevelCommands::GetFileLocks( RelativeFilePaths, Operation->ResultInfo, FileLocks ) )
+		FVSPGitLockCache::Get().SetFileLocks( RelativeFilePaths, FileLocks );
+
+	TArray< FString > LockedFilePaths;
 	for ( auto&& FilePath : RelativeFilePaths )
 	{
-		if ( !VSPGitHelpers::IsFileLockable( FilePath, InWork.Settings->GetCurrentRepoSettings()->LockableRules ) )
+		const TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >* FileLock = FileLocks.Find( FilePath );
+		if ( FileLock != nullptr )
+		{
+			if ( !VSPGitHelpers::IsLockByMe( ( *FileLock )->LockUser ) )
+			{
+				Operation->ResultInfo.ErrorMessages.Add( FText::Format(
+					LOCTEXT( "SourceControl_LockedByOther", "'{0}' is already locked by {1}" ),
+					FText::FromString( FilePath ),
+					FText::FromString( ( *FileLock )->LockUser ) ) );
+				InWork.bCommandSuccessful = false;
+			}
 			continue;
+		}
 
 		TArray< FString > OneFileArg;
 		OneFileArg.Add( FilePath );
 		InWork.bCommandSuccessful &= GitLowLevelCommands::RunGitCommand( TEXT( "lfs lock" ), OneFileArg, TArray< FString >(), Operation->ResultInfo, Queue );
+		LockedFilePaths.Add( FilePath );
 	}
 
-	InWork.bCommandSuccessful &= GitLowLevelCommands::GetAllLocks( Operation->ResultInfo, LockStatesFromGitLfs );
+	// The new locks only, their ids come from the server
+	FileLocks.Reset();
+	if ( LockedFilePaths.Num() > 0 && GitLowLevelCommands::GetFileLocks( LockedFilePaths, Operation->ResultInfo, FileLocks ) )
+		FVSPGitLockCache::Get().SetFileLocks( LockedFilePaths, FileLocks );
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
 	InWork.bCommandSuccessful &= GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
 		StatesFromGit,
@@ -551,7 +643,10 @@ bool GitHighLevelWorkers::FUnlockWorker::Execute( FVSPGitWork& InWork )
 		InWork.bCommandSuccessful &= GitLowLevelCommands::RunGitCommand( TEXT( "lfs unlock" ), OneFileArg, TArray< FString >(), Operation->ResultInfo, Queue );
 	}
 
-	InWork.bCommandSuccessful &= GitLowLevelCommands::GetAllLocks( Operation->ResultInfo, LockStatesFromGitLfs );
+	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > FileLocks;
+	if ( GitLowLevelCommands::GetFileLocks( RelativeFilePaths, Operation->ResultInfo, FileLocks ) )
+		FVSPGitLockCache::Get().SetFileLocks( RelativeFilePaths, FileLocks );
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
 	InWork.bCommandSuccessful &= GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
 		StatesFromGit,
@@ -598,12 +693,51 @@ bool GitHighLevelWorkers::FBackgroundWorker::Execute( FVSPGitWork& InWork )
 		: UpstreamBranch;
 	FVSPGitProvider::AccessProvider().Divergence = Div;
 
-	FSourceControlResultInfo LfsResult;
-	InWork.bCommandSuccessful &= GitLowLevelCommands::GetAllLocks( LfsResult, LockStatesFromGitLfs );
-	InWork.bCommandSuccessful &= GitLowLevelCommands::UpdateStatus(
+	// The whole lock table only when due, see FVSPGitLockCache
+	if ( InWork.Settings->GetCurrentRepoSettings()->bUsingGitLfsLocking && FVSPGitLockCache::Get().NeedsFullRefresh() )
+	{
+		FSourceControlResultInfo LfsResult;
+		TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > > AllLocks;
+		InWork.bCommandSuccessful &= GitLowLevelCommands::GetAllLocks( LfsResult, AllLocks );
+		if ( InWork.bCommandSuccessful )
+			FVSPGitLockCache::Get().SetAllLocks( AllLocks );
+	}
+	LockStatesFromGitLfs = FVSPGitLockCache::Get().GetLocks();
+
+	// Only the directories changed on disk since the last time, nothing at all if none changed
+	TArray< FString > StatusDirectories;
+	if ( !Operation->bFullStatus && VSPGitHelpers::GetStatusDirectories( Operation->ChangedFiles, InWork.Settings->GetCurrentRepoSettings()->RepoRoot, StatusDirectories ) )
+		StatusScope = StatusDirectories;
+	else
+		StatusDirectories.Reset();
+
+	bool bStatusSuccessful = StatusScope.Num() == 0 || GitLowLevelCommands::UpdateStatus(
 		InWork.Settings->GetCurrentRepoSettings()->LockableRules,
+		StatusDirectories,
 		StatesFromGit,
 		Operation->ResultInfo );
+	if ( !bStatusSuccessful && StatusDirectories.Num() > 0 )
+	{
+		// The changed files were taken from the provider, only a full status still covers them
+		StatesFromGit.Reset();
+		StatusDirectories.Reset();
+		StatusScope = { FString() };
+		bStatusSuccessful = GitLowLevelCommands::UpdateStatus(
+			InWork.Settings->GetCurrentRepoSettings()->LockableRules,
+			StatusDirectories,
+			StatesFromGit,
+			Operation->ResultInfo );
+	}
+	if ( !bStatusSuccessful )
+	{
+		// Keep the cached states rather than dropping them
+		StatusScope.Reset();
+		InWork.bCommandSuccessful = false;
+	}
+
+	// Keeps the history of a file a lookup in the index, a failure only means 'git log' is run for it instead
+	FSourceControlResultInfo HistoryResult;
+	GitLowLevelCommands::UpdateHistoryCache( HistoryResult );
 
 	if ( InWork.bCommandSuccessful )
 		switch ( GitLowLevelCommands::GitLogMode )
@@ -37,7 +37,7 @@ namespace GitHighLevelWorkers
 	};
 
 	// UpdateStatus
-	class FUpdateStatusWorker : public FVSPGitWorkerBase
+	class FUpdateStatusWorker : public FVSPGitLfsWorkerBase
 	{
 	public:
 		virtual FName GetName() const override { return FName( "UpdateStatus" ); }
@@ -206,6 +206,11 @@ namespace GitHighLevelWorkers
 	public:
 		virtual FName GetName() const override { return FName( "Background" ); };
 		virtual FText GetInProgressString() const override;
+
+		/** Paths changed on disk since the previous background task, the status only covers their directories */
+		TArray< FString > ChangedFiles;
+		/** The status covers the whole repository, e.g. after HEAD moved */
+		bool bFullStatus = true;
 	};
 
 	class FBackgroundWorker : public FVSPGitLfsWorkerBase
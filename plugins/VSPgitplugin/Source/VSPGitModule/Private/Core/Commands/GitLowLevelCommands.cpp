@@ -16,30 +16,169 @@
 #include "GitLowLevelCommands.h"
 
 // Module includes
+#include "HAL/FileManager.h"
 #include "Misc/DefaultValueHelper.h"
+#include "Misc/ScopeLock.h"
 #include "VSPGitModule.h"
 #include "Core/VSPGitRevision.h"
 #include "Core/VSPGitState.h"
 #include "Core/Base/VSPGitHelpers.h"
+#include "Core/Base/VSPGitHistoryCache.h"
+#include "Core/Base/VSPGitPipeReader.h"
+#include "Core/Base/VSPGitProcessPool.h"
+
+FString GitLowLevelCommands::GitBinPath = TEXT( "git" );
+FString GitLowLevelCommands::RepoRoot;
+GitLowLevelCommands::EGitLogMode GitLowLevelCommands::GitLogMode = ShortWithErrorOutput;
+bool GitLowLevelCommands::bUseBuiltinFsMonitor = false;
+bool GitLowLevelCommands::bUsePathspecFromFile = false;
 
 namespace GitLowLevelCommandsLocal
 {
-	void ParseStatusResult(
-		const FSourceControlResultInfo& InResults,
-		TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates );
+	/** How often a command waited on is checked for being alive, when its output pipe does not tell */
+	const double ProcessCheckSeconds = 0.1;
+	/** Output lines of a failed command kept for the error messages and the log */
+	const int32 MaxErrorOutputLines = 100;
+#if PLATFORM_WINDOWS
+	/** Files given on one command line at most (in characters), CreateProcess takes 32767 with the executable and the other parameters */
+	const int32 MaxFilesArgLength = 30000;
+#else
+	/** Files given on one command line at most (in characters), far below the argument limits of Linux and Mac */
+	const int32 MaxFilesArgLength = 128 * 1024;
+#endif
+	/** Read-only commands run at the same time for one call */
+	const int32 MaxConcurrentCommands = 4;
+	/** Fewer files are not worth a command of their own */
+	const int32 MinConcurrentBatchFiles = 16;
+	/** Written to a command stdin at once */
+	const int32 StdInChunkSize = 4096;
+	/** Same heuristic as git: binary content has a NUL byte in its first 8000 bytes */
+	const int32 BinaryCheckSize = 8000;
+	/** Commits a full build of the history index parses per call, the next call carries on */
+	const int32 HistoryBuildChunkCommits = 2000;
+
+	/** Full build of the history index, spread over the calls of UpdateHistoryCache */
+	struct FHistoryBuild
+	{
+		FCriticalSection Lock;
+		TUniquePtr< FVSPGitHistoryCache::FBuilder > Builder;
+		FString RepoRoot;
+		/** HEAD when the build started, the index is built up to it */
+		FString TipCommit;
+		int32 LoggedCommits = 0;
+	};
+
+	FVSPGitProcessPool& GetProcessPool();
+
+	/** Consecutive batches of the files, each within the length and count limits */
+	TArray< TArray< FString > > SplitFiles( const TArray< FString >& InFiles, int32 InMaxLength, int32 InMaxCount );
+
+	bool IsPathspecFromFileCommand( const FString& InCommand );
+
+	bool WriteStdIn( void* InWritePipe, const TArray< uint8 >& InData, FProcHandle& InProcessHandle );
+
+	bool IsBinaryLfsFree( const uint8* InHead, int32 InHeadSize );
 
 	FString LogStatusToString( TCHAR InStatus );
 
-	void ParseLogResults( const FSourceControlResultInfo& InResults, TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory );
+	void ParseLogResults( const TArray< FString >& InResults, TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory );
+
+	/** Revision numbers from the index in the history (the log starts with the most recent change) and the source of the moves */
+	void NumberRevisions( TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& InOutHistory );
+
+	/** Commit HEAD points to, empty if there is none yet */
+	FString GetHeadCommit();
 
-	bool ParseFileState(
-		const FString& StatusResult,
+	/** History of the file from the index, false when the index is behind HEAD or doesn't know the file */
+	bool GetCachedHistory( const FString& InFile, TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory );
+
+	FHistoryBuild& GetHistoryBuild();
+
+	/** Feed the builder with the log of the revisions, parents before children once reversed as the index needs them */
+	bool RunHistoryLog( const TArray< FString >& InRevisions, FVSPGitHistoryCache::FBuilder& OutBuilder, FSourceControlResultInfo& OutResults );
+
+	/** Parse the next chunk of the full build log, saving the index after the last one */
+	bool ContinueHistoryBuild( FHistoryBuild& InOutBuild, FSourceControlResultInfo& OutResults );
+
+	bool ParseStatusRecord(
+		const FString& InRecord,
 		EGitState::Type& OutFileGitState,
-		FString& OutFileName );
+		FString& OutFileName,
+		FString& OutMergeBaseFileHash,
+		bool& bOutHasOriginalPath );
+
+	FString GetStatusField( const FString& InRecord, int32 InFieldIndex, bool bInUpToEnd = false );
+
+	void AddLockInfo( const FString& InLine, TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks );
+}
+
+FVSPGitProcessPool& GitLowLevelCommandsLocal::GetProcessPool()
+{
+	FVSPGitProcessPool& ProcessPool = FVSPGitProcessPool::Get();
+	ProcessPool.Configure( GitLowLevelCommands::GitBinPath, GitLowLevelCommands::RepoRoot );
+	return ProcessPool;
+}
+
+TArray< TArray< FString > > GitLowLevelCommandsLocal::SplitFiles( const TArray< FString >& InFiles, int32 InMaxLength, int32 InMaxCount )
+{
+	TArray< TArray< FString > > Batches;
+	int32 BatchLength = 0;
+	for ( const FString& File : InFiles )
+	{
+		// Each file takes a separating space too
+		const int32 FileLength = File.Len() + 1;
+		if ( Batches.Num() == 0 || Batches.Last().Num() >= InMaxCount || ( Batches.Last().Num() > 0 && BatchLength + FileLength > InMaxLength ) )
+		{
+			Batches.AddDefaulted();
+			BatchLength = 0;
+		}
+		Batches.Last().Add( File );
+		BatchLength += FileLength;
+	}
+	return Batches;
+}
+
+bool GitLowLevelCommandsLocal::IsPathspecFromFileCommand( const FString& InCommand )
+{
+	return InCommand == TEXT( "add" )
+		|| InCommand == TEXT( "checkout" )
+		|| InCommand == TEXT( "reset" )
+		|| InCommand == TEXT( "restore" )
+		|| InCommand == TEXT( "rm" );
+}
+
+// The pipe may take less than asked while git is still reading, keep writing as long as it runs
+bool GitLowLevelCommandsLocal::WriteStdIn( void* InWritePipe, const TArray< uint8 >& InData, FProcHandle& InProcessHandle )
+{
+	int32 Offset = 0;
+	while ( Offset < InData.Num() )
+	{
+		int32 Written = 0;
+		FPlatformProcess::WritePipe( InWritePipe, InData.GetData() + Offset, FMath::Min( InData.Num() - Offset, StdInChunkSize ), &Written );
+		if ( Written > 0 )
+			Offset += Written;
+		else if ( !FPlatformProcess::IsProcRunning( InProcessHandle ) )
+			return false;
+		else
+			FPlatformProcess::Sleep( 0.001f );
+	}
+	return true;
+}
 
-	void RunGetConflictStatus(
-		const FString& InFile,
-		TSharedRef< FVSPGitState, ESPMode::ThreadSafe >& FileState );
+// Whether the raw blob is what the working copy would get, from its first BinaryCheckSize bytes:
+// git applies no eol conversion to binary content and LFS pointers still need the smudge filter
+bool GitLowLevelCommandsLocal::IsBinaryLfsFree( const uint8* InHead, int32 InHeadSize )
+{
+	static const FAnsiStringView LfsPointerStart = "version https://git-lfs";
+	if ( InHeadSize >= LfsPointerStart.Len()
+		&& FMemory::Memcmp( InHead, LfsPointerStart.GetData(), LfsPointerStart.Len() ) == 0 )
+		return false;
+
+	const int32 CheckedBytes = FMath::Min( InHeadSize, BinaryCheckSize );
+	for ( int32 Index = 0; Index < CheckedBytes; Index++ )
+		if ( InHead[ Index ] == 0 )
+			return true;
+	return false;
 }
 
 bool GitLowLevelCommands::RunGitCommandLow(
@@ -48,6 +187,27 @@ bool GitLowLevelCommands::RunGitCommandLow(
 	const TArray< FString >& InFiles,
 	FSourceControlResultInfo& OutResults,
 	TQueue< FString >& OutOutputQueue )
+{
+	return RunGitCommandLow(
+		InCommand,
+		InParams,
+		InFiles,
+		[&OutResults]( const FString& InLine )
+		{
+			OutResults.InfoMessages.Add( FText::FromString( InLine ) );
+		},
+		OutResults,
+		OutOutputQueue );
+}
+
+bool GitLowLevelCommands::RunGitCommandLow(
+	const FString& InCommand,
+	const TArray< FString >& InParams,
+	const TArray< FString >& InFiles,
+	TFunctionRef< void( const FString& ) > InOnOutputLine,
+	FSourceControlResultInfo& OutResults,
+	TQueue< FString >& OutOutputQueue,
+	const TArray< uint8 >* InStdIn )
 {
 	FDateTime StartTime = FDateTime::Now();
 
@@ -87,7 +247,6 @@ bool GitLowLevelCommands::RunGitCommandLow(
 			break;
 	}
 
-	TArray< FString > OutResultsStrings;
 	int32 RetCode = 0;
 
 	const bool bLaunchDetached = true;
@@ -96,59 +255,104 @@ bool GitLowLevelCommands::RunGitCommandLow(
 
 	void* ReadPipe = nullptr;
 	void* WritePipe = nullptr;
-
-	verify( FPlatformProcess::CreatePipe(ReadPipe, WritePipe) );
-
+	void* StdInReadPipe = nullptr;
+	void* StdInWritePipe = nullptr;
 	uint32 ProcessId;
-	FProcHandle Handle = FPlatformProcess::CreateProc(
-		*ExecCommand,
-		*ArgsLineCommand,
-		bLaunchDetached,
-		bLaunchHidden,
-		bLaunchReallyHidden,
-		&ProcessId,
-		0,
-		nullptr,
-		WritePipe );
+	FProcHandle Handle;
+	{
+		FScopeLock ProcessStartLock( &VSPGitHelpers::GetProcessStartLock() );
+
+		verify( VSPGitHelpers::CreateStdOutPipe(ReadPipe, WritePipe) );
+		if ( InStdIn != nullptr )
+			verify( VSPGitHelpers::CreateStdInPipe(StdInReadPipe, StdInWritePipe) );
+
+		Handle = FPlatformProcess::CreateProc(
+			*ExecCommand,
+			*ArgsLineCommand,
+			bLaunchDetached,
+			bLaunchHidden,
+			bLaunchReallyHidden,
+			&ProcessId,
+			0,
+			nullptr,
+			WritePipe,
+			StdInReadPipe );
+		// The child has its own copy: without ours, the end of its output shows up as a closed pipe
+		FPlatformProcess::ClosePipe( StdInReadPipe, WritePipe );
+	}
 	if ( !Handle.IsValid() || !FPlatformProcess::IsProcRunning( Handle ) || !FPlatformProcess::IsApplicationRunning( ProcessId ) )
 	{
 		UE_LOG( VSPGitLog, Warning, TEXT("Cant create proccess for '%s'."), *GitBinPath );
-		FPlatformProcess::ClosePipe( ReadPipe, WritePipe );
+		FPlatformProcess::ClosePipe( ReadPipe, nullptr );
+		FPlatformProcess::ClosePipe( nullptr, StdInWritePipe );
 		return false;
 	}
 
-	FString CurrentLine;
-	FString FullOutput;
-	FString LatestOutput;
-	do
+	// Git reads all the pathspecs before writing anything, the output can wait
+	if ( InStdIn != nullptr )
 	{
-		LatestOutput = FPlatformProcess::ReadPipe( ReadPipe );
-		if ( !LatestOutput.IsEmpty() )
+		if ( !GitLowLevelCommandsLocal::WriteStdIn( StdInWritePipe, *InStdIn, Handle ) )
 		{
-			FullOutput += LatestOutput;
-			CurrentLine += LatestOutput;
-			VSPGitHelpers::ParseCumulativeStream( CurrentLine, OutOutputQueue );
+			UE_LOG( VSPGitLog, Warning, TEXT("Cant write the stdin of 'git %s'."), *InCommand );
 		}
+		FPlatformProcess::ClosePipe( nullptr, StdInWritePipe );
 	}
-	while ( FPlatformProcess::IsProcRunning( Handle ) );
-	LatestOutput = FPlatformProcess::ReadPipe( ReadPipe );
-	FullOutput += LatestOutput;
-	CurrentLine += LatestOutput;
-	VSPGitHelpers::ParseCumulativeStream( CurrentLine, OutOutputQueue );
-	if ( !CurrentLine.IsEmpty() )
+
+	// The whole output is only kept for the logs asking for it, the last lines for the error report
+	const bool bKeepFullOutput = GitLogMode == Verbose || GitLogMode == Full;
+	FString FullOutput;
+	TArray< FString > LastLines;
+	int32 NextLastLine = 0;
+	auto OnLine = [&]( const FString& InLine )
+	{
+		if ( bKeepFullOutput )
+		{
+			FullOutput += InLine;
+			FullOutput += TEXT( "\n" );
+		}
+		if ( LastLines.Num() < GitLowLevelCommandsLocal::MaxErrorOutputLines )
+			LastLines.Add( InLine );
+		else
+			LastLines[ NextLastLine ] = InLine;
+		NextLastLine = ( NextLastLine + 1 ) % GitLowLevelCommandsLocal::MaxErrorOutputLines;
+
+		OutOutputQueue.Enqueue( InLine );
+		InOnOutputLine( InLine );
+	};
+	// Output asked with -z comes in NUL separated records instead of lines
+	FVSPGitLineSplitter LineSplitter( OnLine, InParams.Contains( TEXT( "-z" ) ) );
+
+	FVSPGitPipeReader PipeReader( ReadPipe );
+	TArray< uint8 > OutputChunk;
+	bool bProcessRunning = true;
+	while ( true )
 	{
-		CurrentLine = CurrentLine.TrimEnd();
-		OutOutputQueue.Enqueue( CurrentLine );
+		if ( PipeReader.Read( OutputChunk, GitLowLevelCommandsLocal::ProcessCheckSeconds ) )
+			LineSplitter.Append( OutputChunk );
+		else if ( PipeReader.IsClosed() || !bProcessRunning )
+			break;
+		else
+			// One more read once the process is gone, for what it wrote just before exiting
+			bProcessRunning = FPlatformProcess::IsProcRunning( Handle );
 	}
+	LineSplitter.Flush();
 
+	FPlatformProcess::WaitForProc( Handle );
 	bool bGotReturnCode = FPlatformProcess::GetProcReturnCode( Handle, &RetCode );
 	FPlatformProcess::CloseProc( Handle );
-	FPlatformProcess::ClosePipe( ReadPipe, WritePipe );
-
-	FullOutput.ParseIntoArrayLines( OutResultsStrings );
+	FPlatformProcess::ClosePipe( ReadPipe, nullptr );
 
-	for ( FString& ResultsString : OutResultsStrings )
-		OutResults.InfoMessages.Add( FText::FromString( ResultsString ) );
+	if ( RetCode != 0 )
+	{
+		// Oldest kept line first
+		TArray< FString > ErrorLines;
+		for ( int32 Index = 0; Index < LastLines.Num(); Index++ )
+			ErrorLines.Add( MoveTemp( LastLines[ ( NextLastLine + Index ) % LastLines.Num() ] ) );
+		for ( const FString& ErrorLine : ErrorLines )
+			OutResults.ErrorMessages.Add( FText::FromString( ErrorLine ) );
+		if ( !bKeepFullOutput )
+			FullOutput = FString::Join( ErrorLines, TEXT( "\n" ) );
+	}
 
 	if ( RetCode == 0 )
 		switch ( GitLogMode )
@@ -162,9 +366,6 @@ bool GitLowLevelCommands::RunGitCommandLow(
 		}
 	else
 	{
-		for ( FString& ResultsString : OutResultsStrings )
-			OutResults.ErrorMessages.Add( FText::FromString( ResultsString ) );
-
 		switch ( GitLogMode )
 		{
 			case Verbose:
@@ -278,8 +479,102 @@ bool GitLowLevelCommands::RunGitCommand(
 	FSourceControlResultInfo& OutResults,
 	TQueue< FString >& OutOutputQueue )
 {
-	const bool bSuccessful = RunGitCommandLow( InCommand, InParams, InFiles, OutResults, OutOutputQueue );
+	return RunGitCommand(
+		InCommand,
+		InParams,
+		InFiles,
+		[&OutResults]( const FString& InLine )
+		{
+			OutResults.InfoMessages.Add( FText::FromString( InLine ) );
+		},
+		OutResults,
+		OutOutputQueue );
+}
 
+bool GitLowLevelCommands::RunGitCommand(
+	const FString& InCommand,
+	const TArray< FString >& InParams,
+	const TArray< FString >& InFiles,
+	TFunctionRef< void( const FString& ) > InOnOutputLine,
+	FSourceControlResultInfo& OutResults,
+	TQueue< FString >& OutOutputQueue )
+{
+	int32 FilesLength = 0;
+	for ( const FString& File : InFiles )
+		FilesLength += File.Len() + 1;
+	if ( FilesLength <= GitLowLevelCommandsLocal::MaxFilesArgLength )
+		return RunGitCommandLow( InCommand, InParams, InFiles, InOnOutputLine, OutResults, OutOutputQueue );
+
+	if ( bUsePathspecFromFile && GitLowLevelCommandsLocal::IsPathspecFromFileCommand( InCommand ) )
+	{
+		TArray< FString > Params = InParams;
+		Params.Add( TEXT( "--pathspec-from-file=-" ) );
+		Params.Add( TEXT( "--pathspec-file-nul" ) );
+		TArray< uint8 > StdIn;
+		StdIn.Reserve( FilesLength );
+		for ( const FString& File : InFiles )
+		{
+			const FTCHARToUTF8 Utf8File( *File );
+			StdIn.Append( reinterpret_cast< const uint8* >( Utf8File.Get() ), Utf8File.Length() );
+			StdIn.Add( 0 );
+		}
+		return RunGitCommandLow( InCommand, Params, TArray< FString >(), InOnOutputLine, OutResults, OutOutputQueue, &StdIn );
+	}
+
+	// One run after another, concurrent runs of a command writing the index would fight over its lock
+	bool bSuccessful = true;
+	for ( const TArray< FString >& Batch : GitLowLevelCommandsLocal::SplitFiles( InFiles, GitLowLevelCommandsLocal::MaxFilesArgLength, MAX_int32 ) )
+		bSuccessful &= RunGitCommandLow( InCommand, InParams, Batch, InOnOutputLine, OutResults, OutOutputQueue );
+	return bSuccessful;
+}
+
+bool GitLowLevelCommands::RunGitCommandConcurrently(
+	const FString& InCommand,
+	const TArray< FString >& InParams,
+	const TArray< FString >& InFiles,
+	TFunctionRef< void( const FString& ) > InOnOutputLine,
+	FSourceControlResultInfo& OutResults )
+{
+	const int32 MaxBatchFiles = FMath::Max(
+		GitLowLevelCommandsLocal::MinConcurrentBatchFiles,
+		FMath::DivideAndRoundUp( InFiles.Num(), GitLowLevelCommandsLocal::MaxConcurrentCommands ) );
+	const TArray< TArray< FString > > Batches = GitLowLevelCommandsLocal::SplitFiles( InFiles, GitLowLevelCommandsLocal::MaxFilesArgLength, MaxBatchFiles );
+	if ( Batches.Num() <= 1 )
+	{
+		TQueue< FString > Queue;
+		return RunGitCommandLow( InCommand, InParams, InFiles, InOnOutputLine, OutResults, Queue );
+	}
+
+	TArray< TArray< FString > > BatchLines;
+	TArray< FSourceControlResultInfo > BatchResults;
+	TArray< bool > BatchSuccessful;
+	BatchLines.SetNum( Batches.Num() );
+	BatchResults.SetNum( Batches.Num() );
+	BatchSuccessful.Init( false, Batches.Num() );
+	VSPGitHelpers::RunConcurrently(
+		Batches.Num(),
+		GitLowLevelCommandsLocal::MaxConcurrentCommands,
+		[&]( int32 InBatchIndex )
+		{
+			TQueue< FString > Queue;
+			TArray< FString >& Lines = BatchLines[ InBatchIndex ];
+			BatchSuccessful[ InBatchIndex ] = RunGitCommandLow(
+				InCommand,
+				InParams,
+				Batches[ InBatchIndex ],
+				[&Lines]( const FString& InLine ) { Lines.Add( InLine ); },
+				BatchResults[ InBatchIndex ],
+				Queue );
+		} );
+
+	bool bSuccessful = true;
+	for ( int32 BatchIndex = 0; BatchIndex < Batches.Num(); BatchIndex++ )
+	{
+		for ( const FString& Line : BatchLines[ BatchIndex ] )
+			InOnOutputLine( Line );
+		OutResults.Append( BatchResults[ BatchIndex ] );
+		bSuccessful &= BatchSuccessful[ BatchIndex ];
+	}
 	return bSuccessful;
 }
 
@@ -464,16 +759,42 @@ bool GitLowLevelCommands::GetAllLocks(
 	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks )
 {
 	TQueue< FString > Queue;
-	const bool bResult = RunGitCommand( TEXT( "lfs locks" ), TArray< FString >(), TArray< FString >(), OutResults, Queue );
-	for ( const FText& Result : OutResults.InfoMessages )
-	{
-		TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > LockFile = MakeShared< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >(
-			Result.ToString() );
-		if ( GitLogMode == Full )
+	const bool bResult = RunGitCommand(
+		TEXT( "lfs locks" ),
+		TArray< FString >(),
+		TArray< FString >(),
+		[&OutLocks]( const FString& InLine )
 		{
-			UE_LOG( VSPGitLog, Log, TEXT("LockedFile ID:%d (%s, %s)"), LockFile->Id, *LockFile->LocalFilename, *LockFile->LockUser );
-		}
-		OutLocks.Add( LockFile->LocalFilename, LockFile );
+			GitLowLevelCommandsLocal::AddLockInfo( InLine, OutLocks );
+		},
+		OutResults,
+		Queue );
+
+	return bResult;
+}
+
+bool GitLowLevelCommands::GetFileLocks(
+	const TArray< FString >& InFiles,
+	FSourceControlResultInfo& OutResults,
+	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks )
+{
+	// 'git lfs locks' takes a single --path, which matches that exact file
+	bool bResult = true;
+	TQueue< FString > Queue;
+	for ( const FString& File : InFiles )
+	{
+		TArray< FString > Params;
+		Params.Add( FString::Printf( TEXT( "--path=\"%s\"" ), *File ) );
+		bResult &= RunGitCommand(
+			TEXT( "lfs locks" ),
+			Params,
+			TArray< FString >(),
+			[&OutLocks]( const FString& InLine )
+			{
+				GitLowLevelCommandsLocal::AddLockInfo( InLine, OutLocks );
+			},
+			OutResults,
+			Queue );
 	}
 
 	return bResult;
@@ -484,22 +805,63 @@ bool GitLowLevelCommands::UpdateStatus(
 	TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates,
 	FSourceControlResultInfo& OutResults )
 {
+	return UpdateStatus( InLockableRules, TArray< FString >(), OutStates, OutResults );
+}
+
+bool GitLowLevelCommands::UpdateStatus(
+	const TArray< FString >& InLockableRules,
+	const TArray< FString >& InDirectories,
+	TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates,
+	FSourceControlResultInfo& OutResults )
+{
+	// The untracked cache and fsmonitor let git skip the directories nothing changed in
+	FString Command = TEXT( "-c core.untrackedCache=true " );
+	if ( bUseBuiltinFsMonitor )
+		Command += TEXT( "-c core.fsmonitor=true " );
+	Command += TEXT( "status" );
+
 	TArray< FString > Params;
-	Params.Add( TEXT( "--porcelain=v1" ) );
+	Params.Add( TEXT( "--porcelain=v2" ) );
+	Params.Add( TEXT( "-z" ) );
 	Params.Add( TEXT( "--untracked-files=all" ) );
+	// Commands run from the project directory, the directories are relative to the repository root
+	TArray< FString > PathSpecs;
+	for ( const FString& Directory : InDirectories )
+		PathSpecs.Add( FString::Printf( TEXT( "\":(top)%s\"" ), *Directory ) );
 	FSourceControlResultInfo StatusResult;
 
-	TQueue< FString > Queue;
-	const bool bResult = RunGitCommand( TEXT( "status" ), Params, TArray< FString >(), StatusResult, Queue );
-	if ( bResult )
-	{
-		GitLowLevelCommandsLocal::ParseStatusResult( StatusResult, OutStates );
-		for ( TSharedRef< ISourceControlState, ESPMode::ThreadSafe >& State : OutStates )
+	TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > > States;
+	const FDateTime Now = FDateTime::Now();
+	bool bOriginalPathRecord = false;
+	// Disjoint directories, each batch gives whole records
+	const bool bResult = RunGitCommandConcurrently(
+		Command,
+		Params,
+		PathSpecs,
+		[&]( const FString& InRecord )
 		{
-			TSharedRef< FVSPGitState, ESPMode::ThreadSafe > GitState = StaticCastSharedRef< FVSPGitState >( State );
-			GitState->bUsingGitLfsLocking = VSPGitHelpers::IsFileLockable( GitState->FileName, InLockableRules );
-		}
-	}
+			// Renames and copies are followed by a record with the original path
+			if ( bOriginalPathRecord )
+			{
+				bOriginalPathRecord = false;
+				return;
+			}
+
+			EGitState::Type GitState;
+			FString RelativeFilename;
+			FString MergeBaseFileHash;
+			if ( !GitLowLevelCommandsLocal::ParseStatusRecord( InRecord, GitState, RelativeFilename, MergeBaseFileHash, bOriginalPathRecord ) )
+				return;
+
+			TSharedRef< FVSPGitState, ESPMode::ThreadSafe > NewState = MakeShared< FVSPGitState, ESPMode::ThreadSafe >( RelativeFilename, GitState );
+			NewState->TimeStamp = Now;
+			NewState->PendingMergeBaseFileHash = MoveTemp( MergeBaseFileHash );
+			NewState->bUsingGitLfsLocking = VSPGitHelpers::IsFileLockable( NewState->FileName, InLockableRules );
+			States.Add( NewState );
+		},
+		StatusResult );
+	if ( bResult )
+		OutStates.Append( MoveTemp( States ) );
 	OutResults.Append( StatusResult );
 
 	return bResult;
@@ -638,6 +1000,44 @@ bool GitLowLevelCommands::RunDumpToFile(
 	const FString& InParameter,
 	const FString& InDumpFilename )
 {
+	// Binary non-LFS blobs are streamed straight from the cat-file helper to the file. Text and LFS pointers are told
+	// by the first bytes, the helper skips the rest of them and they go through the filters instead
+	TUniquePtr< FArchive > DumpWriter;
+	bool bNeedsFilters = false;
+	FVSPGitObjectInfo ObjectInfo;
+	const bool bStreamed = GitLowLevelCommandsLocal::GetProcessPool().StreamObjectContent(
+		InParameter,
+		GitLowLevelCommandsLocal::BinaryCheckSize,
+		ObjectInfo,
+		[&DumpWriter, &bNeedsFilters, &InDumpFilename]( const uint8* InData, int32 InNum, int64 InOffset )
+		{
+			if ( InOffset == 0 )
+			{
+				DumpWriter.Reset();
+				bNeedsFilters = !GitLowLevelCommandsLocal::IsBinaryLfsFree( InData, InNum );
+				if ( bNeedsFilters )
+					return false;
+				DumpWriter.Reset( IFileManager::Get().CreateFileWriter( *InDumpFilename ) );
+			}
+			if ( !DumpWriter )
+				return false;
+			DumpWriter->Serialize( const_cast< uint8* >( InData ), InNum );
+			return !DumpWriter->IsError();
+		} );
+	if ( bStreamed && !bNeedsFilters )
+	{
+		if ( DumpWriter && DumpWriter->Close() )
+		{
+			UE_LOG( VSPGitLog, Log, TEXT("Saved file '%s' (%lldo)"), *InDumpFilename, ObjectInfo.Size );
+			return true;
+		}
+		DumpWriter.Reset();
+		IFileManager::Get().Delete( *InDumpFilename );
+		UE_LOG( VSPGitLog, Warning, TEXT("Could not write %s"), *InDumpFilename );
+		return false;
+	}
+	DumpWriter.Reset();
+
 	int32 ReturnCode = -1;
 	FString FullCommand;
 
@@ -676,33 +1076,61 @@ bool GitLowLevelCommands::RunDumpToFile(
 		PipeWrite );
 	if ( ProcessHandle.IsValid() )
 	{
-		FPlatformProcess::Sleep( 0.01 );
-
-		TArray< uint8 > BinaryFileContent;
-		while ( FPlatformProcess::IsProcRunning( ProcessHandle ) )
+		// The child has its own copy: without ours, the end of its output shows up as a closed pipe
+		FPlatformProcess::ClosePipe( nullptr, PipeWrite );
+		PipeWrite = nullptr;
+
+		// The output goes to the file as it comes, only a first line starting with "Downloading" is held back for the hack below
+		DumpWriter.Reset( IFileManager::Get().CreateFileWriter( *InDumpFilename ) );
+		static const FAnsiStringView DownloadingStart = "Downloading";
+		TArray< uint8 > FirstLine;
+		bool bFirstLineDone = false;
+		int64 DumpSize = 0;
+		auto WriteOutput = [&DumpWriter, &FirstLine, &bFirstLineDone, &DumpSize]( TArray< uint8 >& InData, bool bInLast )
 		{
-			TArray< uint8 > BinaryData;
-			FPlatformProcess::ReadPipeToArray( PipeRead, BinaryData );
-			if ( BinaryData.Num() > 0 )
-				BinaryFileContent.Append( MoveTemp( BinaryData ) );
-		}
-		TArray< uint8 > BinaryData;
-		FPlatformProcess::ReadPipeToArray( PipeRead, BinaryData );
-		if ( BinaryData.Num() > 0 )
+			if ( !bFirstLineDone )
+			{
+				FirstLine.Append( InData );
+				if ( !bInLast
+					&& ( FirstLine.Num() < DownloadingStart.Len()
+						|| ( FMemory::Memcmp( FirstLine.GetData(), DownloadingStart.GetData(), DownloadingStart.Len() ) == 0
+							&& !FirstLine.Contains( 0x0A ) ) ) )
+					return;
+				// HACK: check function's definition to get more details.
+				RemoveDownloadingString( FirstLine );
+				bFirstLineDone = true;
+				Swap( InData, FirstLine );
+			}
+			if ( DumpWriter && InData.Num() > 0 )
+			{
+				DumpWriter->Serialize( InData.GetData(), InData.Num() );
+				DumpSize += InData.Num();
+			}
+		};
+
+		FVSPGitPipeReader PipeReader( PipeRead );
+		TArray< uint8 > OutputChunk;
+		bool bProcessRunning = true;
+		while ( true )
 		{
-			BinaryFileContent.Append( MoveTemp( BinaryData ) );
+			if ( PipeReader.Read( OutputChunk, GitLowLevelCommandsLocal::ProcessCheckSeconds ) )
+				WriteOutput( OutputChunk, false );
+			else if ( PipeReader.IsClosed() || !bProcessRunning )
+				break;
+			else
+				// One more read once the process is gone, for what it wrote just before exiting
+				bProcessRunning = FPlatformProcess::IsProcRunning( ProcessHandle );
 		}
+		OutputChunk.Reset();
+		WriteOutput( OutputChunk, true );
 
-		// HACK: check function's definition to get more details.
-		RemoveDownloadingString(BinaryFileContent);
-
+		FPlatformProcess::WaitForProc( ProcessHandle );
 		FPlatformProcess::GetProcReturnCode( ProcessHandle, &ReturnCode );
 		if ( ReturnCode == 0 )
 		{
-			// Save buffer into temp file
-			if ( FFileHelper::SaveArrayToFile( BinaryFileContent, *InDumpFilename ) )
+			if ( DumpWriter && DumpWriter->Close() )
 			{
-				UE_LOG( VSPGitLog, Log, TEXT("Saved file '%s' (%do)"), *InDumpFilename, BinaryFileContent.Num() );
+				UE_LOG( VSPGitLog, Log, TEXT("Saved file '%s' (%lldo)"), *InDumpFilename, DumpSize );
 			}
 			else
 			{
@@ -715,6 +1143,10 @@ bool GitLowLevelCommands::RunDumpToFile(
 			UE_LOG( VSPGitLog, Warning, TEXT("DumpToFile: ReturnCode=%d"), ReturnCode );
 		}
 
+		DumpWriter.Reset();
+		if ( ReturnCode != 0 )
+			IFileManager::Get().Delete( *InDumpFilename );
+
 		FPlatformProcess::CloseProc( ProcessHandle );
 	}
 	else
@@ -837,12 +1269,12 @@ C099	Content/Textures/T_Concrete_Poured_N.uasset Content/Textures/T_Concrete_Pou
 */
 // ReSharper restore CommentTypo
 void GitLowLevelCommandsLocal::ParseLogResults(
-	const FSourceControlResultInfo& InResults,
+	const TArray< FString >& InResults,
 	TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory )
 {
 	TSharedRef< FVSPGitRevision, ESPMode::ThreadSafe > VSPGitRevision = MakeShareable( new FVSPGitRevision() );
-	for ( const FText& Result : InResults.InfoMessages )
-		if ( Result.ToString().StartsWith( TEXT( "commit " ) ) ) // Start of a new commit
+	for ( const FString& Result : InResults )
+		if ( Result.StartsWith( TEXT( "commit " ) ) ) // Start of a new commit
 		{
 			// End of the previous commit
 			if ( VSPGitRevision->RevisionNumber != 0 )
@@ -851,80 +1283,212 @@ void GitLowLevelCommandsLocal::ParseLogResults(
 
 				VSPGitRevision = MakeShareable( new FVSPGitRevision );
 			}
-			VSPGitRevision->CommitId = Result.ToString().RightChop( 7 ); // Full commit SHA1 hexadecimal string
+			VSPGitRevision->CommitId = Result.RightChop( 7 ); // Full commit SHA1 hexadecimal string
 			VSPGitRevision->ShortCommitId = VSPGitRevision->CommitId.Left( 8 ); // Short revision ; first 8 hex characters (max that can hold a 32 bit integer)
 			VSPGitRevision->CommitIdNumber = FParse::HexNumber( *VSPGitRevision->ShortCommitId );
 			VSPGitRevision->RevisionNumber = -1; // RevisionNumber will be set at the end, based off the index in the History
 		}
-		else if ( Result.ToString().StartsWith( TEXT( "Author: " ) ) ) // Author name & email
+		else if ( Result.StartsWith( TEXT( "Author: " ) ) ) // Author name & email
 		{
 			// Remove the 'email' part of the UserName
-			FString UserNameEmail = Result.ToString().RightChop( 8 );
+			FString UserNameEmail = Result.RightChop( 8 );
 			int32 EmailIndex = 0;
 			if ( UserNameEmail.FindLastChar( '<', EmailIndex ) )
 				VSPGitRevision->UserName = UserNameEmail.Left( EmailIndex - 1 );
 		}
-		else if ( Result.ToString().StartsWith( TEXT( "Date:   " ) ) ) // Commit date
+		else if ( Result.StartsWith( TEXT( "Date:   " ) ) ) // Commit date
 		{
-			FString Date = Result.ToString().RightChop( 8 );
+			FString Date = Result.RightChop( 8 );
 			VSPGitRevision->Date = FDateTime::FromUnixTimestamp( FCString::Atoi( *Date ) );
 		}
 			//	else if(Result.IsEmpty()) // empty line before/after commit message has already been taken care by FString::ParseIntoArray()
-		else if ( Result.ToString().StartsWith( TEXT( "    " ) ) ) // Multi-lines commit message
+		else if ( Result.StartsWith( TEXT( "    " ) ) ) // Multi-lines commit message
 		{
-			VSPGitRevision->Description += Result.ToString().RightChop( 4 );
+			VSPGitRevision->Description += Result.RightChop( 4 );
 			VSPGitRevision->Description += TEXT( "\n" );
 		}
 		else // Name of the file, starting with an uppercase status letter ("A"/"M"...)
 		{
-			const TCHAR Status = Result.ToString()[ 0 ];
+			const TCHAR Status = Result[ 0 ];
 			VSPGitRevision->Action = LogStatusToString( Status ); // Readable action string ("Added", Modified"...) instead of "A"/"M"...
 			// Take care of special case for Renamed/Copied file: extract the second filename after second tabulation
 			int32 IdxTab;
-			if ( Result.ToString().FindLastChar( '\t', IdxTab ) )
-				VSPGitRevision->Filename = Result.ToString().RightChop( IdxTab + 1 ); // relative filename
+			if ( Result.FindLastChar( '\t', IdxTab ) )
+				VSPGitRevision->Filename = Result.RightChop( IdxTab + 1 ); // relative filename
 		}
 	// End of the last commit
 	if ( VSPGitRevision->RevisionNumber != 0 )
 		OutHistory.Add( MoveTemp( VSPGitRevision ) );
 
-	// Then set the revision number of each Revision based on its index (reverse order since the log starts with the most recent change)
-	for ( int32 RevisionIndex = 0; RevisionIndex < OutHistory.Num(); RevisionIndex++ )
+	NumberRevisions( OutHistory );
+}
+
+void GitLowLevelCommandsLocal::NumberRevisions( TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& InOutHistory )
+{
+	// Set the revision number of each Revision based on its index (reverse order since the log starts with the most recent change)
+	for ( int32 RevisionIndex = 0; RevisionIndex < InOutHistory.Num(); RevisionIndex++ )
 	{
 		TSharedRef< FVSPGitRevision, ESPMode::ThreadSafe > SourceControlRevisionItem =
-			StaticCastSharedRef< FVSPGitRevision >( OutHistory[ RevisionIndex ] );
-		SourceControlRevisionItem->RevisionNumber = OutHistory.Num() - RevisionIndex;
+			StaticCastSharedRef< FVSPGitRevision >( InOutHistory[ RevisionIndex ] );
+		SourceControlRevisionItem->RevisionNumber = InOutHistory.Num() - RevisionIndex;
 
 		// Special case of a move ("branch" in Perforce term): point to the previous change (so the next one in the order of the log)
-		if ( ( SourceControlRevisionItem->Action == "branch" ) && ( RevisionIndex < OutHistory.Num() - 1 ) )
-			SourceControlRevisionItem->BranchSource = OutHistory[ RevisionIndex + 1 ];
+		if ( ( SourceControlRevisionItem->Action == "branch" ) && ( RevisionIndex < InOutHistory.Num() - 1 ) )
+			SourceControlRevisionItem->BranchSource = InOutHistory[ RevisionIndex + 1 ];
 	}
 }
 
+FString GitLowLevelCommandsLocal::GetHeadCommit()
+{
+	TArray< FString > ObjectNames;
+	ObjectNames.Add( TEXT( "HEAD" ) );
+	TArray< FVSPGitObjectInfo > ObjectInfos;
+	if ( !GetProcessPool().GetObjectInfos( ObjectNames, ObjectInfos ) || !ObjectInfos[ 0 ].IsValid() )
+		return FString();
+	return ObjectInfos[ 0 ].Hash;
+}
+
+bool GitLowLevelCommandsLocal::GetCachedHistory(
+	const FString& InFile,
+	TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory )
+{
+	const FString TipCommit = FVSPGitHistoryCache::Get().GetTipCommit();
+	if ( TipCommit.IsEmpty() || TipCommit != GetHeadCommit() )
+		return false;
+
+	TArray< FVSPGitHistoryEntry > Entries;
+	if ( !FVSPGitHistoryCache::Get().GetHistory( InFile, Entries ) )
+		return false;
+
+	for ( FVSPGitHistoryEntry& Entry : Entries )
+	{
+		TSharedRef< FVSPGitRevision, ESPMode::ThreadSafe > VSPGitRevision = MakeShareable( new FVSPGitRevision() );
+		VSPGitRevision->CommitId = MoveTemp( Entry.CommitId );
+		VSPGitRevision->ShortCommitId = VSPGitRevision->CommitId.Left( 8 );
+		VSPGitRevision->CommitIdNumber = FParse::HexNumber( *VSPGitRevision->ShortCommitId );
+		VSPGitRevision->UserName = MoveTemp( Entry.UserName );
+		VSPGitRevision->Date = Entry.Date;
+		VSPGitRevision->Description = MoveTemp( Entry.Description );
+		VSPGitRevision->Action = LogStatusToString( Entry.Status );
+		VSPGitRevision->Filename = MoveTemp( Entry.Filename );
+		OutHistory.Add( MoveTemp( VSPGitRevision ) );
+	}
+	NumberRevisions( OutHistory );
+	return true;
+}
+
+GitLowLevelCommandsLocal::FHistoryBuild& GitLowLevelCommandsLocal::GetHistoryBuild()
+{
+	static FHistoryBuild HistoryBuild;
+	return HistoryBuild;
+}
+
+bool GitLowLevelCommandsLocal::RunHistoryLog(
+	const TArray< FString >& InRevisions,
+	FVSPGitHistoryCache::FBuilder& OutBuilder,
+	FSourceControlResultInfo& OutResults )
+{
+	TQueue< FString > Queue;
+	TArray< FString > Parameters;
+	Parameters.Add( TEXT( "--name-status" ) );
+	Parameters.Add( TEXT( "--find-renames" ) ); // whatever diff.renames says, GetHistory follows them
+	Parameters.Add( TEXT( "--topo-order" ) ); // the index tells older from newer by position, dates may lie
+	Parameters.Add( TEXT( "-z" ) );
+	Parameters.Add( FString::Printf( TEXT( "--format=%s" ), FVSPGitHistoryCache::FBuilder::GetLogFormat() ) );
+	Parameters.Append( InRevisions );
+	return GitLowLevelCommands::RunGitCommand(
+		TEXT( "log" ),
+		Parameters,
+		TArray< FString >(),
+		[&OutBuilder]( const FString& InRecord ) { OutBuilder.AddLogRecord( InRecord ); },
+		OutResults,
+		Queue );
+}
+
+bool GitLowLevelCommandsLocal::ContinueHistoryBuild(
+	FHistoryBuild& InOutBuild,
+	FSourceControlResultInfo& OutResults )
+{
+	// The same topological order every time for the same tip, so each chunk starts where the previous one ended
+	TArray< FString > ChunkRevisions;
+	ChunkRevisions.Add( FString::Printf( TEXT( "--skip=%d" ), InOutBuild.LoggedCommits ) );
+	ChunkRevisions.Add( FString::Printf( TEXT( "--max-count=%d" ), HistoryBuildChunkCommits ) );
+	ChunkRevisions.Add( InOutBuild.TipCommit );
+	const int32 LogCommitCount = InOutBuild.Builder->GetLogCommitCount();
+	if ( !RunHistoryLog( ChunkRevisions, *InOutBuild.Builder, OutResults ) )
+	{
+		// Started over next time, the chunk may be fed partly
+		InOutBuild.Builder.Reset();
+		return false;
+	}
+
+	const int32 ChunkCommits = InOutBuild.Builder->GetLogCommitCount() - LogCommitCount;
+	InOutBuild.LoggedCommits += ChunkCommits;
+	if ( ChunkCommits >= HistoryBuildChunkCommits )
+		return true;
+
+	InOutBuild.Builder->FinishLog();
+	const bool bSaved = FVSPGitHistoryCache::Get().Save( *InOutBuild.Builder, InOutBuild.TipCommit );
+	InOutBuild.Builder.Reset();
+	return bSaved;
+}
+
 bool GitLowLevelCommands::RunGetHistory(
 	const FString& InFile,
 	bool bMergeConflict,
 	FSourceControlResultInfo& OutResults,
 	TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory )
 {
-	TArray< FString > Parameters;
 	TQueue< FString > Queue;
-	Parameters.Add( TEXT( "--follow" ) ); // follow file renames
-	Parameters.Add( TEXT( "--date=raw" ) );
-	Parameters.Add( TEXT( "--name-status" ) ); // relative filename at this revision, preceded by a status character
-	Parameters.Add( TEXT( "--pretty=medium" ) ); // make sure format matches expected in ParseLogResults
-	if ( bMergeConflict )
+	bool bResults = true;
+	// The index has the log of the current branch only, and nothing of the files it doesn't know yet
+	if ( bMergeConflict || !GitLowLevelCommandsLocal::GetCachedHistory( InFile, OutHistory ) )
+	{
+		TArray< FString > Parameters;
+		Parameters.Add( TEXT( "--follow" ) ); // follow file renames
+		Parameters.Add( TEXT( "--date=raw" ) );
+		Parameters.Add( TEXT( "--name-status" ) ); // relative filename at this revision, preceded by a status character
+		Parameters.Add( TEXT( "--pretty=medium" ) ); // make sure format matches expected in ParseLogResults
+		if ( bMergeConflict )
+		{
+			// In case of a merge conflict, we also need to get the tip of the "remote branch" (MERGE_HEAD) before the log of the "current branch" (HEAD)
+			// @todo does not work for a cherry-pick! Test for a rebase.
+			Parameters.Add( TEXT( "MERGE_HEAD" ) );
+			Parameters.Add( TEXT( "--max-count 1" ) );
+		}
+		TArray< FString > Files;
+		Files.Add( *InFile );
+		TArray< FString > LogLines;
+		bResults = RunGitCommand(
+			TEXT( "log" ),
+			Parameters,
+			Files,
+			[&LogLines]( const FString& InLine ) { LogLines.Add( InLine ); },
+			OutResults,
+			Queue );
+		if ( bResults )
+			GitLowLevelCommandsLocal::ParseLogResults( LogLines, OutHistory );
+	}
+
+	// Get file (blob) sha1 id and size of all revisions in one request to the cat-file helper
+	TArray< FString > ObjectNames;
+	for ( const TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe >& Revision : OutHistory )
 	{
-		// In case of a merge conflict, we also need to get the tip of the "remote branch" (MERGE_HEAD) before the log of the "current branch" (HEAD)
-		// @todo does not work for a cherry-pick! Test for a rebase.
-		Parameters.Add( TEXT( "MERGE_HEAD" ) );
-		Parameters.Add( TEXT( "--max-count 1" ) );
+		const TSharedRef< FVSPGitRevision, ESPMode::ThreadSafe > GitRevision = StaticCastSharedRef< FVSPGitRevision >( Revision );
+		ObjectNames.Add( FString::Printf( TEXT( "%s:%s" ), *GitRevision->CommitId, *GitRevision->GetFilename() ) );
+	}
+	TArray< FVSPGitObjectInfo > ObjectInfos;
+	if ( GitLowLevelCommandsLocal::GetProcessPool().GetObjectInfos( ObjectNames, ObjectInfos ) )
+	{
+		for ( int32 RevisionIndex = 0; RevisionIndex < OutHistory.Num(); RevisionIndex++ )
+			if ( ObjectInfos[ RevisionIndex ].IsValid() )
+			{
+				TSharedRef< FVSPGitRevision, ESPMode::ThreadSafe > GitRevision = StaticCastSharedRef< FVSPGitRevision >( OutHistory[ RevisionIndex ] );
+				GitRevision->FileHash = ObjectInfos[ RevisionIndex ].Hash;
+				GitRevision->FileSize = static_cast< int32 >( ObjectInfos[ RevisionIndex ].Size );
+			}
+		return bResults;
 	}
-	TArray< FString > Files;
-	Files.Add( *InFile );
-	bool bResults = RunGitCommand( TEXT( "log" ), Parameters, Files, OutResults, Queue );
-	if ( bResults )
-		GitLowLevelCommandsLocal::ParseLogResults( OutResults, OutHistory );
 
 	for ( TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe >& Revision : OutHistory )
 	{
@@ -948,98 +1512,222 @@ bool GitLowLevelCommands::RunGetHistory(
 	return bResults;
 }
 
-/** Execute a command to get the details of a conflict */
-void GitLowLevelCommandsLocal::RunGetConflictStatus(
-	const FString& InFile,
-	TSharedRef< FVSPGitState, ESPMode::ThreadSafe >& FileState )
+bool GitLowLevelCommands::UpdateHistoryCache(
+	FSourceControlResultInfo& OutResults )
 {
-	FSourceControlResultInfo Results;
-	TQueue< FString > Queue;
-	TArray< FString > Files;
-	Files.Add( InFile );
-	TArray< FString > Parameters;
-	Parameters.Add( TEXT( "--unmerged" ) );
-	const bool bResult = GitLowLevelCommands::RunGitCommand( TEXT( "ls-files" ), Parameters, Files, Results, Queue );
-	if ( bResult && Results.InfoMessages.Num() == 3 )
+	GitLowLevelCommandsLocal::FHistoryBuild& HistoryBuild = GitLowLevelCommandsLocal::GetHistoryBuild();
+	FScopeLock ScopeLock( &HistoryBuild.Lock );
+	// A full build started for this repository is finished first, whatever HEAD became meanwhile
+	if ( HistoryBuild.Builder.IsValid() && HistoryBuild.RepoRoot == RepoRoot )
+		return GitLowLevelCommandsLocal::ContinueHistoryBuild( HistoryBuild, OutResults );
+	HistoryBuild.Builder.Reset();
+
+	const FString HeadCommit = GitLowLevelCommandsLocal::GetHeadCommit();
+	if ( HeadCommit.IsEmpty() )
+		return false;
+
+	const FString TipCommit = FVSPGitHistoryCache::Get().GetTipCommit();
+	if ( TipCommit == HeadCommit )
+		return true;
+
+	if ( !TipCommit.IsEmpty() )
 	{
-		// Parse the unmerge status: extract the base revision (or the other branch?)
-		const FString& FirstResult = Results.InfoMessages[ 0 ].ToString(); // 1: The common ancestor of merged branches
-		FileState->PendingMergeBaseFileHash = FirstResult.Mid( 7, 40 ); ///< SHA1 Id of the file (warning: not the commit Id)
+		// Only the commits added on top of the index, unless the branch moved elsewhere (checkout, reset, rebase...)
+		TQueue< FString > Queue;
+		TArray< FString > AncestorParameters;
+		AncestorParameters.Add( TEXT( "--is-ancestor" ) );
+		AncestorParameters.Add( TipCommit );
+		AncestorParameters.Add( HeadCommit );
+		FSourceControlResultInfo AncestorResults;
+		if ( RunGitCommand( TEXT( "merge-base" ), AncestorParameters, TArray< FString >(), AncestorResults, Queue ) )
+		{
+			// Appended as a segment of its own, all of them are rewritten as one only once in a while
+			FVSPGitHistoryCache::FBuilder Builder;
+			const bool bCompaction = FVSPGitHistoryCache::Get().NeedsCompaction();
+			if ( bCompaction )
+				FVSPGitHistoryCache::Get().LoadInto( Builder );
+
+			TArray< FString > Revisions;
+			Revisions.Add( FString::Printf( TEXT( "%s..%s" ), *TipCommit, *HeadCommit ) );
+			if ( !GitLowLevelCommandsLocal::RunHistoryLog( Revisions, Builder, OutResults ) )
+				return false;
+
+			Builder.FinishLog();
+			if ( bCompaction )
+				return FVSPGitHistoryCache::Get().Save( Builder, HeadCommit );
+			if ( FVSPGitHistoryCache::Get().Append( Builder, HeadCommit ) )
+				return true;
+		}
 	}
+
+	// From scratch, a chunk per call: on a large repository the whole log would hold the background task up for long
+	HistoryBuild.Builder = MakeUnique< FVSPGitHistoryCache::FBuilder >();
+	HistoryBuild.RepoRoot = RepoRoot;
+	HistoryBuild.TipCommit = HeadCommit;
+	HistoryBuild.LoggedCommits = 0;
+	return GitLowLevelCommandsLocal::ContinueHistoryBuild( HistoryBuild, OutResults );
 }
 
-// Parse one row from of Porcelain Format Version 1
-bool GitLowLevelCommandsLocal::ParseFileState(
-	const FString& StatusResult,
-	EGitState::Type& OutFileGitState,
-	FString& OutFileName )
+bool GitLowLevelCommands::RemoveIgnoredFiles(
+	TArray< FString >& InOutFiles )
 {
-	OutFileGitState = EGitState::Unknown;
-	OutFileName = TEXT( "" );
-
-	if ( StatusResult.IsEmpty() )
+	TArray< FString > IgnoredFiles;
+	if ( InOutFiles.Num() == 0 || !GitLowLevelCommandsLocal::GetProcessPool().GetIgnoredFiles( InOutFiles, IgnoredFiles ) )
 		return false;
 
-	// parse git status
-	const TCHAR IndexState = StatusResult[ 0 ];
-	const TCHAR WorkingCopyState = StatusResult[ 1 ];
-
-	if ( ( IndexState == 'U' || WorkingCopyState == 'U' ) ||
-		( IndexState == 'A' && WorkingCopyState == 'A' ) ||
-		( IndexState == 'D' && WorkingCopyState == 'D' ) )
-		OutFileGitState = EGitState::Conflicted;
-	else if ( IndexState == 'A' )
-		OutFileGitState = EGitState::Added;
-	else if ( IndexState == 'D' )
-		OutFileGitState = EGitState::Deleted;
-	else if ( WorkingCopyState == 'D' )
-		OutFileGitState = EGitState::Missing;
-	else if ( IndexState == 'M' || WorkingCopyState == 'M' )
-		OutFileGitState = EGitState::Modified;
-	else if ( IndexState == 'R' )
-		OutFileGitState = EGitState::Renamed;
-	else if ( IndexState == 'C' )
-		OutFileGitState = EGitState::Copied;
-	else if ( IndexState == '?' || WorkingCopyState == '?' )
-		OutFileGitState = EGitState::NotControlled;
-	else if ( IndexState == '!' || WorkingCopyState == '!' )
-		OutFileGitState = EGitState::Ignored;
-	else // UNKNOWN State
-		return false;
+	for ( const FString& IgnoredFile : IgnoredFiles )
+	{
+		UE_LOG( VSPGitLog, Warning, TEXT("'%s' is ignored by git, skipping it."), *IgnoredFile );
+		InOutFiles.Remove( IgnoredFile );
+	}
+	return true;
+}
 
-	// get file name
-	auto Index = StatusResult.Find( " -> " );
-	if ( Index == INDEX_NONE )
-		Index = 3;
-	else
-		Index += 4; // Len of " -> "
-	OutFileName = StatusResult.RightChop( Index );
+bool GitLowLevelCommands::GetLockableFiles(
+	const TArray< FString >& InFiles,
+	const TArray< FString >& InLockableRules,
+	TArray< FString >& OutLockableFiles )
+{
+	// The attributes follow every .gitattributes file and its precedence, the rules are only the fallback
+	TMap< FString, TMap< FString, FString > > Attributes;
+	TArray< FString > AttributeNames;
+	AttributeNames.Add( TEXT( "lockable" ) );
+	const bool bResult = InFiles.Num() > 0 && GitLowLevelCommandsLocal::GetProcessPool().GetAttributes( AttributeNames, InFiles, Attributes );
 
-	if ( OutFileName.IsEmpty() )
-		return false; // unknown row format
+	for ( const FString& File : InFiles )
+	{
+		const TMap< FString, FString >* FileAttributes = bResult ? Attributes.Find( File ) : nullptr;
+		const bool bLockable = FileAttributes != nullptr
+			? FileAttributes->FindRef( TEXT( "lockable" ) ) == TEXT( "set" )
+			: VSPGitHelpers::IsFileLockable( File, InLockableRules );
+		if ( bLockable )
+			OutLockableFiles.Add( File );
+	}
+	return bResult;
+}
 
-	return true;
+/**
+ * Field of a 'git status --porcelain=v2' record, fields are separated by spaces but the path may hold some
+ *
+ * Example records:
+1 .M N... 100644 100644 100644 587be6b4c3f93f93c489c0111bba5596147a26cb 587be6b4c3f93f93c489c0111bba5596147a26cb Content/Maps/Map.umap
+2 R. N... 100644 100644 100644 718f4d2ff533cf8ead8d3556cf43912bd245fbc4 718f4d2ff533cf8ead8d3556cf43912bd245fbc4 R100 Content/New.uasset
+u UU N... 100644 100644 100644 100644 df967b96a579e45a18b8251732d16804b2e56a55 ab7768987ce64e0490e93767ca9a4bcd950c79f6 223b7836fb19fdf64ba2d3cd6173c6a283141f78 Content/Conflict.uasset
+? Content/Untracked.uasset
+ */
+FString GitLowLevelCommandsLocal::GetStatusField( const FString& InRecord, int32 InFieldIndex, bool bInUpToEnd )
+{
+	int32 FieldStart = 0;
+	for ( int32 Field = 0; Field < InFieldIndex; Field++ )
+	{
+		const int32 Separator = InRecord.Find( TEXT( " " ), ESearchCase::CaseSensitive, ESearchDir::FromStart, FieldStart );
+		if ( Separator == INDEX_NONE )
+			return FString();
+		FieldStart = Separator + 1;
+	}
+	if ( bInUpToEnd )
+		return InRecord.Mid( FieldStart );
+
+	const int32 FieldEnd = InRecord.Find( TEXT( " " ), ESearchCase::CaseSensitive, ESearchDir::FromStart, FieldStart );
+	return InRecord.Mid( FieldStart, FieldEnd == INDEX_NONE ? MAX_int32 : FieldEnd - FieldStart );
 }
 
-void GitLowLevelCommandsLocal::ParseStatusResult(
-	const FSourceControlResultInfo& InResults,
-	TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates )
+void GitLowLevelCommandsLocal::AddLockInfo(
+	const FString& InLine,
+	TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks )
 {
-	for ( const FText& ResultLine : InResults.InfoMessages )
+	TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > LockFile = MakeShared< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >( InLine );
+	if ( LockFile->LocalFilename.IsEmpty() )
+		return;
+
+	if ( GitLowLevelCommands::GitLogMode == GitLowLevelCommands::Full )
 	{
-		FString RelativeFilename;
-		EGitState::Type GitState;
-		if ( ParseFileState( ResultLine.ToString(), GitState, RelativeFilename ) )
-		{
-			if ( FPaths::DirectoryExists( RelativeFilename ) )
-				continue;
+		UE_LOG( VSPGitLog, Log, TEXT("LockedFile ID:%d (%s, %s)"), LockFile->Id, *LockFile->LocalFilename, *LockFile->LockUser );
+	}
+	OutLocks.Add( LockFile->LocalFilename, LockFile );
+}
 
-			TSharedRef< FVSPGitState, ESPMode::ThreadSafe > NewState = MakeShared< FVSPGitState, ESPMode::ThreadSafe >( RelativeFilename, GitState );
-			NewState->TimeStamp = FDateTime::Now();
-			if ( NewState->IsConflicted() )
-				// In case of a conflict (unmerged file) get the base revision to merge
-				RunGetConflictStatus( RelativeFilename, NewState );
-			OutStates.Add( NewState );
+// Parse one record of Porcelain Format Version 2
+bool GitLowLevelCommandsLocal::ParseStatusRecord(
+	const FString& InRecord,
+	EGitState::Type& OutFileGitState,
+	FString& OutFileName,
+	FString& OutMergeBaseFileHash,
+	bool& bOutHasOriginalPath )
+{
+	OutFileGitState = EGitState::Unknown;
+	OutFileName.Empty();
+	OutMergeBaseFileHash.Empty();
+	bOutHasOriginalPath = false;
+
+	// Warnings printed on stderr end up in front of the first record
+	FString StatusResult = InRecord;
+	int32 LineEnd;
+	if ( StatusResult.FindLastChar( '\n', LineEnd ) )
+		StatusResult.RemoveAt( 0, LineEnd + 1 );
+	if ( StatusResult.Len() < 3 )
+		return false;
+
+	int32 PathField;
+	switch ( StatusResult[ 0 ] )
+	{
+		case TEXT( '1' ): // ordinary changed entry
+			PathField = 8;
+			break;
+		case TEXT( '2' ): // renamed or copied entry
+			PathField = 9;
+			bOutHasOriginalPath = true;
+			break;
+		case TEXT( 'u' ): // unmerged entry, with the hash of the common ancestor (stage 1)
+		{
+			PathField = 10;
+			OutFileGitState = EGitState::Conflicted;
+			const FString BaseHash = GetStatusField( StatusResult, 7 );
+			if ( BaseHash.Len() == 40 && BaseHash != FString::ChrN( 40, '0' ) )
+				OutMergeBaseFileHash = BaseHash;
+			break;
 		}
+		case TEXT( '?' ):
+			OutFileGitState = EGitState::NotControlled;
+			OutFileName = StatusResult.RightChop( 2 );
+			return !OutFileName.IsEmpty();
+		case TEXT( '!' ):
+			OutFileGitState = EGitState::Ignored;
+			OutFileName = StatusResult.RightChop( 2 );
+			return !OutFileName.IsEmpty();
+		default: // headers ("# branch.oid ...") and anything unexpected
+			return false;
+	}
+
+	// Submodules are directories for the editor
+	if ( !GetStatusField( StatusResult, 2 ).StartsWith( TEXT( "N" ) ) )
+		return false;
+
+	if ( OutFileGitState != EGitState::Conflicted )
+	{
+		const FString XY = GetStatusField( StatusResult, 1 );
+		if ( XY.Len() != 2 )
+			return false;
+		const TCHAR IndexState = XY[ 0 ];
+		const TCHAR WorkingCopyState = XY[ 1 ];
+
+		if ( IndexState == 'A' )
+			OutFileGitState = EGitState::Added;
+		else if ( IndexState == 'D' )
+			OutFileGitState = EGitState::Deleted;
+		else if ( WorkingCopyState == 'D' )
+			OutFileGitState = EGitState::Missing;
+		else if ( IndexState == 'M' || WorkingCopyState == 'M' )
+			OutFileGitState = EGitState::Modified;
+		else if ( IndexState == 'R' )
+			OutFileGitState = EGitState::Renamed;
+		else if ( IndexState == 'C' )
+			OutFileGitState = EGitState::Copied;
+		else // UNKNOWN State
+			return false;
 	}
+
+	OutFileName = GetStatusField( StatusResult, PathField, true );
+
+	return !OutFileName.IsEmpty();
 }
@@ -32,9 +32,13 @@ namespace GitLowLevelCommands
 		ShortWithErrorOutput,	// 1 command - and full output if error
 	};
 
-	static FString GitBinPath = TEXT( "git" );
-	static FString RepoRoot;
-	static EGitLogMode GitLogMode = ShortWithErrorOutput;
+	extern FString GitBinPath;
+	extern FString RepoRoot;
+	extern EGitLogMode GitLogMode;
+	/** Git 2.37+ on Windows and Mac has its own file system monitor daemon */
+	extern bool bUseBuiltinFsMonitor;
+	/** Git 2.26+ reads the pathspecs of add, checkout, reset, restore and rm from stdin */
+	extern bool bUsePathspecFromFile;
 
 	bool RunGitCommandLow(
 		const FString& InCommand,
@@ -43,6 +47,19 @@ namespace GitLowLevelCommands
 		FSourceControlResultInfo& OutResults,
 		TQueue< FString >& OutOutputQueue );
 
+	/**
+	* Hand every output line to InOnOutputLine as it is read, OutResults only gets the error output of a failed command.
+	* InStdIn, if any, is written to the command stdin before its output is read.
+	*/
+	bool RunGitCommandLow(
+		const FString& InCommand,
+		const TArray< FString >& InParams,
+		const TArray< FString >& InFiles,
+		TFunctionRef< void( const FString& ) > InOnOutputLine,
+		FSourceControlResultInfo& OutResults,
+		TQueue< FString >& OutOutputQueue,
+		const TArray< uint8 >* InStdIn = nullptr );
+
 	bool RunGitCommand(
 		const FString& InCommand,
 		const TArray< FString >& InParams,
@@ -50,6 +67,26 @@ namespace GitLowLevelCommands
 		FSourceControlResultInfo& OutResults,
 		TQueue< FString >& OutOutputQueue );
 
+	/** Files too many for one command line go through stdin when the command reads pathspecs from it, in several runs otherwise */
+	bool RunGitCommand(
+		const FString& InCommand,
+		const TArray< FString >& InParams,
+		const TArray< FString >& InFiles,
+		TFunctionRef< void( const FString& ) > InOnOutputLine,
+		FSourceControlResultInfo& OutResults,
+		TQueue< FString >& OutOutputQueue );
+
+	/**
+	* Read-only commands only: the files are split into batches run concurrently,
+	* the output of the batches is handed to InOnOutputLine one batch after another on the calling thread.
+	*/
+	bool RunGitCommandConcurrently(
+		const FString& InCommand,
+		const TArray< FString >& InParams,
+		const TArray< FString >& InFiles,
+		TFunctionRef< void( const FString& ) > InOnOutputLine,
+		FSourceControlResultInfo& OutResults );
+
 	bool CheckGit(
 		VSPGitHelpers::FGitVersion* OutVersion = nullptr );
 
@@ -78,8 +115,21 @@ namespace GitLowLevelCommands
 		FSourceControlResultInfo& OutResults,
 		TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks );
 
+	/** Locks of the given files only (relative to the repository root), the server filters them out of the whole table */
+	bool GetFileLocks(
+		const TArray< FString >& InFiles,
+		FSourceControlResultInfo& OutResults,
+		TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& OutLocks );
+
+	bool UpdateStatus(
+		const TArray< FString >& InLockableRules,
+		TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates,
+		FSourceControlResultInfo& OutResults );
+
+	/** Status of the given directories only (relative to the repository root), of the whole repository if empty */
 	bool UpdateStatus(
 		const TArray< FString >& InLockableRules,
+		const TArray< FString >& InDirectories,
 		TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& OutStates,
 		FSourceControlResultInfo& OutResults );
 
@@ -110,9 +160,24 @@ namespace GitLowLevelCommands
 		int32& OutLeftCountCommit,
 		int32& OutRightCountCommit );
 
+	bool RemoveIgnoredFiles(
+		TArray< FString >& InOutFiles );
+
+	bool GetLockableFiles(
+		const TArray< FString >& InFiles,
+		const TArray< FString >& InLockableRules,
+		TArray< FString >& OutLockableFiles );
+
 	bool RunGetHistory(
 		const FString& InFile,
 		bool bMergeConflict,
 		FSourceControlResultInfo& OutResults,
 		TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >& OutHistory );
+
+	/**
+	* Bring the history index up to HEAD, from the commits added on top of it or from scratch when the branch moved elsewhere.
+	* Built from scratch a chunk of commits per call, the index stays behind HEAD until the last one.
+	*/
+	bool UpdateHistoryCache(
+		FSourceControlResultInfo& OutResults );
 };
@@ -15,6 +15,7 @@
 */ 
 #include "VSPGitProvider.h"
 // Engine heads
+#include "DirectoryWatcherModule.h"
 #include "ScopedSourceControlProgress.h"
 #include "SourceControlHelpers.h"
 // Module headers
@@ -22,6 +23,9 @@
 #include "VSPGitModule.h"
 #include "UI/Widgets/SVSPGitRepoSettings.h"
 #include "Base/IVSPGitWorker.h"
+#include "Base/VSPGitHistoryCache.h"
+#include "Base/VSPGitLockCache.h"
+#include "Base/VSPGitProcessPool.h"
 #include "Commands/GitHighLevelWorkers.h"
 #include "Commands/GitLowLevelCommands.h"
 #include "Logging/MessageLog.h"
@@ -29,6 +33,24 @@
 
 static FName ProviderName( "VSPGit" );
 
+namespace VSPGitProviderLocal
+{
+	/** Above it the changed paths are dropped for a status of the whole repository */
+	const int32 MaxChangedFiles = 1024;
+
+	bool IsHeadChange( const FString& InGitDirRelativePath );
+}
+
+// Files of the .git directory telling that the status of files changed without them changing on disk.
+// The index is left out as every status rewrites it, changes to it alone wait for the next full status.
+bool VSPGitProviderLocal::IsHeadChange( const FString& InGitDirRelativePath )
+{
+	return InGitDirRelativePath == TEXT( "HEAD" )
+		|| InGitDirRelativePath == TEXT( "MERGE_HEAD" )
+		|| InGitDirRelativePath == TEXT( "packed-refs" )
+		|| InGitDirRelativePath.StartsWith( TEXT( "refs/heads/" ) );
+}
+
 #define LOCTEXT_NAMESPACE "FVSPGitModule"
 
 FVSPGitProvider& FVSPGitProvider::Get()
@@ -83,9 +105,12 @@ void FVSPGitProvider::Close()
 
 	bGitAvailable = false;
 
+	StopWatchingRepository();
 	Histories.Empty();
 	StateMap.Empty();
 	LocksMap.Empty();
+	FVSPGitProcessPool::Get().Shutdown();
+	FVSPGitHistoryCache::Get().Shutdown();
 	UE_LOG( VSPGitLog, Log, TEXT("VSPGitProvider => Close") );
 }
 
@@ -337,11 +362,24 @@ TSharedRef< SWidget > FVSPGitProvider::MakeSettingsWidget() const
 }
 #endif // SOURCE_CONTROL_WITH_SLATE
 
-bool FVSPGitProvider::UpdateGitModelStates( const TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& InStatesFromGit )
+bool FVSPGitProvider::UpdateGitModelStates(
+	const TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& InStatesFromGit,
+	const TArray< FString >& InStatusScope )
 {
 	const FDateTime Now = FDateTime::Now();
-	StateMap.Empty();
-	// Step 1: Fill map with modified states
+	// Step 1: Git reported every file still modified in the scope, drop the others
+	if ( InStatusScope.Num() == 1 && InStatusScope[ 0 ].IsEmpty() )
+		StateMap.Empty();
+	else
+		for ( auto StateIt = StateMap.CreateIterator(); StateIt; ++StateIt )
+			for ( const FString& Directory : InStatusScope )
+				if ( StateIt.Key().StartsWith( Directory ) )
+				{
+					StateIt.RemoveCurrent();
+					break;
+				}
+
+	// Step 2: Fill map with modified states
 	for ( TSharedRef< ISourceControlState, ESPMode::ThreadSafe > SourceControlState : InStatesFromGit )
 	{
 		TSharedRef< FVSPGitState, ESPMode::ThreadSafe > StatesFromGit = StaticCastSharedRef< FVSPGitState >( SourceControlState );
@@ -349,7 +387,25 @@ bool FVSPGitProvider::UpdateGitModelStates( const TArray< TSharedRef< ISourceCon
 		StateMap.Add( StatesFromGit->FileName, StatesFromGit );
 	}
 
-	// Step 2: Added locked or added marks for exist
+	// Step 3: Clear the locks released since the states were cached
+	for ( auto StateIt = StateMap.CreateIterator(); StateIt; ++StateIt )
+	{
+		TSharedRef< FVSPGitState, ESPMode::ThreadSafe > CachedState = StaticCastSharedRef< FVSPGitState >( StateIt.Value() );
+		if ( !CachedState->bIsLocked || LocksMap.Contains( StateIt.Key() ) )
+			continue;
+
+		if ( CachedState->State == EGitState::Unchanged )
+			// Only there for its lock
+			StateIt.RemoveCurrent();
+		else
+		{
+			CachedState->bIsLocked = false;
+			CachedState->LockUser.Empty();
+			CachedState->LockId = -1;
+		}
+	}
+
+	// Step 4: Added locked or added marks for exist
 	for ( auto&& LocksPair : LocksMap )
 	{
 		TSharedRef< ISourceControlState, ESPMode::ThreadSafe >* Founded = StateMap.Find( LocksPair.Key );
@@ -372,7 +428,7 @@ bool FVSPGitProvider::UpdateGitModelStates( const TArray< TSharedRef< ISourceCon
 		}
 	}
 
-	// Step 3: Update history from cash
+	// Step 5: Update history from cash
 	for ( auto&& StatePair : StateMap )
 	{
 		TArray< TSharedRef< ISourceControlRevision, ESPMode::ThreadSafe > >* History = Histories.Find( StatePair.Key );
@@ -430,6 +486,9 @@ void FVSPGitProvider::CheckGitAndRepository()
 		UE_LOG( VSPGitLog, Log, TEXT("Using git from: '%s'"), *GitBinPath );
 		GitLowLevelCommands::GitBinPath = GitBinPath;
 		bGitAvailable = GitLowLevelCommands::CheckGit( &Settings->GitVersion );
+		// The builtin file system monitor daemon only exists on Windows and Mac
+		GitLowLevelCommands::bUseBuiltinFsMonitor = ( PLATFORM_WINDOWS || PLATFORM_MAC ) && Settings->GitVersion.IsGreaterOrEqualThan( 2, 37 );
+		GitLowLevelCommands::bUsePathspecFromFile = Settings->GitVersion.IsGreaterOrEqualThan( 2, 26 );
 		if ( bGitAvailable )
 		{
 			FVSPGitSlateLayout::Get().ShowUiExtenders();
@@ -457,6 +516,10 @@ void FVSPGitProvider::CheckRepository()
 				Settings->GetCurrentRepoSettings()->bUsingGitLfsLocking = VSPGitHelpers::GetLockableRuleList(
 					Settings->GetCurrentRepoSettings()->RepoRoot,
 					Settings->GetCurrentRepoSettings()->LockableRules );
+
+			FVSPGitLockCache::Get().Configure( Settings->GetCurrentRepoSettings()->RepoRoot );
+			FVSPGitHistoryCache::Get().Configure( Settings->GetCurrentRepoSettings()->RepoRoot );
+			StartWatchingRepository();
 		}
 		else
 		{
@@ -591,6 +654,21 @@ void FVSPGitProvider::ExecuteBackgroundTasksIfNeed()
 		BackgroundTimeStamp = FDateTime::Now();
 		TSharedRef< GitHighLevelWorkers::FBackgroundTask, ESPMode::ThreadSafe > BackgroundTask =
 			GitHighLevelWorkers::FBackgroundTask::Create< GitHighLevelWorkers::FBackgroundTask >();
+
+		// Without the directory watcher, nothing tells what changed
+		const FTimespan FullStatusElapsedTime = BackgroundTimeStamp - FullStatusTimeStamp;
+		BackgroundTask->bFullStatus = bFullStatusPending
+			|| !DirectoryChangedHandle.IsValid()
+			|| FullStatusElapsedTime.GetTotalMilliseconds() >= Settings->FullStatusUpdateTimeMs;
+		if ( BackgroundTask->bFullStatus )
+		{
+			FullStatusTimeStamp = BackgroundTimeStamp;
+			bFullStatusPending = false;
+		}
+		else
+			BackgroundTask->ChangedFiles = ChangedFiles.Array();
+		ChangedFiles.Reset();
+
 		Execute( BackgroundTask, TArray< FString >(), EConcurrency::Asynchronous );
 	}
 
@@ -604,4 +682,56 @@ void FVSPGitProvider::ExecuteBackgroundTasksIfNeed()
 	}
 }
 
+void FVSPGitProvider::StartWatchingRepository()
+{
+	StopWatchingRepository();
+
+	IDirectoryWatcher* DirectoryWatcher = FModuleManager::LoadModuleChecked< FDirectoryWatcherModule >( TEXT( "DirectoryWatcher" ) ).Get();
+	if ( DirectoryWatcher == nullptr )
+		return;
+
+	WatchedDirectory = FPaths::ConvertRelativePathToFull( Settings->GetCurrentRepoSettings()->RepoRoot );
+	FPaths::NormalizeDirectoryName( WatchedDirectory );
+	DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(
+		WatchedDirectory,
+		IDirectoryWatcher::FDirectoryChanged::CreateRaw( this, &FVSPGitProvider::OnDirectoryChanged ),
+		DirectoryChangedHandle );
+	bFullStatusPending = true;
+}
+
+void FVSPGitProvider::StopWatchingRepository()
+{
+	if ( DirectoryChangedHandle.IsValid() )
+	{
+		FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr< FDirectoryWatcherModule >( TEXT( "DirectoryWatcher" ) );
+		if ( DirectoryWatcherModule != nullptr && DirectoryWatcherModule->Get() != nullptr )
+			DirectoryWatcherModule->Get()->UnregisterDirectoryChangedCallback_Handle( WatchedDirectory, DirectoryChangedHandle );
+		DirectoryChangedHandle.Reset();
+	}
+	ChangedFiles.Reset();
+}
+
+void FVSPGitProvider::OnDirectoryChanged( const TArray< FFileChangeData >& InFileChanges )
+{
+	const FString GitDirectory = WatchedDirectory / TEXT( ".git/" );
+	for ( const FFileChangeData& FileChange : InFileChanges )
+	{
+		FString Filename = FileChange.Filename;
+		FPaths::NormalizeFilename( Filename );
+		if ( Filename.StartsWith( GitDirectory ) )
+		{
+			if ( VSPGitProviderLocal::IsHeadChange( Filename.RightChop( GitDirectory.Len() ) ) )
+				bFullStatusPending = true;
+		}
+		else
+			ChangedFiles.Add( MoveTemp( Filename ) );
+	}
+
+	if ( ChangedFiles.Num() > VSPGitProviderLocal::MaxChangedFiles )
+	{
+		ChangedFiles.Reset();
+		bFullStatusPending = true;
+	}
+}
+
 #undef LOCTEXT_NAMESPACE
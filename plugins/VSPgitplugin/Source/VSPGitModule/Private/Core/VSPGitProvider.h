@@ -15,6 +15,7 @@
 */ 
 #pragma once
 // Engine headers
+#include "IDirectoryWatcher.h"
 #include "ISourceControlProvider.h"
 #include "ISourceControlState.h"
 // Module headers
@@ -74,7 +75,10 @@ public:
 
 public:
 	/* Implementation for updating source control states */
-	bool UpdateGitModelStates( const TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& InStatesFromGit );
+	/** Replace the cached states under the directories of InStatusScope ("" for the whole repository) by InStatesFromGit */
+	bool UpdateGitModelStates(
+		const TArray< TSharedRef< ISourceControlState, ESPMode::ThreadSafe > >& InStatesFromGit,
+		const TArray< FString >& InStatusScope );
 	bool UpdateGitLfsModelLockStates( const TMap< FString, TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > >& InLockStatesFromGitLfs );
 
 	void UpdateRepositoryStatus( const FVSPGitWork& InWork );
@@ -102,6 +106,11 @@ private:
 	void UpdateTimersIfNeed( const FVSPGitWork& Work );
 	void ExecuteBackgroundTasksIfNeed();
 
+	/* Collect the paths changed on disk, to limit the background status to them */
+	void StartWatchingRepository();
+	void StopWatchingRepository();
+	void OnDirectoryChanged( const TArray< FFileChangeData >& InFileChanges );
+
 private:
 	bool bGitAvailable;
 	bool bRepoAvailable;
@@ -126,6 +135,14 @@ private:
 
 	FDateTime BackgroundTimeStamp;
 	FDateTime AutoFetchTimeStamp;
+	FDateTime FullStatusTimeStamp;
+
+	/** Paths changed on disk since the last background task */
+	TSet< FString > ChangedFiles;
+	/** Something the changed paths don't tell about happened, e.g. HEAD moved */
+	bool bFullStatusPending = true;
+	FString WatchedDirectory;
+	FDelegateHandle DirectoryChangedHandle;
 	// TODO: Remove this ugly code after demo
 public:
 	VSPGitHelpers::FDivergence Divergence;
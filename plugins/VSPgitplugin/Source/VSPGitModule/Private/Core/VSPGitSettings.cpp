@@ -31,6 +31,7 @@ void FVSPGitSettings::LoadSettings()
 
 	GConfig->GetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "BackgroundUpdateTimeMs" ), BackgroundUpdateTimeMs, IniFile );
 	GConfig->GetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "AutoFetchUpdateTimeMs" ), AutoFetchUpdateTimeMs, IniFile );
+	GConfig->GetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "FullStatusUpdateTimeMs" ), FullStatusUpdateTimeMs, IniFile );
 	GConfig->GetString( *VSPGitSettingsConstants::SettingsSection, TEXT( "GitBinPath" ), GitBinPath, IniFile );
 
 #if IS_PROGRAM
@@ -64,6 +65,7 @@ void FVSPGitSettings::SaveSettings() const
 
 	GConfig->SetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "BackgroundUpdateTimeMs" ), BackgroundUpdateTimeMs, IniFile );
 	GConfig->SetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "AutoFetchUpdateTimeMs" ), AutoFetchUpdateTimeMs, IniFile );
+	GConfig->SetInt( *VSPGitSettingsConstants::SettingsSection, TEXT( "FullStatusUpdateTimeMs" ), FullStatusUpdateTimeMs, IniFile );
 	GConfig->SetString( *VSPGitSettingsConstants::SettingsSection, TEXT( "GitBinPath" ), *GitBinPath, IniFile );
 	GConfig->SetString( *VSPGitSettingsConstants::SettingsSection, TEXT( "CurrentRepo" ), *( CurrentRepoPtr->RepoRoot ), IniFile );
 
@@ -57,6 +57,8 @@ public: //params
 	bool bGitLfsAvailable;
 	int32 BackgroundUpdateTimeMs = 1000 /*Ms*/ * 30 /*sec*/; // * 1 /*Min*/;
 	int32 AutoFetchUpdateTimeMs = 1000 /*Ms*/ * 60 /*sec*/ * 5 /*Min*/;
+	// Background status is limited to the directories changed on disk, with a status of the whole repository from time to time
+	int32 FullStatusUpdateTimeMs = 1000 /*Ms*/ * 60 /*sec*/ * 5 /*Min*/;
 
 private:
 	FString GitBinPath{ TEXT( "git" ) };
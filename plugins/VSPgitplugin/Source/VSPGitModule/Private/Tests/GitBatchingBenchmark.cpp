@@ -0,0 +1,105 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitTestRepo.h"
+#include "VSPTests.h"
+
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+namespace GitBatchingBenchmarkLocal
+{
+	const int32 FilesNum = 100000;
+	/** Files whose content is checked after each step */
+	const int32 CheckedFilesStep = 9973;
+
+	bool HasContent( const FVSPGitTestRepo& InRepo, const TArray< FString >& InFiles, const FString& InContent )
+	{
+		for ( int32 Index = 0; Index < InFiles.Num(); Index += CheckedFilesStep )
+			if ( InRepo.ReadFile( InFiles[ Index ] ) != InContent )
+				return false;
+		return true;
+	}
+
+	/** Checkout of the files from the first commit, then their revert with the commands of FRevertWorker */
+	void CheckoutAndRevert( FAutomationTestBase& InTest, const FVSPGitTestRepo& InRepo, const TArray< FString >& InFiles, const TCHAR* InModeName )
+	{
+		double StartTime = FPlatformTime::Seconds();
+		const bool bCheckedOut = InRepo.RunGit( TEXT( "checkout" ), { TEXT( "HEAD~1" ) }, InFiles );
+		const double CheckoutTime = FPlatformTime::Seconds() - StartTime;
+		InTest.TestTrue( FString::Printf( TEXT( "%s: checkout" ), InModeName ), bCheckedOut && HasContent( InRepo, InFiles, TEXT( "First" ) ) );
+
+		StartTime = FPlatformTime::Seconds();
+		const bool bReverted = InRepo.RunGit( TEXT( "reset" ), { TEXT( "-q" ) }, InFiles )
+			&& InRepo.RunGit( TEXT( "checkout" ), TArray< FString >(), InFiles );
+		const double RevertTime = FPlatformTime::Seconds() - StartTime;
+		InTest.TestTrue( FString::Printf( TEXT( "%s: revert" ), InModeName ), bReverted && HasContent( InRepo, InFiles, TEXT( "Second" ) ) );
+		InTest.TestTrue(
+			FString::Printf( TEXT( "%s: clean after revert" ), InModeName ),
+			InRepo.RunGitOutput( TEXT( "status" ), { TEXT( "--porcelain" ) } ).Num() == 0 );
+
+		InTest.AddInfo( FString::Printf(
+			TEXT( "%s: checkout of %d files took %.3f s, revert %.3f s" ),
+			InModeName,
+			InFiles.Num(),
+			CheckoutTime,
+			RevertTime ) );
+	}
+}
+
+VSP_TEST( VSPGit, BulkCheckoutRevert, BenchmarkFlags )
+{
+	using namespace GitBatchingBenchmarkLocal;
+
+	FVSPGitTestRepo Repo( TEXT( "BulkCheckoutRevert" ) );
+	if ( !Repo.IsValid() )
+	{
+		AddWarning( TEXT( "Git can't be run, benchmark is skipped" ) );
+		return true;
+	}
+
+	const TArray< FString > Files = FVSPGitTestRepo::MakeFilenames( FilesNum );
+	double StartTime = FPlatformTime::Seconds();
+	VSP_EXPECT_TRUE( Repo.WriteFiles( Files, TEXT( "First" ) ) && Repo.CommitAll( TEXT( "First" ) ) );
+	VSP_EXPECT_TRUE( Repo.WriteFiles( Files, TEXT( "Second" ) ) && Repo.CommitAll( TEXT( "Second" ) ) );
+	AddInfo( FString::Printf( TEXT( "Repository of %d files generated in %.3f s" ), FilesNum, FPlatformTime::Seconds() - StartTime ) );
+
+	// Stdin first: it is what the provider uses with any recent git
+	if ( GitLowLevelCommands::bUsePathspecFromFile )
+		CheckoutAndRevert( *this, Repo, Files, TEXT( "Pathspecs from stdin" ) );
+	GitLowLevelCommands::bUsePathspecFromFile = false;
+	CheckoutAndRevert( *this, Repo, Files, TEXT( "Command line batches" ) );
+
+	// Read-only commands: the same batches one after another, then concurrently
+	StartTime = FPlatformTime::Seconds();
+	const int32 SequentialLines = Repo.RunGitOutput( TEXT( "ls-files" ), { TEXT( "-s" ) }, Files ).Num();
+	const double SequentialTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( SequentialLines, FilesNum );
+
+	StartTime = FPlatformTime::Seconds();
+	int32 ConcurrentLines = 0;
+	FSourceControlResultInfo Results;
+	VSP_EXPECT_TRUE( GitLowLevelCommands::RunGitCommandConcurrently(
+		TEXT( "ls-files" ),
+		{ TEXT( "-s" ) },
+		Files,
+		[&ConcurrentLines]( const FString& ) { ConcurrentLines++; },
+		Results ) );
+	const double ConcurrentTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( ConcurrentLines, FilesNum );
+
+	AddInfo( FString::Printf( TEXT( "ls-files of %d files took %.3f s in sequence, %.3f s concurrently" ), FilesNum, SequentialTime, ConcurrentTime ) );
+
+	return true;
+}
@@ -0,0 +1,156 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPTests.h"
+
+#include "Core/Base/VSPGitLockCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+
+namespace VSPGitLockCacheTestLocal
+{
+	const TCHAR* const RepoRoot = TEXT( "D:/Projects/Game" );
+
+	/** As printed by 'git lfs locks', names and users padded to their column */
+	const TArray< FString > LocksOutput = {
+		TEXT( "Content/Maps/Forest.umap    \tAlice Smith\tID:101" ),
+		TEXT( "Content/Props/Barrel.uasset \tBob        \tID:102" ),
+		TEXT( "Content/Props/Crate.uasset  \tAlice Smith\tID:103" ) };
+
+	/** Same locks, Barrel released and locked again by someone else */
+	const TArray< FString > RelockedOutput = {
+		TEXT( "Content/Maps/Forest.umap    \tAlice Smith\tID:101" ),
+		TEXT( "Content/Props/Barrel.uasset \tCarol      \tID:104" ),
+		TEXT( "Content/Props/Crate.uasset  \tAlice Smith\tID:103" ) };
+
+	FString GetSnapshotFilename( const TCHAR* InTestName )
+	{
+		return FPaths::ConvertRelativePathToFull( FPaths::AutomationTransientDir() / TEXT( "VSPGit" ) / InTestName + TEXT( ".txt" ) );
+	}
+
+	FVSPGitLockCache::FLockMap ParseLocks( const TArray< FString >& InLines )
+	{
+		FVSPGitLockCache::FLockMap Locks;
+		for ( const FString& Line : InLines )
+		{
+			TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe > LockInfo = MakeShared< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >( Line );
+			if ( !LockInfo->LocalFilename.IsEmpty() )
+				Locks.Add( LockInfo->LocalFilename, LockInfo );
+		}
+		return Locks;
+	}
+
+	bool HasLock( const FVSPGitLockCache& InCache, const FString& InFile, const FString& InUser, int32 InId )
+	{
+		const FVSPGitLockCache::FLockMap Locks = InCache.GetLocks();
+		const TSharedRef< VSPGitHelpers::FGitLfsLockInfo, ESPMode::ThreadSafe >* LockInfo = Locks.Find( InFile );
+		return LockInfo != nullptr && ( *LockInfo )->LockUser == InUser && ( *LockInfo )->Id == InId;
+	}
+}
+
+VSP_TEST( VSPGit, LockCacheSnapshot, TestsFlags )
+{
+	using namespace VSPGitLockCacheTestLocal;
+
+	const FString SnapshotFilename = GetSnapshotFilename( TEXT( "LockCacheSnapshot" ) );
+	IFileManager::Get().Delete( *SnapshotFilename );
+
+	FVSPGitLockCache Cache( SnapshotFilename );
+	Cache.Configure( RepoRoot );
+	VSP_EXPECT_TRUE( !Cache.HasLocks() && Cache.NeedsFullRefresh() );
+
+	Cache.SetAllLocks( ParseLocks( LocksOutput ) );
+	VSP_EXPECT_TRUE( Cache.HasLocks() && !Cache.NeedsFullRefresh() );
+	VSP_EXPECT_EQ( Cache.GetLocks().Num(), 3 );
+
+	// The next editor session starts with the table, as fresh as the snapshot
+	{
+		FVSPGitLockCache Reloaded( SnapshotFilename );
+		Reloaded.Configure( RepoRoot );
+		VSP_EXPECT_TRUE( Reloaded.HasLocks() && !Reloaded.NeedsFullRefresh() );
+		VSP_EXPECT_EQ( Reloaded.GetLocks().Num(), 3 );
+		VSP_EXPECT_TRUE( HasLock( Reloaded, TEXT( "Content/Maps/Forest.umap" ), TEXT( "Alice Smith" ), 101 ) );
+		VSP_EXPECT_TRUE( HasLock( Reloaded, TEXT( "Content/Props/Barrel.uasset" ), TEXT( "Bob" ), 102 ) );
+	}
+
+	// Locks of single files refreshed on their own are saved too
+	Cache.SetFileLocks( { TEXT( "Content/Props/Crate.uasset" ) }, FVSPGitLockCache::FLockMap() );
+	{
+		FVSPGitLockCache Reloaded( SnapshotFilename );
+		Reloaded.Configure( RepoRoot );
+		VSP_EXPECT_EQ( Reloaded.GetLocks().Num(), 2 );
+		VSP_EXPECT_TRUE( !Reloaded.GetLocks().Contains( TEXT( "Content/Props/Crate.uasset" ) ) );
+	}
+
+	// An old snapshot is used but refreshed right away
+	IFileManager::Get().SetTimeStamp( *SnapshotFilename, FDateTime::UtcNow() - FTimespan::FromHours( 1.0 ) );
+	{
+		FVSPGitLockCache Reloaded( SnapshotFilename );
+		Reloaded.Configure( RepoRoot );
+		VSP_EXPECT_TRUE( Reloaded.HasLocks() && Reloaded.NeedsFullRefresh() );
+	}
+
+	// The snapshot of another repository is ignored
+	{
+		FVSPGitLockCache Reloaded( SnapshotFilename );
+		Reloaded.Configure( TEXT( "D:/Projects/Other" ) );
+		VSP_EXPECT_TRUE( !Reloaded.HasLocks() && Reloaded.NeedsFullRefresh() );
+	}
+
+	IFileManager::Get().Delete( *SnapshotFilename );
+	return true;
+}
+
+VSP_TEST( VSPGit, LockCacheRefreshInterval, TestsFlags )
+{
+	using namespace VSPGitLockCacheTestLocal;
+
+	const FString SnapshotFilename = GetSnapshotFilename( TEXT( "LockCacheRefreshInterval" ) );
+	IFileManager::Get().Delete( *SnapshotFilename );
+
+	FVSPGitLockCache Cache( SnapshotFilename );
+	Cache.Configure( RepoRoot );
+
+	// The first table is a change
+	Cache.SetAllLocks( ParseLocks( LocksOutput ) );
+	VSP_EXPECT_EQ( Cache.GetRefreshIntervalSeconds(), 30.0 );
+
+	// Doubled by each refresh finding the same table, up to 10 minutes
+	const double UnchangedIntervals[] = { 60.0, 120.0, 240.0, 480.0, 600.0, 600.0 };
+	for ( const double Interval : UnchangedIntervals )
+	{
+		Cache.SetAllLocks( ParseLocks( LocksOutput ) );
+		VSP_EXPECT_EQ( Cache.GetRefreshIntervalSeconds(), Interval );
+	}
+	VSP_EXPECT_TRUE( !Cache.NeedsFullRefresh() );
+
+	// Back to the shortest as soon as someone locks or unlocks
+	Cache.SetAllLocks( ParseLocks( RelockedOutput ) );
+	VSP_EXPECT_EQ( Cache.GetRefreshIntervalSeconds(), 30.0 );
+	VSP_EXPECT_TRUE( HasLock( Cache, TEXT( "Content/Props/Barrel.uasset" ), TEXT( "Carol" ), 104 ) );
+
+	Cache.SetAllLocks( ParseLocks( RelockedOutput ) );
+	VSP_EXPECT_EQ( Cache.GetRefreshIntervalSeconds(), 60.0 );
+	Cache.SetAllLocks( ParseLocks( { RelockedOutput[ 0 ] } ) );
+	VSP_EXPECT_EQ( Cache.GetRefreshIntervalSeconds(), 30.0 );
+
+	Cache.Reset();
+	VSP_EXPECT_TRUE( !Cache.HasLocks() && Cache.NeedsFullRefresh() );
+
+	IFileManager::Get().Delete( *SnapshotFilename );
+	return true;
+}
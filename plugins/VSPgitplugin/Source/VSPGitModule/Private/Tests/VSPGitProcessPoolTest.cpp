@@ -0,0 +1,225 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitTestRepo.h"
+#include "VSPTests.h"
+
+#include "Core/Base/VSPGitProcessPool.h"
+#include "Misc/ScopeLock.h"
+
+static constexpr int TestsFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+static constexpr int BenchmarkFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+class FVSPGitProcessPoolTestAccess
+{
+public:
+	/** The helper started for the command, null if there is none */
+	static TSharedPtr< FVSPGitBatchProcess, ESPMode::ThreadSafe > GetProcess( FVSPGitProcessPool& InPool, const FString& InCommand )
+	{
+		FScopeLock ScopeLock( &InPool.ProcessesLock );
+		const TArray< FVSPGitProcessPool::FVSPGitBatchProcessPtr >* CommandProcesses = InPool.Processes.Find( InCommand );
+		return CommandProcesses != nullptr && CommandProcesses->Num() > 0 ? ( *CommandProcesses )[ 0 ] : nullptr;
+	}
+
+	static void Age( FVSPGitBatchProcess& InProcess, double InSeconds )
+	{
+		InProcess.StartTime -= InSeconds;
+	}
+
+	static void Kill( FVSPGitBatchProcess& InProcess )
+	{
+		FPlatformProcess::TerminateProc( InProcess.ProcessHandle );
+		FPlatformProcess::WaitForProc( InProcess.ProcessHandle );
+	}
+
+	/** The helper looks alive but can't be written to anymore */
+	static void BreakStdIn( FVSPGitBatchProcess& InProcess )
+	{
+		FPlatformProcess::ClosePipe( nullptr, InProcess.StdInWrite );
+		InProcess.StdInWrite = nullptr;
+	}
+};
+
+namespace VSPGitProcessPoolTestLocal
+{
+	const TCHAR* const BatchCheckCommand = TEXT( "cat-file --batch-check" );
+	/** Below the age the pool restarts helpers at */
+	const double YoungAgeSeconds = 10.0;
+	const double OldAgeSeconds = 3600.0;
+	const int32 BenchmarkFilesNum = 500;
+
+	bool CommitFixture( const FVSPGitTestRepo& InRepo )
+	{
+		return InRepo.WriteFiles( { TEXT( ".gitattributes" ) }, TEXT( "*.uasset lockable\n*.txt text\n" ) )
+			&& InRepo.WriteFiles( { TEXT( ".gitignore" ) }, TEXT( "*.tmp\n!Keep.tmp\n" ) )
+			&& InRepo.WriteFiles( { TEXT( "Content/A.txt" ) }, TEXT( "Hello" ) )
+			&& InRepo.CommitAll( TEXT( "Fixture" ) );
+	}
+
+	bool IsHelloBlob( FVSPGitProcessPool& InPool )
+	{
+		TArray< FVSPGitObjectInfo > Infos;
+		return InPool.GetObjectInfos( { TEXT( "HEAD:Content/A.txt" ) }, Infos )
+			&& Infos.Num() == 1
+			&& Infos[ 0 ].Type == TEXT( "blob" )
+			&& Infos[ 0 ].Size == 5;
+	}
+}
+
+VSP_TEST( VSPGit, ProcessPoolRoundTrip, TestsFlags )
+{
+	using namespace VSPGitProcessPoolTestLocal;
+
+	FVSPGitTestRepo Repo( TEXT( "ProcessPoolRoundTrip" ) );
+	if ( !Repo.IsValid() )
+	{
+		AddWarning( TEXT( "Git can't be run, test is skipped" ) );
+		return true;
+	}
+	VSP_EXPECT_TRUE( CommitFixture( Repo ) );
+
+	FVSPGitProcessPool Pool;
+	Pool.Configure( GitLowLevelCommands::GitBinPath, Repo.GetRoot() );
+
+	TArray< FVSPGitObjectInfo > Infos;
+	VSP_EXPECT_TRUE( Pool.GetObjectInfos( { TEXT( "HEAD:Content/A.txt" ), TEXT( "HEAD:Content/Missing.txt" ) }, Infos ) );
+	VSP_EXPECT_EQ( Infos.Num(), 2 );
+	if ( Infos.Num() == 2 )
+	{
+		VSP_EXPECT_TRUE( Infos[ 0 ].IsValid() && Infos[ 0 ].Type == TEXT( "blob" ) && Infos[ 0 ].Size == 5 );
+		VSP_EXPECT_TRUE( !Infos[ 1 ].IsValid() );
+	}
+
+	// The head comes in one piece, the rest after it
+	FVSPGitObjectInfo Info;
+	FString Content;
+	TArray< int32 > ChunkSizes;
+	VSP_EXPECT_TRUE( Pool.StreamObjectContent(
+		TEXT( "HEAD:Content/A.txt" ),
+		4,
+		Info,
+		[&Content, &ChunkSizes]( const uint8* InData, int32 InNum, int64 InOffset )
+		{
+			Content += FString( InNum, reinterpret_cast< const ANSICHAR* >( InData ) );
+			ChunkSizes.Add( InNum );
+			return true;
+		} ) );
+	VSP_EXPECT_EQ( Content, TEXT( "Hello" ) );
+	VSP_EXPECT_TRUE( ChunkSizes.Num() > 0 && ChunkSizes[ 0 ] == 4 );
+
+	TMap< FString, TMap< FString, FString > > Attributes;
+	VSP_EXPECT_TRUE( Pool.GetAttributes( { TEXT( "lockable" ), TEXT( "text" ) }, { TEXT( "Content/A.uasset" ), TEXT( "Content/A.txt" ) }, Attributes ) );
+	VSP_EXPECT_EQ( Attributes.FindRef( TEXT( "Content/A.uasset" ) ).FindRef( TEXT( "lockable" ) ), TEXT( "set" ) );
+	VSP_EXPECT_EQ( Attributes.FindRef( TEXT( "Content/A.uasset" ) ).FindRef( TEXT( "text" ) ), TEXT( "unspecified" ) );
+	VSP_EXPECT_EQ( Attributes.FindRef( TEXT( "Content/A.txt" ) ).FindRef( TEXT( "lockable" ) ), TEXT( "unspecified" ) );
+	VSP_EXPECT_EQ( Attributes.FindRef( TEXT( "Content/A.txt" ) ).FindRef( TEXT( "text" ) ), TEXT( "set" ) );
+
+	TArray< FString > IgnoredFiles;
+	VSP_EXPECT_TRUE( Pool.GetIgnoredFiles( { TEXT( "Content/B.tmp" ), TEXT( "Content/Keep.tmp" ), TEXT( "Content/A.txt" ) }, IgnoredFiles ) );
+	VSP_EXPECT_EQ( IgnoredFiles, TArray< FString >( { TEXT( "Content/B.tmp" ) } ) );
+
+	return true;
+}
+
+VSP_TEST( VSPGit, ProcessPoolRestart, TestsFlags )
+{
+	using namespace VSPGitProcessPoolTestLocal;
+
+	FVSPGitTestRepo Repo( TEXT( "ProcessPoolRestart" ) );
+	if ( !Repo.IsValid() )
+	{
+		AddWarning( TEXT( "Git can't be run, test is skipped" ) );
+		return true;
+	}
+	VSP_EXPECT_TRUE( CommitFixture( Repo ) );
+
+	FVSPGitProcessPool Pool;
+	Pool.Configure( GitLowLevelCommands::GitBinPath, Repo.GetRoot() );
+	VSP_EXPECT_TRUE( IsHelloBlob( Pool ) );
+	const TSharedPtr< FVSPGitBatchProcess, ESPMode::ThreadSafe > Process = FVSPGitProcessPoolTestAccess::GetProcess( Pool, BatchCheckCommand );
+	VSP_EXPECT_TRUE( Process.IsValid() );
+	if ( !Process.IsValid() )
+		return true;
+
+	// Dead before the request: started again
+	FVSPGitProcessPoolTestAccess::Kill( *Process );
+	VSP_EXPECT_TRUE( !Process->IsRunning() );
+	VSP_EXPECT_TRUE( IsHelloBlob( Pool ) );
+	VSP_EXPECT_TRUE( Process->IsRunning() );
+
+	// Failing during the request: retried on a fresh helper
+	FVSPGitProcessPoolTestAccess::Age( *Process, YoungAgeSeconds );
+	FVSPGitProcessPoolTestAccess::BreakStdIn( *Process );
+	VSP_EXPECT_TRUE( IsHelloBlob( Pool ) );
+	VSP_EXPECT_TRUE( Process->GetAge() < YoungAgeSeconds );
+
+	// Alive for too long: recycled before the request
+	FVSPGitProcessPoolTestAccess::Age( *Process, OldAgeSeconds );
+	VSP_EXPECT_TRUE( IsHelloBlob( Pool ) );
+	VSP_EXPECT_TRUE( Process->GetAge() < YoungAgeSeconds );
+
+	// Still the only helper of the command
+	VSP_EXPECT_TRUE( FVSPGitProcessPoolTestAccess::GetProcess( Pool, BatchCheckCommand ) == Process );
+
+	return true;
+}
+
+VSP_TEST( VSPGit, ProcessPoolLatency, BenchmarkFlags )
+{
+	using namespace VSPGitProcessPoolTestLocal;
+
+	FVSPGitTestRepo Repo( TEXT( "ProcessPoolLatency" ) );
+	if ( !Repo.IsValid() )
+	{
+		AddWarning( TEXT( "Git can't be run, benchmark is skipped" ) );
+		return true;
+	}
+	const TArray< FString > Files = FVSPGitTestRepo::MakeFilenames( BenchmarkFilesNum );
+	VSP_EXPECT_TRUE( CommitFixture( Repo ) && Repo.WriteFiles( Files, TEXT( "Content" ) ) && Repo.CommitAll( TEXT( "Files" ) ) );
+
+	FVSPGitProcessPool Pool;
+	Pool.Configure( GitLowLevelCommands::GitBinPath, Repo.GetRoot() );
+
+	// One query per file, as the editor asks them: a git process each, then the pool helpers
+	double StartTime = FPlatformTime::Seconds();
+	int32 ProcessAnswers = 0;
+	for ( const FString& File : Files )
+		ProcessAnswers += Repo.RunGitOutput( TEXT( "cat-file" ), { TEXT( "-s" ), TEXT( "HEAD:" ) + File } ).Num();
+	const double ProcessTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( ProcessAnswers, BenchmarkFilesNum );
+
+	StartTime = FPlatformTime::Seconds();
+	int32 PoolAnswers = 0;
+	TArray< FVSPGitObjectInfo > Infos;
+	for ( const FString& File : Files )
+		if ( Pool.GetObjectInfos( { TEXT( "HEAD:" ) + File }, Infos ) && Infos.Num() == 1 && Infos[ 0 ].IsValid() )
+			PoolAnswers++;
+	const double PoolTime = FPlatformTime::Seconds() - StartTime;
+	VSP_EXPECT_EQ( PoolAnswers, BenchmarkFilesNum );
+
+	StartTime = FPlatformTime::Seconds();
+	TMap< FString, TMap< FString, FString > > Attributes;
+	VSP_EXPECT_TRUE( Pool.GetAttributes( { TEXT( "lockable" ) }, Files, Attributes ) );
+	const double AttributesTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo( FString::Printf(
+		TEXT( "%d object queries took %.3f s with a process each, %.3f s on the pool; check-attr of all of them in one request %.3f s" ),
+		BenchmarkFilesNum,
+		ProcessTime,
+		PoolTime,
+		AttributesTime ) );
+
+	return true;
+}
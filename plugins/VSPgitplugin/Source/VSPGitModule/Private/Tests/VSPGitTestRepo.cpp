@@ -0,0 +1,133 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#include "VSPGitTestRepo.h"
+
+// Module includes
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace VSPGitTestRepoLocal
+{
+	const int32 FilesPerDirectory = 1000;
+	/** No identity nor signing setup of the machine is needed to commit */
+	const TCHAR* const CommitCommand = TEXT( "-c user.name=VSPGitTests -c user.email=vspgittests@localhost -c commit.gpgsign=false commit" );
+
+	/** Git makes its objects read-only, they would stay behind */
+	void DeleteRepo( const FString& InRoot );
+}
+
+void VSPGitTestRepoLocal::DeleteRepo( const FString& InRoot )
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if ( !PlatformFile.DirectoryExists( *InRoot ) )
+		return;
+
+	PlatformFile.IterateDirectoryRecursively(
+		*InRoot,
+		[&PlatformFile]( const TCHAR* InFilenameOrDirectory, bool bInIsDirectory )
+		{
+			if ( !bInIsDirectory )
+				PlatformFile.SetReadOnly( InFilenameOrDirectory, false );
+			return true;
+		} );
+	PlatformFile.DeleteDirectoryRecursively( *InRoot );
+}
+
+FVSPGitTestRepo::FVSPGitTestRepo( const FString& InName )
+	: Root( FPaths::ConvertRelativePathToFull( FPaths::AutomationTransientDir() / TEXT( "VSPGit" ) / InName ) )
+	, SavedRepoRoot( GitLowLevelCommands::RepoRoot )
+	, SavedGitLogMode( GitLowLevelCommands::GitLogMode )
+	, bSavedUsePathspecFromFile( GitLowLevelCommands::bUsePathspecFromFile )
+{
+	// Left over by a run that crashed
+	VSPGitTestRepoLocal::DeleteRepo( Root );
+	if ( !IFileManager::Get().MakeDirectory( *Root, true ) )
+		return;
+
+	GitLowLevelCommands::RepoRoot = Root;
+	GitLowLevelCommands::GitLogMode = GitLowLevelCommands::Silent;
+
+	VSPGitHelpers::FGitVersion Version;
+	if ( !GitLowLevelCommands::CheckGit( &Version ) )
+		return;
+	GitLowLevelCommands::bUsePathspecFromFile = Version.IsGreaterOrEqualThan( 2, 26 );
+
+	bValid = RunGit( TEXT( "init" ), { TEXT( "-q" ) } );
+}
+
+FVSPGitTestRepo::~FVSPGitTestRepo()
+{
+	GitLowLevelCommands::RepoRoot = SavedRepoRoot;
+	GitLowLevelCommands::GitLogMode = SavedGitLogMode;
+	GitLowLevelCommands::bUsePathspecFromFile = bSavedUsePathspecFromFile;
+
+	VSPGitTestRepoLocal::DeleteRepo( Root );
+}
+
+TArray< FString > FVSPGitTestRepo::MakeFilenames( int32 InNum )
+{
+	TArray< FString > Files;
+	Files.Reserve( InNum );
+	for ( int32 Index = 0; Index < InNum; Index++ )
+		Files.Add( FString::Printf( TEXT( "Content/Dir%03d/File%06d.txt" ), Index / VSPGitTestRepoLocal::FilesPerDirectory, Index ) );
+	return Files;
+}
+
+bool FVSPGitTestRepo::WriteFiles( const TArray< FString >& InFiles, const FString& InContent ) const
+{
+	bool bSuccessful = true;
+	for ( const FString& File : InFiles )
+		bSuccessful &= FFileHelper::SaveStringToFile( InContent, *( Root / File ) );
+	return bSuccessful;
+}
+
+FString FVSPGitTestRepo::ReadFile( const FString& InFile ) const
+{
+	FString Content;
+	FFileHelper::LoadFileToString( Content, *( Root / InFile ) );
+	return Content;
+}
+
+bool FVSPGitTestRepo::CommitAll( const FString& InMessage ) const
+{
+	return RunGit( TEXT( "add" ), { TEXT( "-A" ) } )
+		&& RunGit( VSPGitTestRepoLocal::CommitCommand, { TEXT( "-q" ), TEXT( "-m" ), FString::Printf( TEXT( "\"%s\"" ), *InMessage ) } );
+}
+
+bool FVSPGitTestRepo::RunGit( const FString& InCommand, const TArray< FString >& InParams, const TArray< FString >& InFiles ) const
+{
+	FSourceControlResultInfo Results;
+	TQueue< FString > Queue;
+	return GitLowLevelCommands::RunGitCommand( InCommand, InParams, InFiles, []( const FString& ) {}, Results, Queue );
+}
+
+TArray< FString > FVSPGitTestRepo::RunGitOutput( const FString& InCommand, const TArray< FString >& InParams, const TArray< FString >& InFiles ) const
+{
+	TArray< FString > Lines;
+	FSourceControlResultInfo Results;
+	TQueue< FString > Queue;
+	if ( !GitLowLevelCommands::RunGitCommand(
+		InCommand,
+		InParams,
+		InFiles,
+		[&Lines]( const FString& InLine ) { Lines.Add( InLine ); },
+		Results,
+		Queue ) )
+		Lines.Reset();
+	return Lines;
+}
@@ -0,0 +1,60 @@
+﻿/*
+* Copyright 2023 Wargaming.net Limited
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/ 
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Core/Commands/GitLowLevelCommands.h"
+
+/**
+* Git repository created in the automation transient directory and deleted with the object.
+* The low level commands run in it meanwhile, silently: the source control provider must not be running any.
+*/
+class FVSPGitTestRepo
+{
+public:
+	explicit FVSPGitTestRepo( const FString& InName );
+	~FVSPGitTestRepo();
+
+	/** False when git could not be run or the repository created */
+	bool IsValid() const { return bValid; }
+
+	const FString& GetRoot() const { return Root; }
+
+	/** Relative filenames of InNum files, a thousand per directory */
+	static TArray< FString > MakeFilenames( int32 InNum );
+
+	/** (Over)write the files (relative to the root) with the content */
+	bool WriteFiles( const TArray< FString >& InFiles, const FString& InContent ) const;
+
+	FString ReadFile( const FString& InFile ) const;
+
+	/** Stage everything and commit it */
+	bool CommitAll( const FString& InMessage ) const;
+
+	bool RunGit( const FString& InCommand, const TArray< FString >& InParams, const TArray< FString >& InFiles = TArray< FString >() ) const;
+
+	/** Output lines of the command, empty if it failed */
+	TArray< FString > RunGitOutput( const FString& InCommand, const TArray< FString >& InParams, const TArray< FString >& InFiles = TArray< FString >() ) const;
+
+private:
+	FString Root;
+	bool bValid = false;
+
+	FString SavedRepoRoot;
+	GitLowLevelCommands::EGitLogMode SavedGitLogMode;
+	bool bSavedUsePathspecFromFile;
+};
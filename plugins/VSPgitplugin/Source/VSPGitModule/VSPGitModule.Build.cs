@@ -25,6 +25,7 @@ public class VSPGitModule : ModuleRules
         PrivateDependencyModuleNames.AddRange(
             new string[] {
 	            "CoreUObject",
+	            "DirectoryWatcher",
 	            "ToolMenus",
                 "AppFramework",
                 "Core",
@@ -37,7 +38,8 @@ public class VSPGitModule : ModuleRules
                 "SourceControl",
                 "DesktopWidgets",
                 "InputCore",
-                "UnrealEd"
+                "UnrealEd",
+                "VSPTests"
             }
         );
 